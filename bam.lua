@@ -468,11 +468,30 @@ function build(settings)
 	-- build tests
 	tests_settings = engine_settings:Copy()
 	tests_src = Collect("src/testing/*.cpp")
+	tests_sql = Compile(tools_settings, "src/engine/client/db_sqlite3.cpp")
+
+	-- the editor undo test drives a CEditor, which needs the ui and the render tools of the client
+	tests_editor_src = {"src/game/client/ui.cpp", "src/game/client/render.cpp", "src/game/client/render_map.cpp",
+		"src/game/client/lineinput.cpp", "src/game/client/animstate.cpp", "src/game/generated/client_data.cpp"}
+	tests_editor = {}
+	for i,v in ipairs(game_client) do
+		for j,w in ipairs(tests_editor_src) do
+			if PathBase(v) == Intermediate_Output(client_settings, w) then
+				table.insert(tests_editor, v)
+			end
+		end
+	end
+
 	tests = {}
 	for i,v in ipairs(tests_src) do
 		testname = PathFilename(PathBase(v))
-		tests[i] = Link(tests_settings, testname, Compile(tools_settings, v), 
-						engine, zlib, pnglite, md5, game_shared, aes128)
+		if testname == "test_editor_undo" then
+			tests[i] = Link(client_settings, testname, Compile(client_settings, v),
+							engine, zlib, pnglite, md5, game_shared, aes128, game_editor, tests_editor)
+		else
+			tests[i] = Link(tests_settings, testname, Compile(tools_settings, v), 
+							engine, zlib, pnglite, md5, game_shared, aes128, tests_sql, sqlite3)
+		end
 	end
 
 
@@ -1,6 +1,30 @@
 local __CTRL = {}
 __CTRL.Events = {}
 __CTRL.Threads = {}	--3D Table which contains the 'threadobject' and its pause stuff
+__CTRL.Dispatchers = {}	--the event functions defined in here, filled in at the end of the file
+
+-- the client looks the event functions up once and only calls the scripts that handle an event.
+-- this tells it to look them up again
+local function __EventsChanged()
+	if _EventsChanged ~= nil then
+		_EventsChanged()
+	end
+end
+
+-- whether calling the event function would reach anything; the dispatchers in here only do while something is registered
+function _EventIsHandled(EventName)
+	local Func = getfenv()[EventName]
+	if type(Func) ~= "function" then
+		return false
+	end
+	if Func ~= __CTRL.Dispatchers[EventName] then
+		return true
+	end
+	if EventName == "ResumeThreads" then
+		return next(__CTRL.Threads) ~= nil
+	end
+	return __CTRL.Events[EventName] ~= nil and next(__CTRL.Events[EventName]) ~= nil
+end
 
 -- YOU SHOULD NOT TOUCH THIS FUNCTION IF YOU DON'T KNOW WHAT YOU ARE DOING!
 function RegisterEvent(EventName, ...)
@@ -36,6 +60,7 @@ function RegisterEvent(EventName, ...)
 			error("Cannot register global '" .. FuncName .. "' (a nil value) for event " .. EventName, 2)
 		end
 	end
+	__EventsChanged()
 end
 
 function RemoveEvent(EventName, ...)
@@ -58,6 +83,7 @@ function RemoveEvent(EventName, ...)
 			error("RemoveEvent expects only strings as variadic arguments (got " .. type(FuncName) .. ")", 2)
 		end
 	end
+	__EventsChanged()
 end
 
 function EventList(EventName)
@@ -318,6 +344,7 @@ function RegisterThread(FuncName, argtable)
 		__CTRL.Threads[Func].Routine = coroutine.create(Func)
 		__CTRL.Threads[Func].ResTick = 0
 		__CTRL.Threads[Func].ResSec = 0
+		__EventsChanged()
 
 		--FOLLOWING CODE IS INFINITE LOOP PROTECTION!
 		--This creates a hook which can register up to 10000 events; if that value is exceeded, the script is cancelled!
@@ -349,6 +376,7 @@ end
 function RemoveThread(Name)
 	local Func = getfenv()[Name]
 	__CTRL.Threads[Func] = nil
+	__EventsChanged()
 end
 
 function thread_sleep_ticks(num)
@@ -360,3 +388,40 @@ function thread_sleep_ms(num)
 	__CTRL.Threads[debug.getinfo(2).func].ResSec = os.clock() + num/1000
 	coroutine.yield()
 end
+
+for Name, Func in pairs(getfenv()) do
+	if type(Func) == "function" then
+		__CTRL.Dispatchers[Name] = Func
+	end
+end
+
+-- the event functions, the same names the client looks up (LuaEventName in luaevents.h)
+__CTRL.EventNames = {
+	"OnKeyPress", "OnKeyRelease", "OnEnterGame", "OnTick", "ResumeThreads", "OnRenderLevel", "OnInputLevel",
+	"OnRenderScoreboard", "OnRenderBackground", "OnKill", "PreRenderPlayer", "PostRenderPlayer", "OnSnapInput",
+	"OnMessageIRC", "OnChat", "OnChatSend", "OnConsoleCommand", "OnStateChange", "OnGameOver", "OnGameStart",
+	"OnFlagGrab", "OnPredHammerHit",
+}
+
+-- the event functions are kept out of the globals table and only reached through its metatable, so that
+-- every assignment to one (OnChat = f, or defining OnTick inside a callback) goes through __newindex and
+-- the client looks the handlers up again. pairs() over the globals doesn't list them anymore
+__CTRL.EventGlobals = {}
+__CTRL.IsEventName = {}
+for i, Name in ipairs(__CTRL.EventNames) do
+	__CTRL.IsEventName[Name] = true
+	__CTRL.EventGlobals[Name] = rawget(getfenv(), Name)
+	rawset(getfenv(), Name, nil)
+end
+
+setmetatable(getfenv(), {
+	__index = __CTRL.EventGlobals,
+	__newindex = function(Globals, Name, Value)
+		if __CTRL.IsEventName[Name] then
+			__CTRL.EventGlobals[Name] = Value
+			__EventsChanged()
+		else
+			rawset(Globals, Name, Value)
+		end
+	end
+})
@@ -6,22 +6,25 @@
 
 static int str_utf8_skeleton(int ch, const int **skeleton, int *skeleton_len)
 {
-	int i;
-	for(i = 0; i < NUM_DECOMPS; i++)
+	/* decomp_chars is sorted, binary search it */
+	int low = 0;
+	int high = NUM_DECOMPS - 1;
+	while(low <= high)
 	{
-		if(ch == decomp_chars[i])
+		int mid = low + (high - low) / 2;
+		if(ch == decomp_chars[mid])
 		{
-			int offset = decomp_slices[i].offset;
-			int length = decomp_lengths[decomp_slices[i].length];
+			int offset = decomp_slices[mid].offset;
+			int length = decomp_lengths[decomp_slices[mid].length];
 
 			*skeleton = &decomp_data[offset];
 			*skeleton_len = length;
 			return 1;
 		}
-		else if(ch < decomp_chars[i])
-		{
-			break;
-		}
+		else if(ch < decomp_chars[mid])
+			high = mid - 1;
+		else
+			low = mid + 1;
 	}
 	*skeleton = NULL;
 	*skeleton_len = 1;
@@ -83,3 +86,18 @@ int str_utf8_comp_confusable(const char *str1, const char *str2)
 			return 1;
 	}
 }
+
+int str_utf8_to_skeleton(const char *str, int *buf, int buf_len)
+{
+	int i;
+	struct SKELETON skel;
+	str_utf8_skeleton_begin(&skel, str);
+	for(i = 0; i < buf_len; i++)
+	{
+		int ch = str_utf8_skeleton_next(&skel);
+		if(ch == 0)
+			break;
+		buf[i] = ch;
+	}
+	return i;
+}
@@ -0,0 +1,65 @@
+#ifndef BASE_SYSTEMPP_SPSC_QUEUE_H
+#define BASE_SYSTEMPP_SPSC_QUEUE_H
+
+#include <atomic>
+
+/**
+ * Bounded lock-free queue for exactly one producer and one consumer thread
+ * @tparam T element type, copied in and out
+ * @tparam SIZE number of slots, has to be a power of two; one slot always stays empty
+ */
+template <class T, unsigned SIZE>
+class CSpscQueue
+{
+	T m_aItems[SIZE];
+	std::atomic<unsigned> m_Read;
+	std::atomic<unsigned> m_Write;
+
+public:
+	CSpscQueue()
+	{
+		static_assert((SIZE & (SIZE-1)) == 0, "queue size has to be a power of two");
+		m_Read.store(0, std::memory_order_relaxed);
+		m_Write.store(0, std::memory_order_relaxed);
+	}
+
+	/**
+	 * Appends an element, may only be called from the producer thread
+	 * @param Item the element to copy into the queue
+	 * @return false if the queue is full
+	 */
+	bool Push(const T& Item)
+	{
+		const unsigned Write = m_Write.load(std::memory_order_relaxed);
+		const unsigned Next = (Write+1) & (SIZE-1);
+		if(Next == m_Read.load(std::memory_order_acquire))
+			return false;
+
+		m_aItems[Write] = Item;
+		m_Write.store(Next, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * Takes the oldest element out, may only be called from the consumer thread
+	 * @param pItem where to copy the element to
+	 * @return false if the queue is empty
+	 */
+	bool Pop(T *pItem)
+	{
+		const unsigned Read = m_Read.load(std::memory_order_relaxed);
+		if(Read == m_Write.load(std::memory_order_acquire))
+			return false;
+
+		*pItem = m_aItems[Read];
+		m_Read.store((Read+1) & (SIZE-1), std::memory_order_release);
+		return true;
+	}
+
+	bool Empty() const
+	{
+		return m_Read.load(std::memory_order_acquire) == m_Write.load(std::memory_order_acquire);
+	}
+};
+
+#endif
@@ -36,6 +36,7 @@
 	#include <arpa/inet.h>
 
 	#include <dirent.h>
+	#include <sys/mman.h>
 
 #if defined(CONF_PLATFORM_MACOSX)
 	// some lock and pthread functions are already defined in headers
@@ -2183,6 +2184,63 @@ int fs_rename(const char *oldname, const char *newname)
 	return 0;
 }
 
+const void *fs_map_file(const char *filename, unsigned *size)
+{
+#if defined(CONF_FAMILY_WINDOWS)
+	HANDLE file, mapping;
+	LARGE_INTEGER length;
+	void *data = 0;
+	*size = 0;
+	file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ|FILE_SHARE_WRITE|FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if(file == INVALID_HANDLE_VALUE)
+		return 0;
+	if(GetFileSizeEx(file, &length) && length.QuadPart > 0 && length.QuadPart < 0x7fffffff)
+	{
+		/* the view keeps the mapping alive, the handles aren't needed anymore */
+		mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if(mapping)
+		{
+			data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			CloseHandle(mapping);
+		}
+		if(data)
+			*size = (unsigned)length.QuadPart;
+	}
+	CloseHandle(file);
+	return data;
+#else
+	struct stat sb;
+	void *data;
+	int fd;
+	*size = 0;
+	fd = open(filename, O_RDONLY);
+	if(fd < 0)
+		return 0;
+	if(fstat(fd, &sb) != 0 || sb.st_size <= 0 || sb.st_size >= 0x7fffffff)
+	{
+		close(fd);
+		return 0;
+	}
+	data = mmap(NULL, (size_t)sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(data == MAP_FAILED)
+		return 0;
+	*size = (unsigned)sb.st_size;
+	return data;
+#endif
+}
+
+void fs_unmap_file(const void *data, unsigned size)
+{
+	if(!data)
+		return;
+#if defined(CONF_FAMILY_WINDOWS)
+	UnmapViewOfFile(data);
+#else
+	munmap((void *)data, size);
+#endif
+}
+
 int fs_compare(const char *a, const char *b)
 {
 #if defined(CONF_FAMILY_UNIX)
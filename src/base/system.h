@@ -1330,6 +1330,34 @@ int fs_remove(const char *filename);
 */
 int fs_rename(const char *oldname, const char *newname);
 
+/*
+	Function: fs_map_file
+		Maps a whole file into memory, read only.
+
+	Parameters:
+		filename - The file to map
+		size - Receives the size of the file
+
+	Returns:
+		Returns a pointer to the contents, NULL on failure or if the file is empty.
+
+	Remarks:
+		- The file must not be truncated or rewritten while it is mapped. Changes to it may show through,
+		  and on POSIX reading a part that was truncated away raises SIGBUS. Removing it is fine.
+		- Free the mapping with <fs_unmap_file>.
+*/
+const void *fs_map_file(const char *filename, unsigned *size);
+
+/*
+	Function: fs_unmap_file
+		Frees a mapping of <fs_map_file>.
+
+	Parameters:
+		data - The pointer returned by <fs_map_file>
+		size - The size of the file
+*/
+void fs_unmap_file(const void *data, unsigned size);
+
 int fs_compare(const char *a, const char *b);
 int fs_compare_num(const char *a, const char *b, int num);
 
@@ -1456,6 +1484,22 @@ void gui_messagebox(const char *title, const char *message);
 */
 int str_utf8_comp_confusable(const char *a, const char *b);
 
+/*
+	Function: str_utf8_to_skeleton
+		Converts a string into its skeleton, the sequence of code points
+		that visually confusable strings have in common. Two strings are
+		confusable exactly when their skeletons are equal.
+
+	Parameters:
+		str - String to convert.
+		buf - Buffer that receives the code points.
+		buf_len - Size of the buffer in code points.
+
+	Returns:
+		The number of code points written to buf.
+*/
+int str_utf8_to_skeleton(const char *str, int *buf, int buf_len);
+
 int str_utf8_isspace(int code);
 
 int str_utf8_isstart(char c);
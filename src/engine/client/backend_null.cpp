@@ -0,0 +1,140 @@
+#include <base/system.h>
+
+#include <base/tl/threading.h>
+
+#if defined(CONF_PLATFORM_MACOSX)
+	#include "backend_sdl.h" // the semaphore comes from SDL there
+#endif
+#include "backend_null.h"
+
+int CGraphicsBackend_Null::Init(const char *pName, int *Screen, int *pWidth, int *pHeight, int FsaaSamples, int Flags, int *pDesktopWidth, int *pDesktopHeight)
+{
+	mem_zero(&m_Stats, sizeof(m_Stats));
+	mem_zero(m_aTextureMemory, sizeof(m_aTextureMemory));
+	mem_zero(m_apQuadBuffers, sizeof(m_apQuadBuffers));
+	m_TextureMemoryUsage = 0;
+
+	// there is no screen to ask, pretend to be a common one
+	if(*pWidth == 0 || *pHeight == 0)
+	{
+		*pWidth = 1920;
+		*pHeight = 1080;
+	}
+	*Screen = 0;
+	*pDesktopWidth = *pWidth;
+	*pDesktopHeight = *pHeight;
+
+	dbg_msg("gfx", "using the null backend, nothing will be drawn");
+	return 0;
+}
+
+void CGraphicsBackend_Null::RunCommand(const CCommandBuffer::SCommand *pBaseCommand)
+{
+	m_Stats.m_NumCommands++;
+
+	switch(pBaseCommand->m_Cmd)
+	{
+	case CCommandBuffer::CMD_SIGNAL:
+		static_cast<const CCommandBuffer::SCommand_Signal *>(pBaseCommand)->m_pSemaphore->signal();
+		break;
+	case CCommandBuffer::CMD_RUNBUFFER:
+		RunBuffer(static_cast<const CCommandBuffer::SCommand_RunBuffer *>(pBaseCommand)->m_pOtherBuffer);
+		break;
+	case CCommandBuffer::CMD_TEXTURE_CREATE:
+		{
+			const CCommandBuffer::SCommand_Texture_Create *pCommand = static_cast<const CCommandBuffer::SCommand_Texture_Create *>(pBaseCommand);
+			int Size = pCommand->m_Width*pCommand->m_Height*pCommand->m_PixelSize;
+			m_Stats.m_NumTextureUploads++;
+			m_Stats.m_TextureUploadBytes += Size;
+			m_TextureMemoryUsage += Size - m_aTextureMemory[pCommand->m_Slot];
+			m_aTextureMemory[pCommand->m_Slot] = Size;
+			mem_free(pCommand->m_pData);
+		}
+		break;
+	case CCommandBuffer::CMD_TEXTURE_UPDATE:
+		{
+			const CCommandBuffer::SCommand_Texture_Update *pCommand = static_cast<const CCommandBuffer::SCommand_Texture_Update *>(pBaseCommand);
+			int PixelSize = pCommand->m_Format == CCommandBuffer::TEXFORMAT_RGBA ? 4 : pCommand->m_Format == CCommandBuffer::TEXFORMAT_RGB ? 3 : 1;
+			m_Stats.m_NumTextureUploads++;
+			m_Stats.m_TextureUploadBytes += pCommand->m_Width*pCommand->m_Height*PixelSize;
+			mem_free(pCommand->m_pData);
+		}
+		break;
+	case CCommandBuffer::CMD_TEXTURE_DESTROY:
+		{
+			const CCommandBuffer::SCommand_Texture_Destroy *pCommand = static_cast<const CCommandBuffer::SCommand_Texture_Destroy *>(pBaseCommand);
+			m_TextureMemoryUsage -= m_aTextureMemory[pCommand->m_Slot];
+			m_aTextureMemory[pCommand->m_Slot] = 0;
+		}
+		break;
+	case CCommandBuffer::CMD_QUADBUFFER_CREATE:
+		{
+			const CCommandBuffer::SCommand_QuadBuffer_Create *pCommand = static_cast<const CCommandBuffer::SCommand_QuadBuffer_Create *>(pBaseCommand);
+			m_apQuadBuffers[pCommand->m_Slot] = pCommand->m_pVertices;
+		}
+		break;
+	case CCommandBuffer::CMD_QUADBUFFER_UPDATE:
+		mem_free(static_cast<const CCommandBuffer::SCommand_QuadBuffer_Update *>(pBaseCommand)->m_pVertices);
+		break;
+	case CCommandBuffer::CMD_QUADBUFFER_DESTROY:
+		{
+			const CCommandBuffer::SCommand_QuadBuffer_Destroy *pCommand = static_cast<const CCommandBuffer::SCommand_QuadBuffer_Destroy *>(pBaseCommand);
+			mem_free(m_apQuadBuffers[pCommand->m_Slot]);
+			m_apQuadBuffers[pCommand->m_Slot] = 0;
+		}
+		break;
+	case CCommandBuffer::CMD_RENDER_QUADBUFFER:
+		{
+			const CCommandBuffer::SCommand_RenderQuadBuffer *pCommand = static_cast<const CCommandBuffer::SCommand_RenderQuadBuffer *>(pBaseCommand);
+			m_Stats.m_NumRenderCommands++;
+			m_Stats.m_NumPrimitives += pCommand->m_PrimCount;
+			m_Stats.m_NumVertices += pCommand->m_PrimCount*4;
+		}
+		break;
+	case CCommandBuffer::CMD_RENDER:
+		{
+			const CCommandBuffer::SCommand_Render *pCommand = static_cast<const CCommandBuffer::SCommand_Render *>(pBaseCommand);
+			int VerticesPerPrim = pCommand->m_PrimType == CCommandBuffer::PRIMTYPE_QUADS ? 4 : pCommand->m_PrimType == CCommandBuffer::PRIMTYPE_LINES ? 2 : 3;
+			m_Stats.m_NumRenderCommands++;
+			m_Stats.m_NumPrimitives += pCommand->m_PrimCount;
+			m_Stats.m_NumVertices += pCommand->m_PrimCount*VerticesPerPrim;
+		}
+		break;
+	case CCommandBuffer::CMD_SWAP:
+		m_Stats.m_NumSwaps++;
+		break;
+	case CCommandBuffer::CMD_VSYNC:
+		*static_cast<const CCommandBuffer::SCommand_VSync *>(pBaseCommand)->m_pRetOk = true;
+		break;
+	case CCommandBuffer::CMD_SCREENSHOT:
+		{
+			// a black image, so whoever asked for it has something to free
+			CImageInfo *pImage = static_cast<const CCommandBuffer::SCommand_Screenshot *>(pBaseCommand)->m_pImage;
+			pImage->m_Width = 1;
+			pImage->m_Height = 1;
+			pImage->m_Format = CImageInfo::FORMAT_RGB;
+			pImage->m_pData = mem_alloc(3, 1);
+			mem_zero(pImage->m_pData, 3);
+		}
+		break;
+	case CCommandBuffer::CMD_VIDEOMODES:
+		*static_cast<const CCommandBuffer::SCommand_VideoModes *>(pBaseCommand)->m_pNumModes = 0;
+		break;
+	}
+}
+
+void CGraphicsBackend_Null::RunBuffer(CCommandBuffer *pBuffer)
+{
+	m_Stats.m_NumBuffers++;
+
+	unsigned CmdIndex = 0;
+	while(1)
+	{
+		const CCommandBuffer::SCommand *pBaseCommand = pBuffer->GetCommand(&CmdIndex);
+		if(pBaseCommand == 0x0)
+			break;
+		RunCommand(pBaseCommand);
+	}
+}
+
+IGraphicsBackend *CreateNullGraphicsBackend() { return new CGraphicsBackend_Null; }
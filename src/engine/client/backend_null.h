@@ -0,0 +1,44 @@
+#ifndef ENGINE_CLIENT_BACKEND_NULL_H
+#define ENGINE_CLIENT_BACKEND_NULL_H
+
+#include "graphics_threaded.h"
+
+// consumes the command buffers right away without any GL, only counting what comes in.
+// lets the client run headless to measure the cpu side of rendering
+class CGraphicsBackend_Null : public IGraphicsBackend
+{
+	CGraphicsStats m_Stats;
+	int m_aTextureMemory[CCommandBuffer::MAX_TEXTURES];
+	int m_TextureMemoryUsage;
+	CCommandBuffer::SQuadVertex *m_apQuadBuffers[CCommandBuffer::MAX_QUADBUFFERS];
+
+	void RunCommand(const CCommandBuffer::SCommand *pBaseCommand);
+
+public:
+	virtual int Init(const char *pName, int *Screen, int *pWidth, int *pHeight, int FsaaSamples, int Flags, int *pDesktopWidth, int *pDesktopHeight);
+	virtual int Shutdown() { return 0; }
+
+	virtual int MemoryUsage() const { return m_TextureMemoryUsage; }
+	virtual void GetStats(CGraphicsStats *pStats) const { *pStats = m_Stats; }
+
+	virtual int GetNumScreens() const { return 1; }
+
+	virtual void Minimize() {}
+	virtual void Maximize() {}
+	virtual bool Fullscreen(bool State) { return false; }
+	virtual void SetWindowBordered(bool State) {}
+	virtual bool SetWindowScreen(int Index) { return Index == 0; }
+	virtual int GetWindowScreen() { return 0; }
+	virtual int WindowActive() { return 1; }
+	virtual int WindowOpen() { return 1; }
+	virtual void SetWindowGrab(bool Grab) {}
+	virtual void NotifyWindow() {}
+	virtual void HideWindow() {}
+	virtual void UnhideWindow() {}
+
+	virtual void RunBuffer(CCommandBuffer *pBuffer);
+	virtual bool IsIdle() const { return true; }
+	virtual void WaitForIdle() {}
+};
+
+#endif
@@ -338,6 +338,27 @@ void CCommandProcessorFragment_OpenGL::Cmd_Texture_Create(const CCommandBuffer::
 	mem_free(pTexData);
 }
 
+void CCommandProcessorFragment_OpenGL::Cmd_QuadBuffer_Create(const CCommandBuffer::SCommand_QuadBuffer_Create *pCommand)
+{
+	m_aQuadBuffers[pCommand->m_Slot].m_pVertices = pCommand->m_pVertices;
+	m_aQuadBuffers[pCommand->m_Slot].m_NumQuads = pCommand->m_NumQuads;
+}
+
+void CCommandProcessorFragment_OpenGL::Cmd_QuadBuffer_Update(const CCommandBuffer::SCommand_QuadBuffer_Update *pCommand)
+{
+	CQuadBuffer *pBuffer = &m_aQuadBuffers[pCommand->m_Slot];
+	if(pCommand->m_FirstQuad >= 0 && pCommand->m_FirstQuad+pCommand->m_NumQuads <= pBuffer->m_NumQuads)
+		mem_copy(pBuffer->m_pVertices+pCommand->m_FirstQuad*4, pCommand->m_pVertices, sizeof(CCommandBuffer::SQuadVertex)*4*pCommand->m_NumQuads);
+	mem_free(pCommand->m_pVertices);
+}
+
+void CCommandProcessorFragment_OpenGL::Cmd_QuadBuffer_Destroy(const CCommandBuffer::SCommand_QuadBuffer_Destroy *pCommand)
+{
+	mem_free(m_aQuadBuffers[pCommand->m_Slot].m_pVertices);
+	m_aQuadBuffers[pCommand->m_Slot].m_pVertices = 0;
+	m_aQuadBuffers[pCommand->m_Slot].m_NumQuads = 0;
+}
+
 void CCommandProcessorFragment_OpenGL::Cmd_Clear(const CCommandBuffer::SCommand_Clear *pCommand)
 {
 	glClearColor(pCommand->m_Color.r, pCommand->m_Color.g, pCommand->m_Color.b, 0.0f);
@@ -348,7 +369,7 @@ void CCommandProcessorFragment_OpenGL::Cmd_Render(const CCommandBuffer::SCommand
 {
 	SetState(pCommand->m_State);
 
-	glVertexPointer(3, GL_FLOAT, sizeof(CCommandBuffer::SVertex), (char*)pCommand->m_pVertices);
+	glVertexPointer(2, GL_FLOAT, sizeof(CCommandBuffer::SVertex), (char*)pCommand->m_pVertices);
 	glTexCoordPointer(2, GL_FLOAT, sizeof(CCommandBuffer::SVertex), (char*)pCommand->m_pVertices + sizeof(float)*3);
 	glColorPointer(4, GL_FLOAT, sizeof(CCommandBuffer::SVertex), (char*)pCommand->m_pVertices + sizeof(float)*5);
 	glEnableClientState(GL_VERTEX_ARRAY);
@@ -376,6 +397,30 @@ void CCommandProcessorFragment_OpenGL::Cmd_Render(const CCommandBuffer::SCommand
 	};
 }
 
+void CCommandProcessorFragment_OpenGL::Cmd_RenderQuadBuffer(const CCommandBuffer::SCommand_RenderQuadBuffer *pCommand)
+{
+	const CQuadBuffer *pBuffer = &m_aQuadBuffers[pCommand->m_Slot];
+	if(pCommand->m_FirstQuad+pCommand->m_PrimCount > (unsigned)pBuffer->m_NumQuads)
+		return;
+
+	SetState(pCommand->m_State);
+
+	const CCommandBuffer::SQuadVertex *pVertices = pBuffer->m_pVertices + pCommand->m_FirstQuad*4;
+	glVertexPointer(2, GL_FLOAT, sizeof(CCommandBuffer::SQuadVertex), (const char*)pVertices);
+	glTexCoordPointer(2, GL_FLOAT, sizeof(CCommandBuffer::SQuadVertex), (const char*)pVertices + sizeof(float)*2);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	glDisableClientState(GL_COLOR_ARRAY);
+	glColor4f(pCommand->m_Color.r, pCommand->m_Color.g, pCommand->m_Color.b, pCommand->m_Color.a);
+
+#if defined(__ANDROID__)
+	for(unsigned i = 0; i < pCommand->m_PrimCount; i++)
+		glDrawArrays(GL_TRIANGLE_FAN, i*4, 4);
+#else
+	glDrawArrays(GL_QUADS, 0, pCommand->m_PrimCount*4);
+#endif
+}
+
 void CCommandProcessorFragment_OpenGL::Cmd_Screenshot(const CCommandBuffer::SCommand_Screenshot *pCommand)
 {
 	// fetch image data
@@ -414,6 +459,7 @@ void CCommandProcessorFragment_OpenGL::Cmd_Screenshot(const CCommandBuffer::SCom
 CCommandProcessorFragment_OpenGL::CCommandProcessorFragment_OpenGL()
 {
 	mem_zero(m_aTextures, sizeof(m_aTextures));
+	mem_zero(m_aQuadBuffers, sizeof(m_aQuadBuffers));
 	m_pTextureMemoryUsage = 0;
 }
 
@@ -425,8 +471,12 @@ bool CCommandProcessorFragment_OpenGL::RunCommand(const CCommandBuffer::SCommand
 	case CCommandBuffer::CMD_TEXTURE_CREATE: Cmd_Texture_Create(static_cast<const CCommandBuffer::SCommand_Texture_Create *>(pBaseCommand)); break;
 	case CCommandBuffer::CMD_TEXTURE_DESTROY: Cmd_Texture_Destroy(static_cast<const CCommandBuffer::SCommand_Texture_Destroy *>(pBaseCommand)); break;
 	case CCommandBuffer::CMD_TEXTURE_UPDATE: Cmd_Texture_Update(static_cast<const CCommandBuffer::SCommand_Texture_Update *>(pBaseCommand)); break;
+	case CCommandBuffer::CMD_QUADBUFFER_CREATE: Cmd_QuadBuffer_Create(static_cast<const CCommandBuffer::SCommand_QuadBuffer_Create *>(pBaseCommand)); break;
+	case CCommandBuffer::CMD_QUADBUFFER_UPDATE: Cmd_QuadBuffer_Update(static_cast<const CCommandBuffer::SCommand_QuadBuffer_Update *>(pBaseCommand)); break;
+	case CCommandBuffer::CMD_QUADBUFFER_DESTROY: Cmd_QuadBuffer_Destroy(static_cast<const CCommandBuffer::SCommand_QuadBuffer_Destroy *>(pBaseCommand)); break;
 	case CCommandBuffer::CMD_CLEAR: Cmd_Clear(static_cast<const CCommandBuffer::SCommand_Clear *>(pBaseCommand)); break;
 	case CCommandBuffer::CMD_RENDER: Cmd_Render(static_cast<const CCommandBuffer::SCommand_Render *>(pBaseCommand)); break;
+	case CCommandBuffer::CMD_RENDER_QUADBUFFER: Cmd_RenderQuadBuffer(static_cast<const CCommandBuffer::SCommand_RenderQuadBuffer *>(pBaseCommand)); break;
 	case CCommandBuffer::CMD_SCREENSHOT: Cmd_Screenshot(static_cast<const CCommandBuffer::SCommand_Screenshot *>(pBaseCommand)); break;
 	default: return false;
 	}
@@ -449,6 +499,8 @@ void CCommandProcessorFragment_SDL::Cmd_Init(const SCommand_Init *pCommand)
 	glDisable(GL_DEPTH_TEST);
 	glMatrixMode(GL_MODELVIEW);
 	glLoadIdentity();
+	// vertices carry no depth, put them all between the near and far plane of the screen mapping
+	glTranslatef(0.0f, 0.0f, -5.0f);
 
 	glAlphaFunc(GL_GREATER, 0);
 	glEnable(GL_ALPHA_TEST);
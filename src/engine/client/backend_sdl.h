@@ -94,6 +94,14 @@ class CCommandProcessorFragment_OpenGL
 	CTexture m_aTextures[CCommandBuffer::MAX_TEXTURES];
 	volatile int *m_pTextureMemoryUsage;
 
+	// there are no buffer objects in the fixed pipeline, the quads are kept in memory and drawn from there
+	struct CQuadBuffer
+	{
+		CCommandBuffer::SQuadVertex *m_pVertices;
+		int m_NumQuads;
+	};
+	CQuadBuffer m_aQuadBuffers[CCommandBuffer::MAX_QUADBUFFERS];
+
 public:
 	enum
 	{
@@ -117,8 +125,12 @@ private:
 	void Cmd_Texture_Update(const CCommandBuffer::SCommand_Texture_Update *pCommand);
 	void Cmd_Texture_Destroy(const CCommandBuffer::SCommand_Texture_Destroy *pCommand);
 	void Cmd_Texture_Create(const CCommandBuffer::SCommand_Texture_Create *pCommand);
+	void Cmd_QuadBuffer_Create(const CCommandBuffer::SCommand_QuadBuffer_Create *pCommand);
+	void Cmd_QuadBuffer_Update(const CCommandBuffer::SCommand_QuadBuffer_Update *pCommand);
+	void Cmd_QuadBuffer_Destroy(const CCommandBuffer::SCommand_QuadBuffer_Destroy *pCommand);
 	void Cmd_Clear(const CCommandBuffer::SCommand_Clear *pCommand);
 	void Cmd_Render(const CCommandBuffer::SCommand_Render *pCommand);
+	void Cmd_RenderQuadBuffer(const CCommandBuffer::SCommand_RenderQuadBuffer *pCommand);
 	void Cmd_Screenshot(const CCommandBuffer::SCommand_Screenshot *pCommand);
 
 public:
@@ -188,6 +200,7 @@ public:
 	virtual int Shutdown();
 
 	virtual int MemoryUsage() const;
+	virtual void GetStats(CGraphicsStats *pStats) const { mem_zero(pStats, sizeof(*pStats)); }
 
 	virtual int GetNumScreens() const { return m_NumScreens; }
 
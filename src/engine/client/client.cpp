@@ -859,7 +859,7 @@ void CClient::OnEnterGame()
 	CALLSTACK_ADD();
 
 	// EVENT CALL
-	LUA_FIRE_EVENT("OnEnterGame");
+	LUA_FIRE_EVENT(LUA_EVENT_ON_ENTER_GAME);
 
 	// reset input
 	int i;
@@ -1415,6 +1415,15 @@ void CClient::DebugRender()
 
 	str_format(aBuffer, sizeof(aBuffer), "pred: %d ms", GetPredictionTime());
 	Graphics()->QuadsText(2, YOFFSET+70, 16, aBuffer);
+
+	if(m_pDatabase)
+	{
+		CSql::CStats SqlStats = m_pDatabase->GetStats();
+		str_format(aBuffer, sizeof(aBuffer), "sql: queued=%d peak=%d  |  latency avg=%.1f ms max=%.1f ms  |  coalesced=%d stalls=%d",
+			SqlStats.m_NumQueued, SqlStats.m_PeakQueued, SqlStats.m_AvgLatency, SqlStats.m_MaxLatency,
+			SqlStats.m_NumCoalesced, SqlStats.m_NumStalls);
+		Graphics()->QuadsText(2, YOFFSET+84, 16, aBuffer);
+	}
 	Graphics()->QuadsEnd();
 
 	// render graphs
@@ -2002,16 +2011,16 @@ void CClient::ProcessServerInfo(int RawType, NETADDR *pFrom, const void *pData,
 		// add the name to the database
 		if(g_Config.m_ClUsernameFetching)
 		{
-			char *pQueryBuf = sqlite3_mprintf("INSERT OR REPLACE INTO names_v2 (name, clan, server, gametype, num_clients, state, score) VALUES ('%q', '%q', '%q', '%q', '%d', '%q', '%d');",
-											  pClient->m_aName,
-											  pClient->m_aClan,
-											  Info.m_aAddress,
-											  Info.m_aGameType,
-											  Info.m_NumClients,
-											  pClient->m_Player ? "player" : "spec",
-											  pClient->m_Score
-			);
-			CQuery *pQuery = new CQuery(pQueryBuf);
+			CQuery *pQuery = new CQuery();
+			pQuery->SetTemplate("INSERT OR REPLACE INTO names_v2 (name, clan, server, gametype, num_clients, state, score) VALUES (?, ?, ?, ?, ?, ?, ?);");
+			pQuery->BindText(pClient->m_aName);
+			pQuery->BindText(pClient->m_aClan);
+			pQuery->BindText(Info.m_aAddress);
+			pQuery->BindText(Info.m_aGameType);
+			pQuery->BindInt(Info.m_NumClients);
+			pQuery->BindText(pClient->m_Player ? "player" : "spec");
+			pQuery->BindInt(pClient->m_Score);
+			pQuery->SetKey(pClient->m_aName); // name is unique, the same player seen again only replaces the row
 			m_pDatabase->InsertQuery(pQuery);
 		}
 	}
@@ -3452,7 +3461,7 @@ void CClient::Run()
 		if((double)time_get() >= (double)LastTick+(double)time_freq()*(1.0/50.0))
 		{
 			LastTick = time_get();
-			LUA_FIRE_EVENT("OnTick");
+			LUA_FIRE_EVENT(LUA_EVENT_ON_TICK);
 		}
 
 		//
@@ -3663,7 +3672,7 @@ void CClient::Run()
 		//for(int oz = 0; oz < m_Lua.GetLuaFiles().size(); oz++)
 		//	;
 
-		LUA_FIRE_EVENT("ResumeThreads");
+		LUA_FIRE_EVENT(LUA_EVENT_RESUME_THREADS);
 
 #if defined(CONF_FAMILY_UNIX)
 		m_Fifo.Update();
@@ -4010,6 +4019,10 @@ void CClient::DemoSlice(const char *pDstPath, CLIENTFUNC_FILTER pfnFilter, void
 	{
 		const char *pDemoFileName = m_DemoPlayer.GetDemoFileName();
 		m_DemoEditor.Slice(pDemoFileName, pDstPath, g_Config.m_ClDemoSliceBegin, g_Config.m_ClDemoSliceEnd, pfnFilter, pUser);
+
+		// reset slice markers
+		g_Config.m_ClDemoSliceBegin = -1;
+		g_Config.m_ClDemoSliceEnd = -1;
 	}
 }
 
@@ -4028,6 +4041,10 @@ const char *CClient::DemoPlayer_Play(const char *pFilename, int StorageType)
 	if(m_DemoPlayer.Load(Storage(), m_pConsole, pFilename, StorageType))
 		return "error loading demo";
 
+	// reset slice markers
+	g_Config.m_ClDemoSliceBegin = -1;
+	g_Config.m_ClDemoSliceEnd = -1;
+
 	// load map
 	Crc = (m_DemoPlayer.Info()->m_Header.m_aMapCrc[0]<<24)|
 		  (m_DemoPlayer.Info()->m_Header.m_aMapCrc[1]<<16)|
@@ -4506,7 +4523,7 @@ int main(int argc, const char **argv) // ignore_convention
 	pClient->RegisterInterfaces();
 
 	// create the components
-	IEngine *pEngine = CreateEngine("Teeworlds");
+	IEngine *pEngine = CreateEngine("Teeworlds", 4); // skins and map images are decoded on the job threads
 	IConsole *pConsole = CreateConsole(CFGFLAG_CLIENT);
 	IStorageTW *pStorage = CreateStorage("Teeworlds", IStorageTW::STORAGETYPE_CLIENT, argc, argv); // ignore_convention
 	IConfig *pConfig = CreateConfig();
@@ -1,6 +1,7 @@
 
 #include <base/system++/threading.h>
 #include <base/system.h>
+#include <base/math.h>
 #include "db_sqlite3.h"
 
 
@@ -16,6 +17,57 @@ bool CQuery::Next()
 	return Ret == SQLITE_ROW;
 }
 
+void CQuery::BindInt(sqlite3_int64 Value)
+{
+	CParam Param;
+	Param.m_Type = SQLITE_INTEGER;
+	Param.m_Int = Value;
+	m_aParams.push_back(Param);
+}
+
+void CQuery::BindFloat(double Value)
+{
+	CParam Param;
+	Param.m_Type = SQLITE_FLOAT;
+	Param.m_Float = Value;
+	m_aParams.push_back(Param);
+}
+
+void CQuery::BindText(const char *pValue)
+{
+	CParam Param;
+	Param.m_Type = SQLITE_TEXT;
+	Param.m_Text = pValue;
+	m_aParams.push_back(Param);
+}
+
+void CQuery::BindNull()
+{
+	CParam Param;
+	Param.m_Type = SQLITE_NULL;
+	m_aParams.push_back(Param);
+}
+
+bool CQuery::Bind() const
+{
+	for(unsigned i = 0; i < m_aParams.size(); i++)
+	{
+		const CParam &Param = m_aParams[i];
+		int Ret;
+		if(Param.m_Type == SQLITE_INTEGER)
+			Ret = sqlite3_bind_int64(m_pStatement, i+1, Param.m_Int);
+		else if(Param.m_Type == SQLITE_FLOAT)
+			Ret = sqlite3_bind_double(m_pStatement, i+1, Param.m_Float);
+		else if(Param.m_Type == SQLITE_TEXT)
+			Ret = sqlite3_bind_text(m_pStatement, i+1, Param.m_Text.c_str(), (int)Param.m_Text.size(), SQLITE_STATIC);
+		else
+			Ret = sqlite3_bind_null(m_pStatement, i+1);
+		if(Ret != SQLITE_OK)
+			return false;
+	}
+	return true;
+}
+
 void CQuery::OnData()
 {
 	Next();
@@ -35,8 +87,13 @@ int CQuery::GetID(const char *pName)
 CSql::CSql(const char *pFilename, bool Threaded)
 {
 	char aFilePath[768], aFullPath[1024];
-	fs_storage_path("Teeworlds", aFilePath, sizeof(aFilePath));
-	str_format(aFullPath, sizeof(aFullPath), "%s/%s", aFilePath, pFilename);
+	if(pFilename[0] == '/' || pFilename[0] == '\\' || (pFilename[0] && pFilename[1] == ':'))
+		str_copy(aFullPath, pFilename, sizeof(aFullPath));
+	else
+	{
+		fs_storage_path("Teeworlds", aFilePath, sizeof(aFilePath));
+		str_format(aFullPath, sizeof(aFullPath), "%s/%s", aFilePath, pFilename);
+	}
 	if(str_comp_nocase_num(aFullPath + str_length(aFullPath)-3, ".db", 3) != 0)
 		str_append(aFullPath, ".db", sizeof(aFullPath));
 
@@ -47,8 +104,19 @@ CSql::CSql(const char *pFilename, bool Threaded)
 	{
 		dbg_msg("SQLite", "Can't open database '%s' (%s)", pFilename, aFullPath);
 		sqlite3_close(m_pDB);
+		m_pDB = NULL;
+	}
+	else
+	{
+		// the client and lua each have their own connection, a writer waits for the other instead of failing
+		sqlite3_busy_timeout(m_pDB, BUSY_TIMEOUT_MS);
+
+		// readers don't block the writer and a commit only appends to the log instead of syncing the database twice
+		Exec("PRAGMA journal_mode=WAL;");
+		Exec("PRAGMA synchronous=NORMAL;");
 	}
 
+	mem_zero(&m_Stats, sizeof(m_Stats));
 	m_Running = true;
 	if(Threaded)
 		m_pThread = thread_init_named(InitWorker, this, "sqlite");
@@ -58,7 +126,13 @@ CSql::CSql(const char *pFilename, bool Threaded)
 
 CSql::~CSql()
 {
-	m_Running = false;
+	{
+		// under the lock, else the worker could miss the wakeup between checking and waiting
+		LOCK_SECTION_MUTEX(m_Mutex);
+		m_Running = false;
+	}
+	m_Wakeup.notify_all();
+
 	if(m_pThread)
 	{
 		{
@@ -71,19 +145,82 @@ CSql::~CSql()
 	}
 	else
 		Flush();
+
+	for(std::unordered_map<std::string, sqlite3_stmt *>::iterator it = m_Statements.begin(); it != m_Statements.end(); ++it)
+		sqlite3_finalize(it->second);
+	m_Statements.clear();
+	if(m_pDB)
+		sqlite3_close(m_pDB);
+}
+
+std::string CSql::QueueKey(const CQuery *pQuery)
+{
+	std::string Key = pQuery->m_pTemplate;
+	Key += '\n';
+	Key += pQuery->m_Key;
+	return Key;
 }
 
 void CSql::InsertQuery(CQuery *pQuery)
 {
-	LOCK_SECTION_MUTEX(m_Mutex);
-	m_lpQueries.push(pQuery);
+	bool Wakeup;
+	{
+		std::unique_lock<std::mutex> Lock(m_Mutex);
+		bool Keyed = pQuery->m_pTemplate && !pQuery->m_Key.empty();
+		bool Stalled = false;
+		while(true)
+		{
+			if(Keyed)
+			{
+				// the queued one runs with the newest values, as if both had run
+				std::unordered_map<std::string, CQuery *>::iterator it = m_QueuedKeys.find(QueueKey(pQuery));
+				if(it != m_QueuedKeys.end())
+				{
+					it->second->m_aParams.swap(pQuery->m_aParams);
+					m_Stats.m_NumCoalesced++;
+					delete pQuery;
+					return;
+				}
+			}
+			if(m_lpQueries.size() < MAX_QUEUED_QUERIES)
+				break;
+
+			// a full queue holds the caller back until the worker took the next batch, nothing is lost.
+			// without a worker the caller runs that batch itself
+			if(!Stalled)
+				m_Stats.m_NumStalls++;
+			Stalled = true;
+			if(m_pThread)
+				m_Drained.wait(Lock);
+			else
+			{
+				Lock.unlock();
+				Work();
+				Lock.lock();
+			}
+		}
+		if(Keyed)
+			m_QueuedKeys[QueueKey(pQuery)] = pQuery;
+
+		pQuery->m_QueuedTime = time_get();
+		m_lpQueries.push(pQuery);
+		m_Stats.m_PeakQueued = max(m_Stats.m_PeakQueued, (int)m_lpQueries.size());
+
+		// the worker waits for the first query and collects until a transaction is full
+		Wakeup = m_lpQueries.size() == 1 || m_lpQueries.size() == QUERIES_PER_TRANSACTION;
+	}
+	if(Wakeup)
+		m_Wakeup.notify_one();
 }
 
 void CSql::InsertQuerySync(CQuery *pQuery)
 {
 	Flush();
 	LOCK_SECTION_MUTEX(m_Mutex);
-	ExecuteQuery(pQuery);
+	{
+		LOCK_SECTION_MUTEX(m_DatabaseMutex);
+		ExecuteQuery(pQuery);
+	}
 	delete pQuery;
 }
 
@@ -97,8 +234,13 @@ void CSql::WorkerThread()
 {
 	while(true)
 	{
-		if(m_Running)
-			thread_sleep(250);
+		{
+			std::unique_lock<std::mutex> Lock(m_Mutex);
+			m_Wakeup.wait(Lock, [this]() { return !m_lpQueries.empty() || !m_Running; });
+
+			// give a burst a moment to fill the transaction, duplicates of it get coalesced meanwhile
+			m_Wakeup.wait_for(Lock, std::chrono::milliseconds(50), [this]() { return m_lpQueries.size() >= QUERIES_PER_TRANSACTION || !m_Running; });
+		}
 
 		unsigned int QueriesLeft = Work();
 
@@ -107,8 +249,90 @@ void CSql::WorkerThread()
 	}
 }
 
+sqlite3_stmt *CSql::GetStatement(const char *pTemplate)
+{
+	if(!m_pDB)
+		return NULL;
+
+	std::unordered_map<std::string, sqlite3_stmt *>::iterator it = m_Statements.find(pTemplate);
+	if(it != m_Statements.end())
+		return it->second;
+
+	sqlite3_stmt *pStatement;
+	if(sqlite3_prepare_v2(m_pDB, pTemplate, -1, &pStatement, 0) != SQLITE_OK)
+		return NULL;
+	m_Statements[pTemplate] = pStatement;
+	return pStatement;
+}
+
+bool CSql::Exec(const char *pSql)
+{
+	if(!m_pDB)
+		return false;
+
+	char *pError = NULL;
+	if(sqlite3_exec(m_pDB, pSql, 0, 0, &pError) == SQLITE_OK)
+		return true;
+
+	dbg_msg("SQLite/error", "@@ %s", pSql);
+	dbg_msg("SQLite/error", "%s", pError ? pError : sqlite3_errmsg(m_pDB));
+	sqlite3_free(pError);
+	return false;
+}
+
+bool CSql::Commit()
+{
+	// each try already waits out the busy timeout, the other connection gets more time after every one.
+	// the transaction is never left open, it would keep the other connection from writing
+	int Ret = SQLITE_OK;
+	for(int i = 0; i < COMMIT_TRIES; i++)
+	{
+		if(i > 0)
+			thread_sleep(COMMIT_BACKOFF_MS<<(i-1));
+		Ret = sqlite3_exec(m_pDB, "COMMIT;", 0, 0, 0);
+		if(Ret == SQLITE_OK)
+			return true;
+		if(Ret != SQLITE_BUSY && Ret != SQLITE_LOCKED)
+			break;
+	}
+
+	dbg_msg("SQLite/error", "@@ COMMIT;");
+	dbg_msg("SQLite/error", "%s", sqlite3_errmsg(m_pDB));
+	Exec("ROLLBACK;");
+	return false;
+}
+
 void CSql::ExecuteQuery(CQuery *pQuery)
 {
+	if(!m_pDB)
+		return;
+
+	if(pQuery->m_pTemplate)
+	{
+		pQuery->m_pStatement = GetStatement(pQuery->m_pTemplate);
+		if(pQuery->m_pStatement && pQuery->Bind())
+		{
+			pQuery->OnData();
+
+			// the statement stays cached, only its state is dropped
+			if(sqlite3_reset(pQuery->m_pStatement) != SQLITE_OK)
+			{
+				dbg_msg("SQLite/error", "@@ %s", pQuery->m_pTemplate);
+				dbg_msg("SQLite/error", "%s", sqlite3_errmsg(m_pDB));
+			}
+			sqlite3_clear_bindings(pQuery->m_pStatement);
+		}
+		else
+		{
+			dbg_msg("SQLite/error", "@@ %s", pQuery->m_pTemplate);
+			dbg_msg("SQLite/error", "%s", sqlite3_errmsg(m_pDB));
+			if(pQuery->m_pStatement)
+				sqlite3_clear_bindings(pQuery->m_pStatement);
+		}
+		pQuery->m_pStatement = NULL;
+		return;
+	}
+
 	int Ret = sqlite3_prepare_v2(m_pDB, pQuery->m_pQueryStr, -1, &pQuery->m_pStatement, 0);
 	if (Ret == SQLITE_OK)
 	{
@@ -129,37 +353,49 @@ unsigned int CSql::Work()
 	if (!m_lpQueries.empty())
 	{
 		// do 250 queries per transaction - cache them so we can release the lock as early as possible
-		enum { QUERIES_PER_TRANSACTION = 250 };
 		CQuery *apQueries[QUERIES_PER_TRANSACTION];
 		int NumQueries = 0;
 		for(int i = 0; i < QUERIES_PER_TRANSACTION && !m_lpQueries.empty(); i++)
 		{
-			apQueries[NumQueries++] = m_lpQueries.front();
+			CQuery *pQuery = m_lpQueries.front();
 			m_lpQueries.pop();
+			if(pQuery->m_pTemplate && !pQuery->m_Key.empty())
+				m_QueuedKeys.erase(QueueKey(pQuery));
+			apQueries[NumQueries++] = pQuery;
 		}
 		m_Mutex.unlock();
+		m_Drained.notify_all();
 
-		// begin transaction
-		{
-			char *pQueryStr = sqlite3_mprintf("BEGIN");
-			CQuery Begin(pQueryStr);
-			ExecuteQuery(&Begin);
-		}
-
-		// perform queries
+		// how long the oldest of them waited
+		int64 Now = time_get();
+		float MaxLatency = 0.0f;
 		for(int i = 0; i < NumQueries; i++)
-		{
-			CQuery *pQuery = apQueries[i];
-			ExecuteQuery(pQuery);
-			delete pQuery;
-		}
+			MaxLatency = max(MaxLatency, (Now-apQueries[i]->m_QueuedTime)*1000.0f/(float)time_freq());
 
-		// end transaction
 		{
-			char *pQueryStr = sqlite3_mprintf("END");
-			CQuery End(pQueryStr);
-			ExecuteQuery(&End);
+			LOCK_SECTION_MUTEX(m_DatabaseMutex);
+
+			// without a database the queries are only discarded
+			if(m_pDB)
+			{
+				// a failing query doesn't stop the others, they are committed together
+				bool Transaction = Exec("BEGIN;");
+
+				for(int i = 0; i < NumQueries; i++)
+					ExecuteQuery(apQueries[i]);
+
+				// a query may have ended the transaction itself already
+				if(Transaction && !sqlite3_get_autocommit(m_pDB) && !Commit())
+					dbg_msg("sqlite", "[%s] couldn't commit, %d queries are lost", GetDatabasePath(), NumQueries);
+			}
+
+			for(int i = 0; i < NumQueries; i++)
+				delete apQueries[i];
 		}
+
+		LOCK_SECTION_MUTEX(m_Mutex);
+		m_Stats.m_MaxLatency = MaxLatency;
+		m_Stats.m_AvgLatency = m_Stats.m_AvgLatency*0.9f + MaxLatency*0.1f;
 	}
 	else
 		m_Mutex.unlock();
@@ -182,9 +418,19 @@ void CSql::Clear()
 		delete m_lpQueries.front();
 		m_lpQueries.pop();
 	}
+	m_QueuedKeys.clear();
+}
+
+CSql::CStats CSql::GetStats()
+{
+	LOCK_SECTION_MUTEX(m_Mutex);
+	m_Stats.m_NumQueued = (int)m_lpQueries.size();
+	return m_Stats;
 }
 
 const char *CSql::GetDatabasePath() const
 {
+	if(!m_pDB)
+		return "";
 	return sqlite3_db_filename(m_pDB, "main");
 }
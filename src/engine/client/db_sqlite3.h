@@ -7,11 +7,13 @@
 #include <vector>
 #include <queue>
 #include <string>
+#include <unordered_map>
 #include <base/system.h>
 #include <base/system++/threading.h>
 #include <engine/external/sqlite3/sqlite3.h>
 #include <engine/server.h>
 #include <mutex>
+#include <condition_variable>
 #include <atomic>
 
 class CQuery
@@ -20,19 +22,53 @@ class CQuery
 	friend class CSql;
 private:
 	char *m_pQueryStr;
+	const char *m_pTemplate;
+	std::string m_Key;
+	int64 m_QueuedTime;
 
 	sqlite3_stmt *m_pStatement;
 
+	struct CParam
+	{
+		int m_Type; // SQLITE_INTEGER, SQLITE_FLOAT, SQLITE_TEXT or SQLITE_NULL
+		sqlite3_int64 m_Int;
+		double m_Float;
+		std::string m_Text;
+
+		CParam() : m_Type(0), m_Int(0), m_Float(0.0) {}
+	};
+	std::vector<CParam> m_aParams;
+
+	bool Bind() const;
+
 protected:
 	virtual void OnData();
 	bool Next();
-	const char *GetQueryString() const { return (const char *)m_pQueryStr; }
+	const char *GetQueryString() const { return m_pQueryStr ? (const char *)m_pQueryStr : m_pTemplate; }
 
 public:
-	CQuery() : m_pQueryStr(NULL), m_pStatement(NULL) {};
-	CQuery(char *pQueryBuf) : m_pQueryStr(pQueryBuf), m_pStatement(NULL) {}
+	CQuery() : m_pQueryStr(NULL), m_pTemplate(NULL), m_QueuedTime(0), m_pStatement(NULL) {};
+	CQuery(char *pQueryBuf) : m_pQueryStr(pQueryBuf), m_pTemplate(NULL), m_QueuedTime(0), m_pStatement(NULL) {}
 	virtual ~CQuery();
 
+	/**
+	 * Runs the query on a statement that is prepared once per database and kept, instead of a formatted string.
+	 * The '?' in the sql are filled with the values bound below, in order. The values are copied.
+	 * @param pTemplate the sql, has to stay valid until the query ran (i.e. a string literal)
+	 */
+	void SetTemplate(const char *pTemplate) { m_pTemplate = pTemplate; }
+	void BindInt(sqlite3_int64 Value);
+	void BindFloat(double Value);
+	void BindText(const char *pValue);
+	void BindNull();
+
+	/**
+	 * Marks a templated query as an upsert of the row named by pKey (e.g. the player name of names_v2).
+	 * A queued query with the same template and key takes over the values of a new one instead of running twice.
+	 * Only for queries whose results aren't read.
+	 */
+	void SetKey(const char *pKey) { m_Key = pKey; }
+
 	int GetColumnCount() { return sqlite3_column_count(m_pStatement); }
 	const char *GetName(int i) { return sqlite3_column_name(m_pStatement, i); }
 	int GetType(int i) { return sqlite3_column_type(m_pStatement, i); }
@@ -54,20 +90,50 @@ public:
 class CSql
 {
 	MACRO_ALLOC_HEAP_NO_INIT()
+public:
+	enum
+	{
+		QUERIES_PER_TRANSACTION=250,
+		MAX_QUEUED_QUERIES=4096,
+		BUSY_TIMEOUT_MS=1000,
+		COMMIT_TRIES=5,
+		COMMIT_BACKOFF_MS=50,
+	};
+
+	struct CStats
+	{
+		int m_NumQueued;
+		int m_PeakQueued;
+		int m_NumCoalesced;
+		int m_NumStalls; // inserts that had to wait for a full queue
+		float m_AvgLatency; // ms from queueing to execution
+		float m_MaxLatency; // of the last batch
+	};
+
 private:
 	sqlite3 *m_pDB;
 	std::mutex m_Mutex;
+	std::condition_variable m_Wakeup;
+	std::condition_variable m_Drained; // the worker took a batch off the queue
+	std::mutex m_DatabaseMutex; // held while statements run, the cached ones can't be shared
+	std::unordered_map<std::string, sqlite3_stmt *> m_Statements;
 	std::atomic_bool m_Running;
 	void * volatile m_pThread;
 	std::queue<CQuery *> m_lpQueries;
+	std::unordered_map<std::string, CQuery *> m_QueuedKeys; // the queued queries that have a key
+	CStats m_Stats;
 
 public:
+	/**
+	 * Opens the database, a relative filename is taken from the storage directory of the user
+	 */
 	CSql(const char *pFilename = "ath_data.db", bool Threaded = true);
 	~CSql();
 
 	/**
-	 * Inserts a new query into the threaded execution queue
-	 * @param pQuery pointer to the query object
+	 * Inserts a new query into the threaded execution queue and wakes the worker.
+	 * While MAX_QUEUED_QUERIES are queued this waits until the worker took the next batch
+	 * @param pQuery pointer to the query object, owned by the queue from now on (it may be deleted right away if it was coalesced)
 	 */
 	void InsertQuery(CQuery *pQuery);
 
@@ -87,7 +153,7 @@ public:
 
 	/**
 	 * Synchronously executes one round of queries (i.e. circumvents the thread!)
-	 * By default this means that 250 queries from the queue will be executed and waited for their completion.
+	 * By default this means that 250 queries from the queue will be executed in one transaction and waited for their completion.
 	 */
 	unsigned int Work();
 
@@ -96,10 +162,19 @@ public:
 	 */
 	void Clear();
 
+	/**
+	 * The queue depth and how long queries waited, for the debug hud
+	 */
+	CStats GetStats();
+
 	inline const char *GetDatabasePath() const;
 
 private:
 	void ExecuteQuery(CQuery *pQuery);
+	sqlite3_stmt *GetStatement(const char *pTemplate);
+	bool Exec(const char *pSql);
+	bool Commit();
+	static std::string QueueKey(const CQuery *pQuery);
 	void WorkerThread();
 	static void InitWorker(void *pSelf);
 };
@@ -14,6 +14,7 @@ CFriends::CFriends()
 {
 	mem_zero(m_aFriends, sizeof(m_aFriends));
 	m_NumFriends = 0;
+	m_Revision = 0;
 	m_Foes = false;
 }
 
@@ -78,38 +79,14 @@ int CFriends::GetFriendState(const char *pName, const char *pClan) const
 {
 	CALLSTACK_ADD();
 
-	int Result = FRIEND_NO;
-	unsigned NameHash = str_quickhash(pName);
-	unsigned ClanHash = str_quickhash(pClan);
-	for(int i = 0; i < m_NumFriends; ++i)
-	{
-		if((g_Config.m_ClFriendsIgnoreClan && m_aFriends[i].m_aName[0]) || (m_aFriends[i].m_ClanHash == ClanHash && !str_comp(m_aFriends[i].m_aClan, pClan)))
-		{
-			if(m_aFriends[i].m_aName[0] == 0)
-				Result = FRIEND_CLAN;
-			else if(m_aFriends[i].m_NameHash == NameHash && !str_comp(m_aFriends[i].m_aName, pName))
-			{
-				Result = FRIEND_PLAYER;
-				break;
-			}
-		}
-	}
-	return Result;
+	return m_Lookup.GetFriendState(pName, pClan, g_Config.m_ClFriendsIgnoreClan);
 }
 
 bool CFriends::IsFriend(const char *pName, const char *pClan, bool PlayersOnly) const
 {
 	CALLSTACK_ADD();
 
-	unsigned NameHash = str_quickhash(pName);
-	unsigned ClanHash = str_quickhash(pClan);
-	for(int i = 0; i < m_NumFriends; ++i)
-	{
-		if(((g_Config.m_ClFriendsIgnoreClan && m_aFriends[i].m_aName[0]) || (m_aFriends[i].m_ClanHash == ClanHash && !str_comp(m_aFriends[i].m_aClan, pClan))) &&
-			((!PlayersOnly && m_aFriends[i].m_aName[0] == 0) || (m_aFriends[i].m_NameHash == NameHash && !str_comp(m_aFriends[i].m_aName, pName))))
-			return true;
-	}
-	return false;
+	return m_Lookup.IsFriend(pName, pClan, PlayersOnly, g_Config.m_ClFriendsIgnoreClan);
 }
 
 void CFriends::AddFriend(const char *pName, const char *pClan)
@@ -133,6 +110,8 @@ void CFriends::AddFriend(const char *pName, const char *pClan)
 	m_aFriends[m_NumFriends].m_NameHash = NameHash;
 	m_aFriends[m_NumFriends].m_ClanHash = ClanHash;
 	++m_NumFriends;
+	++m_Revision;
+	m_Lookup.Build(m_aFriends, m_NumFriends);
 }
 
 void CFriends::RemoveFriend(const char *pName, const char *pClan)
@@ -160,6 +139,8 @@ void CFriends::RemoveFriend(int Index)
 	{
 		mem_move(&m_aFriends[Index], &m_aFriends[Index+1], sizeof(CFriendInfo)*(m_NumFriends-(Index+1)));
 		--m_NumFriends;
+		++m_Revision;
+		m_Lookup.Build(m_aFriends, m_NumFriends);
 	}
 }
 
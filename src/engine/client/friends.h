@@ -5,11 +5,15 @@
 
 #include <engine/friends.h>
 
+#include "friends_lookup.h"
+
 class CFriends : public IFriends
 {
 	CFriendInfo m_aFriends[MAX_FRIENDS];
 	int m_Foes;
 	int m_NumFriends;
+	int m_Revision;
+	CFriendsLookup m_Lookup;
 
 	static void ConAddFriend(IConsole::IResult *pResult, void *pUserData);
 	static void ConRemoveFriend(IConsole::IResult *pResult, void *pUserData);
@@ -26,6 +30,7 @@ public:
 	const CFriendInfo *GetFriend(int Index) const;
 	int GetFriendState(const char *pName, const char *pClan) const;
 	bool IsFriend(const char *pName, const char *pClan, bool PlayersOnly) const;
+	int Revision() const { return m_Revision; }
 
 	void AddFriend(const char *pName, const char *pClan);
 	void RemoveFriend(const char *pName, const char *pClan);
@@ -0,0 +1,105 @@
+#ifndef ENGINE_CLIENT_FRIENDS_LOOKUP_H
+#define ENGINE_CLIENT_FRIENDS_LOOKUP_H
+
+#include <base/system.h>
+#include <engine/friends.h>
+
+// the friends by their name and clan hashes, rebuilt when the list changes, so marking the players of a
+// server costs one lookup per player instead of a pass over the list
+class CFriendsLookup
+{
+public:
+	CFriendsLookup() : m_pFriends(0) { Build(0, 0); }
+
+	void Build(const CFriendInfo *pFriends, int NumFriends)
+	{
+		m_pFriends = pFriends;
+		m_PlayerTable.Clear();
+		m_NameTable.Clear();
+		m_ClanTable.Clear();
+		for(int i = 0; i < NumFriends; i++)
+		{
+			if(pFriends[i].m_aName[0])
+			{
+				m_PlayerTable.Add(PlayerHash(pFriends[i].m_NameHash, pFriends[i].m_ClanHash), i);
+				m_NameTable.Add(pFriends[i].m_NameHash, i);
+			}
+			else
+				m_ClanTable.Add(pFriends[i].m_ClanHash, i);
+		}
+	}
+
+	// with IgnoreClan a friend with a name matches the name in any clan. friends without a name match their whole clan
+	int GetFriendState(const char *pName, const char *pClan, bool IgnoreClan) const
+	{
+		unsigned NameHash = str_quickhash(pName);
+		unsigned ClanHash = str_quickhash(pClan);
+		if(FindPlayer(pName, pClan, NameHash, ClanHash, IgnoreClan))
+			return IFriends::FRIEND_PLAYER;
+		if(FindClan(pClan, ClanHash))
+			return IFriends::FRIEND_CLAN;
+		return IFriends::FRIEND_NO;
+	}
+
+	bool IsFriend(const char *pName, const char *pClan, bool PlayersOnly, bool IgnoreClan) const
+	{
+		unsigned NameHash = str_quickhash(pName);
+		unsigned ClanHash = str_quickhash(pClan);
+		return FindPlayer(pName, pClan, NameHash, ClanHash, IgnoreClan) || (!PlayersOnly && FindClan(pClan, ClanHash));
+	}
+
+private:
+	enum
+	{
+		TABLE_SIZE=IFriends::MAX_FRIENDS*2,
+	};
+
+	// friend indices chained per bucket
+	struct CTable
+	{
+		int m_aFirst[TABLE_SIZE];
+		int m_aNext[IFriends::MAX_FRIENDS];
+
+		void Clear() { mem_set(m_aFirst, -1, sizeof(m_aFirst)); }
+		void Add(unsigned Hash, int Index)
+		{
+			m_aNext[Index] = m_aFirst[Hash%TABLE_SIZE];
+			m_aFirst[Hash%TABLE_SIZE] = Index;
+		}
+		int First(unsigned Hash) const { return m_aFirst[Hash%TABLE_SIZE]; }
+		int Next(int Index) const { return m_aNext[Index]; }
+	};
+
+	const CFriendInfo *m_pFriends;
+	CTable m_PlayerTable; // by name and clan
+	CTable m_NameTable; // by name, for cl_friends_ignore_clan
+	CTable m_ClanTable; // the friends without a name, by clan
+
+	static unsigned PlayerHash(unsigned NameHash, unsigned ClanHash) { return NameHash*31+ClanHash; }
+
+	bool FindPlayer(const char *pName, const char *pClan, unsigned NameHash, unsigned ClanHash, bool IgnoreClan) const
+	{
+		if(IgnoreClan)
+		{
+			for(int i = m_NameTable.First(NameHash); i >= 0; i = m_NameTable.Next(i))
+				if(m_pFriends[i].m_NameHash == NameHash && !str_comp(m_pFriends[i].m_aName, pName))
+					return true;
+			return false;
+		}
+
+		for(int i = m_PlayerTable.First(PlayerHash(NameHash, ClanHash)); i >= 0; i = m_PlayerTable.Next(i))
+			if(m_pFriends[i].m_NameHash == NameHash && m_pFriends[i].m_ClanHash == ClanHash && !str_comp(m_pFriends[i].m_aName, pName) && !str_comp(m_pFriends[i].m_aClan, pClan))
+				return true;
+		return false;
+	}
+
+	bool FindClan(const char *pClan, unsigned ClanHash) const
+	{
+		for(int i = m_ClanTable.First(ClanHash); i >= 0; i = m_ClanTable.Next(i))
+			if(m_pFriends[i].m_ClanHash == ClanHash && !str_comp(m_pFriends[i].m_aClan, pClan))
+				return true;
+		return false;
+	}
+};
+
+#endif
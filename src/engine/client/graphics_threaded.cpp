@@ -17,12 +17,14 @@
 #include <engine/storage.h>
 #include <engine/keys.h>
 #include <engine/console.h>
+#include <engine/engine.h>
 
 #include <math.h> // cosf, sinf
 
 // lua
 #include <lua.hpp>
 #include "graphics_threaded.h"
+#include "image_cache.h"
 #include "luabinding.h"
 
 static CVideoMode g_aFakeModes[] = {
@@ -55,7 +57,6 @@ void CGraphics_Threaded::FlushVertices()
 		return;
 
 	int NumVerts = m_NumVertices;
-	m_NumVertices = 0;
 
 	CCommandBuffer::SCommand_Render Cmd;
 	Cmd.m_State = m_State;
@@ -79,50 +80,60 @@ void CGraphics_Threaded::FlushVertices()
 		Cmd.m_PrimCount = NumVerts/2;
 	}
 	else
-		return;
-
-	Cmd.m_pVertices = (CCommandBuffer::SVertex *)m_pCommandBuffer->AllocData(sizeof(CCommandBuffer::SVertex)*NumVerts);
-	if(Cmd.m_pVertices == 0x0)
 	{
-		// kick command buffer and try again
-		KickCommandBuffer();
-
-		Cmd.m_pVertices = (CCommandBuffer::SVertex *)m_pCommandBuffer->AllocData(sizeof(CCommandBuffer::SVertex)*NumVerts);
-		if(Cmd.m_pVertices == 0x0)
-		{
-			dbg_msg("graphics", "failed to allocate data for vertices");
-			return;
-		}
+		m_NumVertices = 0;
+		return;
 	}
 
 	// check if we have enough free memory in the commandbuffer
+	Cmd.m_pVertices = m_pVertices;
 	if(!m_pCommandBuffer->AddCommand(Cmd))
 	{
-		// kick command buffer and try again
+		// kick command buffer and try again, the vertices move along
 		KickCommandBuffer();
+		m_NumFullKicks++;
 
-		Cmd.m_pVertices = (CCommandBuffer::SVertex *)m_pCommandBuffer->AllocData(sizeof(CCommandBuffer::SVertex)*NumVerts);
-		if(Cmd.m_pVertices == 0x0)
-		{
-			dbg_msg("graphics", "failed to allocate data for vertices");
-			return;
-		}
-
+		Cmd.m_pVertices = m_pVertices;
 		if(!m_pCommandBuffer->AddCommand(Cmd))
 		{
 			dbg_msg("graphics", "failed to allocate memory for render command");
+			m_NumVertices = 0;
 			return;
 		}
 	}
 
-	mem_copy(Cmd.m_pVertices, m_aVertices, sizeof(CCommandBuffer::SVertex)*NumVerts);
+	// the vertices are already in place, just claim them
+	m_pCommandBuffer->AllocData(sizeof(CCommandBuffer::SVertex)*NumVerts);
+	m_NumVertices = 0;
+	m_NumFlushes++;
+	m_NumStreamedVertices += NumVerts;
+	UpdateVertexWindow();
+}
+
+void CGraphics_Threaded::UpdateVertexWindow()
+{
+	m_pVertices = (CCommandBuffer::SVertex *)m_pCommandBuffer->m_DataBuffer.FreePtr();
+	m_MaxVertices = min((int)(m_pCommandBuffer->m_DataBuffer.FreeSize()/sizeof(CCommandBuffer::SVertex)), (int)MAX_VERTICES);
+}
+
+void CGraphics_Threaded::ReserveVertices(int Count)
+{
+	if(m_NumVertices + Count <= m_MaxVertices)
+		return;
+
+	FlushVertices();
+	if(Count > m_MaxVertices)
+	{
+		// the data buffer is full, continue in the next one
+		KickCommandBuffer();
+		m_NumFullKicks++;
+	}
+	dbg_assert(Count <= m_MaxVertices, "too many vertices in one draw call");
 }
 
 void CGraphics_Threaded::AddVertices(int Count)
 {
 	m_NumVertices += Count;
-	if((m_NumVertices + Count) >= MAX_VERTICES)
-		FlushVertices();
 }
 
 void CGraphics_Threaded::Rotate(const CCommandBuffer::SPoint &rCenter, CCommandBuffer::SVertex *pPoints, int NumPoints)
@@ -158,8 +169,19 @@ CGraphics_Threaded::CGraphics_Threaded()
 	m_pCommandBuffer = 0x0;
 	m_apCommandBuffers[0] = 0x0;
 	m_apCommandBuffers[1] = 0x0;
+	m_CmdBufferSize = CMDBUFFER_SIZE;
+	m_DataBufferSize = DATABUFFER_SIZE;
+	m_NumFullKicks = 0;
 
+	m_pVertices = 0x0;
 	m_NumVertices = 0;
+	m_MaxVertices = 0;
+	m_NumStreamedVertices = 0;
+	m_NumFlushes = 0;
+	m_NumKicks = 0;
+	m_BytesCopied = 0;
+	m_NumImagesDecoded = 0;
+	m_NumImagesFromCache = 0;
 
 	m_ScreenWidth = -1;
 	m_ScreenHeight = -1;
@@ -229,6 +251,17 @@ int CGraphics_Threaded::MemoryUsage() const
 	return m_pBackend->MemoryUsage();
 }
 
+void CGraphics_Threaded::GetStats(CGraphicsStats *pStats) const
+{
+	m_pBackend->GetStats(pStats);
+	pStats->m_NumStreamedVertices = m_NumStreamedVertices;
+	pStats->m_NumFlushes = m_NumFlushes;
+	pStats->m_NumKicks = m_NumKicks;
+	pStats->m_BytesCopied = m_BytesCopied;
+	pStats->m_NumImagesDecoded = m_NumImagesDecoded;
+	pStats->m_NumImagesFromCache = m_NumImagesFromCache;
+}
+
 void CGraphics_Threaded::MapScreen(float TopLeftX, float TopLeftY, float BottomRightX, float BottomRightY)
 {
 	m_State.m_ScreenTL.x = TopLeftX;
@@ -262,18 +295,19 @@ void CGraphics_Threaded::LinesEnd()
 void CGraphics_Threaded::LinesDraw(const CLineItem *pArray, int Num)
 {
 	dbg_assert(m_Drawing == DRAWING_LINES, "called Graphics()->LinesDraw without begin");
+	ReserveVertices(2*Num);
 
 	for(int i = 0; i < Num; ++i)
 	{
-		m_aVertices[m_NumVertices + 2*i].m_Pos.x = pArray[i].m_X0;
-		m_aVertices[m_NumVertices + 2*i].m_Pos.y = pArray[i].m_Y0;
-		m_aVertices[m_NumVertices + 2*i].m_Tex = m_aTexture[0];
-		m_aVertices[m_NumVertices + 2*i].m_Color = m_aColor[0];
-
-		m_aVertices[m_NumVertices + 2*i + 1].m_Pos.x = pArray[i].m_X1;
-		m_aVertices[m_NumVertices + 2*i + 1].m_Pos.y = pArray[i].m_Y1;
-		m_aVertices[m_NumVertices + 2*i + 1].m_Tex = m_aTexture[1];
-		m_aVertices[m_NumVertices + 2*i + 1].m_Color = m_aColor[1];
+		m_pVertices[m_NumVertices + 2*i].m_Pos.x = pArray[i].m_X0;
+		m_pVertices[m_NumVertices + 2*i].m_Pos.y = pArray[i].m_Y0;
+		m_pVertices[m_NumVertices + 2*i].m_Tex = m_aTexture[0];
+		m_pVertices[m_NumVertices + 2*i].m_Color = m_aColor[0];
+
+		m_pVertices[m_NumVertices + 2*i + 1].m_Pos.x = pArray[i].m_X1;
+		m_pVertices[m_NumVertices + 2*i + 1].m_Pos.y = pArray[i].m_Y1;
+		m_pVertices[m_NumVertices + 2*i + 1].m_Tex = m_aTexture[1];
+		m_pVertices[m_NumVertices + 2*i + 1].m_Color = m_aColor[1];
 	}
 
 	AddVertices(2*Num);
@@ -475,43 +509,100 @@ int CGraphics_Threaded::LoadTextureLuaSimple(const char *pFilename, lua_State *L
 	return TexID;
 }
 
+struct CPNGReadBuffer
+{
+	const unsigned char *m_pData;
+	unsigned m_Size;
+	unsigned m_Pos;
+};
+
+static unsigned PNGReadCallback(void *pOutput, unsigned long Size, unsigned long Numel, void *pUser)
+{
+	CPNGReadBuffer *pBuffer = (CPNGReadBuffer *)pUser;
+	unsigned Bytes = min((unsigned)(Size*Numel), pBuffer->m_Size - pBuffer->m_Pos);
+	if(pOutput) // no output means skip
+		mem_copy(pOutput, pBuffer->m_pData + pBuffer->m_Pos, Bytes);
+	pBuffer->m_Pos += Bytes;
+	return Size ? Bytes/Size : 0;
+}
+
 int CGraphics_Threaded::LoadPNG(CImageInfo *pImg, const char *pFilename, int StorageType)
 {
 	char aCompleteFilename[512];
-	unsigned char *pBuffer;
-	png_t Png; // ignore_convention
-
-	// open file for reading
-	png_init(0,0); // ignore_convention
 
+	// read the whole file, it is hashed before anything gets decoded
 	IOHANDLE File = m_pStorage->OpenFile(pFilename, IOFLAG_READ, StorageType, aCompleteFilename, sizeof(aCompleteFilename));
-	if(File)
-		io_close(File);
-	else
+	if(!File)
 	{
 		dbg_msg("game/png", "failed to open file. filename='%s'", pFilename);
 		return 0;
 	}
 
-	int Error = png_open_file(&Png, aCompleteFilename); // ignore_convention
-	if(Error != PNG_NO_ERROR)
+	unsigned FileSize = (unsigned)io_length(File);
+	unsigned char *pFileData = (unsigned char *)mem_alloc(max(FileSize, 1u), 1);
+	unsigned ReadSize = io_read(File, pFileData, FileSize);
+	io_close(File);
+	if(ReadSize != FileSize)
 	{
-		dbg_msg("game/png", "failed to open file. filename='%s'", aCompleteFilename);
-		if(Error != PNG_FILE_ERROR)
-			png_close_file(&Png); // ignore_convention
+		dbg_msg("game/png", "failed to read file. filename='%s'", aCompleteFilename);
+		mem_free(pFileData);
+		return 0;
+	}
+
+	char aCacheFile[64] = {0};
+	if(g_Config.m_GfxImageCache)
+	{
+		MD5_HASH Hash = md5_simple(pFileData, FileSize);
+		char aHash[33];
+		str_hex_simple(aHash, sizeof(aHash), Hash.digest, sizeof(Hash.digest));
+		str_format(aCacheFile, sizeof(aCacheFile), "tmp/cache/images/%s.img", aHash);
+		if(LoadCachedImage(pImg, aCacheFile))
+		{
+			mem_free(pFileData);
+			m_NumImagesFromCache++;
+			return 1;
+		}
+	}
+
+	int Result = DecodePNG(pImg, pFileData, FileSize, aCompleteFilename);
+	mem_free(pFileData);
+	if(Result)
+	{
+		m_NumImagesDecoded++;
+		if(aCacheFile[0])
+			SaveCachedImage(pImg, aCacheFile);
+	}
+	return Result;
+}
+
+int CGraphics_Threaded::DecodePNG(CImageInfo *pImg, const unsigned char *pData, unsigned DataSize, const char *pFilename)
+{
+	png_t Png; // ignore_convention
+	png_init(0,0); // ignore_convention
+
+	CPNGReadBuffer Buffer;
+	Buffer.m_pData = pData;
+	Buffer.m_Size = DataSize;
+	Buffer.m_Pos = 0;
+	if(png_open(&Png, PNGReadCallback, &Buffer) != PNG_NO_ERROR) // ignore_convention
+	{
+		dbg_msg("game/png", "failed to open file. filename='%s'", pFilename);
 		return 0;
 	}
 
 	if(Png.depth != 8 || (Png.color_type != PNG_TRUECOLOR && Png.color_type != PNG_TRUECOLOR_ALPHA)) // ignore_convention
 	{
-		dbg_msg("game/png", "invalid format. filename='%s'", aCompleteFilename);
-		png_close_file(&Png); // ignore_convention
+		dbg_msg("game/png", "invalid format. filename='%s'", pFilename);
 		return 0;
 	}
 
-	pBuffer = (unsigned char *)mem_alloc(Png.width * Png.height * Png.bpp, 1); // ignore_convention
-	png_get_data(&Png, pBuffer); // ignore_convention
-	png_close_file(&Png); // ignore_convention
+	unsigned char *pBuffer = (unsigned char *)mem_alloc(Png.width * Png.height * Png.bpp, 1); // ignore_convention
+	if(png_get_data(&Png, pBuffer) != PNG_NO_ERROR) // ignore_convention
+	{
+		dbg_msg("game/png", "failed to decode file. filename='%s'", pFilename);
+		mem_free(pBuffer);
+		return 0;
+	}
 
 	pImg->m_Width = Png.width; // ignore_convention
 	pImg->m_Height = Png.height; // ignore_convention
@@ -523,14 +614,56 @@ int CGraphics_Threaded::LoadPNG(CImageInfo *pImg, const char *pFilename, int Sto
 	return 1;
 }
 
+bool CGraphics_Threaded::LoadCachedImage(CImageInfo *pImg, const char *pCacheFile)
+{
+	IOHANDLE File = m_pStorage->OpenFile(pCacheFile, IOFLAG_READ, IStorageTW::TYPE_SAVE);
+	if(!File)
+		return false;
+	bool Success = CImageCache::Load(File, pImg);
+	io_close(File);
+	return Success;
+}
+
+void CGraphics_Threaded::SaveCachedImage(const CImageInfo *pImg, const char *pCacheFile)
+{
+	IOHANDLE File = m_pStorage->OpenFile(pCacheFile, IOFLAG_WRITE, IStorageTW::TYPE_SAVE);
+	if(!File)
+		return;
+	CImageCache::Save(File, pImg);
+	io_close(File);
+}
+
+int CGraphics_Threaded::PruneImageCacheJob(void *pUser)
+{
+	CGraphics_Threaded *pSelf = (CGraphics_Threaded *)pUser;
+	int NumRemoved = CImageCache::Prune(pSelf->m_aImageCacheDir, (int64)g_Config.m_GfxImageCacheSize*1024*1024);
+	if(NumRemoved)
+		dbg_msg("gfx", "removed %d images from the image cache", NumRemoved);
+	return 0;
+}
+
 void CGraphics_Threaded::KickCommandBuffer()
 {
+	const CCommandBuffer::SVertex *pPendingVertices = m_pVertices;
 	m_pBackend->RunBuffer(m_pCommandBuffer);
+	m_NumKicks++;
 
-	// swap buffer
+	// swap buffer, the backend is done with the other one
 	m_CurrentCommandBuffer ^= 1;
 	m_pCommandBuffer = m_apCommandBuffers[m_CurrentCommandBuffer];
-	m_pCommandBuffer->Reset();
+	if(m_pCommandBuffer->m_DataBuffer.DataSize() < m_DataBufferSize)
+		m_pCommandBuffer->Resize(m_CmdBufferSize, m_DataBufferSize);
+	else
+		m_pCommandBuffer->Reset();
+	UpdateVertexWindow();
+
+	// vertices that are written but not flushed yet are the only ones that get copied
+	if(m_NumVertices)
+	{
+		unsigned Size = sizeof(CCommandBuffer::SVertex)*m_NumVertices;
+		mem_copy(m_pVertices, pPendingVertices, Size);
+		m_BytesCopied += Size;
+	}
 }
 
 void CGraphics_Threaded::ScreenshotDirect()
@@ -666,6 +799,85 @@ void CGraphics_Threaded::SetColorLua(float r, float g, float b, float a, lua_Sta
 	SetColor(r, g, b, a);
 }
 
+template<class T>
+void CGraphics_Threaded::AddCommandOrKick(const T &Command)
+{
+	if(!m_pCommandBuffer->AddCommand(Command))
+	{
+		// kick command buffer and try again
+		KickCommandBuffer();
+		if(!m_pCommandBuffer->AddCommand(Command))
+			dbg_msg("graphics", "failed to allocate memory for command");
+	}
+}
+
+int CGraphics_Threaded::CreateQuadBuffer(const CQuadVertex *pVertices, int NumQuads)
+{
+	static_assert(sizeof(CQuadVertex) == sizeof(CCommandBuffer::SQuadVertex), "the vertices are copied as they are");
+	if(m_FirstFreeQuadBuffer < 0 || NumQuads <= 0)
+		return -1;
+
+	// grab a slot
+	int Slot = m_FirstFreeQuadBuffer;
+	m_FirstFreeQuadBuffer = m_aQuadBufferIndices[Slot];
+	m_aQuadBufferIndices[Slot] = -1;
+
+	CCommandBuffer::SCommand_QuadBuffer_Create Cmd;
+	Cmd.m_Slot = Slot;
+	Cmd.m_NumQuads = NumQuads;
+	Cmd.m_pVertices = (CCommandBuffer::SQuadVertex *)mem_alloc(sizeof(CCommandBuffer::SQuadVertex)*4*NumQuads, sizeof(void*));
+	mem_copy(Cmd.m_pVertices, pVertices, sizeof(CCommandBuffer::SQuadVertex)*4*NumQuads);
+	AddCommandOrKick(Cmd);
+
+	return Slot;
+}
+
+void CGraphics_Threaded::UpdateQuadBuffer(int BufferID, int FirstQuad, const CQuadVertex *pVertices, int NumQuads)
+{
+	if(BufferID < 0 || NumQuads <= 0)
+		return;
+
+	CCommandBuffer::SCommand_QuadBuffer_Update Cmd;
+	Cmd.m_Slot = BufferID;
+	Cmd.m_FirstQuad = FirstQuad;
+	Cmd.m_NumQuads = NumQuads;
+	Cmd.m_pVertices = (CCommandBuffer::SQuadVertex *)mem_alloc(sizeof(CCommandBuffer::SQuadVertex)*4*NumQuads, sizeof(void*));
+	mem_copy(Cmd.m_pVertices, pVertices, sizeof(CCommandBuffer::SQuadVertex)*4*NumQuads);
+	AddCommandOrKick(Cmd);
+}
+
+void CGraphics_Threaded::DeleteQuadBuffer(int BufferID)
+{
+	if(BufferID < 0)
+		return;
+
+	CCommandBuffer::SCommand_QuadBuffer_Destroy Cmd;
+	Cmd.m_Slot = BufferID;
+	AddCommandOrKick(Cmd);
+
+	m_aQuadBufferIndices[BufferID] = m_FirstFreeQuadBuffer;
+	m_FirstFreeQuadBuffer = BufferID;
+}
+
+void CGraphics_Threaded::RenderQuadBuffer(int BufferID, int FirstQuad, int NumQuads, float r, float g, float b, float a)
+{
+	dbg_assert(m_Drawing == 0, "called Graphics()->RenderQuadBuffer within begin");
+	if(BufferID < 0 || NumQuads <= 0)
+		return;
+
+	// gfx_quad_as_triangle is left out here, the whole quad has one color anyway
+	CCommandBuffer::SCommand_RenderQuadBuffer Cmd;
+	Cmd.m_State = m_State;
+	Cmd.m_Color.r = r;
+	Cmd.m_Color.g = g;
+	Cmd.m_Color.b = b;
+	Cmd.m_Color.a = a;
+	Cmd.m_Slot = BufferID;
+	Cmd.m_FirstQuad = FirstQuad;
+	Cmd.m_PrimCount = NumQuads;
+	AddCommandOrKick(Cmd);
+}
+
 void CGraphics_Threaded::QuadsSetSubset(float TlU, float TlV, float BrU, float BrV)
 {
 	dbg_assert(m_Drawing == DRAWING_QUADS, "called Graphics()->QuadsSetSubset without begin");
@@ -771,49 +983,50 @@ void CGraphics_Threaded::QuadsDrawTL(const CQuadItem *pArray, int Num)
 
 	if(g_Config.m_GfxQuadAsTriangle)
 	{
+		ReserveVertices(3*2*Num);
 		for(int i = 0; i < Num; ++i)
 		{
 			const IGraphics::CQuadItem &Source = pArray[i];
 			int BaseIndex = m_NumVertices + 6*i;
 
 			// first triangle
-			m_aVertices[BaseIndex].m_Pos.x = Source.m_X;
-			m_aVertices[BaseIndex].m_Pos.y = Source.m_Y;
-			m_aVertices[BaseIndex].m_Tex = m_aTexture[0];
-			m_aVertices[BaseIndex].m_Color = m_aColor[0];
+			m_pVertices[BaseIndex].m_Pos.x = Source.m_X;
+			m_pVertices[BaseIndex].m_Pos.y = Source.m_Y;
+			m_pVertices[BaseIndex].m_Tex = m_aTexture[0];
+			m_pVertices[BaseIndex].m_Color = m_aColor[0];
 
-			m_aVertices[BaseIndex + 1].m_Pos.x = Source.m_X + Source.m_Width;
-			m_aVertices[BaseIndex + 1].m_Pos.y = Source.m_Y;
-			m_aVertices[BaseIndex + 1].m_Tex = m_aTexture[1];
-			m_aVertices[BaseIndex + 1].m_Color = m_aColor[1];
+			m_pVertices[BaseIndex + 1].m_Pos.x = Source.m_X + Source.m_Width;
+			m_pVertices[BaseIndex + 1].m_Pos.y = Source.m_Y;
+			m_pVertices[BaseIndex + 1].m_Tex = m_aTexture[1];
+			m_pVertices[BaseIndex + 1].m_Color = m_aColor[1];
 
-			m_aVertices[BaseIndex + 2].m_Pos.x = Source.m_X + Source.m_Width;
-			m_aVertices[BaseIndex + 2].m_Pos.y = Source.m_Y + Source.m_Height;
-			m_aVertices[BaseIndex + 2].m_Tex = m_aTexture[2];
-			m_aVertices[BaseIndex + 2].m_Color = m_aColor[2];
+			m_pVertices[BaseIndex + 2].m_Pos.x = Source.m_X + Source.m_Width;
+			m_pVertices[BaseIndex + 2].m_Pos.y = Source.m_Y + Source.m_Height;
+			m_pVertices[BaseIndex + 2].m_Tex = m_aTexture[2];
+			m_pVertices[BaseIndex + 2].m_Color = m_aColor[2];
 
 			// second triangle
-			m_aVertices[BaseIndex + 3].m_Pos.x = Source.m_X;
-			m_aVertices[BaseIndex + 3].m_Pos.y = Source.m_Y;
-			m_aVertices[BaseIndex + 3].m_Tex = m_aTexture[0];
-			m_aVertices[BaseIndex + 3].m_Color = m_aColor[0];
+			m_pVertices[BaseIndex + 3].m_Pos.x = Source.m_X;
+			m_pVertices[BaseIndex + 3].m_Pos.y = Source.m_Y;
+			m_pVertices[BaseIndex + 3].m_Tex = m_aTexture[0];
+			m_pVertices[BaseIndex + 3].m_Color = m_aColor[0];
 
-			m_aVertices[BaseIndex + 4].m_Pos.x = Source.m_X + Source.m_Width;
-			m_aVertices[BaseIndex + 4].m_Pos.y = Source.m_Y + Source.m_Height;
-			m_aVertices[BaseIndex + 4].m_Tex = m_aTexture[2];
-			m_aVertices[BaseIndex + 4].m_Color = m_aColor[2];
+			m_pVertices[BaseIndex + 4].m_Pos.x = Source.m_X + Source.m_Width;
+			m_pVertices[BaseIndex + 4].m_Pos.y = Source.m_Y + Source.m_Height;
+			m_pVertices[BaseIndex + 4].m_Tex = m_aTexture[2];
+			m_pVertices[BaseIndex + 4].m_Color = m_aColor[2];
 
-			m_aVertices[BaseIndex + 5].m_Pos.x = Source.m_X;
-			m_aVertices[BaseIndex + 5].m_Pos.y = Source.m_Y + Source.m_Height;
-			m_aVertices[BaseIndex + 5].m_Tex = m_aTexture[3];
-			m_aVertices[BaseIndex + 5].m_Color = m_aColor[3];
+			m_pVertices[BaseIndex + 5].m_Pos.x = Source.m_X;
+			m_pVertices[BaseIndex + 5].m_Pos.y = Source.m_Y + Source.m_Height;
+			m_pVertices[BaseIndex + 5].m_Tex = m_aTexture[3];
+			m_pVertices[BaseIndex + 5].m_Color = m_aColor[3];
 
 			if(m_Rotation != 0)
 			{
 				Center.x = Source.m_X + Source.m_Width/2;
 				Center.y = Source.m_Y + Source.m_Height/2;
 
-				Rotate(Center, &m_aVertices[BaseIndex], 6);
+				Rotate(Center, &m_pVertices[BaseIndex], 6);
 			}
 		}
 
@@ -821,37 +1034,38 @@ void CGraphics_Threaded::QuadsDrawTL(const CQuadItem *pArray, int Num)
 	}
 	else
 	{
+		ReserveVertices(4*Num);
 		for(int i = 0; i < Num; ++i)
 		{
 			const IGraphics::CQuadItem &Source = pArray[i];
 			int BaseIndex = m_NumVertices + 4*i;
 
-			m_aVertices[BaseIndex].m_Pos.x = Source.m_X;
-			m_aVertices[BaseIndex].m_Pos.y = Source.m_Y;
-			m_aVertices[BaseIndex].m_Tex = m_aTexture[0];
-			m_aVertices[BaseIndex].m_Color = m_aColor[0];
+			m_pVertices[BaseIndex].m_Pos.x = Source.m_X;
+			m_pVertices[BaseIndex].m_Pos.y = Source.m_Y;
+			m_pVertices[BaseIndex].m_Tex = m_aTexture[0];
+			m_pVertices[BaseIndex].m_Color = m_aColor[0];
 
-			m_aVertices[BaseIndex + 1].m_Pos.x = Source.m_X + Source.m_Width;
-			m_aVertices[BaseIndex + 1].m_Pos.y = Source.m_Y;
-			m_aVertices[BaseIndex + 1].m_Tex = m_aTexture[1];
-			m_aVertices[BaseIndex + 1].m_Color = m_aColor[1];
+			m_pVertices[BaseIndex + 1].m_Pos.x = Source.m_X + Source.m_Width;
+			m_pVertices[BaseIndex + 1].m_Pos.y = Source.m_Y;
+			m_pVertices[BaseIndex + 1].m_Tex = m_aTexture[1];
+			m_pVertices[BaseIndex + 1].m_Color = m_aColor[1];
 
-			m_aVertices[BaseIndex + 2].m_Pos.x = Source.m_X + Source.m_Width;
-			m_aVertices[BaseIndex + 2].m_Pos.y = Source.m_Y + Source.m_Height;
-			m_aVertices[BaseIndex + 2].m_Tex = m_aTexture[2];
-			m_aVertices[BaseIndex + 2].m_Color = m_aColor[2];
+			m_pVertices[BaseIndex + 2].m_Pos.x = Source.m_X + Source.m_Width;
+			m_pVertices[BaseIndex + 2].m_Pos.y = Source.m_Y + Source.m_Height;
+			m_pVertices[BaseIndex + 2].m_Tex = m_aTexture[2];
+			m_pVertices[BaseIndex + 2].m_Color = m_aColor[2];
 
-			m_aVertices[BaseIndex + 3].m_Pos.x = Source.m_X;
-			m_aVertices[BaseIndex + 3].m_Pos.y = Source.m_Y + Source.m_Height;
-			m_aVertices[BaseIndex + 3].m_Tex = m_aTexture[3];
-			m_aVertices[BaseIndex + 3].m_Color = m_aColor[3];
+			m_pVertices[BaseIndex + 3].m_Pos.x = Source.m_X;
+			m_pVertices[BaseIndex + 3].m_Pos.y = Source.m_Y + Source.m_Height;
+			m_pVertices[BaseIndex + 3].m_Tex = m_aTexture[3];
+			m_pVertices[BaseIndex + 3].m_Color = m_aColor[3];
 
 			if(m_Rotation != 0)
 			{
 				Center.x = Source.m_X + Source.m_Width/2;
 				Center.y = Source.m_Y + Source.m_Height/2;
 
-				Rotate(Center, &m_aVertices[m_NumVertices + 4*i], 4);
+				Rotate(Center, &m_pVertices[m_NumVertices + 4*i], 4);
 			}
 		}
 
@@ -865,76 +1079,139 @@ void CGraphics_Threaded::QuadsDrawFreeform(const CFreeformItem *pArray, int Num)
 
 	if(g_Config.m_GfxQuadAsTriangle)
 	{
+		ReserveVertices(3*2*Num);
 		for(int i = 0; i < Num; ++i)
 		{
 			const IGraphics::CFreeformItem &Source = pArray[i];
 			int BaseIndex = m_NumVertices + 6*i;
 
-			m_aVertices[BaseIndex].m_Pos.x = Source.m_X0;
-			m_aVertices[BaseIndex].m_Pos.y = Source.m_Y0;
-			m_aVertices[BaseIndex].m_Tex = m_aTexture[0];
-			m_aVertices[BaseIndex].m_Color = m_aColor[0];
-
-			m_aVertices[BaseIndex + 1].m_Pos.x = Source.m_X1;
-			m_aVertices[BaseIndex + 1].m_Pos.y = Source.m_Y1;
-			m_aVertices[BaseIndex + 1].m_Tex = m_aTexture[1];
-			m_aVertices[BaseIndex + 1].m_Color = m_aColor[1];
-
-			m_aVertices[BaseIndex + 2].m_Pos.x = Source.m_X3;
-			m_aVertices[BaseIndex + 2].m_Pos.y = Source.m_Y3;
-			m_aVertices[BaseIndex + 2].m_Tex = m_aTexture[3];
-			m_aVertices[BaseIndex + 2].m_Color = m_aColor[3];
-
-			m_aVertices[BaseIndex + 3].m_Pos.x = Source.m_X0;
-			m_aVertices[BaseIndex + 3].m_Pos.y = Source.m_Y0;
-			m_aVertices[BaseIndex + 3].m_Tex = m_aTexture[0];
-			m_aVertices[BaseIndex + 3].m_Color = m_aColor[0];
-
-			m_aVertices[BaseIndex + 4].m_Pos.x = Source.m_X3;
-			m_aVertices[BaseIndex + 4].m_Pos.y = Source.m_Y3;
-			m_aVertices[BaseIndex + 4].m_Tex = m_aTexture[3];
-			m_aVertices[BaseIndex + 4].m_Color = m_aColor[3];
-
-			m_aVertices[BaseIndex + 5].m_Pos.x = Source.m_X2;
-			m_aVertices[BaseIndex + 5].m_Pos.y = Source.m_Y2;
-			m_aVertices[BaseIndex + 5].m_Tex = m_aTexture[2];
-			m_aVertices[BaseIndex + 5].m_Color = m_aColor[2];
+			m_pVertices[BaseIndex].m_Pos.x = Source.m_X0;
+			m_pVertices[BaseIndex].m_Pos.y = Source.m_Y0;
+			m_pVertices[BaseIndex].m_Tex = m_aTexture[0];
+			m_pVertices[BaseIndex].m_Color = m_aColor[0];
+
+			m_pVertices[BaseIndex + 1].m_Pos.x = Source.m_X1;
+			m_pVertices[BaseIndex + 1].m_Pos.y = Source.m_Y1;
+			m_pVertices[BaseIndex + 1].m_Tex = m_aTexture[1];
+			m_pVertices[BaseIndex + 1].m_Color = m_aColor[1];
+
+			m_pVertices[BaseIndex + 2].m_Pos.x = Source.m_X3;
+			m_pVertices[BaseIndex + 2].m_Pos.y = Source.m_Y3;
+			m_pVertices[BaseIndex + 2].m_Tex = m_aTexture[3];
+			m_pVertices[BaseIndex + 2].m_Color = m_aColor[3];
+
+			m_pVertices[BaseIndex + 3].m_Pos.x = Source.m_X0;
+			m_pVertices[BaseIndex + 3].m_Pos.y = Source.m_Y0;
+			m_pVertices[BaseIndex + 3].m_Tex = m_aTexture[0];
+			m_pVertices[BaseIndex + 3].m_Color = m_aColor[0];
+
+			m_pVertices[BaseIndex + 4].m_Pos.x = Source.m_X3;
+			m_pVertices[BaseIndex + 4].m_Pos.y = Source.m_Y3;
+			m_pVertices[BaseIndex + 4].m_Tex = m_aTexture[3];
+			m_pVertices[BaseIndex + 4].m_Color = m_aColor[3];
+
+			m_pVertices[BaseIndex + 5].m_Pos.x = Source.m_X2;
+			m_pVertices[BaseIndex + 5].m_Pos.y = Source.m_Y2;
+			m_pVertices[BaseIndex + 5].m_Tex = m_aTexture[2];
+			m_pVertices[BaseIndex + 5].m_Color = m_aColor[2];
 		}
 
 		AddVertices(3*2*Num);
 	}
 	else
 	{
+		ReserveVertices(4*Num);
 		for(int i = 0; i < Num; ++i)
 		{
 			const IGraphics::CFreeformItem &Source = pArray[i];
 			int BaseIndex = m_NumVertices + 4*i;
 
-			m_aVertices[BaseIndex].m_Pos.x = Source.m_X0;
-			m_aVertices[BaseIndex].m_Pos.y = Source.m_Y0;
-			m_aVertices[BaseIndex].m_Tex = m_aTexture[0];
-			m_aVertices[BaseIndex].m_Color = m_aColor[0];
-
-			m_aVertices[BaseIndex + 1].m_Pos.x = Source.m_X1;
-			m_aVertices[BaseIndex + 1].m_Pos.y = Source.m_Y1;
-			m_aVertices[BaseIndex + 1].m_Tex = m_aTexture[1];
-			m_aVertices[BaseIndex + 1].m_Color = m_aColor[1];
-
-			m_aVertices[BaseIndex + 2].m_Pos.x = Source.m_X3;
-			m_aVertices[BaseIndex + 2].m_Pos.y = Source.m_Y3;
-			m_aVertices[BaseIndex + 2].m_Tex = m_aTexture[3];
-			m_aVertices[BaseIndex + 2].m_Color = m_aColor[3];
-
-			m_aVertices[BaseIndex + 3].m_Pos.x = Source.m_X2;
-			m_aVertices[BaseIndex + 3].m_Pos.y = Source.m_Y2;
-			m_aVertices[BaseIndex + 3].m_Tex = m_aTexture[2];
-			m_aVertices[BaseIndex + 3].m_Color = m_aColor[2];
+			m_pVertices[BaseIndex].m_Pos.x = Source.m_X0;
+			m_pVertices[BaseIndex].m_Pos.y = Source.m_Y0;
+			m_pVertices[BaseIndex].m_Tex = m_aTexture[0];
+			m_pVertices[BaseIndex].m_Color = m_aColor[0];
+
+			m_pVertices[BaseIndex + 1].m_Pos.x = Source.m_X1;
+			m_pVertices[BaseIndex + 1].m_Pos.y = Source.m_Y1;
+			m_pVertices[BaseIndex + 1].m_Tex = m_aTexture[1];
+			m_pVertices[BaseIndex + 1].m_Color = m_aColor[1];
+
+			m_pVertices[BaseIndex + 2].m_Pos.x = Source.m_X3;
+			m_pVertices[BaseIndex + 2].m_Pos.y = Source.m_Y3;
+			m_pVertices[BaseIndex + 2].m_Tex = m_aTexture[3];
+			m_pVertices[BaseIndex + 2].m_Color = m_aColor[3];
+
+			m_pVertices[BaseIndex + 3].m_Pos.x = Source.m_X2;
+			m_pVertices[BaseIndex + 3].m_Pos.y = Source.m_Y2;
+			m_pVertices[BaseIndex + 3].m_Tex = m_aTexture[2];
+			m_pVertices[BaseIndex + 3].m_Color = m_aColor[2];
 		}
 
 		AddVertices(4*Num);
 	}
 }
 
+void CGraphics_Threaded::QuadsDrawSprites(const CSpriteItem *pArray, int Num)
+{
+	dbg_assert(m_Drawing == DRAWING_QUADS, "called Graphics()->QuadsDrawSprites without begin");
+
+	const int VertsPerQuad = g_Config.m_GfxQuadAsTriangle ? 6 : 4;
+	ReserveVertices(VertsPerQuad*Num);
+	CCommandBuffer::SVertex *pVert = &m_pVertices[m_NumVertices];
+	for(int i = 0; i < Num; ++i)
+	{
+		const IGraphics::CSpriteItem &Source = pArray[i];
+		const float c = cosf(Source.m_Rotation)*Source.m_Size*0.5f;
+		const float s = sinf(Source.m_Rotation)*Source.m_Size*0.5f;
+		CCommandBuffer::SColor Color;
+		Color.r = Source.m_R;
+		Color.g = Source.m_G;
+		Color.b = Source.m_B;
+		Color.a = Source.m_A;
+
+		// top left, top right, bottom right, bottom left, rotated around the center
+		CCommandBuffer::SVertex aCorners[4];
+		aCorners[0].m_Pos.x = Source.m_X - c + s;
+		aCorners[0].m_Pos.y = Source.m_Y - s - c;
+		aCorners[0].m_Tex.u = Source.m_aUvs[0];
+		aCorners[0].m_Tex.v = Source.m_aUvs[1];
+		aCorners[1].m_Pos.x = Source.m_X + c + s;
+		aCorners[1].m_Pos.y = Source.m_Y + s - c;
+		aCorners[1].m_Tex.u = Source.m_aUvs[2];
+		aCorners[1].m_Tex.v = Source.m_aUvs[1];
+		aCorners[2].m_Pos.x = Source.m_X + c - s;
+		aCorners[2].m_Pos.y = Source.m_Y + s + c;
+		aCorners[2].m_Tex.u = Source.m_aUvs[2];
+		aCorners[2].m_Tex.v = Source.m_aUvs[3];
+		aCorners[3].m_Pos.x = Source.m_X - c - s;
+		aCorners[3].m_Pos.y = Source.m_Y - s + c;
+		aCorners[3].m_Tex.u = Source.m_aUvs[0];
+		aCorners[3].m_Tex.v = Source.m_aUvs[3];
+		for(int k = 0; k < 4; k++)
+			aCorners[k].m_Color = Color;
+
+		if(VertsPerQuad == 6)
+		{
+			pVert[0] = aCorners[0];
+			pVert[1] = aCorners[1];
+			pVert[2] = aCorners[2];
+			pVert[3] = aCorners[0];
+			pVert[4] = aCorners[2];
+			pVert[5] = aCorners[3];
+		}
+		else
+		{
+			pVert[0] = aCorners[0];
+			pVert[1] = aCorners[1];
+			pVert[2] = aCorners[2];
+			pVert[3] = aCorners[3];
+		}
+		pVert += VertsPerQuad;
+	}
+
+	AddVertices(VertsPerQuad*Num);
+}
+
 void CGraphics_Threaded::QuadsText(float x, float y, float Size, const char *pText)
 {
 	float StartX = x;
@@ -1046,9 +1323,12 @@ int CGraphics_Threaded::Init()
 	m_pStorage = Kernel()->RequestInterface<IStorageTW>();
 	m_pConsole = Kernel()->RequestInterface<IConsole>();
 
-	// Set all z to -5.0f
-	for(int i = 0; i < MAX_VERTICES; i++)
-		m_aVertices[i].m_Pos.z = -5.0f;
+	// keep the image cache within its size, next to the loading. a video restart inits again without a shutdown
+	if(g_Config.m_GfxImageCache && m_PruneImageCacheJob.Status() == CJob::STATE_DONE)
+	{
+		m_pStorage->GetCompletePath(IStorageTW::TYPE_SAVE, "tmp/cache/images", m_aImageCacheDir, sizeof(m_aImageCacheDir));
+		Kernel()->RequestInterface<IEngine>()->AddJob(&m_PruneImageCacheJob, PruneImageCacheJob, this);
+	}
 
 	// init textures
 	m_FirstFreeTexture = 0;
@@ -1056,7 +1336,16 @@ int CGraphics_Threaded::Init()
 		m_aTextureIndices[i] = i+1;
 	m_aTextureIndices[MAX_TEXTURES-1] = -1;
 
-	m_pBackend = CreateGraphicsBackend();
+	// init quad buffers
+	m_FirstFreeQuadBuffer = 0;
+	for(int i = 0; i < CCommandBuffer::MAX_QUADBUFFERS-1; i++)
+		m_aQuadBufferIndices[i] = i+1;
+	m_aQuadBufferIndices[CCommandBuffer::MAX_QUADBUFFERS-1] = -1;
+
+	if(g_Config.m_GfxNullBackend)
+		m_pBackend = CreateNullGraphicsBackend();
+	else
+		m_pBackend = CreateGraphicsBackend();
 	if(InitWindow() != 0)
 		return -1;
 
@@ -1065,9 +1354,12 @@ int CGraphics_Threaded::Init()
 	m_ScreenHeight = g_Config.m_GfxScreenHeight;
 
 	// create command buffers
+	m_CmdBufferSize = CMDBUFFER_SIZE;
+	m_DataBufferSize = DATABUFFER_SIZE;
 	for(int i = 0; i < NUM_CMDBUFFERS; i++)
-		m_apCommandBuffers[i] = new CCommandBuffer(256*1024, 2*1024*1024);
+		m_apCommandBuffers[i] = new CCommandBuffer(m_CmdBufferSize, m_DataBufferSize);
 	m_pCommandBuffer = m_apCommandBuffers[0];
+	UpdateVertexWindow();
 
 	// create null texture, will get id=0
 	static const unsigned char aNullTextureData[] = {
@@ -1083,6 +1375,9 @@ int CGraphics_Threaded::Init()
 
 void CGraphics_Threaded::Shutdown()
 {
+	while(m_PruneImageCacheJob.Status() != CJob::STATE_DONE)
+		thread_sleep(1);
+
 	// shutdown the backend
 	m_pBackend->Shutdown();
 	delete m_pBackend;
@@ -1212,6 +1507,15 @@ void CGraphics_Threaded::Swap()
 	Cmd.m_Finish = g_Config.m_GfxFinish;
 	m_pCommandBuffer->AddCommand(Cmd);
 
+	// a frame that didn't fit into one buffer makes the buffers grow, they get reallocated on their next turn
+	if(m_NumFullKicks > 0 && m_DataBufferSize < MAX_DATABUFFER_SIZE)
+	{
+		m_CmdBufferSize *= 2;
+		m_DataBufferSize *= 2;
+		dbg_msg("graphics", "command buffers grown to %d kb commands, %d kb data", m_CmdBufferSize/1024, m_DataBufferSize/1024);
+	}
+	m_NumFullKicks = 0;
+
 	// kick the command buffer
 	KickCommandBuffer();
 }
@@ -1,9 +1,11 @@
 #ifndef ENGINE_CLIENT_GRAPHICS_THREADED_H
 #define ENGINE_CLIENT_GRAPHICS_THREADED_H
 
+#include <atomic>
 #include <map>
 #include <string>
 #include <engine/graphics.h>
+#include <engine/shared/jobs.h>
 
 class CCommandBuffer
 {
@@ -33,6 +35,15 @@ class CCommandBuffer
 			m_Used = 0;
 		}
 
+		// drops the contents
+		void Resize(unsigned BufferSize)
+		{
+			delete [] m_pData;
+			m_Size = BufferSize;
+			m_pData = new unsigned char[m_Size];
+			m_Used = 0;
+		}
+
 		void *Alloc(unsigned Requested)
 		{
 			if(Requested + m_Used > m_Size)
@@ -45,6 +56,8 @@ class CCommandBuffer
 		unsigned char *DataPtr() { return m_pData; }
 		unsigned DataSize() { return m_Size; }
 		unsigned DataUsed() { return m_Used; }
+		unsigned char *FreePtr() { return &m_pData[m_Used]; }
+		unsigned FreeSize() { return m_Size - m_Used; }
 	};
 
 public:
@@ -54,6 +67,7 @@ public:
 	enum
 	{
 		MAX_TEXTURES=1024*4,
+		MAX_QUADBUFFERS=1024,
 	};
 
 	enum
@@ -77,9 +91,15 @@ public:
 		CMD_TEXTURE_DESTROY,
 		CMD_TEXTURE_UPDATE,
 
+		// quad buffer commands
+		CMD_QUADBUFFER_CREATE,
+		CMD_QUADBUFFER_DESTROY,
+		CMD_QUADBUFFER_UPDATE,
+
 		// rendering
 		CMD_CLEAR,
 		CMD_RENDER,
+		CMD_RENDER_QUADBUFFER,
 
 		// swap
 		CMD_SWAP,
@@ -138,6 +158,12 @@ public:
 		SColor m_Color;
 	};
 
+	// vertices of the quad buffers, the color is given when rendering
+	struct SQuadVertex
+	{
+		float x, y, u, v;
+	};
+
 	struct SCommand
 	{
 	public:
@@ -186,7 +212,17 @@ public:
 		SState m_State;
 		unsigned m_PrimType;
 		unsigned m_PrimCount;
-		SVertex *m_pVertices; // you should use the command buffer data to allocate vertices for this command
+		SVertex *m_pVertices; // you should use the command buffer data to allocate vertices for this command, only x and y of the position are used
+	};
+
+	struct SCommand_RenderQuadBuffer : public SCommand
+	{
+		SCommand_RenderQuadBuffer() : SCommand(CMD_RENDER_QUADBUFFER) {}
+		SState m_State;
+		SColor m_Color;
+		int m_Slot;
+		unsigned m_FirstQuad;
+		unsigned m_PrimCount;
 	};
 
 	struct SCommand_Screenshot : public SCommand
@@ -268,6 +304,32 @@ public:
 		int m_Slot;
 	};
 
+	struct SCommand_QuadBuffer_Create : public SCommand
+	{
+		SCommand_QuadBuffer_Create() : SCommand(CMD_QUADBUFFER_CREATE) {}
+
+		int m_Slot;
+		int m_NumQuads;
+		SQuadVertex *m_pVertices; // will be owned by the command processor from now on
+	};
+
+	struct SCommand_QuadBuffer_Update : public SCommand
+	{
+		SCommand_QuadBuffer_Update() : SCommand(CMD_QUADBUFFER_UPDATE) {}
+
+		int m_Slot;
+		int m_FirstQuad;
+		int m_NumQuads;
+		SQuadVertex *m_pVertices; // will be freed by the command processor
+	};
+
+	struct SCommand_QuadBuffer_Destroy : public SCommand
+	{
+		SCommand_QuadBuffer_Destroy() : SCommand(CMD_QUADBUFFER_DESTROY) {}
+
+		int m_Slot; // the processor frees the vertices
+	};
+
 	//
 	CCommandBuffer(unsigned CmdBufferSize, unsigned DataBufferSize)
 	: m_CmdBuffer(CmdBufferSize), m_DataBuffer(DataBufferSize)
@@ -312,6 +374,12 @@ public:
 		m_CmdBuffer.Reset();
 		m_DataBuffer.Reset();
 	}
+
+	void Resize(unsigned CmdBufferSize, unsigned DataBufferSize)
+	{
+		m_CmdBuffer.Resize(CmdBufferSize);
+		m_DataBuffer.Resize(DataBufferSize);
+	}
 };
 
 // interface for the graphics backend
@@ -334,6 +402,7 @@ public:
 	virtual int Shutdown() = 0;
 
 	virtual int MemoryUsage() const = 0;
+	virtual void GetStats(CGraphicsStats *pStats) const = 0;
 
 	virtual int GetNumScreens() const = 0;
 
@@ -364,6 +433,10 @@ class CGraphics_Threaded : public IEngineGraphics
 		MAX_VERTICES = 32*1024,
 		MAX_TEXTURES = 1024*4,
 
+		CMDBUFFER_SIZE = 256*1024,
+		DATABUFFER_SIZE = 2*1024*1024,
+		MAX_DATABUFFER_SIZE = 32*1024*1024,
+
 		DRAWING_QUADS=1,
 		DRAWING_LINES=2
 	};
@@ -374,13 +447,27 @@ class CGraphics_Threaded : public IEngineGraphics
 	CCommandBuffer *m_apCommandBuffers[NUM_CMDBUFFERS];
 	CCommandBuffer *m_pCommandBuffer;
 	unsigned m_CurrentCommandBuffer;
+	unsigned m_CmdBufferSize;
+	unsigned m_DataBufferSize;
+	int m_NumFullKicks; // kicks this frame because a buffer ran full
 
 	//
 	class IStorageTW *m_pStorage;
 	class IConsole *m_pConsole;
 
-	CCommandBuffer::SVertex m_aVertices[MAX_VERTICES];
+	// the vertices are written straight into the free part of the current data buffer
+	CCommandBuffer::SVertex *m_pVertices;
 	int m_NumVertices;
+	int m_MaxVertices;
+
+	int64 m_NumStreamedVertices;
+	int64 m_NumFlushes;
+	int64 m_NumKicks;
+	int64 m_BytesCopied;
+
+	// png loading runs on worker threads too
+	std::atomic<int> m_NumImagesDecoded;
+	std::atomic<int> m_NumImagesFromCache;
 
 	CCommandBuffer::SColor m_aColor[4];
 	CCommandBuffer::STexCoord m_aTexture[4];
@@ -399,11 +486,25 @@ class CGraphics_Threaded : public IEngineGraphics
 	int m_FirstFreeTexture;
 	int m_TextureMemoryUsage;
 
+	int m_aQuadBufferIndices[CCommandBuffer::MAX_QUADBUFFERS];
+	int m_FirstFreeQuadBuffer;
+
 	void FlushVertices();
+	void UpdateVertexWindow();
+	void ReserveVertices(int Count);
 	void AddVertices(int Count);
 	void Rotate(const CCommandBuffer::SPoint &rCenter, CCommandBuffer::SVertex *pPoints, int NumPoints);
 
+	int DecodePNG(CImageInfo *pImg, const unsigned char *pData, unsigned DataSize, const char *pFilename);
+	bool LoadCachedImage(CImageInfo *pImg, const char *pCacheFile);
+	void SaveCachedImage(const CImageInfo *pImg, const char *pCacheFile);
+
+	CJob m_PruneImageCacheJob;
+	char m_aImageCacheDir[512];
+	static int PruneImageCacheJob(void *pUser);
+
 	void KickCommandBuffer();
+	template<class T> void AddCommandOrKick(const T &Command);
 
 	int IssueInit();
 	int InitWindow();
@@ -421,6 +522,7 @@ public:
 	virtual void WrapClamp();
 
 	virtual int MemoryUsage() const;
+	virtual void GetStats(CGraphicsStats *pStats) const;
 
 	virtual void MapScreen(float TopLeftX, float TopLeftY, float BottomRightX, float BottomRightY);
 	virtual void GetScreen(float *pTopLeftX, float *pTopLeftY, float *pBottomRightX, float *pBottomRightY) const;
@@ -463,6 +565,11 @@ public:
 	virtual void SetColor(float r, float g, float b, float a);
 	virtual void SetColorLua(float r, float g, float b, float a, lua_State *L);
 
+	virtual int CreateQuadBuffer(const CQuadVertex *pVertices, int NumQuads);
+	virtual void UpdateQuadBuffer(int BufferID, int FirstQuad, const CQuadVertex *pVertices, int NumQuads);
+	virtual void DeleteQuadBuffer(int BufferID);
+	virtual void RenderQuadBuffer(int BufferID, int FirstQuad, int NumQuads, float r, float g, float b, float a);
+
 	virtual void QuadsSetSubset(float TlU, float TlV, float BrU, float BrV);
 	virtual void QuadsSetSubsetFree(
 		float x0, float y0, float x1, float y1,
@@ -473,6 +580,7 @@ public:
 	virtual void QuadsDrawTL(const CQuadItem *pArray, int Num);
 	virtual int QuadsDrawTLLua(lua_State *L);
 	virtual void QuadsDrawFreeform(const CFreeformItem *pArray, int Num);
+	virtual void QuadsDrawSprites(const CSpriteItem *pArray, int Num);
 	virtual void QuadsText(float x, float y, float Size, const char *pText);
 
 	virtual int GetNumScreens() const;
@@ -514,5 +622,6 @@ public:
 };
 
 extern IGraphicsBackend *CreateGraphicsBackend();
+extern IGraphicsBackend *CreateNullGraphicsBackend();
 
 #endif
@@ -0,0 +1,132 @@
+#ifndef ENGINE_CLIENT_IMAGE_CACHE_H
+#define ENGINE_CLIENT_IMAGE_CACHE_H
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <base/system.h>
+#include <engine/graphics.h>
+
+// decoded png images on disk, named after the md5 of the png they came from: a header and the plain RGB/RGBA data
+class CImageCache
+{
+public:
+	struct CHeader
+	{
+		char m_aMagic[4];
+		int m_Version;
+		int m_Width;
+		int m_Height;
+		int m_Format;
+	};
+
+	enum { VERSION=1 };
+	static const char *Magic() { return "TWIC"; }
+
+	static unsigned DataSize(int Width, int Height, int Format) { return Width*Height*(Format == CImageInfo::FORMAT_RGBA ? 4 : 3); }
+
+	// anything that doesn't add up, like a file another thread is still writing, isn't loaded
+	static bool Load(IOHANDLE File, CImageInfo *pImg)
+	{
+		CHeader Header;
+		long FileSize = io_length(File);
+		if(io_read(File, &Header, sizeof(Header)) != sizeof(Header) ||
+			mem_comp(Header.m_aMagic, Magic(), sizeof(Header.m_aMagic)) != 0 || Header.m_Version != VERSION ||
+			Header.m_Width <= 0 || Header.m_Height <= 0 || (Header.m_Format != CImageInfo::FORMAT_RGB && Header.m_Format != CImageInfo::FORMAT_RGBA))
+			return false;
+
+		unsigned Size = DataSize(Header.m_Width, Header.m_Height, Header.m_Format);
+		if(FileSize != (long)(sizeof(Header)+Size))
+			return false;
+
+		unsigned char *pData = (unsigned char *)mem_alloc(Size, 1);
+		if(io_read(File, pData, Size) != Size)
+		{
+			mem_free(pData);
+			return false;
+		}
+
+		pImg->m_Width = Header.m_Width;
+		pImg->m_Height = Header.m_Height;
+		pImg->m_Format = Header.m_Format;
+		pImg->m_pData = pData;
+		return true;
+	}
+
+	static void Save(IOHANDLE File, const CImageInfo *pImg)
+	{
+		CHeader Header;
+		mem_copy(Header.m_aMagic, Magic(), sizeof(Header.m_aMagic));
+		Header.m_Version = VERSION;
+		Header.m_Width = pImg->m_Width;
+		Header.m_Height = pImg->m_Height;
+		Header.m_Format = pImg->m_Format;
+		io_write(File, &Header, sizeof(Header));
+		io_write(File, pImg->m_pData, DataSize(pImg->m_Width, pImg->m_Height, pImg->m_Format));
+	}
+
+	// removes the oldest images of the directory until the rest fit into MaxSize bytes, returns how many went.
+	// loading an image doesn't make it newer, one that goes while still in use is decoded and written again
+	static int Prune(const char *pDir, int64 MaxSize)
+	{
+		CPruneList List;
+		List.m_pDir = pDir;
+		fs_listdir_info(pDir, PruneListCallback, 0, &List);
+		std::sort(List.m_lFiles.begin(), List.m_lFiles.end());
+
+		int64 Size = 0;
+		int NumRemoved = 0;
+		for(unsigned i = 0; i < List.m_lFiles.size(); i++)
+		{
+			Size += List.m_lFiles[i].m_Size;
+			if(Size > MaxSize)
+			{
+				char aPath[512];
+				str_format(aPath, sizeof(aPath), "%s/%s", pDir, List.m_lFiles[i].m_Name.c_str());
+				NumRemoved += fs_remove(aPath) == 0;
+			}
+		}
+		return NumRemoved;
+	}
+
+private:
+	struct CPruneFile
+	{
+		std::string m_Name;
+		time_t m_Date;
+		int64 m_Size;
+
+		// newest first
+		bool operator<(const CPruneFile &Other) const { return m_Date > Other.m_Date; }
+	};
+
+	struct CPruneList
+	{
+		const char *m_pDir;
+		std::vector<CPruneFile> m_lFiles;
+	};
+
+	static int PruneListCallback(const char *pName, time_t Date, int IsDir, int DirType, void *pUser)
+	{
+		CPruneList *pList = (CPruneList *)pUser;
+		int Length = str_length(pName);
+		if(IsDir || Length < 4 || str_comp(pName+Length-4, ".img") != 0)
+			return 0;
+
+		char aPath[512];
+		str_format(aPath, sizeof(aPath), "%s/%s", pList->m_pDir, pName);
+		IOHANDLE File = io_open(aPath, IOFLAG_READ);
+		if(!File)
+			return 0;
+
+		CPruneFile Entry;
+		Entry.m_Name = pName;
+		Entry.m_Date = Date;
+		Entry.m_Size = io_length(File);
+		io_close(File);
+		pList->m_lFiles.push_back(Entry);
+		return 0;
+	}
+};
+
+#endif
@@ -475,7 +475,7 @@ int CInput::Update()
 					if(!HoldKeys[Key])
 					{
 						// EVENT CALL
-						LUA_FIRE_EVENT("OnKeyPress", IInput::KeyName(Key));
+						LUA_FIRE_EVENT(LUA_EVENT_ON_KEY_PRESS, IInput::KeyName(Key));
 						HoldKeys[Key] = true;
 					}
 				}
@@ -483,7 +483,7 @@ int CInput::Update()
 				if(Action&IInput::FLAG_RELEASE)
 				{
 					// EVENT CALL
-					LUA_FIRE_EVENT("OnKeyRelease", IInput::KeyName(Key));
+					LUA_FIRE_EVENT(LUA_EVENT_ON_KEY_RELEASE, IInput::KeyName(Key));
 					HoldKeys[Key] = false;
 				}
 
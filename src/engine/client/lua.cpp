@@ -26,6 +26,7 @@ CLua::CLua()
 	m_pStorage = 0;
 	m_pConsole = 0;
 	m_pFullscreenedScript = 0;
+	m_EventsDirty = false;
 
 	m_pDatabase = new CSql();
 
@@ -209,15 +210,37 @@ void CLua::StartReceiveEvents(CLuaFile *pLF)
 {
 	dbg_assert_strict(m_apActiveScripts.find(pLF, NULL) == NULL, "loaded a script twice!?");
 	m_apActiveScripts.add(pLF);
+
+	// its handlers are looked up before the next event, after OnScriptInit had its say
+	m_EventsDirty = true;
 }
 
 void CLua::StopReceiveEvents(CLuaFile *pLF)
 {
+	m_EventRegistry.Remove(pLF);
 	bool Success = m_apActiveScripts.remove_fast(pLF);
 	if(!dbg_assert_strict(Success, "unloaded a script that wasn't even loaded!"))
 		CLua::m_pCGameClient->m_pMenus->m_Nalf[pLF->GetPermissionFlags()&CLuaFile::PERMISSION_GODMODE?1:0]--;
 }
 
+void CLua::UpdateEventListeners()
+{
+	m_EventsDirty = false;
+
+	m_EventRegistry.Clear();
+	for(int i = 0; i < m_apActiveScripts.size(); i++)
+	{
+		CLuaFile *pLF = m_apActiveScripts[i];
+		if(pLF->State() != CLuaFile::STATE_LOADED)
+			continue;
+		pLF->m_EventHandlers.Resolve(pLF->L());
+		m_EventRegistry.Add(pLF, &pLF->m_EventHandlers);
+	}
+
+	if(CGameConsole::m_pStatLuaConsole && CGameConsole::m_pStatLuaConsole->m_LuaHandler.m_pLuaState)
+		CGameConsole::m_pStatLuaConsole->m_LuaHandler.m_EventHandlers.Resolve(CGameConsole::m_pStatLuaConsole->m_LuaHandler.m_pLuaState);
+}
+
 int CLua::HandleException(std::exception &e, lua_State *L)
 {
 	return HandleException(e.what(), L);
@@ -254,6 +277,7 @@ int CLua::HandleException(const char *pError, CLuaFile *pLF, bool CalledFromUnlo
 		else
 		{
 			// restart the lua console
+			m_pCGameClient->m_pGameConsole->m_pStatLuaConsole->m_LuaHandler.m_EventHandlers.Clear();
 			lua_close(m_pCGameClient->m_pGameConsole->m_pStatLuaConsole->m_LuaHandler.m_pLuaState);
 			m_pCGameClient->m_pGameConsole->m_pStatLuaConsole->InitLua();
 			m_pCGameClient->m_pGameConsole->m_pStatLuaConsole->m_LuaHandler.m_FullLine = "";
@@ -6,34 +6,38 @@
 #include <base/tl/array.h>
 #include <engine/external/zlib/zlib.h>
 #include "luafile.h"
+#include "luaevents.h"
 #include "db_sqlite3.h"
 
-#define LUA_FIRE_EVENT(EVENTNAME, ...) \
+#define LUA_FIRE_EVENT(EVENT, ...) \
 	if(!g_StealthMode && g_Config.m_ClLua) \
 	{ \
-		const int __NumLuaFiles = CLua::Client()->Lua()->GetActiveLuaFiles().size(); \
-		for(int ijdfg = 0; ijdfg < __NumLuaFiles; ijdfg++) \
+		CLua *__pLua = CLua::Client()->Lua(); \
+		if(__pLua->EventsDirty()) \
+			__pLua->UpdateEventListeners(); \
+		const array<CLuaFile*> &__apListeners = __pLua->GetEventListeners(EVENT); \
+		for(int ijdfg = 0; ijdfg < __apListeners.size(); ijdfg++) \
 		{ \
-			CLuaFile *pLF = CLua::Client()->Lua()->GetActiveLuaFiles()[ijdfg]; \
+			CLuaFile *pLF = __apListeners[ijdfg]; \
 			if(pLF->State() != CLuaFile::STATE_LOADED) \
 				continue; \
-			LuaRef lfunc = pLF->GetFunc(EVENTNAME); \
-			if(lfunc) try { \
+			const LuaRef &lfunc = pLF->EventHandlers()->Handler(EVENT); \
+			try { \
 				if(pLF->ProfilingActive()) { \
-                    int64 StartTime = time_get_raw(); \
+					int64 StartTime = time_get_raw(); \
 					lfunc(__VA_ARGS__); \
-                    int64 TimeTaken = time_get_raw()-StartTime; \
-                    pLF->ProfilingDoSample(EVENTNAME, time_to_nanos(TimeTaken)); \
-                } \
+					int64 TimeTaken = time_get_raw()-StartTime; \
+					pLF->ProfilingDoSample(LuaEventName(EVENT), time_to_nanos(TimeTaken)); \
+				} \
 				else \
 					lfunc(__VA_ARGS__); /* worse code, but better performance/reliability on the profiling (it's about fractions of microseconds there!) */ \
-				CLua::Client()->LuaCheckDrawingState(pLF->L(), EVENTNAME); \
-			} catch(std::exception &e) { CLua::Client()->Lua()->HandleException(e, pLF); } \
+				CLua::Client()->LuaCheckDrawingState(pLF->L(), LuaEventName(EVENT)); \
+			} catch(std::exception &e) { __pLua->HandleException(e, pLF); } \
 		} \
-		if(CGameConsole::m_pStatLuaConsole->m_LuaHandler.m_pDebugChild == NULL) \
+		if(CGameConsole::m_pStatLuaConsole->m_LuaHandler.m_pDebugChild == NULL && CGameConsole::m_pStatLuaConsole->m_LuaHandler.m_EventHandlers.Handles(EVENT)) \
 		{ \
-			LuaRef confunc = getGlobal(CGameConsole::m_pStatLuaConsole->m_LuaHandler.m_pLuaState, EVENTNAME); \
-			if(confunc) try { confunc(__VA_ARGS__); } catch(std::exception &e) { CLua::Client()->Lua()->HandleException(e, CGameConsole::m_pStatLuaConsole->m_LuaHandler.m_pLuaState); } \
+			const LuaRef &confunc = CGameConsole::m_pStatLuaConsole->m_LuaHandler.m_EventHandlers.Handler(EVENT); \
+			try { confunc(__VA_ARGS__); } catch(std::exception &e) { __pLua->HandleException(e, CGameConsole::m_pStatLuaConsole->m_LuaHandler.m_pLuaState); } \
 		} \
 	}
 
@@ -58,6 +62,9 @@ class CLua
 	array<std::string> m_aAutoloadFiles;
 	CLuaFile *m_pFullscreenedScript;
 
+	CLuaEventRegistry<CLuaFile> m_EventRegistry;
+	bool m_EventsDirty;
+
 public:
 	CLua();
 	~CLua();
@@ -75,6 +82,12 @@ public:
 	void StartReceiveEvents(CLuaFile *pLF);
 	void StopReceiveEvents(CLuaFile *pLF);
 
+	// the handlers are looked up again before the next event once something might have changed them
+	void MarkEventsDirty() { m_EventsDirty = true; }
+	bool EventsDirty() const { return m_EventsDirty; }
+	void UpdateEventListeners();
+	const array<CLuaFile*> &GetEventListeners(int Event) const { return m_EventRegistry.Listeners(Event); }
+
 	static int ErrorFunc(lua_State *L);
 	static int Panic(lua_State *L);
 	int HandleException(std::exception &e, lua_State *L);
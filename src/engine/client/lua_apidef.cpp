@@ -44,6 +44,7 @@ void CLuaFile::RegisterLuaCallbacks(lua_State *L) // LUABRIDGE!
 	lua_register(L, "ExitFullscreen", CLuaBinding::LuaExitFullscreen);
 	lua_register(L, "ScriptPath", CLuaBinding::LuaScriptPath);
 	lua_register(L, "StrIsNetAddr", CLuaBinding::LuaStrIsNetAddr);
+	lua_register(L, "_EventsChanged", CLuaBinding::LuaEventsChanged);
 
 	// re-bind common functions
 	luaL_dostring(L, "dofile = Import");
@@ -738,6 +739,7 @@ void CLuaFile::RegisterLuaCallbacks(lua_State *L) // LUABRIDGE!
 			.addFunction("GetSnap", &CGameClient::LuaGetFullSnap)
 			.addVariable("Snap", &CLua::m_pCGameClient->m_Snap, false)
 			.addFunction("Tuning", &CGameClient::LuaGetTuning)
+			.addFunction("SearchServers", &CGameClient::LuaSearchServers)
 			//dummy access
 			.addFunction("DummyInput", &CControls::LuaGetInputData)
 		.endNamespace()
@@ -253,6 +253,13 @@ int CLuaBinding::LuaStrIsNetAddr(lua_State *L)
 	return 1;
 }
 
+int CLuaBinding::LuaEventsChanged(lua_State *L)
+{
+	// called by events.lua when something was registered or removed
+	CLua::Client()->Lua()->MarkEventsDirty();
+	return 0;
+}
+
 
 int CLuaBinding::LuaSetScriptTitle(lua_State *L)
 {
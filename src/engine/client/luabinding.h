@@ -29,6 +29,7 @@ public:
 	static int LuaPrintOverride(lua_State *L);
 	static int LuaThrow(lua_State *L);
 	static int LuaStrIsNetAddr(lua_State *L);
+	static int LuaEventsChanged(lua_State *L);
 
 	// io namespace
 	static int LuaIO_Open(lua_State *L);
@@ -0,0 +1,164 @@
+#ifndef ENGINE_CLIENT_LUAEVENTS_H
+#define ENGINE_CLIENT_LUAEVENTS_H
+
+#include <base/system.h>
+#include <base/tl/array.h>
+#include <lua.hpp>
+#include <engine/external/luabridge/LuaBridge.h>
+
+// the events the client fires into the scripts, in the order of their names below
+enum
+{
+	LUA_EVENT_ON_KEY_PRESS=0,
+	LUA_EVENT_ON_KEY_RELEASE,
+	LUA_EVENT_ON_ENTER_GAME,
+	LUA_EVENT_ON_TICK,
+	LUA_EVENT_RESUME_THREADS,
+	LUA_EVENT_ON_RENDER_LEVEL,
+	LUA_EVENT_ON_INPUT_LEVEL,
+	LUA_EVENT_ON_RENDER_SCOREBOARD,
+	LUA_EVENT_ON_RENDER_BACKGROUND,
+	LUA_EVENT_ON_KILL,
+	LUA_EVENT_PRE_RENDER_PLAYER,
+	LUA_EVENT_POST_RENDER_PLAYER,
+	LUA_EVENT_ON_SNAP_INPUT,
+	LUA_EVENT_ON_MESSAGE_IRC,
+	LUA_EVENT_ON_CHAT,
+	LUA_EVENT_ON_CHAT_SEND,
+	LUA_EVENT_ON_CONSOLE_COMMAND,
+	LUA_EVENT_ON_STATE_CHANGE,
+	LUA_EVENT_ON_GAME_OVER,
+	LUA_EVENT_ON_GAME_START,
+	LUA_EVENT_ON_FLAG_GRAB,
+	LUA_EVENT_ON_PRED_HAMMER_HIT,
+	NUM_LUA_EVENTS
+};
+
+// the global function that handles the event
+inline const char *LuaEventName(int Event)
+{
+	static const char *const s_apNames[NUM_LUA_EVENTS] = {
+		"OnKeyPress",
+		"OnKeyRelease",
+		"OnEnterGame",
+		"OnTick",
+		"ResumeThreads",
+		"OnRenderLevel",
+		"OnInputLevel",
+		"OnRenderScoreboard",
+		"OnRenderBackground",
+		"OnKill",
+		"PreRenderPlayer",
+		"PostRenderPlayer",
+		"OnSnapInput",
+		"OnMessageIRC",
+		"OnChat",
+		"OnChatSend",
+		"OnConsoleCommand",
+		"OnStateChange",
+		"OnGameOver",
+		"OnGameStart",
+		"OnFlagGrab",
+		"OnPredHammerHit",
+	};
+	return s_apNames[Event];
+}
+
+// the event handlers of one lua state, looked up by name once instead of on every event
+class CLuaEventHandlers
+{
+public:
+	CLuaEventHandlers() : m_pLuaState(0)
+	{
+		mem_zero(m_apHandlers, sizeof(m_apHandlers));
+		mem_zero(m_aHandled, sizeof(m_aHandled));
+	}
+	~CLuaEventHandlers() { Clear(); }
+
+	// drops the references, has to happen before the state is closed
+	void Clear()
+	{
+		for(int i = 0; i < NUM_LUA_EVENTS; i++)
+		{
+			delete m_apHandlers[i];
+			m_apHandlers[i] = 0;
+			m_aHandled[i] = false;
+		}
+		m_pLuaState = 0;
+	}
+
+	// looks the handlers up again. the dispatchers of events.lua only count while something is registered
+	// with them, they tell so through _EventIsHandled. events.lua also reports scripts assigning the event
+	// globals themselves through _EventsChanged. the references stay allocated for the state, so a
+	// handler that is being called while this runs is not freed underneath
+	void Resolve(lua_State *L)
+	{
+		if(L != m_pLuaState)
+		{
+			Clear();
+			m_pLuaState = L;
+			for(int i = 0; i < NUM_LUA_EVENTS; i++)
+				m_apHandlers[i] = new luabridge::LuaRef(L);
+		}
+
+		luabridge::LuaRef IsHandled = luabridge::getGlobal(L, "_EventIsHandled");
+		for(int i = 0; i < NUM_LUA_EVENTS; i++)
+		{
+			*m_apHandlers[i] = luabridge::getGlobal(L, LuaEventName(i));
+			m_aHandled[i] = m_apHandlers[i]->isFunction();
+			if(m_aHandled[i] && IsHandled.isFunction())
+			{
+				try { m_aHandled[i] = IsHandled(LuaEventName(i)).cast<bool>(); }
+				catch(std::exception &) { m_aHandled[i] = true; }
+			}
+			if(!m_aHandled[i])
+				*m_apHandlers[i] = luabridge::Nil();
+		}
+	}
+
+	bool Handles(int Event) const { return m_aHandled[Event]; }
+	const luabridge::LuaRef &Handler(int Event) const { return *m_apHandlers[Event]; }
+
+private:
+	lua_State *m_pLuaState;
+	luabridge::LuaRef *m_apHandlers[NUM_LUA_EVENTS];
+	bool m_aHandled[NUM_LUA_EVENTS];
+};
+
+// the listeners of every event, only the ones with a handler for it
+template<class T>
+class CLuaEventRegistry
+{
+public:
+	void Add(T *pListener, const CLuaEventHandlers *pHandlers)
+	{
+		for(int i = 0; i < NUM_LUA_EVENTS; i++)
+			if(pHandlers->Handles(i))
+				m_aapListeners[i].add(pListener);
+	}
+
+	// keeps the order the scripts were loaded in
+	void Remove(T *pListener)
+	{
+		for(int i = 0; i < NUM_LUA_EVENTS; i++)
+			for(int j = 0; j < m_aapListeners[i].size(); j++)
+				if(m_aapListeners[i][j] == pListener)
+				{
+					m_aapListeners[i].remove_index(j);
+					break;
+				}
+	}
+
+	void Clear()
+	{
+		for(int i = 0; i < NUM_LUA_EVENTS; i++)
+			m_aapListeners[i].clear();
+	}
+
+	const array<T *> &Listeners(int Event) const { return m_aapListeners[Event]; }
+
+private:
+	array<T *> m_aapListeners[NUM_LUA_EVENTS];
+};
+
+#endif
@@ -26,6 +26,7 @@ CLuaFile::CLuaFile(CLua *pLua, const std::string& Filename, bool Autoload) : m_p
 CLuaFile::~CLuaFile()
 {
 	Unload();
+	m_EventHandlers.Clear();
 }
 
 void CLuaFile::Reset(bool error)
@@ -171,6 +172,7 @@ void CLuaFile::OpenLua()
 	dbg_assert_strict(m_pLuaState == NULL, "possibly leaking a lua_state");
 
 	// firstly, close a previous state if there is any
+	m_EventHandlers.Clear();
 	if(m_pLuaStateContainer)
 		lua_close(m_pLuaStateContainer);
 
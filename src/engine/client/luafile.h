@@ -13,6 +13,7 @@
 #include <engine/external/luabridge/RefCountedPtr.h>
 
 #include "luaresman.h"
+#include "luaevents.h"
 
 
 class IClient;
@@ -100,6 +101,7 @@ private:
 	bool m_ScriptAutoload;
 
 	CLuaRessourceMgr m_ResMan;
+	CLuaEventHandlers m_EventHandlers;
 
 	std::map<std::string, CProfilingData> m_ProfilingResults;
 	bool m_ProfilingActive;
@@ -137,6 +139,7 @@ public:
 	double GetScriptAliveTime() const { return time_to_millis(time_get_raw()-m_ScriptStartTime); }
 
 	CLuaRessourceMgr *GetResMan() { return &m_ResMan; }
+	const CLuaEventHandlers *EventHandlers() const { return &m_EventHandlers; }
 
 	CLua *Lua() const { return m_pLua; }
 
@@ -1,7 +1,6 @@
 /* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 #include <cstdio> // file io  TODO: remove this, use tw's own storage system instead
-#include <algorithm> // sort  TODO: remove this
 
 #include <base/math.h>
 #include <base/system.h>
@@ -26,16 +25,6 @@
 #include <base/system++/threading.h>
 
 #include "serverbrowser.h"
-class SortWrap
-{
-	typedef bool (CServerBrowser::*SortFunc)(int, int) const;
-	SortFunc m_pfnSort;
-	CServerBrowser *m_pThis;
-public:
-	SortWrap(CServerBrowser *t, SortFunc f) : m_pfnSort(f), m_pThis(t) {}
-	bool operator()(int a, int b) { return (g_Config.m_BrSortOrder ? (m_pThis->*m_pfnSort)(b, a) : (m_pThis->*m_pfnSort)(a, b)); }
-};
-
 void CQueryRecent::OnData()
 {
 	while(Next()) // process everything
@@ -71,13 +60,9 @@ CServerBrowser::CServerBrowser()
 
 	m_NumFavoriteServers = 0;
 
-	mem_zero(m_aServerlistIp, sizeof(m_aServerlistIp));
-
-	m_pFirstReqServer = 0; // request list
-	m_pLastReqServer = 0;
-	m_NumRequests = 0;
 	m_MasterServerCount = 0;
-	m_CurrentMaxRequests = g_Config.m_BrMaxRequests;
+	m_VisibleFirst = 0;
+	m_VisibleNum = 0;
 
 	m_NeedRefresh = 0;
 	m_aRecentServers.clear();
@@ -91,6 +76,10 @@ CServerBrowser::CServerBrowser()
 	m_NumDDNetTypes = 0;
 	m_NumDDNetCountries = 0;
 
+	m_SortCriteria = -1;
+	m_FriendsRevision = -1;
+	m_NeedRefilter = false;
+
 	m_Sorthash = 0;
 	m_aFilterString[0] = 0;
 	m_aFilterGametypeString[0] = 0;
@@ -173,6 +162,49 @@ const CServerInfo *CServerBrowser::Get(int Index)// const
 	return &m_ppServerlist[Index]->m_Info;
 }
 
+int CServerBrowser::Search(const char *pQuery, const CServerInfo **apResults, int *paHits, int MaxResults)
+{
+	LOCK_SECTION_RECURSIVE_MUTEX_OPT(m_Mutex, return 0)
+
+	if(!pQuery[0])
+		return 0;
+
+	m_aSearchHits.set_size(m_NumServers);
+	if(m_SearchIndex.Search(pQuery, m_aSearchHits.base_ptr()) < 0)
+	{
+		// too short for the index, look at every server
+		char aQuery[64];
+		ServerFilterLowercase(aQuery, pQuery, sizeof(aQuery));
+		for(int i = 0; i < m_NumServers; i++)
+		{
+			const CServerFilterKeys *pKeys = &m_ppServerlist[i]->m_FilterKeys;
+			int Hit = 0;
+			if(str_find(pKeys->m_aName, aQuery))
+				Hit |= IServerBrowser::QUICK_SERVERNAME;
+			for(int p = 0; p < m_ppServerlist[i]->m_Info.m_NumClients; p++)
+				if(str_find(pKeys->m_aaClientNames[p], aQuery) || str_find(pKeys->m_aaClientClans[p], aQuery))
+				{
+					Hit |= IServerBrowser::QUICK_PLAYER;
+					break;
+				}
+			if(str_find(pKeys->m_aMap, aQuery))
+				Hit |= IServerBrowser::QUICK_MAPNAME;
+			m_aSearchHits[i] = Hit;
+		}
+	}
+
+	int NumResults = 0;
+	for(int i = 0; i < m_NumServers && NumResults < MaxResults; i++)
+	{
+		if(!m_aSearchHits[i])
+			continue;
+		apResults[NumResults] = &m_ppServerlist[i]->m_Info;
+		paHits[NumResults] = m_aSearchHits[i];
+		NumResults++;
+	}
+	return NumResults;
+}
+
 int CServerBrowser::GetInfoAge(int Index) const
 {
 	if(Index < 0 || Index >= m_NumSortedServers)
@@ -209,10 +241,10 @@ const char *CServerBrowser::GetDebugString(int Index) const
 			   "64-legacy: %s\n"
 			   "\n"
 			   "NextIp = %p\n"
-			   "PrevReq = %p\n"
-			   "NextReq = %p\n"
 			   "\n"
-			   "CurrentMaxRequests = %i"
+			   "Request rate = %.0f/s\n"
+			   "Request timeout = %i ms\n"
+			   "Requests sent/answered/timed out = %i/%i/%i"
 			,
 			   Index, m_NumSortedServers, pInfo,
 			   aAddr,
@@ -220,218 +252,79 @@ const char *CServerBrowser::GetDebugString(int Index) const
 			   pInfo->m_GotInfo ? "true" : "false",
 			   pInfo->m_Request64Legacy ? "true" : "false",
 			   pInfo->m_pNextIp,
-			   pInfo->m_pPrevReq,
-			   pInfo->m_pNextReq,
-			   m_CurrentMaxRequests
+			   m_Requests.Rate(),
+			   m_Requests.TimeoutMs(),
+			   m_Requests.NumSent(), m_Requests.NumAnswered(), m_Requests.NumTimeouts()
 	);
 
 	return s_aBuffer;
 }
 
-bool CServerBrowser::SortCompareName(int Index1, int Index2) const
+void CServerBrowser::GetFilterSettings(CServerFilter::CSettings *pSettings) const
 {
-	CServerEntry *a = m_ppServerlist[Index1];
-	CServerEntry *b = m_ppServerlist[Index2];
-	//	make sure empty entries are listed last
-	return (a->m_GotInfo && b->m_GotInfo) || (!a->m_GotInfo && !b->m_GotInfo) ? str_comp(a->m_Info.m_aName, b->m_Info.m_aName) < 0 : a->m_GotInfo != 0;
+	mem_zero(pSettings, sizeof(CServerFilter::CSettings));
+	pSettings->m_FilterEmpty = g_Config.m_BrFilterEmpty;
+	pSettings->m_FilterNonEmpty = g_Config.m_BrFilterNonEmpty;
+	pSettings->m_FilterFull = g_Config.m_BrFilterFull;
+	pSettings->m_FilterSpectators = g_Config.m_BrFilterSpectators;
+	pSettings->m_FilterPw = g_Config.m_BrFilterPw;
+	pSettings->m_FilterPure = g_Config.m_BrFilterPure;
+	pSettings->m_FilterPureMap = g_Config.m_BrFilterPureMap;
+	pSettings->m_FilterPing = g_Config.m_BrFilterPing;
+	pSettings->m_FilterCompatversion = g_Config.m_BrFilterCompatversion;
+	pSettings->m_FilterGametypeStrict = g_Config.m_BrFilterGametypeStrict;
+	pSettings->m_FilterVersionStrict = g_Config.m_BrFilterVersionStrict;
+	pSettings->m_FilterCountry = g_Config.m_BrFilterCountry;
+	pSettings->m_FilterCountryIndex = g_Config.m_BrFilterCountryIndex;
+	pSettings->m_FilterFriends = g_Config.m_BrFilterFriends;
+	pSettings->m_HideDDNet = g_Config.m_BrShowDDNet == 1 && g_Config.m_UiBrowserPage != CMenus::PAGE_BROWSER_DDNET && g_Config.m_UiBrowserPage != CMenus::PAGE_BROWSER_FAVORITES;
+	pSettings->m_FriendsIgnoreClan = g_Config.m_ClFriendsIgnoreClan;
+	ServerFilterLowercase(pSettings->m_aFilterString, g_Config.m_BrFilterString, sizeof(pSettings->m_aFilterString));
+	ServerFilterLowercase(pSettings->m_aExcludeString, g_Config.m_BrExcludeString, sizeof(pSettings->m_aExcludeString));
+	ServerFilterLowercase(pSettings->m_aFilterGametype, g_Config.m_BrFilterGametype, sizeof(pSettings->m_aFilterGametype));
+	ServerFilterLowercase(pSettings->m_aFilterVersion, g_Config.m_BrFilterVersion, sizeof(pSettings->m_aFilterVersion));
+	ServerFilterLowercase(pSettings->m_aFilterServerAddress, g_Config.m_BrFilterServerAddress, sizeof(pSettings->m_aFilterServerAddress));
+	str_copy(pSettings->m_aNetVersion, m_aNetVersion, sizeof(pSettings->m_aNetVersion));
 }
 
-bool CServerBrowser::SortCompareMap(int Index1, int Index2) const
-{
-	CServerEntry *a = m_ppServerlist[Index1];
-	CServerEntry *b = m_ppServerlist[Index2];
-	return str_comp(a->m_Info.m_aMap, b->m_Info.m_aMap) < 0;
-}
-
-bool CServerBrowser::SortComparePing(int Index1, int Index2) const
-{
-	CServerEntry *a = m_ppServerlist[Index1];
-	CServerEntry *b = m_ppServerlist[Index2];
-	return a->m_Info.m_Latency < b->m_Info.m_Latency;
-}
-
-bool CServerBrowser::SortCompareGametype(int Index1, int Index2) const
-{
-	CServerEntry *a = m_ppServerlist[Index1];
-	CServerEntry *b = m_ppServerlist[Index2];
-	return str_comp(a->m_Info.m_aGameType, b->m_Info.m_aGameType) < 0;
-}
-
-bool CServerBrowser::SortCompareNumPlayers(int Index1, int Index2) const
-{
-	CServerEntry *a = m_ppServerlist[Index1];
-	CServerEntry *b = m_ppServerlist[Index2];
-	return a->m_Info.m_NumPlayers < b->m_Info.m_NumPlayers;
-}
-
-bool CServerBrowser::SortCompareNumClients(int Index1, int Index2) const
-{
-	CServerEntry *a = m_ppServerlist[Index1];
-	CServerEntry *b = m_ppServerlist[Index2];
-	return a->m_Info.m_NumClients < b->m_Info.m_NumClients;
-}
-
-void CServerBrowser::Filter()
+void CServerBrowser::Filter(int Index, int SearchHit)
 {
 	LOCK_SECTION_RECURSIVE_MUTEX_OPT(m_Mutex, return)
 
-	int i = 0, p = 0;
-	m_NumSortedServers = 0;
-
-	// allocate the sorted list
-	if(m_NumSortedServersCapacity < m_NumServers)
+	CServerEntry *pEntry = m_ppServerlist[Index];
+	if(m_Filter.Filtered(&pEntry->m_Info, &pEntry->m_FilterKeys, &pEntry->m_Info.m_QuickSearchHit, SearchHit))
 	{
-		if(m_pSortedServerlist)
-			mem_free(m_pSortedServerlist);
-		m_NumSortedServersCapacity = m_NumServers;
-		m_pSortedServerlist = (int *)mem_alloc(m_NumSortedServersCapacity*sizeof(int), 1);
+		m_SortOrder.Remove(Index);
+		return;
 	}
 
-	// filter the servers
-	for(i = 0; i < m_NumServers; i++)
+	// check for friend
+	pEntry->m_Info.m_FriendState = IFriends::FRIEND_NO;
+	for(int p = 0; p < pEntry->m_Info.m_NumClients; p++)
 	{
-		int Filtered = 0;
-
-		if(g_Config.m_BrFilterEmpty && ((g_Config.m_BrFilterSpectators && m_ppServerlist[i]->m_Info.m_NumPlayers == 0) || m_ppServerlist[i]->m_Info.m_NumClients == 0))
-			Filtered = 1;
-		else if(g_Config.m_BrFilterNonEmpty && ((g_Config.m_BrFilterSpectators && m_ppServerlist[i]->m_Info.m_NumPlayers != 0) || m_ppServerlist[i]->m_Info.m_NumClients != 0))
-			Filtered = 1;
-		else if(g_Config.m_BrFilterFull && ((g_Config.m_BrFilterSpectators && m_ppServerlist[i]->m_Info.m_NumPlayers == m_ppServerlist[i]->m_Info.m_MaxPlayers) ||
-				m_ppServerlist[i]->m_Info.m_NumClients == m_ppServerlist[i]->m_Info.m_MaxClients))
-			Filtered = 1;
-		else if(g_Config.m_BrFilterPw && (m_ppServerlist[i]->m_Info.m_Flags&SERVER_FLAG_PASSWORD))
-			Filtered = 1;
-		else if(g_Config.m_BrFilterPure &&
-			(str_comp(m_ppServerlist[i]->m_Info.m_aGameType, "DM") != 0 &&
-			str_comp(m_ppServerlist[i]->m_Info.m_aGameType, "TDM") != 0 &&
-			str_comp(m_ppServerlist[i]->m_Info.m_aGameType, "CTF") != 0))
-		{
-			Filtered = 1;
-		}
-		else if(g_Config.m_BrFilterPureMap &&
-			!(str_comp(m_ppServerlist[i]->m_Info.m_aMap, "dm1") == 0 ||
-			str_comp(m_ppServerlist[i]->m_Info.m_aMap, "dm2") == 0 ||
-			str_comp(m_ppServerlist[i]->m_Info.m_aMap, "dm6") == 0 ||
-			str_comp(m_ppServerlist[i]->m_Info.m_aMap, "dm7") == 0 ||
-			str_comp(m_ppServerlist[i]->m_Info.m_aMap, "dm8") == 0 ||
-			str_comp(m_ppServerlist[i]->m_Info.m_aMap, "dm9") == 0 ||
-			str_comp(m_ppServerlist[i]->m_Info.m_aMap, "ctf1") == 0 ||
-			str_comp(m_ppServerlist[i]->m_Info.m_aMap, "ctf2") == 0 ||
-			str_comp(m_ppServerlist[i]->m_Info.m_aMap, "ctf3") == 0 ||
-			str_comp(m_ppServerlist[i]->m_Info.m_aMap, "ctf4") == 0 ||
-			str_comp(m_ppServerlist[i]->m_Info.m_aMap, "ctf5") == 0 ||
-			str_comp(m_ppServerlist[i]->m_Info.m_aMap, "ctf6") == 0 ||
-			str_comp(m_ppServerlist[i]->m_Info.m_aMap, "ctf7") == 0)
-		)
-		{
-			Filtered = 1;
-		}
-		else if(g_Config.m_BrFilterPing < m_ppServerlist[i]->m_Info.m_Latency)
-			Filtered = 1;
-		else if(g_Config.m_BrFilterCompatversion && str_comp_num(m_ppServerlist[i]->m_Info.m_aVersion, m_aNetVersion, 3) != 0)
-			Filtered = 1;
-		else if(g_Config.m_BrFilterServerAddress[0] && !str_find_nocase(m_ppServerlist[i]->m_Info.m_aAddress, g_Config.m_BrFilterServerAddress))
-			Filtered = 1;
-		else if(g_Config.m_BrFilterGametypeStrict && g_Config.m_BrFilterGametype[0] && str_comp_nocase(m_ppServerlist[i]->m_Info.m_aGameType, g_Config.m_BrFilterGametype))
-			Filtered = 1;
-		else if(!g_Config.m_BrFilterGametypeStrict && g_Config.m_BrFilterGametype[0] && !str_find_nocase(m_ppServerlist[i]->m_Info.m_aGameType, g_Config.m_BrFilterGametype))
-			Filtered = 1;
-		else if(g_Config.m_BrFilterVersionStrict && g_Config.m_BrFilterVersion[0] && str_comp_nocase(m_ppServerlist[i]->m_Info.m_aVersion, g_Config.m_BrFilterVersion))
-			Filtered = 1;
-		else if(!g_Config.m_BrFilterVersionStrict && g_Config.m_BrFilterVersion[0] && !str_find_nocase(m_ppServerlist[i]->m_Info.m_aVersion, g_Config.m_BrFilterVersion))
-			Filtered = 1;
-		else if(g_Config.m_BrShowDDNet == 1 && g_Config.m_UiBrowserPage != CMenus::PAGE_BROWSER_DDNET && g_Config.m_UiBrowserPage != CMenus::PAGE_BROWSER_FAVORITES && str_find_nocase(m_ppServerlist[i]->m_Info.m_aName, "[DDRaceNetwork]"))
-			Filtered = 1;
-		else
-		{
-			if(g_Config.m_BrFilterCountry)
-			{
-				Filtered = 1;
-				// match against player country
-				for(p = 0; p < m_ppServerlist[i]->m_Info.m_NumClients; p++)
-				{
-					if(m_ppServerlist[i]->m_Info.m_aClients[p].m_Country == g_Config.m_BrFilterCountryIndex)
-					{
-						Filtered = 0;
-						break;
-					}
-				}
-			}
-
-			if(!Filtered && g_Config.m_BrFilterString[0] != 0)
-			{
-				int MatchFound = 0;
-
-				m_ppServerlist[i]->m_Info.m_QuickSearchHit = 0;
-
-				// match against server name
-				if(str_find_nocase(m_ppServerlist[i]->m_Info.m_aName, g_Config.m_BrFilterString))
-				{
-					MatchFound = 1;
-					m_ppServerlist[i]->m_Info.m_QuickSearchHit |= IServerBrowser::QUICK_SERVERNAME;
-				}
-
-				// match against players
-				for(p = 0; p < m_ppServerlist[i]->m_Info.m_NumClients; p++)
-				{
-					if(str_find_nocase(m_ppServerlist[i]->m_Info.m_aClients[p].m_aName, g_Config.m_BrFilterString) ||
-						str_find_nocase(m_ppServerlist[i]->m_Info.m_aClients[p].m_aClan, g_Config.m_BrFilterString))
-					{
-						MatchFound = 1;
-						m_ppServerlist[i]->m_Info.m_QuickSearchHit |= IServerBrowser::QUICK_PLAYER;
-						break;
-					}
-				}
-
-				// match against map
-				if(str_find_nocase(m_ppServerlist[i]->m_Info.m_aMap, g_Config.m_BrFilterString))
-				{
-					MatchFound = 1;
-					m_ppServerlist[i]->m_Info.m_QuickSearchHit |= IServerBrowser::QUICK_MAPNAME;
-				}
-
-				if(!MatchFound)
-					Filtered = 1;
-			}
-
-			if(!Filtered && g_Config.m_BrExcludeString[0] != 0)
-			{
-				int MatchFound = 0;
-
-				// match against server name
-				if(str_find_nocase(m_ppServerlist[i]->m_Info.m_aName, g_Config.m_BrExcludeString))
-				{
-					MatchFound = 1;
-				}
-
-				// match against map
-				if(str_find_nocase(m_ppServerlist[i]->m_Info.m_aMap, g_Config.m_BrExcludeString))
-				{
-					MatchFound = 1;
-				}
-
-				if(MatchFound)
-					Filtered = 1;
-			}
-		}
-
-		if(Filtered == 0)
-		{
-			// check for friend
-			m_ppServerlist[i]->m_Info.m_FriendState = IFriends::FRIEND_NO;
-			for(p = 0; p < m_ppServerlist[i]->m_Info.m_NumClients; p++)
-			{
-				m_ppServerlist[i]->m_Info.m_aClients[p].m_FriendState = m_pFriends->GetFriendState(
-						m_ppServerlist[i]->m_Info.m_aClients[p].m_aName,
-						m_ppServerlist[i]->m_Info.m_aClients[p].m_aClan
-				);
-				m_ppServerlist[i]->m_Info.m_FriendState = max(m_ppServerlist[i]->m_Info.m_FriendState, m_ppServerlist[i]->m_Info.m_aClients[p].m_FriendState);
-			}
+		pEntry->m_Info.m_aClients[p].m_FriendState = m_pFriends->GetFriendState(pEntry->m_Info.m_aClients[p].m_aName, pEntry->m_Info.m_aClients[p].m_aClan);
+		pEntry->m_Info.m_FriendState = max(pEntry->m_Info.m_FriendState, pEntry->m_Info.m_aClients[p].m_FriendState);
+	}
 
-			if(!g_Config.m_BrFilterFriends || m_ppServerlist[i]->m_Info.m_FriendState != IFriends::FRIEND_NO)
-				m_pSortedServerlist[m_NumSortedServers++] = i;
-		}
+	if(g_Config.m_BrFilterFriends && pEntry->m_Info.m_FriendState == IFriends::FRIEND_NO)
+	{
+		m_SortOrder.Remove(Index);
+		return;
 	}
+
+	// sort
+	if(g_Config.m_BrSort == IServerBrowser::SORT_NAME)
+		m_SortOrder.Insert(Index, pEntry->m_GotInfo ? 0 : 1, 0, pEntry->m_Info.m_aName); // make sure empty entries are listed last
+	else if(g_Config.m_BrSort == IServerBrowser::SORT_PING)
+		m_SortOrder.Insert(Index, 0, pEntry->m_Info.m_Latency, 0);
+	else if(g_Config.m_BrSort == IServerBrowser::SORT_MAP)
+		m_SortOrder.Insert(Index, 0, 0, pEntry->m_Info.m_aMap);
+	else if(g_Config.m_BrSort == IServerBrowser::SORT_NUMPLAYERS)
+		m_SortOrder.Insert(Index, 0, g_Config.m_BrFilterSpectators ? pEntry->m_Info.m_NumPlayers : pEntry->m_Info.m_NumClients, 0);
+	else if(g_Config.m_BrSort == IServerBrowser::SORT_GAMETYPE)
+		m_SortOrder.Insert(Index, 0, 0, pEntry->m_Info.m_aGameType);
+	else
+		m_SortOrder.Insert(Index, 0, 0, 0);
 }
 
 int64 CServerBrowser::SortHash() const
@@ -452,7 +345,6 @@ int64 CServerBrowser::SortHash() const
 	i |= g_Config.m_BrFilterVersionStrict	<< n++;
 	i |= g_Config.m_BrFilterCountry			<< n++;
 	i |= g_Config.m_BrFilterPing			<< n++;
-	i |= m_NumServers						<< n++;
 	return i;
 }
 
@@ -462,21 +354,51 @@ void CServerBrowser::Sort()
 
 	int i;
 
-	// create filtered list
-	Filter();
+	// the servers are filtered and put in order as their infos arrive,
+	// only a change of the settings or the friends has to go over all of them again
+	CServerFilter::CSettings Settings;
+	GetFilterSettings(&Settings);
+	bool Refilter = m_Filter.SetSettings(Settings) || m_NeedRefilter;
+	if(m_FriendsRevision != m_pFriends->Revision())
+	{
+		m_FriendsRevision = m_pFriends->Revision();
+		Refilter = true;
+	}
 
-	// sort
-	if(g_Config.m_BrSort == IServerBrowser::SORT_NAME)
-		std::stable_sort(m_pSortedServerlist, m_pSortedServerlist+m_NumSortedServers, SortWrap(this, &CServerBrowser::SortCompareName));
-	else if(g_Config.m_BrSort == IServerBrowser::SORT_PING)
-		std::stable_sort(m_pSortedServerlist, m_pSortedServerlist+m_NumSortedServers, SortWrap(this, &CServerBrowser::SortComparePing));
-	else if(g_Config.m_BrSort == IServerBrowser::SORT_MAP)
-		std::stable_sort(m_pSortedServerlist, m_pSortedServerlist+m_NumSortedServers, SortWrap(this, &CServerBrowser::SortCompareMap));
-	else if(g_Config.m_BrSort == IServerBrowser::SORT_NUMPLAYERS)
-		std::stable_sort(m_pSortedServerlist, m_pSortedServerlist+m_NumSortedServers, SortWrap(this,
-					g_Config.m_BrFilterSpectators ? &CServerBrowser::SortCompareNumPlayers : &CServerBrowser::SortCompareNumClients));
-	else if(g_Config.m_BrSort == IServerBrowser::SORT_GAMETYPE)
-		std::stable_sort(m_pSortedServerlist, m_pSortedServerlist+m_NumSortedServers, SortWrap(this, &CServerBrowser::SortCompareGametype));
+	int SortCriteria = (g_Config.m_BrSort&0xf) | (g_Config.m_BrSortOrder ? 0x10 : 0) | (g_Config.m_BrFilterSpectators ? 0x20 : 0);
+	if(SortCriteria != m_SortCriteria)
+	{
+		m_SortCriteria = SortCriteria;
+		bool Strings = g_Config.m_BrSort == IServerBrowser::SORT_NAME || g_Config.m_BrSort == IServerBrowser::SORT_MAP || g_Config.m_BrSort == IServerBrowser::SORT_GAMETYPE;
+		m_SortOrder.Init(Strings, g_Config.m_BrSortOrder != 0);
+		Refilter = true;
+	}
+
+	if(Refilter)
+	{
+		// the filter string is looked up in the search index once instead of in every server
+		int NumFound = -1;
+		if(Settings.m_aFilterString[0])
+		{
+			m_aSearchHits.set_size(m_NumServers);
+			NumFound = m_SearchIndex.Search(Settings.m_aFilterString, m_aSearchHits.base_ptr());
+		}
+
+		m_SortOrder.Clear();
+		for(i = 0; i < m_NumServers; i++)
+			Filter(i, NumFound >= 0 ? m_aSearchHits[i] : -1);
+		m_NeedRefilter = false;
+	}
+
+	// allocate the sorted list
+	if(m_NumSortedServersCapacity < m_NumServers)
+	{
+		if(m_pSortedServerlist)
+			mem_free(m_pSortedServerlist);
+		m_NumSortedServersCapacity = m_NumServers;
+		m_pSortedServerlist = (int *)mem_alloc(m_NumSortedServersCapacity*sizeof(int), 1);
+	}
+	m_NumSortedServers = m_SortOrder.Flatten(m_pSortedServerlist);
 
 	// set indexes
 	for(i = 0; i < m_NumSortedServers; i++)
@@ -487,57 +409,31 @@ void CServerBrowser::Sort()
 	m_Sorthash = SortHash();
 }
 
-void CServerBrowser::RemoveRequest(CServerEntry *pEntry)
+void CServerBrowser::ResetRequests()
 {
-	if(pEntry->m_pPrevReq || pEntry->m_pNextReq || m_pFirstReqServer == pEntry)
-	{
-		if(pEntry->m_pPrevReq)
-			pEntry->m_pPrevReq->m_pNextReq = pEntry->m_pNextReq;
-		else
-			m_pFirstReqServer = pEntry->m_pNextReq;
-
-		if(pEntry->m_pNextReq)
-			pEntry->m_pNextReq->m_pPrevReq = pEntry->m_pPrevReq;
-		else
-			m_pLastReqServer = pEntry->m_pPrevReq;
-
-		pEntry->m_pPrevReq = 0;
-		pEntry->m_pNextReq = 0;
-		m_NumRequests--;
-	}
+	m_Requests.Reset(g_Config.m_BrRequestRate, g_Config.m_BrMaxRequests, g_Config.m_BrCurrRequestsAbortLimit);
 }
 
 CServerBrowser::CServerEntry *CServerBrowser::Find(const NETADDR &Addr)
 {
 	LOCK_SECTION_RECURSIVE_MUTEX_OPT(m_Mutex, return NULL)
 
-	CServerEntry *pEntry = m_aServerlistIp[Addr.ip[0]];
-	for(; pEntry; pEntry = pEntry->m_pNextIp)
-	{
-		if(net_addr_comp(&pEntry->m_Addr, &Addr) == 0)
-			return pEntry;
-	}
-	return NULL;
+	return m_ServerlistIp.Find(&Addr);
 }
 
 void CServerBrowser::QueueRequest(CServerEntry *pEntry)
 {
-	// add it to the list of servers that we should request info from
-	pEntry->m_pPrevReq = m_pLastReqServer;
-	if(m_pLastReqServer)
-		m_pLastReqServer->m_pNextReq = pEntry;
-	else
-		m_pFirstReqServer = pEntry;
-	m_pLastReqServer = pEntry;
-	pEntry->m_pNextReq = 0;
-	m_NumRequests++;
+	// add it to the servers that we should request info from, favorites first
+	m_Requests.Queue(pEntry->m_Info.m_ServerIndex, pEntry->m_Info.m_Favorite ? CRequestScheduler::PRIO_FAVORITE : CRequestScheduler::PRIO_NORMAL);
 }
 
 void CServerBrowser::SetInfo(CServerEntry *pEntry, const CServerInfo &Info)
 {
 	int Fav = pEntry->m_Info.m_Favorite;
+	int ServerIndex = pEntry->m_Info.m_ServerIndex;
 	pEntry->m_Info = Info;
 	pEntry->m_Info.m_Favorite = Fav;
+	pEntry->m_Info.m_ServerIndex = ServerIndex;
 	pEntry->m_Info.m_NetAddr = pEntry->m_Addr;
 
 	// all these are just for nice compability
@@ -548,6 +444,9 @@ void CServerBrowser::SetInfo(CServerEntry *pEntry, const CServerInfo &Info)
 	else if(pEntry->m_Info.m_aGameType[0] == '2' && pEntry->m_Info.m_aGameType[1] == 0)
 		str_copy(pEntry->m_Info.m_aGameType, "CTF", sizeof(pEntry->m_Info.m_aGameType));
 
+	pEntry->m_FilterKeys.Set(&pEntry->m_Info);
+	m_SearchIndex.Update(pEntry->m_Info.m_ServerIndex, &pEntry->m_FilterKeys, pEntry->m_Info.m_NumClients);
+
 	/*if(!request)
 	{
 		pEntry->m_Info.latency = (time_get()-pEntry->request_time)*1000/time_freq();
@@ -559,9 +458,7 @@ void CServerBrowser::SetInfo(CServerEntry *pEntry, const CServerInfo &Info)
 
 CServerBrowser::CServerEntry *CServerBrowser::Add(const NETADDR &Addr)
 {
-	int Hash = Addr.ip[0];
 	CServerEntry *pEntry = 0;
-	int i;
 
 	// create new pEntry
 	pEntry = (CServerEntry *)m_ServerlistHeap.Allocate(sizeof(CServerEntry));
@@ -575,22 +472,18 @@ CServerBrowser::CServerEntry *CServerBrowser::Add(const NETADDR &Addr)
 	pEntry->m_Info.m_Latency = 999;
 	net_addr_str(&Addr, pEntry->m_Info.m_aAddress, sizeof(pEntry->m_Info.m_aAddress), true);
 	str_copy(pEntry->m_Info.m_aName, pEntry->m_Info.m_aAddress, sizeof(pEntry->m_Info.m_aName));
+	pEntry->m_FilterKeys.Set(&pEntry->m_Info);
 
 	// check if it's a favorite
-	for(i = 0; i < m_NumFavoriteServers; i++)
-	{
-		if(net_addr_comp(&Addr, &m_aFavoriteServers[i]) == 0)
-			pEntry->m_Info.m_Favorite = 1;
-	}
+	pEntry->m_Info.m_Favorite = m_FavoriteSet.Contains(&Addr);
 
-	// add to the hash list
-	pEntry->m_pNextIp = m_aServerlistIp[Hash];
-	m_aServerlistIp[Hash] = pEntry;
+	// add to the hash table
+	m_ServerlistIp.Insert(pEntry);
 
 	if(m_NumServers == m_NumServerCapacity)
 	{
 		CServerEntry **ppNewlist;
-		m_NumServerCapacity += 100;
+		m_NumServerCapacity = max(256, m_NumServerCapacity*2);
 		ppNewlist = (CServerEntry **)mem_alloc(m_NumServerCapacity*sizeof(CServerEntry*), 1);
 		mem_copy(ppNewlist, m_ppServerlist, m_NumServers*sizeof(CServerEntry*));
 		mem_free(m_ppServerlist);
@@ -602,6 +495,8 @@ CServerBrowser::CServerEntry *CServerBrowser::Add(const NETADDR &Addr)
 	pEntry->m_Info.m_ServerIndex = m_NumServers;
 	m_NumServers++;
 
+	m_SearchIndex.Update(pEntry->m_Info.m_ServerIndex, &pEntry->m_FilterKeys, pEntry->m_Info.m_NumClients);
+
 	return pEntry;
 }
 
@@ -690,28 +585,21 @@ void CServerBrowser::Set(const NETADDR &Addr, int Type, int Token, const CServer
 				pEntry->m_Info.m_Latency = min(static_cast<int>((time_get()-pEntry->m_RequestTime)*1000/time_freq()), 999);
 				pEntry->m_RequestTime = -1; // Request has been answered
 			}
-			RemoveRequest(pEntry);
+			m_Requests.Answered(pEntry->m_Info.m_ServerIndex, time_get());
 		}
 	}
 
+	// only the server that changed has to be filtered and put in place again
+	if(pEntry && m_SortCriteria != -1)
+		Filter(pEntry->m_Info.m_ServerIndex);
+
 	if(!NoSort)
 		Sort();
 }
 
 void CServerBrowser::AbortRefresh()
 {
-	CServerEntry *pEntry = m_pFirstReqServer;
-	while(pEntry)
-	{
-		CServerEntry *pNext = pEntry->m_pNextReq;
-		RemoveRequest(pEntry); // release request
-		pEntry = pNext;
-	}
-
-	m_pFirstReqServer = 0;
-	m_pLastReqServer = 0;
-	m_NumRequests = 0;
-	m_CurrentMaxRequests = g_Config.m_BrMaxRequests;
+	ResetRequests();
 
 	m_NeedRefresh = false;
 }
@@ -728,11 +616,10 @@ void CServerBrowser::Refresh(int Type)
 		m_ServerlistHeap.Reset();
 		m_NumServers = 0;
 		m_NumSortedServers = 0;
-		mem_zero(m_aServerlistIp, sizeof(m_aServerlistIp));
-		m_pFirstReqServer = 0;
-		m_pLastReqServer = 0;
-		m_NumRequests = 0;
-		m_CurrentMaxRequests = g_Config.m_BrMaxRequests;
+		m_SortOrder.Clear();
+		m_ServerlistIp.Clear();
+		m_SearchIndex.Clear();
+		ResetRequests();
 		// next token
 		m_CurrentToken = secure_rand()%0xFF;
 
@@ -818,7 +705,7 @@ void CServerBrowser::RefreshQuick()
 	if(IsRefreshing())
 		AbortRefresh();
 
-	m_CurrentMaxRequests = g_Config.m_BrMaxRequests;
+	ResetRequests();
 
 	const int Length = NumServers();
 
@@ -832,9 +719,10 @@ void CServerBrowser::RefreshQuick()
 				continue;
 			pEntry->m_RequestTime = /*Now*/0;
 			pEntry->m_GotInfo = 0;
-			QueueRequest(m_ppServerlist[i]);
+			QueueRequest(pEntry);
 		}
 	}
+	m_NeedRefilter = true;
 }
 
 void CServerBrowser::SaveCache()
@@ -856,171 +744,75 @@ void CServerBrowser::SaveCache()
 		return;
 	}
 
-	// save version of serverlist cache file
-	{ char v = CACHE_VERSION; io_write(File, &v, 1); } // save version of cachefile
-
-	// save number of servers
-	io_write(File, &m_NumServers, sizeof(m_NumServers)); // save number of servers
-
-	// save array length
-	io_write(File, &m_NumServerCapacity, sizeof(m_NumServerCapacity)); // save length of array
-
-	// save all the infos
-	CServerInfo *aAllInfos = mem_allocb(CServerInfo, m_NumServers);
+	CServerListCache::CWriter Writer;
 	for(int i = 0; i < m_NumServers; i++)
-		aAllInfos[i] = m_ppServerlist[i]->m_Info;
-
-	const unsigned int SIZE = sizeof(CServerInfo)*m_NumServers;
-	unsigned char *pCompressed = (unsigned char *)mem_alloc(SIZE, 0);
-	int CompressedSize = CNetBase::Compress(aAllInfos, SIZE, pCompressed, SIZE);
-	io_write(File, &CompressedSize, sizeof(CompressedSize));
-
-	dbg_msg("browser/cache", "compressed %lu -> %i", (unsigned long)(sizeof(CServerInfo)*m_NumServers), CompressedSize);
-
-	if(CompressedSize == -1)
-		io_write(File, aAllInfos, SIZE);
-	else
-		io_write(File, pCompressed, (unsigned int)CompressedSize);
-
+		Writer.Add(&m_ppServerlist[i]->m_Info);
+	std::vector<char> aData;
+	Writer.Finish(&aData);
+	io_write(File, &aData[0], (unsigned)aData.size());
 	io_close(File);
-	mem_free(pCompressed);
-	mem_free(aAllInfos);
 
 	if(g_Config.m_Debug)
-		dbg_msg("browser", "successfully saved serverlist with %i entries", m_NumServers);
+		dbg_msg("browser", "successfully saved serverlist with %i entries, %u bytes", m_NumServers, (unsigned)aData.size());
 	m_CacheExists = true;
 }
 
 void CServerBrowser::LoadCache()
 {
-	m_ServerlistType = TYPE_INTERNET;
-	m_pThread = thread_init(LoadCacheThread, this);
-}
-
-void CServerBrowser::LoadCacheWait()
-{
-	LoadCache();
-	LOCK_SECTION_RECURSIVE_MUTEX(m_Mutex);
-}
-
-void CServerBrowser::LoadCacheThread(void *pUser)
-{
-	CServerBrowser *pSelf = (CServerBrowser *)pUser;
-	IStorageTW *pStorage = pSelf->Kernel()->RequestInterface<IStorageTW>();
+	LOCK_SECTION_RECURSIVE_MUTEX_OPT(m_Mutex, return)
 
 	int64 StartTime = time_get();
 
-	LOCK_SECTION_RECURSIVE_MUTEX(pSelf->m_Mutex);
-
 	// clear out everything
-	pSelf->m_ServerlistHeap.Reset();
-	pSelf->m_NumServers = 0;
-	pSelf->m_NumSortedServers = 0;
-	mem_zero(pSelf->m_aServerlistIp, sizeof(pSelf->m_aServerlistIp));
-	pSelf->m_pFirstReqServer = 0;
-	pSelf->m_pLastReqServer = 0;
-	pSelf->m_NumRequests = 0;
-	pSelf->m_CurrentMaxRequests = g_Config.m_BrMaxRequests;
-	pSelf->m_CurrentToken = 0;
-	pSelf->m_ServerlistType = IServerBrowser::TYPE_INTERNET;
-
-	// open file
-	IOHANDLE File = pStorage->OpenFile("tmp/cache/serverlist", IOFLAG_READ, IStorageTW::TYPE_SAVE);
-	if(!File)
+	m_ServerlistHeap.Reset();
+	m_NumServers = 0;
+	m_NumSortedServers = 0;
+	m_SortOrder.Clear();
+	m_ServerlistIp.Clear();
+	m_SearchIndex.Clear();
+	ResetRequests();
+	m_CurrentToken = 0;
+	m_ServerlistType = IServerBrowser::TYPE_INTERNET;
+
+	// the file is mapped, the servers are read from it in place. it's unmapped again before the lock is released,
+	// SaveCache rewrites the file under the same lock, so the file can't change while it is mapped
+	IStorageTW *pStorage = Kernel()->RequestInterface<IStorageTW>();
+	char aPath[512];
+	pStorage->GetCompletePath(IStorageTW::TYPE_SAVE, "tmp/cache/serverlist", aPath, sizeof(aPath));
+	unsigned Size;
+	const void *pData = fs_map_file(aPath, &Size);
+	if(!pData)
 	{
 		dbg_msg("browser", "opening cache file failed.");
-		pSelf->m_CacheExists = false;
-		return;// false;
+		m_CacheExists = false;
+		return;
 	}
 
-	// get version
+	CServerListCache Cache;
+	if(!Cache.Open(pData, Size))
 	{
-		char v; io_read(File, &v, 1);
-		if(g_Config.m_Debug)
-			dbg_msg("browser", "loading serverlist from cache...");
-		if(v != CACHE_VERSION)
-		{
-			dbg_msg("browser", "couldn't load cache: file version doesn't match! (%i != %i)", v, CACHE_VERSION);
-			pSelf->m_CacheExists = false;
-			return;
-		}
+		dbg_msg("browser", "couldn't load cache: the file is broken or of another version (current %i)", CACHE_VERSION);
+		fs_unmap_file(pData, Size);
+		m_CacheExists = false;
+		return;
 	}
 
-	// get number of servers
-	int NumServers;
-	io_read(File, &NumServers, sizeof(NumServers));
-	//dbg_msg("browser", "serverlist cache entries: %i", NumServers);
-
-	// get length of array
-	io_read(File, &pSelf->m_NumServerCapacity, sizeof(pSelf->m_NumServerCapacity));
-
-	// get rid of current serverlist and create a new one
-	mem_free(pSelf->m_ppServerlist);
-	pSelf->m_ppServerlist = (CServerEntry **)mem_alloc(pSelf->m_NumServerCapacity*sizeof(CServerEntry*), 1);
-
-	// read the compressed size data
-	int CompressedSize;
-	io_read(File, &CompressedSize, sizeof(CompressedSize));
-
-	// read the data from the file into the serverlist
-	if(CompressedSize == -1)
-	{
-		// if the data is not compressed, read the entries as they are
-		for(int i = 0; i < NumServers; i++)
-		{
-			CServerInfo Info;
-			io_read(File, &Info, sizeof(CServerInfo));
-
-			NETADDR Addr;
-			net_addr_from_str(&Addr, Info.m_aAddress);
-			//dbg_msg("browser", "loading %i %s %s", i, Info.m_aAddress, Info.m_aName);
-			pSelf->Set(Addr, IServerBrowser::SET_TOKEN, pSelf->m_CurrentToken, &Info, true);
-		}
-	}
-	else
+	for(int i = 0; i < Cache.NumServers(); i++)
 	{
-		// allocate some memory
-		const unsigned int SIZE = sizeof(CServerInfo)*NumServers;
-		CServerInfo *aAllInfos = mem_allocb(CServerInfo, NumServers);
-		unsigned char *pCompressed = (unsigned char *)mem_alloc((unsigned int)CompressedSize, 0);
-
-		// read the data from the file and try to decompress it
-		io_read(File, pCompressed, (unsigned int)CompressedSize);
-		int DecompressedSize = CNetBase::Decompress(pCompressed, CompressedSize, aAllInfos, SIZE);
-		mem_free(pCompressed);
-
-		// process the data
-		if(DecompressedSize == -1)
-		{
-			// if decompression failed, return with no serverlist
-			dbg_msg("browser", "failed to decompress the serverlist cache");
-			io_close(File);
-			mem_free(aAllInfos);
-			pSelf->m_CacheExists = false;
-			return;
-		}
-		else
-		{
-			// process all the entries
-			dbg_msg("browser", "decompressed serverlist cache %i -> %i", CompressedSize, DecompressedSize);
-			for(int i = 0; i < NumServers; i++)
-			{
-				CServerInfo Info;
-				mem_copy(&Info, &aAllInfos[i], sizeof(CServerInfo));
-				NETADDR Addr;
-				net_addr_from_str(&Addr, Info.m_aAddress);
-				//dbg_msg("browser", "loading %i %s %s", i, Info.m_aAddress, Info.m_aName);
-				pSelf->Set(Addr, IServerBrowser::SET_TOKEN, pSelf->m_CurrentToken, &Info, true);
-			}
-		}
-		mem_free(aAllInfos);
+		CServerInfo Info;
+		if(Cache.Get(i, &Info))
+			Set(Cache.Addr(i), IServerBrowser::SET_TOKEN, m_CurrentToken, &Info, true);
 	}
-
-	io_close(File);
+	fs_unmap_file(pData, Size);
 
 	if(g_Config.m_Debug)
-		dbg_msg("browser", "successfully loaded serverlist cache with %i entries (total %i), took %.2fms", pSelf->m_NumServers, NumServers, ((time_get()-StartTime)*1000)/(float)time_freq()); // TODO: check if saving actually succeeded
-	pSelf->Sort();
+		dbg_msg("browser", "successfully loaded serverlist cache with %i entries (total %i), took %.2fms", m_NumServers, Cache.NumServers(), ((time_get()-StartTime)*1000)/(float)time_freq());
+	Sort();
+}
+
+void CServerBrowser::LoadCacheWait()
+{
+	LoadCache();
 }
 
 void CServerBrowser::RequestImpl(const NETADDR &Addr, CServerEntry *pEntry) const
@@ -1174,60 +966,38 @@ void CServerBrowser::RequestServerList()
 
 void CServerBrowser::ProcessServerList()
 {
-	int64 Timeout = time_freq();
 	int64 Now = time_get();
-	CServerEntry *pEntry;
 
-	pEntry = m_pFirstReqServer;
-	int Count = 0;
-	while(pEntry) // go through all entries that we currently have and request the infos
+	// retry what timed out, give up when nothing comes back at all
+	m_Requests.Expire(Now);
+	if(m_Requests.Stalled())
 	{
-		// check if entry timed out
-		if(pEntry->m_RequestTime && pEntry->m_RequestTime+Timeout < Now)
-		{
-			pEntry = pEntry->m_pNextReq;
-			continue;
-		}
-
-		// no more than X concurrent requests
-		if(Count >= m_CurrentMaxRequests)
-			break;
-
-		if(pEntry->m_RequestTime == 0)
-		{
-			if (pEntry->m_Request64Legacy)
-				RequestImpl64(pEntry->m_Addr, pEntry);
-			else
-				RequestImpl(pEntry->m_Addr, pEntry);
-		}
-
-		Count++;
-		pEntry = pEntry->m_pNextReq;
+		AbortRefresh();
+		return;
 	}
 
-	// no more current server requests
-	if(Count == 0)
-	{
-		if(m_pFirstReqServer && m_CurrentMaxRequests > g_Config.m_BrCurrRequestsAbortLimit)
-		{
-			// reset old ones
-			pEntry = m_pFirstReqServer;
-			while(pEntry)
-			{
-				pEntry->m_RequestTime = 0;
-				pEntry = pEntry->m_pNextReq;
-			}
+	// the rows on screen go first
+	for(int i = m_VisibleFirst; i < m_VisibleFirst+m_VisibleNum && i < m_NumSortedServers; i++)
+		m_Requests.Promote(m_pSortedServerlist[i], CRequestScheduler::PRIO_VISIBLE);
 
-			// update max-requests
-			m_CurrentMaxRequests /= 2;
-			if(m_CurrentMaxRequests <= g_Config.m_BrCurrRequestsAbortLimit)
-			{
-				AbortRefresh();
-			}
-		}
+	// as many as the rate allows since the last frame
+	int Index;
+	while((Index = m_Requests.Next(Now)) >= 0)
+	{
+		CServerEntry *pEntry = m_ppServerlist[Index];
+		if(pEntry->m_Request64Legacy)
+			RequestImpl64(pEntry->m_Addr, pEntry);
+		else
+			RequestImpl(pEntry->m_Addr, pEntry);
 	}
 }
 
+void CServerBrowser::SetVisibleRange(int First, int Num)
+{
+	m_VisibleFirst = max(First, 0);
+	m_VisibleNum = max(Num, 0);
+}
+
 void CServerBrowser::Update(bool ForceResort)
 {
 	// StateMachine part 1: do server list requests
@@ -1247,7 +1017,7 @@ void CServerBrowser::Update(bool ForceResort)
 		ProcessServerCount();
 	}
 
-	if(m_MasterServerCount > m_NumRequests + m_LastPacketTick)
+	if(m_MasterServerCount > m_Requests.NumPending() + m_LastPacketTick)
 	{
 		++m_LastPacketTick;
 		return; // wait for more packets
@@ -1260,35 +1030,26 @@ void CServerBrowser::Update(bool ForceResort)
 	// check if we need to resort
 //	if(!(g_Config.m_BrLazySorting && IsRefreshing() && LoadingProgression() < 90))
 		if(ForceResort || m_Sorthash != SortHash())
+		{
+			if(ForceResort)
+				m_NeedRefilter = true;
 			Sort();
+		}
 }
 
 
 bool CServerBrowser::IsFavorite(const NETADDR &Addr) const
 {
-	// search for the address
-	int i;
-	for(i = 0; i < m_NumFavoriteServers; i++)
-	{
-		if(net_addr_comp(&Addr, &m_aFavoriteServers[i]) == 0)
-			return true;
-	}
-	return false;
+	return m_FavoriteSet.Contains(&Addr);
 }
 
 void CServerBrowser::AddFavorite(const NETADDR &Addr)
 {
 	CServerEntry *pEntry;
 
-	if(m_NumFavoriteServers == MAX_FAVORITES)
-		return;
-
 	// make sure that we don't already have the server in our list
-	for(int i = 0; i < m_NumFavoriteServers; i++)
-	{
-		if(net_addr_comp(&Addr, &m_aFavoriteServers[i]) == 0)
-			return;
-	}
+	if(m_NumFavoriteServers == MAX_FAVORITES || !m_FavoriteSet.Insert(&Addr))
+		return;
 
 	// add the server to the list
 	m_aFavoriteServers[m_NumFavoriteServers++] = Addr;
@@ -1312,6 +1073,9 @@ void CServerBrowser::RemoveFavorite(const NETADDR &Addr)
 	int i;
 	CServerEntry *pEntry;
 
+	if(!m_FavoriteSet.Remove(&Addr))
+		return;
+
 	for(i = 0; i < m_NumFavoriteServers; i++)
 	{
 		if(net_addr_comp(&Addr, &m_aFavoriteServers[i]) == 0)
@@ -1346,8 +1110,9 @@ void CServerBrowser::AddRecent(const NETADDR& Addr)
 		char aNetAddrStr[NETADDR_MAXSTRSIZE];
 		net_addr_str(&Addr, aNetAddrStr, sizeof(aNetAddrStr), Addr.port);
 
-		char *pQueryBuf = sqlite3_mprintf("INSERT OR REPLACE INTO recent (addr) VALUES ('%q');", aNetAddrStr);
-		CQueryRecent *pQuery = new CQueryRecent(pQueryBuf);
+		CQueryRecent *pQuery = new CQueryRecent();
+		pQuery->SetTemplate("INSERT OR REPLACE INTO recent (addr) VALUES (?);");
+		pQuery->BindText(aNetAddrStr);
 		m_pRecentDB->InsertQuery(pQuery);
 
 		m_pConsole->Printf(IConsole::OUTPUT_LEVEL_DEBUG, "srvbrowse", "added recent '%s'", aNetAddrStr);
@@ -1371,8 +1136,9 @@ void CServerBrowser::RemoveRecent(const NETADDR& Addr)
 		char aNetAddrStr[NETADDR_MAXSTRSIZE];
 		net_addr_str(&Addr, aNetAddrStr, sizeof(aNetAddrStr), Addr.port);
 
-		char *pQueryBuf = sqlite3_mprintf("DELETE FROM recent WHERE addr = '%q';", aNetAddrStr);
-		CQueryRecent *pQuery = new CQueryRecent(pQueryBuf);
+		CQueryRecent *pQuery = new CQueryRecent();
+		pQuery->SetTemplate("DELETE FROM recent WHERE addr = ?;");
+		pQuery->BindText(aNetAddrStr);
 		m_pRecentDB->InsertQuery(pQuery);
 
 		m_pConsole->Printf(IConsole::OUTPUT_LEVEL_DEBUG, "srvbrowse", "removed recent '%s'", aNetAddrStr);
@@ -1496,7 +1262,7 @@ void CServerBrowser::LoadDDNet()
 
 bool CServerBrowser::IsRefreshing() const
 {
-	return m_pFirstReqServer != 0;
+	return m_Requests.Pending();
 }
 
 bool CServerBrowser::IsRefreshingMasters() const
@@ -1511,7 +1277,7 @@ int CServerBrowser::LoadingProgression() const
 		return 0;
 
 	float Servers = m_NumServers;
-	float Loaded = m_NumServers-m_NumRequests;
+	float Loaded = m_NumServers-m_Requests.NumPending();
 	return round_to_int(100.0f * Loaded/Servers);
 }
 
@@ -9,15 +9,25 @@
 #include <mastersrv/mastersrv.h>
 #include <engine/masterserver.h>
 #include <engine/shared/memheap.h>
+#include <engine/shared/netaddr_hash.h>
 #include <engine/config.h>
 
+#include "serverbrowser_cache.h"
+#include "serverbrowser_filter.h"
+#include "serverbrowser_requests.h"
+#include "serverbrowser_search.h"
+
 /**
- * FORMAT OF THE SERVERLIST CACHE FILE (version identifier '1')
+ * FORMAT OF THE SERVERLIST CACHE FILE (version identifier CACHE_VERSION, see CServerListCache)
  *
- * char - file version<br>
- * int  - number of helt servers [NumServers]<br>
- * int  - array capacity<br>
- * sizeof(CServerInfo)*NumServers - all the entries<br>
+ * char[4] - "TWSL"<br>
+ * int  - file version<br>
+ * int  - number of held servers [NumServers]<br>
+ * int  - number of received clients of all servers [NumClients]<br>
+ * int  - size of the string pool [StringsSize]<br>
+ * sizeof(CServerListCache::CServer)*NumServers - the servers, strings as offsets into the pool<br>
+ * sizeof(CServerListCache::CClient)*NumClients - the clients, by server<br>
+ * StringsSize - every string once, zero terminated<br>
  */
 
 class CServerBrowser : public IServerBrowser
@@ -32,11 +42,9 @@ public:
 		bool m_Request64Legacy;
 		int m_ExtraToken;
 		CServerInfo m_Info;
+		CServerFilterKeys m_FilterKeys;
 
-		CServerEntry *m_pNextIp; // ip hashed list
-
-		CServerEntry *m_pPrevReq; // request list
-		CServerEntry *m_pNextReq;
+		CServerEntry *m_pNextIp; // address hash table
 	};
 
 	class CDDNetCountry
@@ -97,7 +105,6 @@ public:
 	void SaveCache();
 	void LoadCache();
 	void LoadCacheWait();
-	static void LoadCacheThread(void *pUser);
 	bool CacheExists() const { return m_CacheExists; }
 	bool IsRefreshing() const;
 	bool IsRefreshingMasters() const;
@@ -109,8 +116,10 @@ public:
 	int NumSortedServers() const { return m_NumSortedServers; }
 	const CServerInfo *SortedGet(int Index);
 	const CServerInfo *Get(int Index);
+	int Search(const char *pQuery, const CServerInfo **apResults, int *paHits, int MaxResults);
 	int GetInfoAge(int Index) const;
 	const char *GetDebugString(int Index) const;
+	void SetVisibleRange(int First, int Num);
 
 	bool IsFavorite(const NETADDR &Addr) const;
 	void AddFavorite(const NETADDR &Addr);
@@ -164,6 +173,7 @@ private:
 
 	NETADDR m_aFavoriteServers[MAX_FAVORITES];
 	int m_NumFavoriteServers;
+	CNetAddrHashSet m_FavoriteSet;
 
 	CSql *m_pRecentDB;
 	sorted_array<RecentServer> m_aRecentServers;
@@ -174,15 +184,14 @@ private:
 	char m_aDDNetTypes[MAX_DDNET_TYPES][32];
 	int m_NumDDNetTypes;
 
-	CServerEntry *m_aServerlistIp[256]; // ip hash list
+	CNetAddrHashTable<CServerEntry> m_ServerlistIp;
 
-	CServerEntry *m_pFirstReqServer; // request list
-	CServerEntry *m_pLastReqServer;
-	int m_NumRequests;
+	CRequestScheduler m_Requests;
 	int m_MasterServerCount;
 
-	// used instead of g_Config.BrMaxRequests to get more servers
-	int m_CurrentMaxRequests;
+	// the sorted rows on screen, their infos are requested first
+	int m_VisibleFirst;
+	int m_VisibleNum;
 
 	int m_LastPacketTick;
 
@@ -194,6 +203,15 @@ private:
 	int m_NumServers;
 	int m_NumServerCapacity;
 
+	// the filtered servers in order, updated per server as their infos arrive
+	CServerFilter m_Filter;
+	CServerSortOrder m_SortOrder;
+	int m_SortCriteria;
+	int m_FriendsRevision;
+	bool m_NeedRefilter;
+	CServerSearchIndex m_SearchIndex;
+	array<int> m_aSearchHits;
+
 	int64 m_Sorthash;
 	char m_aFilterString[64];
 	char m_aFilterGametypeString[128];
@@ -204,26 +222,17 @@ private:
 	int m_ServerlistType;
 	int64 m_BroadcastTime;
 	int m_BroadcastExtraToken;
-
-	void *m_pThread;
 	std::recursive_mutex m_Mutex;
 
-	// sorting criteria
-	bool SortCompareName(int Index1, int Index2) const;
-	bool SortCompareMap(int Index1, int Index2) const;
-	bool SortComparePing(int Index1, int Index2) const;
-	bool SortCompareGametype(int Index1, int Index2) const;
-	bool SortCompareNumPlayers(int Index1, int Index2) const;
-	bool SortCompareNumClients(int Index1, int Index2) const;
-
 	//
-	void Filter();
+	void GetFilterSettings(CServerFilter::CSettings *pSettings) const;
+	void Filter(int Index, int SearchHit = -1);
 	void Sort();
 	int64 SortHash() const;
 
 	CServerEntry *Add(const NETADDR &Addr);
 
-	void RemoveRequest(CServerEntry *pEntry);
+	void ResetRequests();
 
 	void RequestImpl(const NETADDR &Addr, CServerEntry *pEntry) const;
 
@@ -237,6 +246,10 @@ class CQueryRecent : public CQuery
 	sorted_array<CServerBrowser::RecentServer> *m_paRecentList;
 
 public:
+	CQueryRecent() : m_paRecentList(0)
+	{
+	}
+
 	CQueryRecent(char *pQueryBuf) : CQuery(pQueryBuf),
 			m_paRecentList(0)
 	{
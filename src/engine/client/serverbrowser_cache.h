@@ -0,0 +1,222 @@
+#ifndef ENGINE_CLIENT_SERVERBROWSER_CACHE_H
+#define ENGINE_CLIENT_SERVERBROWSER_CACHE_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <base/math.h>
+#include <base/system.h>
+#include <engine/serverbrowser.h>
+
+// the serverlist cache file: one fixed size record per server, the clients that were received in a table of
+// their own and every string once in a pool. all of it is found by offset, so the file can be mapped and
+// the records read in place, one at a time
+class CServerListCache
+{
+public:
+	struct CHeader
+	{
+		char m_aMagic[4];
+		int m_Version;
+		int m_NumServers;
+		int m_NumClients;
+		int m_StringsSize;
+	};
+
+	struct CServer
+	{
+		NETADDR m_Addr;
+		int m_Type;
+		int m_MaxClients;
+		int m_NumClients;
+		int m_MaxPlayers;
+		int m_NumPlayers;
+		int m_Flags;
+		int m_Latency;
+		int m_MapCrc;
+		int m_MapSize;
+		int m_GameType; // string offsets
+		int m_Name;
+		int m_Map;
+		int m_Version;
+		int m_FirstClient;
+		int m_NumReceivedClients;
+	};
+
+	struct CClient
+	{
+		int m_Name; // string offsets
+		int m_Clan;
+		int m_Country;
+		int m_Score;
+		int m_Player;
+	};
+
+	static const char *Magic() { return "TWSL"; }
+
+	class CWriter
+	{
+	public:
+		void Add(const CServerInfo *pInfo)
+		{
+			CServer Server;
+			mem_zero(&Server, sizeof(Server));
+			Server.m_Addr = pInfo->m_NetAddr;
+			Server.m_Type = pInfo->m_Type;
+			Server.m_MaxClients = pInfo->m_MaxClients;
+			Server.m_NumClients = pInfo->m_NumClients;
+			Server.m_MaxPlayers = pInfo->m_MaxPlayers;
+			Server.m_NumPlayers = pInfo->m_NumPlayers;
+			Server.m_Flags = pInfo->m_Flags;
+			Server.m_Latency = pInfo->m_Latency;
+			Server.m_MapCrc = pInfo->m_MapCrc;
+			Server.m_MapSize = pInfo->m_MapSize;
+			Server.m_GameType = AddString(pInfo->m_aGameType);
+			Server.m_Name = AddString(pInfo->m_aName);
+			Server.m_Map = AddString(pInfo->m_aMap);
+			Server.m_Version = AddString(pInfo->m_aVersion);
+			Server.m_FirstClient = (int)m_aClients.size();
+			Server.m_NumReceivedClients = clamp(pInfo->m_NumReceivedClients, 0, (int)MAX_CLIENTS);
+			for(int i = 0; i < Server.m_NumReceivedClients; i++)
+			{
+				const CServerInfo::CClient *pInfoClient = &pInfo->m_aClients[i];
+				CClient Client;
+				Client.m_Name = AddString(pInfoClient->m_aName);
+				Client.m_Clan = AddString(pInfoClient->m_aClan);
+				Client.m_Country = pInfoClient->m_Country;
+				Client.m_Score = pInfoClient->m_Score;
+				Client.m_Player = pInfoClient->m_Player;
+				m_aClients.push_back(Client);
+			}
+			m_aServers.push_back(Server);
+		}
+
+		// the whole file, written at once
+		void Finish(std::vector<char> *pOut) const
+		{
+			CHeader Header;
+			mem_copy(Header.m_aMagic, Magic(), sizeof(Header.m_aMagic));
+			Header.m_Version = IServerBrowser::CACHE_VERSION;
+			Header.m_NumServers = (int)m_aServers.size();
+			Header.m_NumClients = (int)m_aClients.size();
+			Header.m_StringsSize = (int)m_aStrings.size();
+
+			pOut->clear();
+			Append(pOut, &Header, sizeof(Header));
+			if(!m_aServers.empty())
+				Append(pOut, &m_aServers[0], m_aServers.size()*sizeof(CServer));
+			if(!m_aClients.empty())
+				Append(pOut, &m_aClients[0], m_aClients.size()*sizeof(CClient));
+			if(!m_aStrings.empty())
+				Append(pOut, &m_aStrings[0], m_aStrings.size());
+		}
+
+	private:
+		std::vector<CServer> m_aServers;
+		std::vector<CClient> m_aClients;
+		std::vector<char> m_aStrings;
+		std::unordered_map<std::string, int> m_StringOffsets;
+
+		int AddString(const char *pStr)
+		{
+			std::unordered_map<std::string, int>::iterator it = m_StringOffsets.find(pStr);
+			if(it != m_StringOffsets.end())
+				return it->second;
+			int Offset = (int)m_aStrings.size();
+			m_aStrings.insert(m_aStrings.end(), pStr, pStr+str_length(pStr)+1);
+			m_StringOffsets[pStr] = Offset;
+			return Offset;
+		}
+
+		static void Append(std::vector<char> *pOut, const void *pData, unsigned Size)
+		{
+			pOut->insert(pOut->end(), (const char *)pData, (const char *)pData+Size);
+		}
+	};
+
+	CServerListCache() : m_pServers(0), m_pClients(0), m_pStrings(0), m_NumServers(0), m_NumClients(0), m_StringsSize(0) {}
+
+	// checks the header and that the parts add up to the size, the records themselves are checked when they are read.
+	// the data has to stay around as long as servers are read, the records aren't copied
+	bool Open(const void *pData, unsigned Size)
+	{
+		m_NumServers = 0;
+		const CHeader *pHeader = (const CHeader *)pData;
+		if(!pData || Size < sizeof(CHeader) || mem_comp(pHeader->m_aMagic, Magic(), sizeof(pHeader->m_aMagic)) != 0 ||
+			pHeader->m_Version != IServerBrowser::CACHE_VERSION || pHeader->m_NumServers < 0 || pHeader->m_NumClients < 0 || pHeader->m_StringsSize <= 0 ||
+			Size != sizeof(CHeader)+pHeader->m_NumServers*(int64)sizeof(CServer)+pHeader->m_NumClients*(int64)sizeof(CClient)+pHeader->m_StringsSize)
+			return false;
+
+		const char *pStart = (const char *)pData;
+		m_pServers = (const CServer *)(pStart+sizeof(CHeader));
+		m_pClients = (const CClient *)(m_pServers+pHeader->m_NumServers);
+		m_pStrings = (const char *)(m_pClients+pHeader->m_NumClients);
+		m_StringsSize = pHeader->m_StringsSize;
+
+		// every offset into the pool is a terminated string then
+		if(m_pStrings[m_StringsSize-1] != 0)
+			return false;
+		m_NumClients = pHeader->m_NumClients;
+		m_NumServers = pHeader->m_NumServers;
+		return true;
+	}
+
+	int NumServers() const { return m_NumServers; }
+	const NETADDR &Addr(int Index) const { return m_pServers[Index].m_Addr; }
+
+	// fills in what the cache keeps of a server, false if the record is broken
+	bool Get(int Index, CServerInfo *pInfo) const
+	{
+		const CServer *pServer = &m_pServers[Index];
+		if(pServer->m_NumReceivedClients < 0 || pServer->m_NumReceivedClients > MAX_CLIENTS ||
+			pServer->m_FirstClient < 0 || pServer->m_FirstClient > m_NumClients-pServer->m_NumReceivedClients)
+			return false;
+
+		mem_zero(pInfo, sizeof(CServerInfo));
+		pInfo->m_NetAddr = pServer->m_Addr;
+		net_addr_str(&pServer->m_Addr, pInfo->m_aAddress, sizeof(pInfo->m_aAddress), true);
+		pInfo->m_Type = pServer->m_Type;
+		pInfo->m_MaxClients = pServer->m_MaxClients;
+		pInfo->m_NumClients = pServer->m_NumClients;
+		pInfo->m_MaxPlayers = pServer->m_MaxPlayers;
+		pInfo->m_NumPlayers = pServer->m_NumPlayers;
+		pInfo->m_Flags = pServer->m_Flags;
+		pInfo->m_Latency = pServer->m_Latency;
+		pInfo->m_MapCrc = pServer->m_MapCrc;
+		pInfo->m_MapSize = pServer->m_MapSize;
+		str_copy(pInfo->m_aGameType, String(pServer->m_GameType), sizeof(pInfo->m_aGameType));
+		str_copy(pInfo->m_aName, String(pServer->m_Name), sizeof(pInfo->m_aName));
+		str_copy(pInfo->m_aMap, String(pServer->m_Map), sizeof(pInfo->m_aMap));
+		str_copy(pInfo->m_aVersion, String(pServer->m_Version), sizeof(pInfo->m_aVersion));
+
+		pInfo->m_NumReceivedClients = pServer->m_NumReceivedClients;
+		for(int i = 0; i < pServer->m_NumReceivedClients; i++)
+		{
+			const CClient *pClient = &m_pClients[pServer->m_FirstClient+i];
+			CServerInfo::CClient *pInfoClient = &pInfo->m_aClients[i];
+			str_copy(pInfoClient->m_aName, String(pClient->m_Name), sizeof(pInfoClient->m_aName));
+			str_copy(pInfoClient->m_aClan, String(pClient->m_Clan), sizeof(pInfoClient->m_aClan));
+			pInfoClient->m_Country = pClient->m_Country;
+			pInfoClient->m_Score = pClient->m_Score;
+			pInfoClient->m_Player = pClient->m_Player != 0;
+		}
+		return true;
+	}
+
+private:
+	const CServer *m_pServers;
+	const CClient *m_pClients;
+	const char *m_pStrings;
+	int m_NumServers;
+	int m_NumClients;
+	int m_StringsSize;
+
+	const char *String(int Offset) const
+	{
+		if(Offset < 0 || Offset >= m_StringsSize)
+			return "";
+		return &m_pStrings[Offset];
+	}
+};
+
+#endif
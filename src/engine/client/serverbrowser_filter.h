@@ -0,0 +1,276 @@
+#ifndef ENGINE_CLIENT_SERVERBROWSER_FILTER_H
+#define ENGINE_CLIENT_SERVERBROWSER_FILTER_H
+
+#include <ctype.h>
+#include <set>
+#include <base/system.h>
+#include <base/tl/array.h>
+#include <engine/serverbrowser.h>
+
+// the filters and the sort order of the server browser
+
+inline void ServerFilterLowercase(char *pDst, const char *pSrc, int DstSize)
+{
+	int i = 0;
+	for(; i < DstSize-1 && pSrc[i]; i++)
+		pDst[i] = (char)tolower((unsigned char)pSrc[i]);
+	pDst[i] = 0;
+}
+
+// the searched strings of one server in lower case, taken when its info arrives.
+// matching them against a lowered search string does what str_find_nocase did, without lowering every character on every pass
+class CServerFilterKeys
+{
+public:
+	char m_aName[64];
+	char m_aMap[32];
+	char m_aGameType[16];
+	char m_aVersion[32];
+	char m_aAddress[NETADDR_MAXSTRSIZE];
+	char m_aaClientNames[MAX_CLIENTS][MAX_NAME_LENGTH];
+	char m_aaClientClans[MAX_CLIENTS][MAX_CLAN_LENGTH];
+
+	void Set(const CServerInfo *pInfo)
+	{
+		ServerFilterLowercase(m_aName, pInfo->m_aName, sizeof(m_aName));
+		ServerFilterLowercase(m_aMap, pInfo->m_aMap, sizeof(m_aMap));
+		ServerFilterLowercase(m_aGameType, pInfo->m_aGameType, sizeof(m_aGameType));
+		ServerFilterLowercase(m_aVersion, pInfo->m_aVersion, sizeof(m_aVersion));
+		ServerFilterLowercase(m_aAddress, pInfo->m_aAddress, sizeof(m_aAddress));
+		for(int i = 0; i < pInfo->m_NumClients && i < MAX_CLIENTS; i++)
+		{
+			ServerFilterLowercase(m_aaClientNames[i], pInfo->m_aClients[i].m_aName, sizeof(m_aaClientNames[i]));
+			ServerFilterLowercase(m_aaClientClans[i], pInfo->m_aClients[i].m_aClan, sizeof(m_aaClientClans[i]));
+		}
+	}
+};
+
+class CServerFilter
+{
+public:
+	// everything the filter depends on, the strings in lower case. compared as a whole to notice changes
+	struct CSettings
+	{
+		int m_FilterEmpty;
+		int m_FilterNonEmpty;
+		int m_FilterFull;
+		int m_FilterSpectators;
+		int m_FilterPw;
+		int m_FilterPure;
+		int m_FilterPureMap;
+		int m_FilterPing;
+		int m_FilterCompatversion;
+		int m_FilterGametypeStrict;
+		int m_FilterVersionStrict;
+		int m_FilterCountry;
+		int m_FilterCountryIndex;
+		int m_FilterFriends;
+		int m_HideDDNet;
+		int m_FriendsIgnoreClan;
+		char m_aFilterString[64];
+		char m_aExcludeString[64];
+		char m_aFilterGametype[128];
+		char m_aFilterVersion[128];
+		char m_aFilterServerAddress[128];
+		char m_aNetVersion[128];
+	};
+
+	CServerFilter() { mem_zero(&m_Settings, sizeof(m_Settings)); }
+
+	const CSettings &Settings() const { return m_Settings; }
+
+	// returns whether anything changed, the settings have to be zeroed before they are filled
+	bool SetSettings(const CSettings &Settings)
+	{
+		if(mem_comp(&Settings, &m_Settings, sizeof(CSettings)) == 0)
+			return false;
+		m_Settings = Settings;
+		return true;
+	}
+
+	// the same checks the browser always did, in the same order. the friends filter is left to the caller.
+	// SearchHit are the QUICK_* flags of the filter string if they were looked up already, -1 to search here
+	bool Filtered(const CServerInfo *pInfo, const CServerFilterKeys *pKeys, int *pQuickSearchHit, int SearchHit = -1) const
+	{
+		const CSettings &s = m_Settings;
+		if(s.m_FilterEmpty && ((s.m_FilterSpectators && pInfo->m_NumPlayers == 0) || pInfo->m_NumClients == 0))
+			return true;
+		if(s.m_FilterNonEmpty && ((s.m_FilterSpectators && pInfo->m_NumPlayers != 0) || pInfo->m_NumClients != 0))
+			return true;
+		if(s.m_FilterFull && ((s.m_FilterSpectators && pInfo->m_NumPlayers == pInfo->m_MaxPlayers) || pInfo->m_NumClients == pInfo->m_MaxClients))
+			return true;
+		if(s.m_FilterPw && (pInfo->m_Flags&SERVER_FLAG_PASSWORD))
+			return true;
+		if(s.m_FilterPure && str_comp(pInfo->m_aGameType, "DM") != 0 && str_comp(pInfo->m_aGameType, "TDM") != 0 && str_comp(pInfo->m_aGameType, "CTF") != 0)
+			return true;
+		if(s.m_FilterPureMap && !IsPureMap(pInfo->m_aMap))
+			return true;
+		if(s.m_FilterPing < pInfo->m_Latency)
+			return true;
+		if(s.m_FilterCompatversion && str_comp_num(pInfo->m_aVersion, s.m_aNetVersion, 3) != 0)
+			return true;
+		if(s.m_aFilterServerAddress[0] && !str_find(pKeys->m_aAddress, s.m_aFilterServerAddress))
+			return true;
+		if(s.m_FilterGametypeStrict && s.m_aFilterGametype[0] && str_comp(pKeys->m_aGameType, s.m_aFilterGametype))
+			return true;
+		if(!s.m_FilterGametypeStrict && s.m_aFilterGametype[0] && !str_find(pKeys->m_aGameType, s.m_aFilterGametype))
+			return true;
+		if(s.m_FilterVersionStrict && s.m_aFilterVersion[0] && str_comp(pKeys->m_aVersion, s.m_aFilterVersion))
+			return true;
+		if(!s.m_FilterVersionStrict && s.m_aFilterVersion[0] && !str_find(pKeys->m_aVersion, s.m_aFilterVersion))
+			return true;
+		if(s.m_HideDDNet && str_find(pKeys->m_aName, "[ddracenetwork]"))
+			return true;
+
+		if(s.m_FilterCountry)
+		{
+			// match against player country
+			int p = 0;
+			while(p < pInfo->m_NumClients && pInfo->m_aClients[p].m_Country != s.m_FilterCountryIndex)
+				p++;
+			if(p == pInfo->m_NumClients)
+				return true;
+		}
+
+		if(s.m_aFilterString[0] != 0)
+		{
+			*pQuickSearchHit = 0;
+
+			// match against server name, players and map
+			if(SearchHit >= 0)
+				*pQuickSearchHit = SearchHit;
+			else
+			{
+				if(str_find(pKeys->m_aName, s.m_aFilterString))
+					*pQuickSearchHit |= IServerBrowser::QUICK_SERVERNAME;
+				for(int p = 0; p < pInfo->m_NumClients; p++)
+				{
+					if(str_find(pKeys->m_aaClientNames[p], s.m_aFilterString) || str_find(pKeys->m_aaClientClans[p], s.m_aFilterString))
+					{
+						*pQuickSearchHit |= IServerBrowser::QUICK_PLAYER;
+						break;
+					}
+				}
+				if(str_find(pKeys->m_aMap, s.m_aFilterString))
+					*pQuickSearchHit |= IServerBrowser::QUICK_MAPNAME;
+			}
+
+			if(!*pQuickSearchHit)
+				return true;
+		}
+
+		if(s.m_aExcludeString[0] != 0 && (str_find(pKeys->m_aName, s.m_aExcludeString) || str_find(pKeys->m_aMap, s.m_aExcludeString)))
+			return true;
+
+		return false;
+	}
+
+private:
+	CSettings m_Settings;
+
+	static bool IsPureMap(const char *pMap)
+	{
+		static const char *const s_apPureMaps[] = {"dm1", "dm2", "dm6", "dm7", "dm8", "dm9", "ctf1", "ctf2", "ctf3", "ctf4", "ctf5", "ctf6", "ctf7"};
+		for(unsigned i = 0; i < sizeof(s_apPureMaps)/sizeof(s_apPureMaps[0]); i++)
+			if(str_comp(pMap, s_apPureMaps[i]) == 0)
+				return true;
+		return false;
+	}
+};
+
+// the servers that passed the filter, kept in order in a balanced tree, so a server whose info changed
+// only costs its own removal and insertion. equal ones stay in list order, as with a stable sort
+class CServerSortOrder
+{
+public:
+	CServerSortOrder() : m_Set(CCompare(false, false)) {}
+
+	// drops everything, the servers have to be inserted again
+	void Init(bool Strings, bool Reverse)
+	{
+		m_Set = CKeySet(CCompare(Strings, Reverse));
+		for(int i = 0; i < m_aKeys.size(); i++)
+			m_aKeys[i].m_Index = -1;
+	}
+
+	void Clear() { Init(m_Set.key_comp().m_Strings, m_Set.key_comp().m_Reverse); }
+
+	// Group sorts before the rest, Value or String after it depending on the kind of order
+	void Insert(int Index, int Group, int Value, const char *pString)
+	{
+		while(m_aKeys.size() <= Index)
+		{
+			CKey Unused;
+			Unused.m_Index = -1;
+			m_aKeys.add(Unused);
+		}
+
+		CKey *pKey = &m_aKeys[Index];
+		if(pKey->m_Index != -1)
+			m_Set.erase(*pKey);
+		pKey->m_Index = Index;
+		pKey->m_Group = Group;
+		pKey->m_Value = Value;
+		str_copy(pKey->m_aString, pString ? pString : "", sizeof(pKey->m_aString));
+		m_Set.insert(*pKey);
+	}
+
+	void Remove(int Index)
+	{
+		if(!Contains(Index))
+			return;
+		m_Set.erase(m_aKeys[Index]);
+		m_aKeys[Index].m_Index = -1;
+	}
+
+	bool Contains(int Index) const { return Index < m_aKeys.size() && m_aKeys[Index].m_Index != -1; }
+	int Size() const { return (int)m_Set.size(); }
+
+	// writes the indices in order, returns how many
+	int Flatten(int *pOut) const
+	{
+		int Num = 0;
+		for(CKeySet::const_iterator it = m_Set.begin(); it != m_Set.end(); ++it)
+			pOut[Num++] = it->m_Index;
+		return Num;
+	}
+
+private:
+	struct CKey
+	{
+		int m_Index;
+		int m_Group;
+		int m_Value;
+		char m_aString[64];
+	};
+
+	struct CCompare
+	{
+		bool m_Strings;
+		bool m_Reverse;
+
+		CCompare(bool Strings, bool Reverse) : m_Strings(Strings), m_Reverse(Reverse) {}
+
+		int Compare(const CKey &a, const CKey &b) const
+		{
+			if(a.m_Group != b.m_Group)
+				return a.m_Group < b.m_Group ? -1 : 1;
+			if(m_Strings)
+				return str_comp(a.m_aString, b.m_aString);
+			return a.m_Value < b.m_Value ? -1 : a.m_Value > b.m_Value;
+		}
+
+		bool operator()(const CKey &a, const CKey &b) const
+		{
+			int c = m_Reverse ? Compare(b, a) : Compare(a, b);
+			return c != 0 ? c < 0 : a.m_Index < b.m_Index;
+		}
+	};
+
+	typedef std::set<CKey, CCompare> CKeySet;
+
+	CKeySet m_Set;
+	array<CKey> m_aKeys;
+};
+
+#endif
@@ -0,0 +1,281 @@
+#ifndef ENGINE_CLIENT_SERVERBROWSER_REQUESTS_H
+#define ENGINE_CLIENT_SERVERBROWSER_REQUESTS_H
+
+#include <deque>
+#include <vector>
+#include <base/math.h>
+#include <base/system.h>
+
+// paces the info requests of a refresh with a token bucket instead of a fixed number of requests in flight,
+// so servers that never answer don't hold up the others. the rate backs off when answers only come on a retry
+// or the latency grows, and creeps back up to the configured rate otherwise. works on server indices
+class CRequestScheduler
+{
+public:
+	enum
+	{
+		PRIO_VISIBLE=0,
+		PRIO_FAVORITE,
+		PRIO_RETRY,
+		PRIO_NORMAL,
+		NUM_PRIOS,
+
+		MAX_TRIES=3,
+		EPOCH_SAMPLES=32, // answers (or timeouts without any answer) between two rate changes
+		MIN_TIMEOUT_MS=500,
+		MAX_TIMEOUT_MS=1000,
+	};
+
+	CRequestScheduler() { Reset(500, 50, 10); }
+
+	// MaxRate in requests per second, Burst requests can go out at once.
+	// a refresh that doesn't get any answers is given up once the rate had to go below MinRate
+	void Reset(int MaxRate, int Burst, int MinRate)
+	{
+		for(int p = 0; p < NUM_PRIOS; p++)
+			m_aQueues[p].clear();
+		m_Sent.clear();
+		m_aServers.clear();
+
+		m_MaxRate = max(MaxRate, 1);
+		m_MinRate = clamp(MinRate, 1, m_MaxRate);
+		m_Burst = max(Burst, 1);
+		m_Rate = (float)m_MaxRate;
+		m_Tokens = (float)m_Burst;
+		m_LastRefill = 0;
+
+		m_AvgLatency = 0.0f;
+		m_BaseLatency = 0.0f;
+		m_EpochAnswers = 0;
+		m_EpochRetryAnswers = 0;
+		m_EpochMinLatency = 0.0f;
+		m_TimeoutsSinceAnswer = 0;
+		m_SlowDownTime = 0;
+		m_Stalled = false;
+
+		m_NumPending = 0;
+		m_NumSent = 0;
+		m_NumAnswered = 0;
+		m_NumTimeouts = 0;
+		m_NumFailed = 0;
+	}
+
+	void Queue(int Index, int Prio)
+	{
+		if((int)m_aServers.size() <= Index)
+			m_aServers.resize(Index+1);
+		CServer *pServer = &m_aServers[Index];
+		if(pServer->m_State == STATE_QUEUED || pServer->m_State == STATE_SENT)
+			return;
+		if(pServer->m_State == STATE_NONE)
+			m_NumPending++;
+		pServer->m_State = STATE_QUEUED;
+		pServer->m_Prio = Prio;
+		pServer->m_Tries = 0;
+		m_aQueues[Prio].push_back(Index);
+	}
+
+	// moves a queued request ahead. the old queue position is skipped when it comes up
+	void Promote(int Index, int Prio)
+	{
+		if(Index < 0 || Index >= (int)m_aServers.size())
+			return;
+		CServer *pServer = &m_aServers[Index];
+		if(pServer->m_State != STATE_QUEUED || pServer->m_Prio <= Prio)
+			return;
+		pServer->m_Prio = Prio;
+		m_aQueues[Prio].push_back(Index);
+	}
+
+	// the next server to request now, -1 if nothing is queued or the bucket is empty
+	int Next(int64 Now)
+	{
+		Refill(Now);
+		if(m_Tokens < 1.0f)
+			return -1;
+
+		for(int p = 0; p < NUM_PRIOS; p++)
+		{
+			while(!m_aQueues[p].empty())
+			{
+				int Index = m_aQueues[p].front();
+				m_aQueues[p].pop_front();
+				CServer *pServer = &m_aServers[Index];
+				if(pServer->m_State != STATE_QUEUED || pServer->m_Prio != p)
+					continue;
+
+				pServer->m_State = STATE_SENT;
+				pServer->m_SendTime = Now;
+				pServer->m_Tries++;
+				CSent Sent = {Index, Now};
+				m_Sent.push_back(Sent);
+				m_Tokens -= 1.0f;
+				m_NumSent++;
+				return Index;
+			}
+		}
+		return -1;
+	}
+
+	void Answered(int Index, int64 Now)
+	{
+		if(Index < 0 || Index >= (int)m_aServers.size())
+			return;
+		CServer *pServer = &m_aServers[Index];
+		if(pServer->m_State == STATE_NONE || pServer->m_State == STATE_DONE)
+			return;
+
+		// a late answer to a request that already timed out still counts, it just doesn't say much about the latency.
+		// neither do the answers to requests from before the last slow down, they'd only slow it down again
+		if(pServer->m_State == STATE_SENT && pServer->m_SendTime > m_SlowDownTime)
+		{
+			float Latency = (Now-pServer->m_SendTime)*1000.0f/time_freq();
+			m_AvgLatency = m_NumAnswered ? m_AvgLatency+(Latency-m_AvgLatency)/8.0f : Latency;
+			m_EpochMinLatency = m_EpochAnswers ? min(m_EpochMinLatency, Latency) : Latency;
+			m_EpochAnswers++;
+			m_EpochRetryAnswers += pServer->m_Tries > 1;
+		}
+		pServer->m_State = STATE_DONE;
+		m_NumPending--;
+		m_NumAnswered++;
+		m_TimeoutsSinceAnswer = 0;
+
+		if(m_EpochAnswers >= EPOCH_SAMPLES)
+			Adapt(Now);
+	}
+
+	// requeues the requests that weren't answered in time, or gives up on them after MAX_TRIES
+	void Expire(int64 Now)
+	{
+		int64 Timeout = TimeoutMs()*time_freq()/1000;
+		while(!m_Sent.empty() && m_Sent.front().m_SendTime+Timeout < Now)
+		{
+			CSent Sent = m_Sent.front();
+			m_Sent.pop_front();
+			CServer *pServer = &m_aServers[Sent.m_Index];
+			if(pServer->m_State != STATE_SENT || pServer->m_SendTime != Sent.m_SendTime)
+				continue;
+
+			m_NumTimeouts++;
+			if(pServer->m_Tries < MAX_TRIES)
+			{
+				// retries go before the servers that weren't asked yet, a retry that gets answered is what tells loss apart from dead servers
+				pServer->m_State = STATE_QUEUED;
+				pServer->m_Prio = min((int)pServer->m_Prio, (int)PRIO_RETRY);
+				m_aQueues[pServer->m_Prio].push_back(Sent.m_Index);
+			}
+			else
+			{
+				pServer->m_State = STATE_DONE;
+				m_NumPending--;
+				m_NumFailed++;
+			}
+
+			// nothing comes back at all
+			if(++m_TimeoutsSinceAnswer%EPOCH_SAMPLES == 0)
+			{
+				if(m_Rate <= m_MinRate)
+					m_Stalled = true;
+				SlowDown(0.5f, Now);
+			}
+		}
+	}
+
+	bool Pending() const { return m_NumPending > 0; }
+	int NumPending() const { return m_NumPending; }
+	bool Stalled() const { return m_Stalled; }
+	float Rate() const { return m_Rate; }
+	float AvgLatency() const { return m_AvgLatency; }
+	int TimeoutMs() const { return m_NumAnswered ? clamp(round_to_int(m_AvgLatency*3.0f), (int)MIN_TIMEOUT_MS, (int)MAX_TIMEOUT_MS) : (int)MAX_TIMEOUT_MS; }
+
+	int NumSent() const { return m_NumSent; }
+	int NumAnswered() const { return m_NumAnswered; }
+	int NumTimeouts() const { return m_NumTimeouts; }
+	int NumFailed() const { return m_NumFailed; }
+
+private:
+	enum
+	{
+		STATE_NONE=0,
+		STATE_QUEUED,
+		STATE_SENT,
+		STATE_DONE,
+	};
+
+	struct CServer
+	{
+		unsigned char m_State;
+		unsigned char m_Prio;
+		unsigned char m_Tries;
+		int64 m_SendTime;
+
+		CServer() : m_State(STATE_NONE), m_Prio(PRIO_NORMAL), m_Tries(0), m_SendTime(0) {}
+	};
+
+	struct CSent
+	{
+		int m_Index;
+		int64 m_SendTime;
+	};
+
+	std::deque<int> m_aQueues[NUM_PRIOS];
+	std::deque<CSent> m_Sent; // in send order, so the oldest request is the first to time out
+	std::vector<CServer> m_aServers;
+
+	int m_MaxRate;
+	int m_MinRate;
+	int m_Burst;
+	float m_Rate;
+	float m_Tokens;
+	int64 m_LastRefill;
+
+	float m_AvgLatency;
+	float m_BaseLatency; // the lowest latency seen, what it is without our own queueing
+	int m_EpochAnswers;
+	int m_EpochRetryAnswers;
+	float m_EpochMinLatency;
+	int m_TimeoutsSinceAnswer;
+	int64 m_SlowDownTime;
+	bool m_Stalled;
+
+	int m_NumPending;
+	int m_NumSent;
+	int m_NumAnswered;
+	int m_NumTimeouts;
+	int m_NumFailed;
+
+	void Refill(int64 Now)
+	{
+		if(m_LastRefill)
+			m_Tokens = min(m_Tokens+m_Rate*(Now-m_LastRefill)/(float)time_freq(), (float)m_Burst);
+		m_LastRefill = Now;
+	}
+
+	// halve the rate on loss, slow down a bit when the answers queue up somewhere, speed up otherwise.
+	// the servers are all over the world, but a queue in front of the client delays even the closest of them,
+	// so it shows in the lowest latency of an epoch
+	void Adapt(int64 Now)
+	{
+		if(m_BaseLatency == 0.0f || m_EpochMinLatency < m_BaseLatency)
+			m_BaseLatency = m_EpochMinLatency;
+
+		float Loss = m_EpochRetryAnswers/(float)m_EpochAnswers;
+		if(Loss > 0.1f)
+			SlowDown(0.5f, Now);
+		else if(m_EpochMinLatency > m_BaseLatency*2.0f+30.0f)
+			SlowDown(0.85f, Now);
+		else
+			m_Rate = min(m_Rate+m_MaxRate/16.0f, (float)m_MaxRate);
+
+		m_EpochAnswers = 0;
+		m_EpochRetryAnswers = 0;
+	}
+
+	void SlowDown(float Factor, int64 Now)
+	{
+		m_Rate = max(m_Rate*Factor, (float)m_MinRate);
+		m_SlowDownTime = Now;
+	}
+};
+
+#endif
@@ -0,0 +1,186 @@
+#ifndef ENGINE_CLIENT_SERVERBROWSER_SEARCH_H
+#define ENGINE_CLIENT_SERVERBROWSER_SEARCH_H
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+#include <base/system.h>
+#include "serverbrowser_filter.h"
+
+// the servers by the three letter runs of their lowered name, map and player names and clans.
+// a search only checks the servers that have the rarest run of the query, instead of every player of every server
+class CServerSearchIndex
+{
+public:
+	enum
+	{
+		MIN_QUERY_LENGTH=3,
+	};
+
+	CServerSearchIndex() : m_NumLive(0), m_NumStale(0) {}
+
+	void Clear()
+	{
+		m_Lists.clear();
+		m_aServers.clear();
+		m_NumLive = 0;
+		m_NumStale = 0;
+	}
+
+	// (re)indexes a server. the keys are kept by pointer and have to live until the server is indexed again or the index is cleared
+	void Update(int Index, const CServerFilterKeys *pKeys, int NumClients)
+	{
+		if((int)m_aServers.size() <= Index)
+			m_aServers.resize(Index+1);
+
+		// the postings of the last update become stale, they are dropped from the lists later
+		CServer *pServer = &m_aServers[Index];
+		pServer->m_pKeys = pKeys;
+		pServer->m_NumClients = NumClients;
+		pServer->m_Generation++;
+		m_NumStale += pServer->m_NumPostings;
+		m_NumLive -= pServer->m_NumPostings;
+
+		m_aRuns.clear();
+		AddRuns(pKeys->m_aName, IServerBrowser::QUICK_SERVERNAME);
+		AddRuns(pKeys->m_aMap, IServerBrowser::QUICK_MAPNAME);
+		for(int i = 0; i < NumClients && i < MAX_CLIENTS; i++)
+		{
+			AddRuns(pKeys->m_aaClientNames[i], IServerBrowser::QUICK_PLAYER);
+			AddRuns(pKeys->m_aaClientClans[i], IServerBrowser::QUICK_PLAYER);
+		}
+
+		// one posting per run, with all the fields it was found in
+		std::sort(m_aRuns.begin(), m_aRuns.end());
+		pServer->m_NumPostings = 0;
+		for(unsigned i = 0; i < m_aRuns.size(); )
+		{
+			unsigned Run = m_aRuns[i]>>8;
+			CPosting Posting;
+			Posting.m_Index = Index;
+			Posting.m_Generation = pServer->m_Generation;
+			Posting.m_Fields = 0;
+			for(; i < m_aRuns.size() && m_aRuns[i]>>8 == Run; i++)
+				Posting.m_Fields |= m_aRuns[i]&0xff;
+			m_Lists[Run].push_back(Posting);
+			pServer->m_NumPostings++;
+		}
+		m_NumLive += pServer->m_NumPostings;
+
+		if(m_NumStale > m_NumLive+4096)
+			Compact();
+	}
+
+	// sets the IServerBrowser::QUICK_* flags of every indexed server in paHits, 0 if it does not match.
+	// returns the number of matching servers, or -1 if the query is too short to be looked up
+	int Search(const char *pQuery, int *paHits) const
+	{
+		char aQuery[128];
+		ServerFilterLowercase(aQuery, pQuery, sizeof(aQuery));
+		int Length = str_length(aQuery);
+		if(Length < MIN_QUERY_LENGTH)
+			return -1;
+
+		mem_zero(paHits, m_aServers.size()*sizeof(int));
+
+		// every match has every run of the query, so the shortest list holds all of them
+		const std::vector<CPosting> *pShortest = 0;
+		for(int i = 0; i+2 < Length; i++)
+		{
+			CListMap::const_iterator it = m_Lists.find(MakeRun(&aQuery[i]));
+			if(it == m_Lists.end())
+				return 0;
+			if(!pShortest || it->second.size() < pShortest->size())
+				pShortest = &it->second;
+		}
+
+		int NumFound = 0;
+		for(unsigned i = 0; i < pShortest->size(); i++)
+		{
+			const CPosting &Posting = (*pShortest)[i];
+			const CServer &Server = m_aServers[Posting.m_Index];
+			if(Posting.m_Generation != Server.m_Generation)
+				continue;
+
+			int Hit = 0;
+			if((Posting.m_Fields&IServerBrowser::QUICK_SERVERNAME) && str_find(Server.m_pKeys->m_aName, aQuery))
+				Hit |= IServerBrowser::QUICK_SERVERNAME;
+			if(Posting.m_Fields&IServerBrowser::QUICK_PLAYER)
+			{
+				for(int p = 0; p < Server.m_NumClients; p++)
+					if(str_find(Server.m_pKeys->m_aaClientNames[p], aQuery) || str_find(Server.m_pKeys->m_aaClientClans[p], aQuery))
+					{
+						Hit |= IServerBrowser::QUICK_PLAYER;
+						break;
+					}
+			}
+			if((Posting.m_Fields&IServerBrowser::QUICK_MAPNAME) && str_find(Server.m_pKeys->m_aMap, aQuery))
+				Hit |= IServerBrowser::QUICK_MAPNAME;
+
+			paHits[Posting.m_Index] = Hit;
+			NumFound += Hit != 0;
+		}
+		return NumFound;
+	}
+
+	int NumServers() const { return (int)m_aServers.size(); }
+	int NumRuns() const { return (int)m_Lists.size(); }
+
+private:
+	struct CPosting
+	{
+		int m_Index;
+		int m_Generation;
+		int m_Fields;
+	};
+
+	struct CServer
+	{
+		const CServerFilterKeys *m_pKeys;
+		int m_NumClients;
+		int m_Generation;
+		int m_NumPostings;
+
+		CServer() : m_pKeys(0), m_NumClients(0), m_Generation(0), m_NumPostings(0) {}
+	};
+
+	typedef std::unordered_map<unsigned, std::vector<CPosting> > CListMap;
+
+	CListMap m_Lists;
+	std::vector<CServer> m_aServers;
+	std::vector<unsigned> m_aRuns;
+	int m_NumLive;
+	int m_NumStale;
+
+	static unsigned MakeRun(const char *pStr)
+	{
+		return ((unsigned char)pStr[0]<<16)|((unsigned char)pStr[1]<<8)|(unsigned char)pStr[2];
+	}
+
+	void AddRuns(const char *pStr, int Field)
+	{
+		for(int i = 0; pStr[i] && pStr[i+1] && pStr[i+2]; i++)
+			m_aRuns.push_back(MakeRun(&pStr[i])<<8|Field);
+	}
+
+	// drops the postings of old updates
+	void Compact()
+	{
+		for(CListMap::iterator it = m_Lists.begin(); it != m_Lists.end(); )
+		{
+			std::vector<CPosting> &List = it->second;
+			unsigned Num = 0;
+			for(unsigned i = 0; i < List.size(); i++)
+				if(List[i].m_Generation == m_aServers[List[i].m_Index].m_Generation)
+					List[Num++] = List[i];
+			List.resize(Num);
+			if(Num == 0)
+				m_Lists.erase(it++);
+			else
+				++it;
+		}
+		m_NumStale = 0;
+	}
+};
+
+#endif
@@ -2,6 +2,7 @@
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 #include <base/math.h>
 #include <base/system.h>
+#include <base/system++/spsc_queue.h>
 
 #include <engine/graphics.h>
 #include <engine/storage.h>
@@ -11,6 +12,7 @@
 #include "SDL.h"
 
 #include "sound.h"
+#include "soundmix.h"
 #include "luabinding.h"
 
 extern "C" { // wavpack
@@ -24,6 +26,7 @@ enum
 	NUM_SAMPLES = 512,
 	NUM_VOICES = 256,
 	NUM_CHANNELS = 16,
+	NUM_COMMANDS = 4096,
 };
 
 struct CSample
@@ -43,11 +46,13 @@ struct CChannel
 	int m_Pan;
 };
 
+// playback state, only touched by the mixer
 struct CVoice
 {
 	CSample *m_pSample;
 	CChannel *m_pChannel;
-	int m_Age; // increases when reused
+	int m_Serial; // of the play command that started the voice
+	int m_ActiveIndex; // position in m_aActiveVoices
 	int m_Tick;
 	int m_Vol; // 0 - 255
 	int m_Flags;
@@ -62,11 +67,51 @@ struct CVoice
 	};
 };
 
+// what the game thread knows about a voice, used to hand out voices and to validate handles
+struct CVoiceSlot
+{
+	CSample *m_pSample;
+	int m_Age; // increases when reused
+	int m_Serial; // increases with every play
+};
+
+// sent from the game thread to the mixer, so neither of them has to wait for the other
+struct CSoundCommand
+{
+	enum
+	{
+		PLAY=0,
+		STOP_VOICE,
+		STOP_SAMPLE,
+		STOP_ALL,
+		SET_VOLUME,
+		SET_FALLOFF,
+		SET_LOCATION,
+		SET_TIME_OFFSET,
+		SET_CIRCLE,
+		SET_RECTANGLE,
+	};
+
+	int m_Type;
+	int m_VoiceID;
+	int m_Serial;
+	int m_SampleID;
+	int m_ChannelID;
+	int m_Flags;
+	float m_aParams[2];
+};
+
 static CSample m_aSamples[NUM_SAMPLES] = { {0} };
 static CVoice m_aVoices[NUM_VOICES] = { {0} };
+static CVoiceSlot m_aVoiceSlots[NUM_VOICES] = { {0} };
 static CChannel m_aChannels[NUM_CHANNELS] = { {255, 0} };
 
-static LOCK m_SoundLock = 0;
+static int m_aActiveVoices[NUM_VOICES];
+static int m_NumActiveVoices = 0;
+
+static CSpscQueue<CSoundCommand, NUM_COMMANDS> m_Commands;
+static std::atomic<int> m_aFinishedSerials[NUM_VOICES]; // serial of the last voice that ran out, written by the mixer
+static bool m_MixerRunning = false;
 
 static int m_CenterX = 0;
 static int m_CenterY = 0;
@@ -84,16 +129,6 @@ static int ms_WVBufferSize = 0;
 
 const int DefaultDistance = 1500;
 
-// TODO: there should be a faster way todo this
-static short Int2Short(int i)
-{
-	if(i > 0x7fff)
-		return 0x7fff;
-	else if(i < -0x7fff)
-		return -0x7fff;
-	return i;
-}
-
 static int IntAbs(int i)
 {
 	if(i<0)
@@ -101,174 +136,330 @@ static int IntAbs(int i)
 	return i;
 }
 
+static void ActivateVoice(int VoiceID)
+{
+	m_aVoices[VoiceID].m_ActiveIndex = m_NumActiveVoices;
+	m_aActiveVoices[m_NumActiveVoices++] = VoiceID;
+}
+
+static void DeactivateVoice(int VoiceID)
+{
+	CVoice *v = &m_aVoices[VoiceID];
+	if(!v->m_pSample)
+		return;
+
+	// swap the last active voice into the gap
+	int Last = m_aActiveVoices[--m_NumActiveVoices];
+	m_aActiveVoices[v->m_ActiveIndex] = Last;
+	m_aVoices[Last].m_ActiveIndex = v->m_ActiveIndex;
+	v->m_pSample = 0;
+}
+
+static void StopVoicePaused(int VoiceID)
+{
+	CVoice *v = &m_aVoices[VoiceID];
+	if(v->m_Flags & ISound::FLAG_LOOP)
+		v->m_pSample->m_PausedAt = v->m_Tick;
+	else
+		v->m_pSample->m_PausedAt = 0;
+	DeactivateVoice(VoiceID);
+}
+
+static void ExecuteCommand(const CSoundCommand *pCommand)
+{
+	CVoice *v = &m_aVoices[pCommand->m_VoiceID];
+	if(pCommand->m_Type == CSoundCommand::PLAY)
+	{
+		CSample *pSample = &m_aSamples[pCommand->m_SampleID];
+		if(!v->m_pSample)
+			ActivateVoice(pCommand->m_VoiceID);
+		v->m_pSample = pSample;
+		v->m_pChannel = &m_aChannels[pCommand->m_ChannelID];
+		v->m_Serial = pCommand->m_Serial;
+		if(pCommand->m_Flags & ISound::FLAG_LOOP)
+			v->m_Tick = pSample->m_PausedAt;
+		else
+			v->m_Tick = 0;
+		v->m_Vol = 255;
+		v->m_Flags = pCommand->m_Flags;
+		v->m_X = (int)pCommand->m_aParams[0];
+		v->m_Y = (int)pCommand->m_aParams[1];
+		v->m_Falloff = 0.0f;
+		v->m_Shape = ISound::SHAPE_CIRCLE;
+		v->m_Circle.m_Radius = DefaultDistance;
+		return;
+	}
+
+	if(pCommand->m_Type == CSoundCommand::STOP_SAMPLE || pCommand->m_Type == CSoundCommand::STOP_ALL)
+	{
+		CSample *pSample = &m_aSamples[pCommand->m_SampleID];
+		for(int i = m_NumActiveVoices-1; i >= 0; i--)
+		{
+			int VoiceID = m_aActiveVoices[i];
+			if(pCommand->m_Type == CSoundCommand::STOP_ALL || m_aVoices[VoiceID].m_pSample == pSample)
+				StopVoicePaused(VoiceID);
+		}
+		return;
+	}
+
+	// the rest only applies to the voice the game thread had in mind
+	if(!v->m_pSample || v->m_Serial != pCommand->m_Serial)
+		return;
+
+	switch(pCommand->m_Type)
+	{
+	case CSoundCommand::STOP_VOICE:
+		DeactivateVoice(pCommand->m_VoiceID);
+		break;
+	case CSoundCommand::SET_VOLUME:
+		v->m_Vol = (int)(pCommand->m_aParams[0]*255.0f);
+		break;
+	case CSoundCommand::SET_FALLOFF:
+		v->m_Falloff = pCommand->m_aParams[0];
+		break;
+	case CSoundCommand::SET_LOCATION:
+		v->m_X = pCommand->m_aParams[0];
+		v->m_Y = pCommand->m_aParams[1];
+		break;
+	case CSoundCommand::SET_TIME_OFFSET:
+		{
+			int Tick = 0;
+			bool IsLooping = v->m_Flags&ISound::FLAG_LOOP;
+			uint64_t TickOffset = v->m_pSample->m_Rate * pCommand->m_aParams[0];
+			if(v->m_pSample->m_NumFrames > 0 && IsLooping)
+				Tick = TickOffset % v->m_pSample->m_NumFrames;
+			else
+				Tick = clamp(TickOffset, (uint64_t)0, (uint64_t)v->m_pSample->m_NumFrames);
+
+			// at least 200msec off, else depend on buffer size
+			float Threshold = max(0.2f * v->m_pSample->m_Rate, (float)m_MaxFrames);
+			if(abs(v->m_Tick-Tick) > Threshold)
+			{
+				// take care of looping (modulo!)
+				if( !(IsLooping && (min(v->m_Tick, Tick) + v->m_pSample->m_NumFrames - max(v->m_Tick, Tick)) <= Threshold))
+				{
+					v->m_Tick = Tick;
+				}
+			}
+		}
+		break;
+	case CSoundCommand::SET_CIRCLE:
+		v->m_Shape = ISound::SHAPE_CIRCLE;
+		v->m_Circle.m_Radius = pCommand->m_aParams[0];
+		break;
+	case CSoundCommand::SET_RECTANGLE:
+		v->m_Shape = ISound::SHAPE_RECTANGLE;
+		v->m_Rectangle.m_Width = pCommand->m_aParams[0];
+		v->m_Rectangle.m_Height = pCommand->m_aParams[1];
+		break;
+	}
+}
+
+// runs on whoever is the mixer right now: the audio callback, or the game thread while it holds the audio lock
+static void ProcessCommands()
+{
+	CSoundCommand Command;
+	while(m_Commands.Pop(&Command))
+		ExecuteCommand(&Command);
+}
+
+static void PushCommand(const CSoundCommand &Command)
+{
+	// without a running mixer the commands would pile up, apply them right away
+	if(!m_MixerRunning)
+	{
+		ExecuteCommand(&Command);
+		return;
+	}
+
+	if(!m_Commands.Push(Command))
+	{
+		// the mixer fell behind, catch up in its place
+		SDL_LockAudio();
+		ProcessCommands();
+		ExecuteCommand(&Command);
+		SDL_UnlockAudio();
+	}
+}
+
+// picks up voices that the mixer let run out since we last looked
+static CVoiceSlot *UpdateVoiceSlot(int VoiceID)
+{
+	CVoiceSlot *pSlot = &m_aVoiceSlots[VoiceID];
+	if(pSlot->m_pSample && m_aFinishedSerials[VoiceID].load(std::memory_order_acquire) == pSlot->m_Serial)
+	{
+		pSlot->m_pSample = 0;
+		pSlot->m_Age++;
+	}
+	return pSlot;
+}
+
+static int PlayingVoiceID(ISound::CVoiceHandle Voice)
+{
+	if(!Voice.IsValid())
+		return -1;
+
+	int VoiceID = Voice.Id();
+	CVoiceSlot *pSlot = UpdateVoiceSlot(VoiceID);
+	if(pSlot->m_Age != Voice.Age() || !pSlot->m_pSample)
+		return -1;
+	return VoiceID;
+}
+
+static void PushVoiceCommand(int Type, int VoiceID, float Param0 = 0.0f, float Param1 = 0.0f)
+{
+	CSoundCommand Command;
+	mem_zero(&Command, sizeof(Command));
+	Command.m_Type = Type;
+	Command.m_VoiceID = VoiceID;
+	Command.m_Serial = m_aVoiceSlots[VoiceID].m_Serial;
+	Command.m_aParams[0] = Param0;
+	Command.m_aParams[1] = Param1;
+	PushCommand(Command);
+}
+
 static void Mix(short *pFinalOut, unsigned Frames)
 {
 	int MasterVol;
 	mem_zero(m_pMixBuffer, m_MaxFrames*2*sizeof(int));
 	Frames = min(Frames, m_MaxFrames);
 
-	// aquire lock while we are mixing
-	lock_wait(m_SoundLock);
+	// apply everything the game thread sent since the last mix
+	ProcessCommands();
 
 	MasterVol = m_SoundVolume;
 
-	for(unsigned i = 0; i < NUM_VOICES; i++)
+	for(int a = 0; a < m_NumActiveVoices; )
 	{
-		if(m_aVoices[i].m_pSample)
-		{
-			// mix voice
-			CVoice *v = &m_aVoices[i];
-			int *pOut = m_pMixBuffer;
-
-			int Step = v->m_pSample->m_Channels; // setup input sources
-			short *pInL = &v->m_pSample->m_pData[v->m_Tick*Step];
-			short *pInR = &v->m_pSample->m_pData[v->m_Tick*Step+1];
+		// mix voice
+		CVoice *v = &m_aVoices[m_aActiveVoices[a]];
 
-			unsigned End = v->m_pSample->m_NumFrames-v->m_Tick;
+		int Step = v->m_pSample->m_Channels; // setup input sources
+		const short *pIn = &v->m_pSample->m_pData[v->m_Tick*Step];
 
-			int Rvol = (int)(v->m_pChannel->m_Vol*(v->m_Vol/255.0f));
-			int Lvol = (int)(v->m_pChannel->m_Vol*(v->m_Vol/255.0f));
+		unsigned End = v->m_pSample->m_NumFrames-v->m_Tick;
 
-			// make sure that we don't go outside the sound data
-			if(Frames < End)
-				End = Frames;
+		int Rvol = (int)(v->m_pChannel->m_Vol*(v->m_Vol/255.0f));
+		int Lvol = (int)(v->m_pChannel->m_Vol*(v->m_Vol/255.0f));
 
-			// check if we have a mono sound
-			if(v->m_pSample->m_Channels == 1)
-				pInR = pInL;
+		// make sure that we don't go outside the sound data
+		if(Frames < End)
+			End = Frames;
 
-			// volume calculation
-			if(v->m_Flags&ISound::FLAG_POS && v->m_pChannel->m_Pan)
+		// volume calculation
+		if(v->m_Flags&ISound::FLAG_POS && v->m_pChannel->m_Pan)
+		{
+			// TODO: we should respect the channel panning value
+			int dx = v->m_X - m_CenterX;
+			int dy = v->m_Y - m_CenterY;
+			//
+			int p = IntAbs(dx);
+			float FalloffX = 0.0f;
+			float FalloffY = 0.0f;
+
+			int RangeX = 0; // for panning
+			bool InVoiceField = false;
+
+			switch(v->m_Shape)
 			{
-				// TODO: we should respect the channel panning value
-				int dx = v->m_X - m_CenterX;
-				int dy = v->m_Y - m_CenterY;
-				//
-				int p = IntAbs(dx);
-				float FalloffX = 0.0f;
-				float FalloffY = 0.0f;
-
-				int RangeX = 0; // for panning
-				bool InVoiceField = false;
-
-				switch(v->m_Shape)
+			case ISound::SHAPE_CIRCLE:
 				{
-				case ISound::SHAPE_CIRCLE:
+					float r = v->m_Circle.m_Radius;
+					RangeX = r;
+
+					int Dist = (int)sqrtf((float)dx*dx+dy*dy); // nasty float
+					if(Dist < r)
 					{
-						float r = v->m_Circle.m_Radius;
-						RangeX = r;
-
-						int Dist = (int)sqrtf((float)dx*dx+dy*dy); // nasty float
-						if(Dist < r)
-						{
-							InVoiceField = true;
-
-							// falloff
-							int FalloffDistance = r*v->m_Falloff;
-							if(Dist > FalloffDistance)
-								FalloffX = FalloffY = (r-Dist)/(r-FalloffDistance);
-							else
-								FalloffX = FalloffY = 1.0f;
-						}
-						else
-							InVoiceField = false;
+						InVoiceField = true;
 
-						break;
+						// falloff
+						int FalloffDistance = r*v->m_Falloff;
+						if(Dist > FalloffDistance)
+							FalloffX = FalloffY = (r-Dist)/(r-FalloffDistance);
+						else
+							FalloffX = FalloffY = 1.0f;
 					}
+					else
+						InVoiceField = false;
 
-				case ISound::SHAPE_RECTANGLE:
-					{
-						RangeX = v->m_Rectangle.m_Width/2.0f;
-
-						int abs_dx = abs(dx);
-						int abs_dy = abs(dy);
+					break;
+				}
 
-						int w = v->m_Rectangle.m_Width/2.0f;
-						int h = v->m_Rectangle.m_Height/2.0f;
+			case ISound::SHAPE_RECTANGLE:
+				{
+					RangeX = v->m_Rectangle.m_Width/2.0f;
 
-						if(abs_dx < w && abs_dy < h)
-						{
-							InVoiceField = true;
+					int abs_dx = abs(dx);
+					int abs_dy = abs(dy);
 
-							// falloff
-							int fx = v->m_Falloff * w;
-							int fy = v->m_Falloff * h;
+					int w = v->m_Rectangle.m_Width/2.0f;
+					int h = v->m_Rectangle.m_Height/2.0f;
 
-							FalloffX = abs_dx > fx ? (float)(w-abs_dx)/(w-fx) : 1.0f;
-							FalloffY = abs_dy > fy ? (float)(h-abs_dy)/(h-fy) : 1.0f;
-						}
-						else
-							InVoiceField = false;
+					if(abs_dx < w && abs_dy < h)
+					{
+						InVoiceField = true;
 
-						break;
-					}
-				};
+						// falloff
+						int fx = v->m_Falloff * w;
+						int fy = v->m_Falloff * h;
 
-				if(InVoiceField)
-				{
-					// panning
-					if(!(v->m_Flags&ISound::FLAG_NO_PANNING))
-					{
-						if(dx > 0)
-							Lvol = ((RangeX-p)*Lvol)/RangeX;
-						else
-							Rvol = ((RangeX-p)*Rvol)/RangeX;
+						FalloffX = abs_dx > fx ? (float)(w-abs_dx)/(w-fx) : 1.0f;
+						FalloffY = abs_dy > fy ? (float)(h-abs_dy)/(h-fy) : 1.0f;
 					}
+					else
+						InVoiceField = false;
 
-					{
-						Lvol *= FalloffX * FalloffY;
-						Rvol *= FalloffX * FalloffY;
-					}
-				}
-				else
-				{
-					Lvol = 0;
-					Rvol = 0;
+					break;
 				}
-			}
+			};
 
-			// process all frames
-			for(unsigned s = 0; s < End; s++)
+			if(InVoiceField)
 			{
-				*pOut++ += (*pInL)*Lvol;
-				*pOut++ += (*pInR)*Rvol;
-				pInL += Step;
-				pInR += Step;
-				v->m_Tick++;
-			}
+				// panning
+				if(!(v->m_Flags&ISound::FLAG_NO_PANNING))
+				{
+					if(dx > 0)
+						Lvol = ((RangeX-p)*Lvol)/RangeX;
+					else
+						Rvol = ((RangeX-p)*Rvol)/RangeX;
+				}
 
-			// free voice if not used any more
-			if(v->m_Tick == v->m_pSample->m_NumFrames)
-			{
-				if(v->m_Flags&ISound::FLAG_LOOP)
-					v->m_Tick = 0;
-				else
 				{
-					v->m_pSample = 0;
-					v->m_Age++;
+					Lvol *= FalloffX * FalloffY;
+					Rvol *= FalloffX * FalloffY;
 				}
 			}
+			else
+			{
+				Lvol = 0;
+				Rvol = 0;
+			}
 		}
-	}
 
+		// process all frames, voices out of range only advance
+		if(Lvol || Rvol)
+			SoundMix(m_pMixBuffer, pIn, Step, End, clamp(Lvol, 0, 0x7fff), clamp(Rvol, 0, 0x7fff));
+		v->m_Tick += End;
 
-	// release the lock
-	lock_unlock(m_SoundLock);
-
-	{
-		// clamp accumulated values
-		// TODO: this seams slow
-		for(unsigned i = 0; i < Frames; i++)
+		// free voice if not used any more
+		if(v->m_Tick == v->m_pSample->m_NumFrames)
 		{
-			int j = i<<1;
-			int vl = ((m_pMixBuffer[j]*MasterVol)/101)>>8;
-			int vr = ((m_pMixBuffer[j+1]*MasterVol)/101)>>8;
-
-			pFinalOut[j] = Int2Short(vl);
-			pFinalOut[j+1] = Int2Short(vr);
+			if(v->m_Flags&ISound::FLAG_LOOP)
+				v->m_Tick = 0;
+			else
+			{
+				// let the game thread know, the last active voice takes this place in the list
+				m_aFinishedSerials[m_aActiveVoices[a]].store(v->m_Serial, std::memory_order_release);
+				DeactivateVoice(m_aActiveVoices[a]);
+				continue;
+			}
 		}
+		a++;
 	}
 
+	// clamp accumulated values
+	SoundClamp(pFinalOut, m_pMixBuffer, Frames, MasterVol);
+
 #if defined(CONF_ARCH_ENDIAN_BIG)
 	swap_endian(pFinalOut, sizeof(short), Frames * 2);
 #endif
@@ -289,8 +480,6 @@ int CSound::Init()
 
 	SDL_AudioSpec Format, FormatOut;
 
-	m_SoundLock = lock_create();
-
 	if(!g_Config.m_SndEnable)
 		return 0;
 
@@ -320,8 +509,10 @@ int CSound::Init()
 		dbg_msg("client/sound", "sound init successful");
 
 	m_MaxFrames = FormatOut.samples*2;
-	m_pMixBuffer = (int *)mem_alloc(m_MaxFrames*2*sizeof(int), 1);
+	m_pMixBuffer = (int *)mem_alloc(m_MaxFrames*2*sizeof(int), 16);
 
+	// from now on voice changes go through the command queue
+	m_MixerRunning = true;
 	SDL_PauseAudio(0);
 
 	m_SoundEnabled = 1;
@@ -338,11 +529,7 @@ int CSound::Update()
 		WantedVolume = 0;
 
 	if(WantedVolume != m_SoundVolume)
-	{
-		lock_wait(m_SoundLock);
 		m_SoundVolume = WantedVolume;
-		lock_unlock(m_SoundLock);
-	}
 
 	return 0;
 }
@@ -357,7 +544,7 @@ int CSound::Shutdown()
 
 	SDL_CloseAudio();
 	SDL_QuitSubSystem(SDL_INIT_AUDIO);
-	lock_destroy(m_SoundLock);
+	m_MixerRunning = false;
 	if(m_pMixBuffer)
 	{
 		mem_free(m_pMixBuffer);
@@ -705,10 +892,17 @@ void CSound::UnloadSample(int SampleID)
 		return;
 
 	Stop(SampleID);
+
+	// the mixer might not have seen the stop yet, make sure it let go of the data before freeing it
+	if(m_MixerRunning)
+		SDL_LockAudio();
+	ProcessCommands();
 	if (m_aSamples[SampleID].m_pData != 0x0) 
 		mem_free(m_aSamples[SampleID].m_pData);
 
 	m_aSamples[SampleID].m_pData = 0x0;
+	if(m_MixerRunning)
+		SDL_UnlockAudio();
 }
 
 void CSound::UnloadSampleLua(int SampleID, lua_State *L)
@@ -733,110 +927,59 @@ void CSound::SetListenerPos(float x, float y)
 
 void CSound::SetVoiceVolume(CVoiceHandle Voice, float Volume)
 {
-	if(!Voice.IsValid())
-		return;
-
-	int VoiceID = Voice.Id();
-
-	if(m_aVoices[VoiceID].m_Age != Voice.Age())
+	int VoiceID = PlayingVoiceID(Voice);
+	if(VoiceID < 0)
 		return;
 
 	Volume = clamp(Volume, 0.0f, 1.0f);
-	m_aVoices[VoiceID].m_Vol = (int)(Volume*255.0f);
+	PushVoiceCommand(CSoundCommand::SET_VOLUME, VoiceID, Volume);
 }
 
 void CSound::SetVoiceFalloff(CVoiceHandle Voice, float Falloff)
 {
-	if(!Voice.IsValid())
-		return;
-
-	int VoiceID = Voice.Id();
-
-	if(m_aVoices[VoiceID].m_Age != Voice.Age())
+	int VoiceID = PlayingVoiceID(Voice);
+	if(VoiceID < 0)
 		return;
 
 	Falloff = clamp(Falloff, 0.0f, 1.0f);
-	m_aVoices[VoiceID].m_Falloff = Falloff;
+	PushVoiceCommand(CSoundCommand::SET_FALLOFF, VoiceID, Falloff);
 }
 
 void CSound::SetVoiceLocation(CVoiceHandle Voice, float x, float y)
 {
-	if(!Voice.IsValid())
-		return;
-
-	int VoiceID = Voice.Id();
-
-	if(m_aVoices[VoiceID].m_Age != Voice.Age())
+	int VoiceID = PlayingVoiceID(Voice);
+	if(VoiceID < 0)
 		return;
 
-	m_aVoices[VoiceID].m_X = x;
-	m_aVoices[VoiceID].m_Y = y;
+	PushVoiceCommand(CSoundCommand::SET_LOCATION, VoiceID, x, y);
 }
 
 void CSound::SetVoiceTimeOffset(CVoiceHandle Voice, float offset)
 {
-	if(!Voice.IsValid())
-		return;
-
-	int VoiceID = Voice.Id();
-
-	if(m_aVoices[VoiceID].m_Age != Voice.Age())
+	int VoiceID = PlayingVoiceID(Voice);
+	if(VoiceID < 0)
 		return;
 
-	lock_wait(m_SoundLock);
-	{
-		if(m_aVoices[VoiceID].m_pSample)
-		{
-			int Tick = 0;
-			bool IsLooping = m_aVoices[VoiceID].m_Flags&ISound::FLAG_LOOP;
-			uint64_t TickOffset = m_aVoices[VoiceID].m_pSample->m_Rate * offset;
-			if(m_aVoices[VoiceID].m_pSample->m_NumFrames > 0 && IsLooping)
-				Tick = TickOffset % m_aVoices[VoiceID].m_pSample->m_NumFrames;
-			else
-				Tick = clamp(TickOffset, (uint64_t)0, (uint64_t)m_aVoices[VoiceID].m_pSample->m_NumFrames);
-
-			// at least 200msec off, else depend on buffer size
-			float Threshold = max(0.2f * m_aVoices[VoiceID].m_pSample->m_Rate, (float)m_MaxFrames);
-			if(abs(m_aVoices[VoiceID].m_Tick-Tick) > Threshold)
-			{
-				// take care of looping (modulo!)
-				if( !(IsLooping && (min(m_aVoices[VoiceID].m_Tick, Tick) + m_aVoices[VoiceID].m_pSample->m_NumFrames - max(m_aVoices[VoiceID].m_Tick, Tick)) <= Threshold))
-				{
-					m_aVoices[VoiceID].m_Tick = Tick;
-				}
-			}
-		}
-	}
-	lock_unlock(m_SoundLock);
+	// the mixer knows where the voice is right now, let it decide whether to jump
+	PushVoiceCommand(CSoundCommand::SET_TIME_OFFSET, VoiceID, offset);
 }
 
 void CSound::SetVoiceCircle(CVoiceHandle Voice, float Radius)
 {
-	if(!Voice.IsValid())
-		return;
-
-	int VoiceID = Voice.Id();
-
-	if(m_aVoices[VoiceID].m_Age != Voice.Age())
+	int VoiceID = PlayingVoiceID(Voice);
+	if(VoiceID < 0)
 		return;
 
-	m_aVoices[VoiceID].m_Shape = ISound::SHAPE_CIRCLE;
-	m_aVoices[VoiceID].m_Circle.m_Radius = max(0.0f, Radius);
+	PushVoiceCommand(CSoundCommand::SET_CIRCLE, VoiceID, max(0.0f, Radius));
 }
 
 void CSound::SetVoiceRectangle(CVoiceHandle Voice, float Width, float Height)
 {
-	if(!Voice.IsValid())
+	int VoiceID = PlayingVoiceID(Voice);
+	if(VoiceID < 0)
 		return;
 
-	int VoiceID = Voice.Id();
-
-	if(m_aVoices[VoiceID].m_Age != Voice.Age())
-		return;
-
-	m_aVoices[VoiceID].m_Shape = ISound::SHAPE_RECTANGLE;
-	m_aVoices[VoiceID].m_Rectangle.m_Width = max(0.0f, Width);
-	m_aVoices[VoiceID].m_Rectangle.m_Height = max(0.0f, Height);
+	PushVoiceCommand(CSoundCommand::SET_RECTANGLE, VoiceID, max(0.0f, Width), max(0.0f, Height));
 }
 
 void CSound::SetChannel(int ChannelID, float Vol, float Pan)
@@ -851,13 +994,11 @@ ISound::CVoiceHandle CSound::Play(int ChannelID, int SampleID, int Flags, float
 	int Age = -1;
 	int i;
 
-	lock_wait(m_SoundLock);
-
 	// search for voice
 	for(i = 0; i < NUM_VOICES; i++)
 	{
 		int id = (m_NextVoice + i) % NUM_VOICES;
-		if(!m_aVoices[id].m_pSample)
+		if(!UpdateVoiceSlot(id)->m_pSample)
 		{
 			VoiceID = id;
 			m_NextVoice = id+1;
@@ -868,23 +1009,24 @@ ISound::CVoiceHandle CSound::Play(int ChannelID, int SampleID, int Flags, float
 	// voice found, use it
 	if(VoiceID != -1)
 	{
-		m_aVoices[VoiceID].m_pSample = &m_aSamples[SampleID];
-		m_aVoices[VoiceID].m_pChannel = &m_aChannels[ChannelID];
-		if(Flags & FLAG_LOOP)
-			m_aVoices[VoiceID].m_Tick = m_aSamples[SampleID].m_PausedAt;
-		else
-			m_aVoices[VoiceID].m_Tick = 0;
-		m_aVoices[VoiceID].m_Vol = 255;
-		m_aVoices[VoiceID].m_Flags = Flags;
-		m_aVoices[VoiceID].m_X = (int)x;
-		m_aVoices[VoiceID].m_Y = (int)y;
-		m_aVoices[VoiceID].m_Falloff = 0.0f;
-		m_aVoices[VoiceID].m_Shape = ISound::SHAPE_CIRCLE;
-		m_aVoices[VoiceID].m_Circle.m_Radius = DefaultDistance;
-		Age = m_aVoices[VoiceID].m_Age;
+		CVoiceSlot *pSlot = &m_aVoiceSlots[VoiceID];
+		pSlot->m_pSample = &m_aSamples[SampleID];
+		pSlot->m_Serial++;
+		Age = pSlot->m_Age;
+
+		CSoundCommand Command;
+		mem_zero(&Command, sizeof(Command));
+		Command.m_Type = CSoundCommand::PLAY;
+		Command.m_VoiceID = VoiceID;
+		Command.m_Serial = pSlot->m_Serial;
+		Command.m_SampleID = SampleID;
+		Command.m_ChannelID = ChannelID;
+		Command.m_Flags = Flags;
+		Command.m_aParams[0] = x;
+		Command.m_aParams[1] = y;
+		PushCommand(Command);
 	}
 
-	lock_unlock(m_SoundLock);
 	return CreateVoiceHandle(VoiceID, Age);
 }
 
@@ -901,56 +1043,41 @@ ISound::CVoiceHandle CSound::Play(int ChannelID, int SampleID, int Flags)
 void CSound::Stop(int SampleID)
 {
 	// TODO: a nice fade out
-	lock_wait(m_SoundLock);
 	CSample *pSample = &m_aSamples[SampleID];
 	for(int i = 0; i < NUM_VOICES; i++)
 	{
-		if(m_aVoices[i].m_pSample == pSample)
-		{
-			if(m_aVoices[i].m_Flags & FLAG_LOOP)
-				m_aVoices[i].m_pSample->m_PausedAt = m_aVoices[i].m_Tick;
-			else
-				m_aVoices[i].m_pSample->m_PausedAt = 0;
-			m_aVoices[i].m_pSample = 0;
-		}
+		if(m_aVoiceSlots[i].m_pSample == pSample)
+			m_aVoiceSlots[i].m_pSample = 0;
 	}
-	lock_unlock(m_SoundLock);
+
+	CSoundCommand Command;
+	mem_zero(&Command, sizeof(Command));
+	Command.m_Type = CSoundCommand::STOP_SAMPLE;
+	Command.m_SampleID = SampleID;
+	PushCommand(Command);
 }
 
 void CSound::StopAll()
 {
 	// TODO: a nice fade out
-	lock_wait(m_SoundLock);
 	for(int i = 0; i < NUM_VOICES; i++)
-	{
-		if(m_aVoices[i].m_pSample)
-		{
-			if(m_aVoices[i].m_Flags & FLAG_LOOP)
-				m_aVoices[i].m_pSample->m_PausedAt = m_aVoices[i].m_Tick;
-			else
-				m_aVoices[i].m_pSample->m_PausedAt = 0;
-		}
-		m_aVoices[i].m_pSample = 0;
-	}
-	lock_unlock(m_SoundLock);
+		m_aVoiceSlots[i].m_pSample = 0;
+
+	CSoundCommand Command;
+	mem_zero(&Command, sizeof(Command));
+	Command.m_Type = CSoundCommand::STOP_ALL;
+	PushCommand(Command);
 }
 
 void CSound::StopVoice(CVoiceHandle Voice)
 {
-	if(!Voice.IsValid())
+	int VoiceID = PlayingVoiceID(Voice);
+	if(VoiceID < 0)
 		return;
 
-	int VoiceID = Voice.Id();
-
-	if(m_aVoices[VoiceID].m_Age != Voice.Age())
-		return;
-
-	lock_wait(m_SoundLock);
-	{
-		m_aVoices[VoiceID].m_pSample = 0;
-		m_aVoices[VoiceID].m_Age++;
-	}
-	lock_unlock(m_SoundLock);
+	PushVoiceCommand(CSoundCommand::STOP_VOICE, VoiceID);
+	m_aVoiceSlots[VoiceID].m_pSample = 0;
+	m_aVoiceSlots[VoiceID].m_Age++;
 }
 
 
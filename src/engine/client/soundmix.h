@@ -0,0 +1,101 @@
+#ifndef ENGINE_CLIENT_SOUNDMIX_H
+#define ENGINE_CLIENT_SOUNDMIX_H
+
+// mixing kernels of the sound engine, they only see the buffers they are given
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define CONF_SOUND_SSE2 1
+	#include <emmintrin.h>
+#endif
+
+// scale Frames frames of pIn by the volumes and add them to the interleaved stereo buffer pOut.
+// pIn has Channels samples per frame, mono sounds go to both sides. volumes have to fit into 16 bits
+inline void SoundMixScalar(int *pOut, const short *pIn, int Channels, unsigned Frames, int LVol, int RVol)
+{
+	const int Right = Channels > 1 ? 1 : 0;
+	for(unsigned s = 0; s < Frames; s++)
+	{
+		*pOut++ += pIn[0]*LVol;
+		*pOut++ += pIn[Right]*RVol;
+		pIn += Channels;
+	}
+}
+
+inline void SoundMix(int *pOut, const short *pIn, int Channels, unsigned Frames, int LVol, int RVol)
+{
+#if defined(CONF_SOUND_SSE2)
+	if(Channels <= 2)
+	{
+		// 16x16 bit products put together from their low and high halves, 8 output values per step
+		const __m128i Vol = _mm_set_epi16(RVol, LVol, RVol, LVol, RVol, LVol, RVol, LVol);
+		unsigned s = 0;
+		if(Channels == 2)
+		{
+			for(; s+4 <= Frames; s += 4)
+			{
+				__m128i In = _mm_loadu_si128((const __m128i *)(pIn+s*2));
+				__m128i Lo = _mm_mullo_epi16(In, Vol);
+				__m128i Hi = _mm_mulhi_epi16(In, Vol);
+				__m128i *pDst = (__m128i *)(pOut+s*2);
+				_mm_storeu_si128(pDst, _mm_add_epi32(_mm_loadu_si128(pDst), _mm_unpacklo_epi16(Lo, Hi)));
+				_mm_storeu_si128(pDst+1, _mm_add_epi32(_mm_loadu_si128(pDst+1), _mm_unpackhi_epi16(Lo, Hi)));
+			}
+		}
+		else
+		{
+			for(; s+8 <= Frames; s += 8)
+			{
+				// duplicate the mono samples into left and right
+				__m128i In = _mm_loadu_si128((const __m128i *)(pIn+s));
+				__m128i aStereo[2] = { _mm_unpacklo_epi16(In, In), _mm_unpackhi_epi16(In, In) };
+				__m128i *pDst = (__m128i *)(pOut+s*2);
+				for(int i = 0; i < 2; i++, pDst += 2)
+				{
+					__m128i Lo = _mm_mullo_epi16(aStereo[i], Vol);
+					__m128i Hi = _mm_mulhi_epi16(aStereo[i], Vol);
+					_mm_storeu_si128(pDst, _mm_add_epi32(_mm_loadu_si128(pDst), _mm_unpacklo_epi16(Lo, Hi)));
+					_mm_storeu_si128(pDst+1, _mm_add_epi32(_mm_loadu_si128(pDst+1), _mm_unpackhi_epi16(Lo, Hi)));
+				}
+			}
+		}
+		SoundMixScalar(pOut+s*2, pIn+s*Channels, Channels, Frames-s, LVol, RVol);
+		return;
+	}
+#endif
+	SoundMixScalar(pOut, pIn, Channels, Frames, LVol, RVol);
+}
+
+inline short SoundClampSample(int i)
+{
+	if(i > 0x7fff)
+		return 0x7fff;
+	else if(i < -0x7fff)
+		return -0x7fff;
+	return i;
+}
+
+// apply the master volume (0 - 100) to the accumulated stereo buffer and clamp it to 16 bit samples
+inline void SoundClampScalar(short *pFinalOut, const int *pMix, unsigned Frames, int MasterVol)
+{
+	for(unsigned i = 0; i < Frames*2; i++)
+		pFinalOut[i] = SoundClampSample(((pMix[i]*MasterVol)/101)>>8);
+}
+
+inline void SoundClamp(short *pFinalOut, const int *pMix, unsigned Frames, int MasterVol)
+{
+	unsigned i = 0;
+#if defined(CONF_SOUND_SSE2)
+	// SSE2 has no 32 bit multiply, so scale in float. the result can differ from the integer version by one
+	const __m128 Scale = _mm_set1_ps(MasterVol/(101.0f*256.0f));
+	const __m128i Min = _mm_set1_epi16(-0x7fff);
+	for(; i+8 <= Frames*2; i += 8)
+	{
+		__m128i A = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)(pMix+i))), Scale));
+		__m128i B = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)(pMix+i+4))), Scale));
+		_mm_storeu_si128((__m128i *)(pFinalOut+i), _mm_max_epi16(_mm_packs_epi32(A, B), Min));
+	}
+#endif
+	SoundClampScalar(pFinalOut+i, pMix+i, Frames-i/2, MasterVol);
+}
+
+#endif
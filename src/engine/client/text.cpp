@@ -4,6 +4,7 @@
 #include <base/math.h>
 #include <engine/graphics.h>
 #include <engine/textrender.h>
+#include <engine/shared/config.h>
 
 #ifdef CONF_FAMILY_WINDOWS
 	#include <windows.h>
@@ -18,6 +19,12 @@
 enum
 {
 	MAX_CHARACTERS = 64,
+	GLYPH_HASH_SIZE = 1024,
+
+	MAX_TEXT_LAYOUTS = 1024,
+	TEXT_LAYOUT_HASH_SIZE = 2048,
+	MAX_TEXT_LAYOUT_LENGTH = 1024,
+	MAX_TEXT_LAYOUT_QUADS = 4096,
 };
 
 
@@ -27,6 +34,37 @@ static unsigned int aFontSizes[] = {8,9,10,11,12,13,14,15,16,17,18,19,20,36,64};
 static const int COLOR_CODE_LEN = str_length(COLOR_CODE_TAG);
 
 
+// doubly linked lists through m_LruPrev and m_LruNext, -1 ends them
+template<class T>
+static void LruUnlink(T *pItems, int *pHead, int *pTail, int Index)
+{
+	T *pItem = &pItems[Index];
+	if(pItem->m_LruPrev >= 0)
+		pItems[pItem->m_LruPrev].m_LruNext = pItem->m_LruNext;
+	else
+		*pHead = pItem->m_LruNext;
+	if(pItem->m_LruNext >= 0)
+		pItems[pItem->m_LruNext].m_LruPrev = pItem->m_LruPrev;
+	else
+		*pTail = pItem->m_LruPrev;
+	pItem->m_LruPrev = -1;
+	pItem->m_LruNext = -1;
+}
+
+template<class T>
+static void LruPushFront(T *pItems, int *pHead, int *pTail, int Index)
+{
+	T *pItem = &pItems[Index];
+	pItem->m_LruPrev = -1;
+	pItem->m_LruNext = *pHead;
+	if(*pHead >= 0)
+		pItems[*pHead].m_LruPrev = Index;
+	else
+		*pTail = Index;
+	*pHead = Index;
+}
+
+
 struct CFontChar
 {
 	FT_ULong m_ID;
@@ -41,6 +79,10 @@ struct CFontChar
 
 	float m_aUvs[4];
 	int64 m_TouchTime;
+
+	int m_HashNext;
+	int m_LruPrev;
+	int m_LruNext;
 };
 
 struct CFontSizeData
@@ -60,6 +102,59 @@ struct CFontSizeData
 	CFontChar m_aCharacters[MAX_CHARACTERS*MAX_CHARACTERS];
 
 	int m_CurrentCharacter;
+
+	// slots by character and by last use, most recent first
+	int m_aGlyphHash[GLYPH_HASH_SIZE];
+	int m_LruHead;
+	int m_LruTail;
+
+	// changes whenever a slot gets another glyph, layouts made before are stale then
+	unsigned m_Generation;
+	// cached layouts don't touch their glyphs
+	int64 m_LayoutTouchTime;
+};
+
+// a glyph of a laid out text, positioned relative to the cursor
+struct CGlyphQuad
+{
+	float m_X;
+	float m_Y;
+	float m_Width;
+	float m_Height;
+	float m_aUvs[4];
+};
+
+// everything that decides how a text is laid out, with the outcome of it
+struct CTextLayout
+{
+	unsigned m_Hash;
+	CFont *m_pFont;
+	unsigned m_FontSize;
+	float m_Size;
+	float m_FakeToScreenX;
+	float m_FakeToScreenY;
+	float m_LineWidth;
+	float m_StartOffset;
+	int m_MaxLines;
+	int m_LineCount;
+	int m_Flags;
+	int m_Length;
+	char *m_pText;
+
+	unsigned m_Generation;
+	CGlyphQuad *m_pQuads;
+	int m_NumQuads;
+	float m_EndX;
+	float m_EndY;
+	float m_MaxLineWidth;
+	bool m_GotNewLine;
+	bool m_HasMaxLineWidth;
+	int m_NumLines;
+	int m_NumChars;
+
+	int m_HashNext;
+	int m_LruPrev;
+	int m_LruNext;
 };
 
 class CFont
@@ -126,6 +221,19 @@ class CTextRender : public IEngineTextRender
 
 	FT_Library m_FTLibrary;
 
+	// recently laid out texts, by key and by last use
+	CTextLayout m_aLayouts[MAX_TEXT_LAYOUTS];
+	int m_aLayoutHash[TEXT_LAYOUT_HASH_SIZE];
+	int m_NumLayouts;
+	int m_LayoutLruHead;
+	int m_LayoutLruTail;
+
+	// glyphs of the text that is being laid out
+	CGlyphQuad m_aRecordedQuads[MAX_TEXT_LAYOUT_QUADS];
+	int m_NumRecordedQuads;
+
+	CTextRenderStats m_Stats;
+
 	int GetFontSizeIndex(unsigned int Pixelsize)
 	{
 		for(unsigned i = 0; i < NUM_FONT_SIZES; i++)
@@ -189,6 +297,10 @@ class CTextRender : public IEngineTextRender
 		pSizeData->m_TextureWidth = Width;
 		pSizeData->m_TextureHeight = Height;
 		pSizeData->m_CurrentCharacter = 0;
+		mem_set(pSizeData->m_aGlyphHash, 0xff, sizeof(pSizeData->m_aGlyphHash));
+		pSizeData->m_LruHead = -1;
+		pSizeData->m_LruTail = -1;
+		pSizeData->m_Generation++;
 
 		dbg_msg("text", "font data memory usage: %d byte (%.2f KiB)", FontMemoryUsage, (float)FontMemoryUsage/1024.0f);
 
@@ -282,7 +394,7 @@ class CTextRender : public IEngineTextRender
 	unsigned char ms_aGlyphData[(1024/8) * (1024/8)];
 	unsigned char ms_aGlyphDataOutlined[(1024/8) * (1024/8)];
 
-	int GetSlot(CFontSizeData *pSizeData)
+	int GetSlot(CFontSizeData *pSizeData, int64 Now)
 	{
 		int CharCount = pSizeData->m_NumXChars*pSizeData->m_NumYChars;
 		if(pSizeData->m_CurrentCharacter < CharCount)
@@ -292,28 +404,30 @@ class CTextRender : public IEngineTextRender
 			return i;
 		}
 
-		// kick out the oldest
-		// TODO: remove this linear search
+		// kick out the least recently used one
 		{
-			int Oldest = 0;
-			for(int i = 1; i < CharCount; i++)
-			{
-				if(pSizeData->m_aCharacters[i].m_TouchTime < pSizeData->m_aCharacters[Oldest].m_TouchTime)
-					Oldest = i;
-			}
-
-			if(time_get()-pSizeData->m_aCharacters[Oldest].m_TouchTime < time_freq() &&
+			int Oldest = pSizeData->m_LruTail;
+			if((Now-pSizeData->m_aCharacters[Oldest].m_TouchTime < time_freq() || Now-pSizeData->m_LayoutTouchTime < time_freq()) &&
 				(pSizeData->m_NumXChars < MAX_CHARACTERS || pSizeData->m_NumYChars < MAX_CHARACTERS))
 			{
 				IncreaseTextureSize(pSizeData);
-				return GetSlot(pSizeData);
+				return GetSlot(pSizeData, Now);
 			}
 
+			// unhash it
+			int *pIndex = &pSizeData->m_aGlyphHash[pSizeData->m_aCharacters[Oldest].m_ID&(GLYPH_HASH_SIZE-1)];
+			while(*pIndex != Oldest)
+				pIndex = &pSizeData->m_aCharacters[*pIndex].m_HashNext;
+			*pIndex = pSizeData->m_aCharacters[Oldest].m_HashNext;
+			LruUnlink(pSizeData->m_aCharacters, &pSizeData->m_LruHead, &pSizeData->m_LruTail, Oldest);
+
+			pSizeData->m_Generation++;
+			m_Stats.m_NumGlyphEvictions++;
 			return Oldest;
 		}
 	}
 
-	int RenderGlyph(CFont *pFont, CFontSizeData *pSizeData, FT_ULong Chr)
+	int RenderGlyph(CFont *pFont, CFontSizeData *pSizeData, FT_ULong Chr, int64 Now)
 	{
 		FT_Bitmap *pBitmap;
 		int SlotID = 0;
@@ -335,7 +449,7 @@ class CTextRender : public IEngineTextRender
 		pBitmap = &pFont->m_FtFace->glyph->bitmap; // ignore_convention
 
 		// fetch slot
-		SlotID = GetSlot(pSizeData);
+		SlotID = GetSlot(pSizeData, Now);
 		if(SlotID < 0)
 			return -1;
 
@@ -405,22 +519,27 @@ class CTextRender : public IEngineTextRender
 			pFontchr->m_aUvs[1] = (SlotID/pSizeData->m_NumXChars) / (float)(pSizeData->m_NumYChars);
 			pFontchr->m_aUvs[2] = pFontchr->m_aUvs[0] + Width*Uscale;
 			pFontchr->m_aUvs[3] = pFontchr->m_aUvs[1] + Height*Vscale;
+
+			int *pBucket = &pSizeData->m_aGlyphHash[Chr&(GLYPH_HASH_SIZE-1)];
+			pFontchr->m_HashNext = *pBucket;
+			*pBucket = SlotID;
+			LruPushFront(pSizeData->m_aCharacters, &pSizeData->m_LruHead, &pSizeData->m_LruTail, SlotID);
 		}
 
 		return SlotID;
 	}
 
-	const CFontChar *GetChar(CFont *pFont, CFontSizeData *pSizeData, FT_ULong Chr)
+	const CFontChar *GetChar(CFont *pFont, CFontSizeData *pSizeData, FT_ULong Chr, int64 Now)
 	{
 		CFontChar *pFontchr = NULL;
 
 		// search for the character
-		// TODO: remove this linear search
-		for(int i = 0; i < pSizeData->m_CurrentCharacter; i++)
+		for(int i = pSizeData->m_aGlyphHash[Chr&(GLYPH_HASH_SIZE-1)]; i >= 0; i = pSizeData->m_aCharacters[i].m_HashNext)
 		{
 			if(pSizeData->m_aCharacters[i].m_ID == Chr)
 			{
 				pFontchr = &pSizeData->m_aCharacters[i];
+				m_Stats.m_NumGlyphHits++;
 				break;
 			}
 		}
@@ -428,15 +547,23 @@ class CTextRender : public IEngineTextRender
 		// check if we need to render the character
 		if(!pFontchr)
 		{
-			int Index = RenderGlyph(pFont, pSizeData, Chr);
+			m_Stats.m_NumGlyphMisses++;
+			int Index = RenderGlyph(pFont, pSizeData, Chr, Now);
 			if(Index >= 0)
 				pFontchr = &pSizeData->m_aCharacters[Index];
 		}
 
 		// touch the character
-		// TODO: don't call time_get here || shouldn't be too bad at all since caching is used...
 		if(pFontchr)
-			pFontchr->m_TouchTime = time_get();
+		{
+			int Index = pFontchr - pSizeData->m_aCharacters;
+			if(pSizeData->m_LruHead != Index)
+			{
+				LruUnlink(pSizeData->m_aCharacters, &pSizeData->m_LruHead, &pSizeData->m_LruTail, Index);
+				LruPushFront(pSizeData->m_aCharacters, &pSizeData->m_LruHead, &pSizeData->m_LruTail, Index);
+			}
+			pFontchr->m_TouchTime = Now;
+		}
 
 		return pFontchr;
 	}
@@ -650,6 +777,117 @@ class CTextRender : public IEngineTextRender
 		}
 	}
 
+	static unsigned LayoutHash(const CTextLayout *pKey)
+	{
+		unsigned Hash = 5381;
+		for(int i = 0; i < pKey->m_Length; i++)
+			Hash = ((Hash << 5) + Hash) + (unsigned char)pKey->m_pText[i];
+		Hash = Hash*31 + pKey->m_FontSize;
+		Hash = Hash*31 + pKey->m_Flags;
+		Hash = Hash*31 + (int)pKey->m_LineWidth;
+		return Hash;
+	}
+
+	static bool SameLayoutKey(const CTextLayout *pA, const CTextLayout *pB)
+	{
+		return pA->m_Hash == pB->m_Hash && pA->m_pFont == pB->m_pFont && pA->m_FontSize == pB->m_FontSize &&
+			pA->m_Size == pB->m_Size && pA->m_FakeToScreenX == pB->m_FakeToScreenX && pA->m_FakeToScreenY == pB->m_FakeToScreenY &&
+			pA->m_LineWidth == pB->m_LineWidth && pA->m_StartOffset == pB->m_StartOffset && pA->m_MaxLines == pB->m_MaxLines &&
+			pA->m_LineCount == pB->m_LineCount && pA->m_Flags == pB->m_Flags && pA->m_Length == pB->m_Length &&
+			mem_comp(pA->m_pText, pB->m_pText, pA->m_Length) == 0;
+	}
+
+	int FindLayout(const CTextLayout *pKey)
+	{
+		for(int i = m_aLayoutHash[pKey->m_Hash&(TEXT_LAYOUT_HASH_SIZE-1)]; i >= 0; i = m_aLayouts[i].m_HashNext)
+		{
+			if(SameLayoutKey(&m_aLayouts[i], pKey))
+				return i;
+		}
+		return -1;
+	}
+
+	// takes the recorded glyphs, Index is the stale entry with the same key or -1
+	void StoreLayout(const CTextLayout *pLayout, int Index)
+	{
+		if(Index < 0)
+		{
+			if(m_NumLayouts < MAX_TEXT_LAYOUTS)
+				Index = m_NumLayouts++;
+			else
+			{
+				// drop the least recently used one
+				Index = m_LayoutLruTail;
+				int *pIndex = &m_aLayoutHash[m_aLayouts[Index].m_Hash&(TEXT_LAYOUT_HASH_SIZE-1)];
+				while(*pIndex != Index)
+					pIndex = &m_aLayouts[*pIndex].m_HashNext;
+				*pIndex = m_aLayouts[Index].m_HashNext;
+				LruUnlink(m_aLayouts, &m_LayoutLruHead, &m_LayoutLruTail, Index);
+				mem_free(m_aLayouts[Index].m_pQuads);
+			}
+
+			int *pBucket = &m_aLayoutHash[pLayout->m_Hash&(TEXT_LAYOUT_HASH_SIZE-1)];
+			m_aLayouts[Index] = *pLayout;
+			m_aLayouts[Index].m_HashNext = *pBucket;
+			*pBucket = Index;
+		}
+		else
+		{
+			int HashNext = m_aLayouts[Index].m_HashNext;
+			LruUnlink(m_aLayouts, &m_LayoutLruHead, &m_LayoutLruTail, Index);
+			mem_free(m_aLayouts[Index].m_pQuads);
+			m_aLayouts[Index] = *pLayout;
+			m_aLayouts[Index].m_HashNext = HashNext;
+		}
+		LruPushFront(m_aLayouts, &m_LayoutLruHead, &m_LayoutLruTail, Index);
+
+		// the text goes behind the glyphs
+		CTextLayout *pEntry = &m_aLayouts[Index];
+		unsigned QuadsSize = pLayout->m_NumQuads*sizeof(CGlyphQuad);
+		pEntry->m_pQuads = (CGlyphQuad *)mem_alloc(QuadsSize+pLayout->m_Length, sizeof(float));
+		mem_copy(pEntry->m_pQuads, m_aRecordedQuads, QuadsSize);
+		pEntry->m_pText = (char *)pEntry->m_pQuads+QuadsSize;
+		mem_copy(pEntry->m_pText, pLayout->m_pText, pLayout->m_Length);
+	}
+
+	float RenderLayout(CTextCursor *pCursor, CFontSizeData *pSizeData, const CTextLayout *pLayout, float CursorX, float CursorY)
+	{
+		if(pCursor->m_Flags&TEXTFLAG_RENDER)
+		{
+			for(int i = 0; i < 2; i++)
+			{
+				if(i == 0)
+					Graphics()->TextureSet(pSizeData->m_aTextures[1]);
+				else
+					Graphics()->TextureSet(pSizeData->m_aTextures[0]);
+
+				Graphics()->QuadsBegin();
+				if(i == 0)
+					Graphics()->SetColor(m_TextOutlineR, m_TextOutlineG, m_TextOutlineB, m_TextOutlineA*m_TextA);
+				else
+					Graphics()->SetColor(m_TextR, m_TextG, m_TextB, m_TextA);
+
+				for(int q = 0; q < pLayout->m_NumQuads; q++)
+				{
+					const CGlyphQuad *pQuad = &pLayout->m_pQuads[q];
+					Graphics()->QuadsSetSubset(pQuad->m_aUvs[0], pQuad->m_aUvs[1], pQuad->m_aUvs[2], pQuad->m_aUvs[3]);
+					IGraphics::CQuadItem QuadItem(CursorX+pQuad->m_X, CursorY+pQuad->m_Y, pQuad->m_Width, pQuad->m_Height);
+					Graphics()->QuadsDrawTL(&QuadItem, 1);
+				}
+				Graphics()->QuadsEnd();
+			}
+		}
+
+		// both passes count the characters
+		pCursor->m_X = CursorX+pLayout->m_EndX;
+		pCursor->m_LineCount += pLayout->m_NumLines;
+		pCursor->m_CharCount += pLayout->m_NumChars * ((pCursor->m_Flags&TEXTFLAG_RENDER) ? 2 : 1);
+		if(pLayout->m_GotNewLine)
+			pCursor->m_Y = CursorY+pLayout->m_EndY;
+
+		return pLayout->m_HasMaxLineWidth ? CursorX+pLayout->m_MaxLineWidth : 0.0f;
+	}
+
 
 public:
 	CTextRender()
@@ -667,6 +905,13 @@ public:
 
 		m_pDefaultFont = 0;
 
+		mem_set(m_aLayoutHash, 0xff, sizeof(m_aLayoutHash));
+		m_NumLayouts = 0;
+		m_LayoutLruHead = -1;
+		m_LayoutLruTail = -1;
+		m_NumRecordedQuads = 0;
+		mem_zero(&m_Stats, sizeof(m_Stats));
+
 		// GL_LUMINANCE can be good for debugging
 		//m_FontTextureFormat = GL_ALPHA;
 	}
@@ -701,9 +946,20 @@ public:
 
 	virtual void DestroyFont(CFont *pFont)
 	{
+		// layouts of the font can't be found anymore and get reused eventually
+		for(int i = 0; i < m_NumLayouts; i++)
+		{
+			if(m_aLayouts[i].m_pFont == pFont)
+				m_aLayouts[i].m_pFont = 0;
+		}
 		mem_free(pFont);
 	}
 
+	virtual void GetStats(CTextRenderStats *pStats) const
+	{
+		*pStats = m_Stats;
+	}
+
 	virtual void SetDefaultFont(CFont *pFont)
 	{
 		dbg_msg("textrender", "default pFont set %p", pFont);
@@ -808,6 +1064,11 @@ public:
 	}
 
 	virtual float TextEx(CTextCursor *pCursor, const char *pText, int Length)
+	{
+		return LayoutText(pCursor, pText, Length, g_Config.m_GfxTextLayoutCache != 0);
+	}
+
+	float LayoutText(CTextCursor *pCursor, const char *pText, int Length, bool UseCache)
 	{
 		if(!pText)
 			return 0.0f;
@@ -868,11 +1129,48 @@ public:
 		RenderSetup(pFont, ActualSize);
 
 		float Scale = 1.0f/(float)pSizeData->m_FontSize;
+		const int64 Now = time_get();
 
 		// set length
 		if(Length < 0)
 			Length = str_length(pText);
 
+		// text that starts a line is laid out the same wherever it is, only the pixel grid matters
+		CTextLayout Layout;
+		int StaleLayout = -1;
+		const bool Cache = UseCache && pCursor->m_X == pCursor->m_StartX && CursorX >= 0.0f && CursorY >= 0.0f && Length <= MAX_TEXT_LAYOUT_LENGTH;
+		if(Cache)
+		{
+			Layout.m_pFont = pFont;
+			Layout.m_FontSize = ActualSize;
+			Layout.m_Size = Size;
+			Layout.m_FakeToScreenX = FakeToScreenX;
+			Layout.m_FakeToScreenY = FakeToScreenY;
+			Layout.m_LineWidth = pCursor->m_LineWidth;
+			Layout.m_StartOffset = (pCursor->m_LineWidth > 0 || (pCursor->m_Flags&TEXTFLAG_STOP_AT_END)) ? pCursor->m_StartX-CursorX : 0.0f;
+			Layout.m_MaxLines = pCursor->m_MaxLines;
+			Layout.m_LineCount = pCursor->m_LineCount;
+			Layout.m_Flags = pCursor->m_Flags&~TEXTFLAG_RENDER;
+			Layout.m_Length = Length;
+			Layout.m_pText = (char *)pText;
+			Layout.m_Hash = LayoutHash(&Layout);
+
+			StaleLayout = FindLayout(&Layout);
+			if(StaleLayout >= 0 && m_aLayouts[StaleLayout].m_Generation == pSizeData->m_Generation)
+			{
+				m_Stats.m_NumLayoutHits++;
+				pSizeData->m_LayoutTouchTime = Now;
+				LruUnlink(m_aLayouts, &m_LayoutLruHead, &m_LayoutLruTail, StaleLayout);
+				LruPushFront(m_aLayouts, &m_LayoutLruHead, &m_LayoutLruTail, StaleLayout);
+				return RenderLayout(pCursor, pSizeData, &m_aLayouts[StaleLayout], CursorX, CursorY);
+			}
+			m_Stats.m_NumLayoutMisses++;
+			m_NumRecordedQuads = 0;
+		}
+		const unsigned Generation = pSizeData->m_Generation;
+		const int StartLineCount = pCursor->m_LineCount;
+		const int StartCharCount = pCursor->m_CharCount;
+
 		float MaxLineWidth = 0.0f;
 
 		// if we don't want to render, we can just skip the first outline pass
@@ -918,7 +1216,7 @@ public:
 					Compare.m_Y = DrawY;
 					Compare.m_Flags &= ~TEXTFLAG_RENDER;
 					Compare.m_LineWidth = -1;
-					TextEx(&Compare, pCurrent, Wlen);
+					LayoutText(&Compare, pCurrent, Wlen, false);
 
 					if(Compare.m_X-DrawX > pCursor->m_LineWidth)
 					{
@@ -930,7 +1228,7 @@ public:
 						Cutter.m_Flags &= ~TEXTFLAG_RENDER;
 						Cutter.m_Flags |= TEXTFLAG_STOP_AT_END;
 
-						TextEx(&Cutter, pCurrent, Wlen);
+						LayoutText(&Cutter, pCurrent, Wlen, false);
 						Wlen = Cutter.m_CharCount;
 						NewLine = 1;
 
@@ -969,7 +1267,7 @@ public:
 						continue;
 					}
 
-					const CFontChar *pChr = GetChar(pFont, pSizeData, Character);
+					const CFontChar *pChr = GetChar(pFont, pSizeData, Character, Now);
 					if(pChr)
 					{
 						float Advance = pChr->m_AdvanceX + Kerning(pFont, Character, NextCharacter)*Scale;
@@ -987,6 +1285,20 @@ public:
 							Graphics()->QuadsDrawTL(&QuadItem, 1);
 						}
 
+						if(Cache && i == 1)
+						{
+							if(m_NumRecordedQuads < MAX_TEXT_LAYOUT_QUADS)
+							{
+								CGlyphQuad *pQuad = &m_aRecordedQuads[m_NumRecordedQuads];
+								pQuad->m_X = DrawX+pChr->m_OffsetX*Size-CursorX;
+								pQuad->m_Y = DrawY+pChr->m_OffsetY*Size-CursorY;
+								pQuad->m_Width = pChr->m_Width*Size;
+								pQuad->m_Height = pChr->m_Height*Size;
+								mem_copy(pQuad->m_aUvs, pChr->m_aUvs, sizeof(pQuad->m_aUvs));
+							}
+							m_NumRecordedQuads++;
+						}
+
 						DrawX += Advance*Size;
 						pCursor->m_CharCount++;
 						MaxLineWidth = max(MaxLineWidth, DrawX);
@@ -1019,6 +1331,21 @@ public:
 		if(GotNewLine)
 			pCursor->m_Y = DrawY;
 
+		// glyphs that got evicted on the way would make the layout stale right away
+		if(Cache && pSizeData->m_Generation == Generation && m_NumRecordedQuads <= MAX_TEXT_LAYOUT_QUADS)
+		{
+			Layout.m_Generation = Generation;
+			Layout.m_NumQuads = m_NumRecordedQuads;
+			Layout.m_EndX = DrawX-CursorX;
+			Layout.m_EndY = DrawY-CursorY;
+			Layout.m_MaxLineWidth = MaxLineWidth-CursorX;
+			Layout.m_HasMaxLineWidth = MaxLineWidth > 0.0f;
+			Layout.m_GotNewLine = GotNewLine != 0;
+			Layout.m_NumLines = LineCount-StartLineCount;
+			Layout.m_NumChars = (pCursor->m_CharCount-StartCharCount) / ((pCursor->m_Flags&TEXTFLAG_RENDER) ? 2 : 1);
+			StoreLayout(&Layout, StaleLayout);
+		}
+
 		return MaxLineWidth;
 	}
 
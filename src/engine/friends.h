@@ -34,6 +34,8 @@ public:
 	virtual const CFriendInfo *GetFriend(int Index) const = 0;
 	virtual int GetFriendState(const char *pName, const char *pClan) const = 0;
 	virtual bool IsFriend(const char *pName, const char *pClan, bool PlayersOnly) const = 0;
+	// changes whenever a friend is added or removed
+	virtual int Revision() const = 0;
 
 	virtual void AddFriend(const char *pName, const char *pClan) = 0;
 	virtual void RemoveFriend(const char *pName, const char *pClan) = 0;
@@ -45,6 +45,32 @@ public:
 	int m_Red, m_Green, m_Blue;
 };
 
+/*
+	Structure: CGraphicsStats
+		Running totals of what was handed to the graphics backend.
+		Backends that don't count leave them at zero.
+*/
+class CGraphicsStats
+{
+public:
+	int64 m_NumBuffers;
+	int64 m_NumCommands;
+	int64 m_NumRenderCommands;
+	int64 m_NumPrimitives;
+	int64 m_NumVertices;
+	int64 m_NumTextureUploads;
+	int64 m_TextureUploadBytes;
+	int64 m_NumSwaps;
+
+	// filled in by the frontend
+	int64 m_NumStreamedVertices;
+	int64 m_NumFlushes;
+	int64 m_NumKicks;
+	int64 m_BytesCopied;
+	int64 m_NumImagesDecoded;
+	int64 m_NumImagesFromCache;
+};
+
 class IGraphics : public IInterface
 {
 	MACRO_INTERFACE("graphics", 0)
@@ -94,7 +120,9 @@ public:
 	virtual void WrapNormal() = 0;
 	virtual void WrapClamp() = 0;
 	virtual int MemoryUsage() const = 0;
+	virtual void GetStats(CGraphicsStats *pStats) const = 0;
 
+	// safe to call from any thread, decoded images are kept in the image cache
 	virtual int LoadPNG(CImageInfo *pImg, const char *pFilename, int StorageType) = 0;
 	virtual int UnloadTexture(int Index) = 0;
 	virtual int UnloadTextureLua(int Index, lua_State *L) = 0;
@@ -149,6 +177,16 @@ public:
 			: m_X0(x0), m_Y0(y0), m_X1(x1), m_Y1(y1), m_X2(x2), m_Y2(y2), m_X3(x3), m_Y3(y3) {}
 	};
 	virtual void QuadsDrawFreeform(const CFreeformItem *pArray, int Num) = 0;
+
+	// centered, rotated quads that carry their own subset and color, so a whole batch
+	// of sprites goes out in one call without touching the drawing state
+	struct CSpriteItem
+	{
+		float m_X, m_Y, m_Size, m_Rotation;
+		float m_aUvs[4]; // u0, v0, u1, v1
+		float m_R, m_G, m_B, m_A;
+	};
+	virtual void QuadsDrawSprites(const CSpriteItem *pArray, int Num) = 0;
 	virtual void QuadsText(float x, float y, float Size, const char *pText) = 0;
 
 	struct CColorVertex
@@ -162,6 +200,17 @@ public:
 	virtual void SetColor(float r, float g, float b, float a) = 0;
 	virtual void SetColorLua(float r, float g, float b, float a, lua_State *L) = 0;
 
+	// quads that are handed to the backend once and drawn from there as often as needed,
+	// four vertices per quad in the same order QuadsDrawTL uses
+	struct CQuadVertex
+	{
+		float m_X, m_Y, m_U, m_V;
+	};
+	virtual int CreateQuadBuffer(const CQuadVertex *pVertices, int NumQuads) = 0;
+	virtual void UpdateQuadBuffer(int BufferID, int FirstQuad, const CQuadVertex *pVertices, int NumQuads) = 0;
+	virtual void DeleteQuadBuffer(int BufferID) = 0;
+	virtual void RenderQuadBuffer(int BufferID, int FirstQuad, int NumQuads, float r, float g, float b, float a) = 0;
+
 	virtual void TakeScreenshot(const char *pFilename) = 0;
 	virtual void TakeCustomScreenshot(const char *pFilename) = 0;
 	virtual int GetVideoModes(CVideoMode *pModes, int MaxModes, int Screen) = 0;
@@ -11,7 +11,25 @@ class CMsgPacker : public CPacker
 public:
 	CMsgPacker(int Type)
 	{
-		Reset();
+		Reset(Type);
+	}
+
+	// builds the message in pBuffer, falls back to the internal buffer if there is none
+	CMsgPacker(int Type, unsigned char *pBuffer, int BufferSize)
+	{
+		Reset(Type, pBuffer, BufferSize);
+	}
+
+	using CPacker::Reset;
+
+	// start over with a new message, so one packer can be reused for many messages
+	void Reset(int Type, unsigned char *pBuffer = 0, int BufferSize = 0)
+	{
+		if(pBuffer)
+			CPacker::Reset(pBuffer, BufferSize);
+		else
+			CPacker::Reset();
+
 		if(Type < OFFSET_UUID)
 		{
 			AddInt(Type);
@@ -341,6 +341,18 @@ CServer::CServer()
 }
 
 
+static unsigned HashSkeleton(const int *pSkeleton, int Length)
+{
+	// FNV-1a over the code points
+	unsigned Hash = 2166136261u;
+	for(int i = 0; i < Length; i++)
+	{
+		Hash ^= (unsigned)pSkeleton[i];
+		Hash *= 16777619u;
+	}
+	return Hash;
+}
+
 int CServer::TrySetClientName(int ClientID, const char *pName)
 {
 	char aTrimmedName[64];
@@ -358,12 +370,17 @@ int CServer::TrySetClientName(int ClientID, const char *pName)
 	if(aTrimmedName[0] == '/')
 		return -1;
 
-	// make sure that two clients don't have the same name
+	// make sure that two clients don't have the same name,
+	// the skeletons of the other names are cached so that this is just a compare
+	int aSkeleton[CClient::MAX_NAME_SKELETON_LENGTH];
+	int SkeletonLength = str_utf8_to_skeleton(aTrimmedName, aSkeleton, CClient::MAX_NAME_SKELETON_LENGTH);
+	unsigned SkeletonHash = HashSkeleton(aSkeleton, SkeletonLength);
 	for(int i = 0; i < MAX_CLIENTS; i++)
 	{
 		if(i != ClientID && m_aClients[i].m_State >= CClient::STATE_READY)
 		{
-			if(str_utf8_comp_confusable(aTrimmedName, m_aClients[i].m_aName) == 0)
+			if(m_aClients[i].m_NameSkeletonHash == SkeletonHash && m_aClients[i].m_NameSkeletonLength == SkeletonLength &&
+				mem_comp(m_aClients[i].m_aNameSkeleton, aSkeleton, SkeletonLength*sizeof(int)) == 0)
 				return -1;
 		}
 	}
@@ -375,6 +392,9 @@ int CServer::TrySetClientName(int ClientID, const char *pName)
 
 	// set the client name
 	str_copy(m_aClients[ClientID].m_aName, pName, MAX_NAME_LENGTH);
+	mem_copy(m_aClients[ClientID].m_aNameSkeleton, aSkeleton, SkeletonLength*sizeof(int));
+	m_aClients[ClientID].m_NameSkeletonLength = SkeletonLength;
+	m_aClients[ClientID].m_NameSkeletonHash = SkeletonHash;
 	return 0;
 }
 
@@ -467,6 +487,7 @@ int CServer::Init()
 	{
 		m_aClients[i].m_State = CClient::STATE_EMPTY;
 		m_aClients[i].m_aName[0] = 0;
+		m_aClients[i].m_NameSkeletonLength = 0;
 		m_aClients[i].m_aClan[0] = 0;
 		m_aClients[i].m_Country = -1;
 		m_aClients[i].m_Snapshots.Init();
@@ -714,7 +735,7 @@ void CServer::DoSnapshot()
 				const int MaxSize = MAX_SNAPSHOT_PACKSIZE;
 				int NumPackets;
 
-				SnapshotSize = CVariableInt::Compress(aDeltaData, DeltaSize, aCompData);
+				SnapshotSize = CVariableInt::Compress(aDeltaData, DeltaSize, aCompData, sizeof(aCompData));
 				NumPackets = (SnapshotSize+MaxSize-1)/MaxSize;
 
 				for(int n = 0, Left = SnapshotSize; Left; n++)
@@ -722,9 +743,13 @@ void CServer::DoSnapshot()
 					int Chunk = Left < MaxSize ? Left : MaxSize;
 					Left -= Chunk;
 
+					// build the message right in the client's outgoing packet, the msg id and the ints need at most 32 bytes
+					const int MaxMsgSize = Chunk+32;
+					unsigned char *pMsgBuffer = m_NetServer.PrepareSend(i, NETSENDFLAG_FLUSH, MaxMsgSize);
+
 					if(NumPackets == 1)
 					{
-						CMsgPacker Msg(NETMSG_SNAPSINGLE);
+						CMsgPacker Msg(NETMSG_SNAPSINGLE, pMsgBuffer, MaxMsgSize);
 						Msg.AddInt(m_CurrentGameTick);
 						Msg.AddInt(m_CurrentGameTick-DeltaTick);
 						Msg.AddInt(Crc);
@@ -734,7 +759,7 @@ void CServer::DoSnapshot()
 					}
 					else
 					{
-						CMsgPacker Msg(NETMSG_SNAP);
+						CMsgPacker Msg(NETMSG_SNAP, pMsgBuffer, MaxMsgSize);
 						Msg.AddInt(m_CurrentGameTick);
 						Msg.AddInt(m_CurrentGameTick-DeltaTick);
 						Msg.AddInt(NumPackets);
@@ -784,6 +809,7 @@ int CServer::NewClientNoAuthCallback(int ClientID, bool Reset, void *pUser)
 	{
 		pThis->m_aClients[ClientID].m_State = CClient::STATE_CONNECTING;
 		pThis->m_aClients[ClientID].m_aName[0] = 0;
+		pThis->m_aClients[ClientID].m_NameSkeletonLength = 0;
 		pThis->m_aClients[ClientID].m_aClan[0] = 0;
 		pThis->m_aClients[ClientID].m_Country = -1;
 		pThis->m_aClients[ClientID].m_Authed = AUTHED_NO;
@@ -804,6 +830,7 @@ int CServer::NewClientCallback(int ClientID, void *pUser)
 	pThis->m_aClients[ClientID].m_State = CClient::STATE_AUTH;
 	pThis->m_aClients[ClientID].m_DnsblState = CClient::DNSBL_STATE_NONE;
 	pThis->m_aClients[ClientID].m_aName[0] = 0;
+	pThis->m_aClients[ClientID].m_NameSkeletonLength = 0;
 	pThis->m_aClients[ClientID].m_aClan[0] = 0;
 	pThis->m_aClients[ClientID].m_Country = -1;
 	pThis->m_aClients[ClientID].m_Authed = AUTHED_NO;
@@ -854,6 +881,7 @@ int CServer::DelClientCallback(int ClientID, const char *pReason, void *pUser)
 
 	pThis->m_aClients[ClientID].m_State = CClient::STATE_EMPTY;
 	pThis->m_aClients[ClientID].m_aName[0] = 0;
+	pThis->m_aClients[ClientID].m_NameSkeletonLength = 0;
 	pThis->m_aClients[ClientID].m_aClan[0] = 0;
 	pThis->m_aClients[ClientID].m_Country = -1;
 	pThis->m_aClients[ClientID].m_Authed = AUTHED_NO;
@@ -126,6 +126,9 @@ public:
 			DNSBL_STATE_PENDING,
 			DNSBL_STATE_BLACKLISTED,
 			DNSBL_STATE_WHITELISTED,
+
+			// a code point decomposes into at most 15 code points of its skeleton
+			MAX_NAME_SKELETON_LENGTH=MAX_NAME_LENGTH*15,
 		};
 
 		class CInput
@@ -152,6 +155,9 @@ public:
 		int m_CurrentInput;
 
 		char m_aName[MAX_NAME_LENGTH];
+		int m_aNameSkeleton[MAX_NAME_SKELETON_LENGTH];
+		int m_NameSkeletonLength;
+		unsigned m_NameSkeletonHash;
 		char m_aClan[MAX_CLAN_LENGTH];
 		int m_Country;
 		int m_Score;
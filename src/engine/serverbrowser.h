@@ -92,7 +92,7 @@ public:
 		SORT_NUMPLAYERS - Sort after how many players there are on the server.
 	*/
 	enum{
-		CACHE_VERSION = 3,
+		CACHE_VERSION = 4,
 
 		SORT_NAME = 0,
 		SORT_PING,
@@ -136,8 +136,13 @@ public:
 	virtual int NumSortedServers() const = 0;
 	virtual const CServerInfo *SortedGet(int Index) = 0;
 	virtual const CServerInfo *Get(int Index) = 0;
+	// the servers whose name, map or players contain the string, case insensitive. apResults get the infos,
+	// paHits the QUICK_* flags of what matched. returns how many were found, at most MaxResults
+	virtual int Search(const char *pQuery, const CServerInfo **apResults, int *paHits, int MaxResults) = 0;
 	virtual int GetInfoAge(int Index) const = 0;
 	virtual const char *GetDebugString(int Index) const = 0;
+	// the sorted rows that are on screen, a refresh asks them first
+	virtual void SetVisibleRange(int First, int Num) = 0;
 
 	virtual bool IsFavorite(const NETADDR &Addr) const = 0;
 	virtual void AddFavorite(const NETADDR &Addr) = 0;
@@ -29,6 +29,7 @@ MACRO_CONFIG_INT(ClCpuThrottle, cl_cpu_throttle, 1, 0, 100, CFGFLAG_SAVE|CFGFLAG
 MACRO_CONFIG_INT(ClCpuThrottleInactive, cl_cpu_throttle_inactive, 5, 0, 100, CFGFLAG_SAVE|CFGFLAG_CLIENT, "")
 MACRO_CONFIG_INT(ClEditor, cl_editor, 0, 0, 1, CFGFLAG_CLIENT, "")
 MACRO_CONFIG_INT(ClEditorUndo, cl_editorundo, 1, 0, 1, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Undo function in editor")
+MACRO_CONFIG_INT(ClEditorUndoMemory, cl_editorundo_memory, 64, 1, 1024, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Memory the editor undo history may take, in MiB")
 MACRO_CONFIG_INT(ClEditorLazyInit, cl_editor_lazy_init, 1, 0, 1, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Delay the editor init after client startup to speed up loading")
 MACRO_CONFIG_INT(ClLoadCountryFlags, cl_load_country_flags, 1, 0, 1, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Load and show country flags")
 MACRO_CONFIG_STR(ClSkinFilterString, cl_skin_filter_string, 25, "", CFGFLAG_SAVE|CFGFLAG_CLIENT, "Skin filtering string")
@@ -82,8 +83,9 @@ MACRO_CONFIG_STR(BrFilterExcludeTypes, br_filter_exclude_types, 128, "", CFGFLAG
 
 MACRO_CONFIG_INT(BrSort, br_sort, 4, 0, 256, CFGFLAG_SAVE|CFGFLAG_CLIENT, "")
 MACRO_CONFIG_INT(BrSortOrder, br_sort_order, 1, 0, 1, CFGFLAG_SAVE|CFGFLAG_CLIENT, "")
-MACRO_CONFIG_INT(BrMaxRequests, br_max_requests, 50, 0, 1000, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Number of requests to use when refreshing server browser")
-MACRO_CONFIG_INT(BrCurrRequestsAbortLimit, br_curr_requests_abort_limit, 10, 1, 999, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Number of requests to use when refreshing server browser")
+MACRO_CONFIG_INT(BrMaxRequests, br_max_requests, 50, 0, 1000, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Number of requests sent at once when refreshing server browser")
+MACRO_CONFIG_INT(BrRequestRate, br_request_rate, 500, 10, 10000, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Maximal number of server info requests per second, lowered on packet loss")
+MACRO_CONFIG_INT(BrCurrRequestsAbortLimit, br_curr_requests_abort_limit, 10, 1, 999, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Requests per second below which a refresh that gets no answers is aborted")
 
 MACRO_CONFIG_INT(BrLanScanStart, br_curr_requests_abort_limit, 8303, 1, 65535, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Number of requests to use when refreshing server browser")
 MACRO_CONFIG_INT(BrLanScanRange, br_curr_requests_abort_limit, 7, 1, 65534, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Number of requests to use when refreshing server browser")
@@ -164,6 +166,10 @@ MACRO_CONFIG_INT(GfxQuadAsTriangle, gfx_quad_as_triangle, 0, 0, 0, CFGFLAG_SAVE|
 MACRO_CONFIG_INT(GfxQuadAsTriangle, gfx_quad_as_triangle, 0, 0, 1, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Render quads as triangles (fixes quad coloring on some GPUs)")
 #endif
 MACRO_CONFIG_INT(GfxHighdpi, gfx_highdpi, 0, 0, 1, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Try to use high-dpi screen features")
+MACRO_CONFIG_INT(GfxNullBackend, gfx_null_backend, 0, 0, 1, CFGFLAG_CLIENT, "Render into a backend that only counts commands, for benchmarking without a GPU (needs a restart)")
+MACRO_CONFIG_INT(GfxTextLayoutCache, gfx_text_layout_cache, 1, 0, 1, CFGFLAG_CLIENT, "Reuse the glyph layout of text that was drawn before")
+MACRO_CONFIG_INT(GfxImageCache, gfx_image_cache, 1, 0, 1, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Keep decoded png images in tmp/cache/images so they don't have to be decoded again")
+MACRO_CONFIG_INT(GfxImageCacheSize, gfx_image_cache_size, 256, 16, 4096, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Size limit of the image cache in MiB, the oldest images are removed at startup")
 MACRO_CONFIG_INT(GfxLaserTrail, gfx_lasertrail, 1, 0, 3, CFGFLAG_SAVE|CFGFLAG_CLIENT, "0: off | 1: vanilla only | 2: not on race servers | 3: everywhere")
 
 MACRO_CONFIG_INT(InpMousesens, inp_mousesens, 130, 5, 100000, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Mouse sensitivity")
@@ -217,6 +223,7 @@ MACRO_CONFIG_INT(DbgDirections, dbg_directions, 0, 0, 1, CFGFLAG_CLIENT, "Debug
 MACRO_CONFIG_INT(DbgAStar, dbg_astar, 0, 0, 1, CFGFLAG_CLIENT, "Debug astar data")
 MACRO_CONFIG_INT(DbgPref, dbg_pref, 0, 0, 1, CFGFLAG_SERVER, "Performance outputs")
 MACRO_CONFIG_INT(DbgGraphs, dbg_graphs, 0, 0, 1, CFGFLAG_CLIENT, "Performance graphs")
+MACRO_CONFIG_INT(DbgGfxStats, dbg_gfx_stats, 0, 0, 1, CFGFLAG_CLIENT, "Show per frame graphics statistics")
 MACRO_CONFIG_INT(DbgHitch, dbg_hitch, 0, 0, 0, CFGFLAG_SERVER, "Hitch warnings")
 #ifdef CONF_DEBUG
 MACRO_CONFIG_INT(DbgStress, dbg_stress, 0, 0, 0, CFGFLAG_CLIENT|CFGFLAG_SERVER, "Stress systems")
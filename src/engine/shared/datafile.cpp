@@ -2,6 +2,7 @@
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 #include <base/math.h>
 #include <base/system.h>
+#include <engine/engine.h>
 #include <engine/storage.h>
 #include "datafile.h"
 #include "config.h"
@@ -422,21 +423,74 @@ IOHANDLE CDataFileReader::File()
 }
 
 
+CDataFileCache::CEntry *CDataFileCache::Find(const MD5_HASH &Hash, int UncompressedSize)
+{
+	for(int i = 0; i < m_lEntries.size(); i++)
+	{
+		CEntry *pEntry = &m_lEntries[i];
+		if(pEntry->m_UncompressedSize == UncompressedSize && mem_comp(&pEntry->m_Hash, &Hash, sizeof(Hash)) == 0)
+		{
+			pEntry->m_Serial = m_Serial;
+			return pEntry;
+		}
+	}
+	return 0;
+}
+
+void CDataFileCache::Add(const MD5_HASH &Hash, int UncompressedSize, int CompressedSize, const void *pCompressedData)
+{
+	CEntry Entry;
+	Entry.m_Hash = Hash;
+	Entry.m_UncompressedSize = UncompressedSize;
+	Entry.m_CompressedSize = CompressedSize;
+	Entry.m_pCompressedData = mem_alloc(CompressedSize, 1);
+	mem_copy(Entry.m_pCompressedData, pCompressedData, CompressedSize);
+	Entry.m_Serial = m_Serial;
+	m_lEntries.add(Entry);
+}
+
+void CDataFileCache::Prune()
+{
+	// only what the last save used stays
+	for(int i = 0; i < m_lEntries.size(); i++)
+	{
+		if(m_lEntries[i].m_Serial != m_Serial)
+		{
+			mem_free(m_lEntries[i].m_pCompressedData);
+			m_lEntries.remove_index_fast(i--);
+		}
+	}
+	m_Serial++;
+}
+
+void CDataFileCache::Clear()
+{
+	for(int i = 0; i < m_lEntries.size(); i++)
+		mem_free(m_lEntries[i].m_pCompressedData);
+	m_lEntries.clear();
+}
+
+
 CDataFileWriter::CDataFileWriter()
 {
 	m_File = 0;
+	m_NumDatas = 0;
+	m_pEngine = 0;
+	m_pCache = 0;
 	m_pItemTypes = static_cast<CItemTypeInfo *>(mem_alloc(sizeof(CItemTypeInfo) * MAX_ITEM_TYPES, 1));
 	m_pItems = static_cast<CItemInfo *>(mem_alloc(sizeof(CItemInfo) * MAX_ITEMS, 1));
-	m_pDatas = static_cast<CDataInfo *>(mem_alloc(sizeof(CDataInfo) * MAX_DATAS, 1));
+	m_pDatas = new CDataInfo[MAX_DATAS];
 }
 
 CDataFileWriter::~CDataFileWriter()
 {
+	// the jobs write into the data infos
+	WaitForJobs();
 	mem_free(m_pItemTypes);
 	m_pItemTypes = 0;
 	mem_free(m_pItems);
 	m_pItems = 0;
-	mem_free(m_pDatas);
+	delete [] m_pDatas;
 	m_pDatas = 0;
 }
 
@@ -502,26 +556,74 @@ int CDataFileWriter::AddItem(int Type, int ID, int Size, void *pData)
 	return m_NumItems-1;
 }
 
-int CDataFileWriter::AddData(int Size, void *pData)
+void CDataFileWriter::CompressData(CDataInfo *pInfo, const void *pData)
 {
-	dbg_assert(m_NumDatas < 1024, "too much data");
-
-	CDataInfo *pInfo = &m_pDatas[m_NumDatas];
-	unsigned long s = compressBound(Size);
+	unsigned long s = compressBound(pInfo->m_UncompressedSize);
 	void *pCompData = mem_alloc(s, 1); // temporary buffer that we use during compression
 
-	int Result = compress((Bytef*)pCompData, &s, (Bytef*)pData, Size); // ignore_convention
+	int Result = compress((Bytef*)pCompData, &s, (const Bytef*)pData, pInfo->m_UncompressedSize); // ignore_convention
 	if(Result != Z_OK)
 	{
 		dbg_msg("datafile", "compression error %d", Result);
 		dbg_assert(0, "zlib error");
 	}
 
-	pInfo->m_UncompressedSize = Size;
 	pInfo->m_CompressedSize = (int)s;
 	pInfo->m_pCompressedData = mem_alloc(pInfo->m_CompressedSize, 1);
 	mem_copy(pInfo->m_pCompressedData, pCompData, pInfo->m_CompressedSize);
 	mem_free(pCompData);
+}
+
+int CDataFileWriter::CompressJob(void *pUser)
+{
+	CDataInfo *pInfo = static_cast<CDataInfo *>(pUser);
+	CompressData(pInfo, pInfo->m_pUncompressedData);
+	mem_free(pInfo->m_pUncompressedData);
+	pInfo->m_pUncompressedData = 0;
+	return 0;
+}
+
+void CDataFileWriter::WaitForJobs()
+{
+	for(int i = 0; i < m_NumDatas; i++)
+		while(m_pDatas[i].m_Job.Status() != CJob::STATE_DONE)
+			thread_sleep(1);
+}
+
+int CDataFileWriter::AddData(int Size, void *pData)
+{
+	dbg_assert(m_NumDatas < 1024, "too much data");
+
+	CDataInfo *pInfo = &m_pDatas[m_NumDatas];
+	pInfo->m_UncompressedSize = Size;
+	pInfo->m_pUncompressedData = 0;
+	pInfo->m_Cached = false;
+
+	if(m_pCache)
+	{
+		// compressing is deterministic, so the data of the last save is what compress would give again
+		pInfo->m_Hash = md5_simple((unsigned char *)pData, Size);
+		CDataFileCache::CEntry *pEntry = m_pCache->Find(pInfo->m_Hash, Size);
+		if(pEntry)
+		{
+			pInfo->m_Cached = true;
+			pInfo->m_CompressedSize = pEntry->m_CompressedSize;
+			pInfo->m_pCompressedData = mem_alloc(pInfo->m_CompressedSize, 1);
+			mem_copy(pInfo->m_pCompressedData, pEntry->m_pCompressedData, pInfo->m_CompressedSize);
+			m_NumDatas++;
+			return m_NumDatas-1;
+		}
+	}
+
+	if(m_pEngine)
+	{
+		// the caller may free the data right away
+		pInfo->m_pUncompressedData = mem_alloc(Size, 1);
+		mem_copy(pInfo->m_pUncompressedData, pData, Size);
+		m_pEngine->AddJob(&pInfo->m_Job, CompressJob, pInfo);
+	}
+	else
+		CompressData(pInfo, pData);
 
 	m_NumDatas++;
 	return m_NumDatas-1;
@@ -546,8 +648,17 @@ int CDataFileWriter::AddDataSwapped(int Size, void *pData)
 
 int CDataFileWriter::Finish()
 {
+	WaitForJobs();
 	if(!m_File) return 1;
 
+	if(m_pCache)
+	{
+		for(int i = 0; i < m_NumDatas; i++)
+			if(!m_pDatas[i].m_Cached)
+				m_pCache->Add(m_pDatas[i].m_Hash, m_pDatas[i].m_UncompressedSize, m_pDatas[i].m_CompressedSize, m_pDatas[i].m_pCompressedData);
+		m_pCache->Prune();
+	}
+
 	int ItemSize = 0;
 	int TypesSize, HeaderSize, OffsetSize, FileSize, SwapSize;
 	int DataSize = 0;
@@ -3,6 +3,11 @@
 #ifndef ENGINE_SHARED_DATAFILE_H
 #define ENGINE_SHARED_DATAFILE_H
 
+#include <base/system.h>
+#include <base/tl/array.h>
+
+#include "jobs.h"
+
 // raw datafile access
 class CDataFileReader
 {
@@ -37,6 +42,34 @@ public:
 	IOHANDLE File();
 };
 
+// the compressed data blocks of the last save, to take them over when the same data is saved again
+class CDataFileCache
+{
+	friend class CDataFileWriter;
+
+	struct CEntry
+	{
+		MD5_HASH m_Hash;
+		int m_UncompressedSize;
+		int m_CompressedSize;
+		void *m_pCompressedData;
+		int m_Serial;
+	};
+
+	array<CEntry> m_lEntries;
+	int m_Serial;
+
+	CEntry *Find(const MD5_HASH &Hash, int UncompressedSize);
+	void Add(const MD5_HASH &Hash, int UncompressedSize, int CompressedSize, const void *pCompressedData);
+	void Prune();
+
+public:
+	CDataFileCache() : m_Serial(0) {}
+	~CDataFileCache() { Clear(); }
+
+	void Clear();
+};
+
 // write access
 class CDataFileWriter
 {
@@ -45,6 +78,10 @@ class CDataFileWriter
 		int m_UncompressedSize;
 		int m_CompressedSize;
 		void *m_pCompressedData;
+		void *m_pUncompressedData; // held until the job compressed it
+		bool m_Cached;
+		MD5_HASH m_Hash;
+		CJob m_Job;
 	};
 
 	struct CItemInfo
@@ -79,17 +116,27 @@ class CDataFileWriter
 	CItemInfo *m_pItems;
 	CDataInfo *m_pDatas;
 
+	class IEngine *m_pEngine;
+	CDataFileCache *m_pCache;
+
+	static void CompressData(CDataInfo *pInfo, const void *pData);
+	static int CompressJob(void *pUser);
+	void WaitForJobs();
+
 public:
 	CDataFileWriter();
 	~CDataFileWriter();
 	void Init();
 	bool OpenFile(class IStorageTW *pStorage, const char *pFilename);
 	bool Open(class IStorageTW *pStorage, const char *Filename);
+	// compress the data on the engine jobs instead of in AddData
+	void SetEngine(class IEngine *pEngine) { m_pEngine = pEngine; }
+	// take over the data that is unchanged since the last save with the same cache, and keep this save's data in it
+	void SetCache(CDataFileCache *pCache) { m_pCache = pCache; }
 	int AddData(int Size, void *pData);
 	int AddDataSwapped(int Size, void *pData);
 	int AddItem(int Type, int ID, int Size, void *pData);
 	int Finish();
 };
 
-
 #endif
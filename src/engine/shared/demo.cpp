@@ -369,14 +369,16 @@ void CDemoRecorder::AddDemoMarker()
 
 
 
-CDemoPlayer::CDemoPlayer(class CSnapshotDelta *pSnapshotDelta)
+CDemoPlayer::CDemoPlayer(class CSnapshotDelta *pSnapshotDelta, bool NoMapData)
 {
 	m_File = 0;
 	m_pKeyFrames = 0;
 	m_SpeedIndex = 4;
+	m_pListener = 0;
 
 	m_pSnapshotDelta = pSnapshotDelta;
 	m_LastSnapshotDataSize = -1;
+	m_NoMapData = NoMapData;
 }
 
 void CDemoPlayer::SetListener(IListener *pListener)
@@ -508,9 +510,6 @@ void CDemoPlayer::ScanFile()
 
 void CDemoPlayer::DoTick()
 {
-	static char aCompresseddata[CSnapshot::MAX_SIZE];
-	static char aDecompressed[CSnapshot::MAX_SIZE];
-	static char aData[CSnapshot::MAX_SIZE];
 	int ChunkType, ChunkTick, ChunkSize;
 	int DataSize = 0;
 	int GotSnapshot = 0;
@@ -539,7 +538,7 @@ void CDemoPlayer::DoTick()
 		// read the chunk
 		if(ChunkSize)
 		{
-			if(io_read(m_File, aCompresseddata, (unsigned int)ChunkSize) != (unsigned)ChunkSize)
+			if(io_read(m_File, m_aCompressedData, (unsigned int)ChunkSize) != (unsigned)ChunkSize)
 			{
 				// stop on error or eof
 				m_pConsole->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "demo_player", "error reading chunk", true);
@@ -547,7 +546,7 @@ void CDemoPlayer::DoTick()
 				break;
 			}
 
-			DataSize = CNetBase::Decompress(aCompresseddata, ChunkSize, aDecompressed, sizeof(aDecompressed));
+			DataSize = CNetBase::Decompress(m_aCompressedData, ChunkSize, m_aDecompressedData, sizeof(m_aDecompressedData));
 			if(DataSize < 0)
 			{
 				// stop on error or eof
@@ -556,7 +555,7 @@ void CDemoPlayer::DoTick()
 				break;
 			}
 
-			DataSize = (int)CVariableInt::Decompress(aDecompressed, DataSize, aData, sizeof(aData));
+			DataSize = (int)CVariableInt::Decompress(m_aDecompressedData, DataSize, m_aChunkData, sizeof(m_aChunkData));
 
 			if(DataSize < 0)
 			{
@@ -569,19 +568,17 @@ void CDemoPlayer::DoTick()
 		if(ChunkType == CHUNKTYPE_DELTA)
 		{
 			// process delta snapshot
-			static char aNewsnap[CSnapshot::MAX_SIZE];
-
 			GotSnapshot = 1;
 
-			DataSize = m_pSnapshotDelta->UnpackDelta((CSnapshot*)m_aLastSnapshotData, (CSnapshot*)aNewsnap, aData, DataSize);
+			DataSize = m_pSnapshotDelta->UnpackDelta((CSnapshot*)m_aLastSnapshotData, (CSnapshot*)m_aNewSnapData, m_aChunkData, DataSize);
 
 			if(DataSize >= 0)
 			{
 				if(m_pListener)
-					m_pListener->OnDemoPlayerSnapshot(aNewsnap, DataSize);
+					m_pListener->OnDemoPlayerSnapshot(m_aNewSnapData, DataSize);
 
 				m_LastSnapshotDataSize = DataSize;
-				mem_copy(m_aLastSnapshotData, aNewsnap, DataSize);
+				mem_copy(m_aLastSnapshotData, m_aNewSnapData, DataSize);
 			}
 			else
 			{
@@ -596,9 +593,9 @@ void CDemoPlayer::DoTick()
 			GotSnapshot = 1;
 
 			m_LastSnapshotDataSize = DataSize;
-			mem_copy(m_aLastSnapshotData, aData, DataSize);
+			mem_copy(m_aLastSnapshotData, m_aChunkData, DataSize);
 			if(m_pListener)
-				m_pListener->OnDemoPlayerSnapshot(aData, DataSize);
+				m_pListener->OnDemoPlayerSnapshot(m_aChunkData, DataSize);
 		}
 		else
 		{
@@ -618,7 +615,7 @@ void CDemoPlayer::DoTick()
 			else if(ChunkType == CHUNKTYPE_MESSAGE)
 			{
 				if(m_pListener)
-					m_pListener->OnDemoPlayerMessage(aData, DataSize);
+					m_pListener->OnDemoPlayerMessage(m_aChunkData, DataSize);
 			}
 		}
 	}
@@ -706,9 +703,14 @@ int CDemoPlayer::Load(class IStorageTW *pStorage, class IConsole *pConsole, cons
 	unsigned Crc = (m_Info.m_Header.m_aMapCrc[0]<<24) | (m_Info.m_Header.m_aMapCrc[1]<<16) | (m_Info.m_Header.m_aMapCrc[2]<<8) | (m_Info.m_Header.m_aMapCrc[3]);
 	char aMapFilename[128];
 	str_format(aMapFilename, sizeof(aMapFilename), "downloadedmaps/%s_%08x.map", m_Info.m_Header.m_aMapName, Crc);
-	IOHANDLE MapFile = pStorage->OpenFile(aMapFilename, IOFLAG_READ, IStorageTW::TYPE_ALL);
+	IOHANDLE MapFile = m_NoMapData ? 0 : pStorage->OpenFile(aMapFilename, IOFLAG_READ, IStorageTW::TYPE_ALL);
 
-	if(MapFile)
+	if(m_NoMapData)
+	{
+		// the caller is only interested in the snapshots, don't touch the map files
+		io_skip(m_File, MapSize);
+	}
+	else if(MapFile)
 	{
 		io_skip(m_File, MapSize);
 		io_close(MapFile);
@@ -751,10 +753,6 @@ int CDemoPlayer::Load(class IStorageTW *pStorage, class IConsole *pConsole, cons
 	// scan the file for interessting points
 	ScanFile();
 
-	// reset slice markers
-	g_Config.m_ClDemoSliceBegin = -1;
-	g_Config.m_ClDemoSliceEnd = -1;
-
 	// ready for playback
 	return 0;
 }
@@ -948,11 +946,9 @@ void CDemoEditor::Init(const char *pNetVersion, class CSnapshotDelta *pSnapshotD
 
 void CDemoEditor::Slice(const char *pDemo, const char *pDst, int StartTick, int EndTick, DEMOFUNC_FILTER pfnFilter, void *pUser)
 {
-	class CDemoPlayer DemoPlayer(m_pSnapshotDelta);
-	class CDemoRecorder DemoRecorder(m_pSnapshotDelta);
-
-	m_pDemoPlayer = &DemoPlayer;
-	m_pDemoRecorder = &DemoRecorder;
+	// both carry snapshot sized buffers, too big for the stack
+	m_pDemoPlayer = new CDemoPlayer(m_pSnapshotDelta);
+	m_pDemoRecorder = new CDemoRecorder(m_pSnapshotDelta);
 
 	m_pDemoPlayer->SetListener(this);
 
@@ -960,25 +956,29 @@ void CDemoEditor::Slice(const char *pDemo, const char *pDst, int StartTick, int
 	m_SliceTo = EndTick;
 	m_Stop = false;
 
-	if (m_pDemoPlayer->Load(m_pStorage, m_pConsole, pDemo, IStorageTW::TYPE_ALL) == -1)
-		return;
-
-	const CDemoPlayer::CMapInfo *pMapInfo = m_pDemoPlayer->GetMapInfo();
-	if (m_pDemoRecorder->Start(m_pStorage, m_pConsole, pDst, m_pNetVersion, pMapInfo->m_aName, pMapInfo->m_Crc, "client", pMapInfo->m_Size, NULL, NULL, pfnFilter, pUser) == -1)
-		return;
+	if (m_pDemoPlayer->Load(m_pStorage, m_pConsole, pDemo, IStorageTW::TYPE_ALL) != -1)
+	{
+		const CDemoPlayer::CMapInfo *pMapInfo = m_pDemoPlayer->GetMapInfo();
+		if (m_pDemoRecorder->Start(m_pStorage, m_pConsole, pDst, m_pNetVersion, pMapInfo->m_aName, pMapInfo->m_Crc, "client", pMapInfo->m_Size, NULL, NULL, pfnFilter, pUser) != -1)
+		{
+			m_pDemoPlayer->Play();
+			const CDemoPlayer::CPlaybackInfo *pInfo = m_pDemoPlayer->Info();
 
+			while (m_pDemoPlayer->IsPlaying() && !m_Stop) {
+				m_pDemoPlayer->Update(false);
 
-	m_pDemoPlayer->Play();
-	const CDemoPlayer::CPlaybackInfo *pInfo = m_pDemoPlayer->Info();
-
-	while (m_pDemoPlayer->IsPlaying() && !m_Stop) {
-		m_pDemoPlayer->Update(false);
+				if (pInfo->m_Info.m_Paused)
+					break;
+			}
 
-		if (pInfo->m_Info.m_Paused)
-			break;
+			m_pDemoRecorder->Stop();
+		}
 	}
 
-	m_pDemoRecorder->Stop();
+	delete m_pDemoPlayer;
+	delete m_pDemoRecorder;
+	m_pDemoPlayer = 0;
+	m_pDemoRecorder = 0;
 }
 
 void CDemoEditor::OnDemoPlayerSnapshot(void *pData, int Size)
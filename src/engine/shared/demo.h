@@ -110,6 +110,13 @@ private:
 	unsigned char m_aLastSnapshotData[CSnapshot::MAX_SIZE];
 	int m_LastSnapshotDataSize;
 	class CSnapshotDelta *m_pSnapshotDelta;
+	bool m_NoMapData;
+
+	// per-player scratch buffers so that several players can run on different threads
+	char m_aCompressedData[CSnapshot::MAX_SIZE];
+	char m_aDecompressedData[CSnapshot::MAX_SIZE];
+	char m_aChunkData[CSnapshot::MAX_SIZE];
+	char m_aNewSnapData[CSnapshot::MAX_SIZE];
 
 	int ReadChunkHeader(int *pType, int *pSize, int *pTick);
 	void DoTick();
@@ -118,7 +125,7 @@ private:
 
 public:
 
-	CDemoPlayer(class CSnapshotDelta *m_pSnapshotDelta);
+	CDemoPlayer(class CSnapshotDelta *m_pSnapshotDelta, bool NoMapData = false);
 
 	void SetListener(IListener *pListener);
 
@@ -57,7 +57,7 @@ public:
 		}
 	}
 
-	CEngine(const char *pAppname)
+	CEngine(const char *pAppname, int NumJobThreads)
 	{
 		//dbg_logger_stdout();
 		//dbg_logger_debugger();
@@ -76,7 +76,7 @@ public:
 		net_init();
 		CNetBase::Init();
 
-		m_JobPool.Init(1);
+		m_JobPool.Init(NumJobThreads);
 
 		m_Logging = false;
 	}
@@ -115,4 +115,4 @@ public:
 	}
 };
 
-IEngine *CreateEngine(const char *pAppname) { return new CEngine(pAppname); }
+IEngine *CreateEngine(const char *pAppname, int NumJobThreads) { return new CEngine(pAppname, NumJobThreads); }
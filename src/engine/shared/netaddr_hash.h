@@ -0,0 +1,220 @@
+#ifndef ENGINE_SHARED_NETADDR_HASH_H
+#define ENGINE_SHARED_NETADDR_HASH_H
+
+#include <base/system.h>
+
+// hashes the whole address, the port included. equal addresses (net_addr_comp) hash equal
+inline unsigned NetAddrHash(const NETADDR *pAddr)
+{
+	// fnv-1a
+	unsigned Hash = 2166136261u;
+	Hash = (Hash^pAddr->type)*16777619u;
+	int Length = pAddr->type&NETTYPE_IPV4 ? 4 : 16;
+	for(int i = 0; i < Length; i++)
+		Hash = (Hash^pAddr->ip[i])*16777619u;
+	Hash = (Hash^(pAddr->port&0xff))*16777619u;
+	Hash = (Hash^(pAddr->port>>8))*16777619u;
+	return Hash^(Hash>>16);
+}
+
+// for keying the std containers by address
+struct CNetAddrHasher
+{
+	size_t operator()(const NETADDR &Addr) const { return NetAddrHash(&Addr); }
+};
+
+struct CNetAddrEqual
+{
+	bool operator()(const NETADDR &a, const NETADDR &b) const { return net_addr_comp(&a, &b) == 0; }
+};
+
+// entries looked up by their address. the entries are chained through their own m_pNextIp,
+// the table owns only the buckets and doubles them once there are more entries than buckets
+template<class T>
+class CNetAddrHashTable
+{
+public:
+	CNetAddrHashTable() : m_ppBuckets(0), m_NumBuckets(0), m_Size(0) {}
+	~CNetAddrHashTable() { mem_free(m_ppBuckets); }
+
+	// forgets the entries, keeps the buckets for the next list
+	void Clear()
+	{
+		if(m_ppBuckets)
+			mem_zero(m_ppBuckets, m_NumBuckets*sizeof(T *));
+		m_Size = 0;
+	}
+
+	void Insert(T *pEntry)
+	{
+		if(m_Size >= m_NumBuckets)
+			Rehash(m_NumBuckets ? m_NumBuckets*2 : MIN_BUCKETS);
+
+		T **ppBucket = &m_ppBuckets[NetAddrHash(&pEntry->m_Addr)&(m_NumBuckets-1)];
+		pEntry->m_pNextIp = *ppBucket;
+		*ppBucket = pEntry;
+		m_Size++;
+	}
+
+	void Remove(T *pEntry)
+	{
+		if(!m_Size)
+			return;
+		for(T **ppEntry = &m_ppBuckets[NetAddrHash(&pEntry->m_Addr)&(m_NumBuckets-1)]; *ppEntry; ppEntry = &(*ppEntry)->m_pNextIp)
+			if(*ppEntry == pEntry)
+			{
+				*ppEntry = pEntry->m_pNextIp;
+				m_Size--;
+				return;
+			}
+	}
+
+	T *Find(const NETADDR *pAddr) const
+	{
+		if(!m_Size)
+			return 0;
+		for(T *pEntry = m_ppBuckets[NetAddrHash(pAddr)&(m_NumBuckets-1)]; pEntry; pEntry = pEntry->m_pNextIp)
+			if(net_addr_comp(&pEntry->m_Addr, pAddr) == 0)
+				return pEntry;
+		return 0;
+	}
+
+	int Size() const { return m_Size; }
+
+private:
+	enum
+	{
+		MIN_BUCKETS=256,
+	};
+
+	T **m_ppBuckets;
+	int m_NumBuckets;
+	int m_Size;
+
+	void Rehash(int NumBuckets)
+	{
+		T **ppBuckets = (T **)mem_alloc(NumBuckets*sizeof(T *), 1);
+		mem_zero(ppBuckets, NumBuckets*sizeof(T *));
+		for(int i = 0; i < m_NumBuckets; i++)
+		{
+			T *pEntry = m_ppBuckets[i];
+			while(pEntry)
+			{
+				T *pNext = pEntry->m_pNextIp;
+				T **ppBucket = &ppBuckets[NetAddrHash(&pEntry->m_Addr)&(NumBuckets-1)];
+				pEntry->m_pNextIp = *ppBucket;
+				*ppBucket = pEntry;
+				pEntry = pNext;
+			}
+		}
+		mem_free(m_ppBuckets);
+		m_ppBuckets = ppBuckets;
+		m_NumBuckets = NumBuckets;
+	}
+};
+
+// a set of addresses with open addressing, kept at most half full
+class CNetAddrHashSet
+{
+public:
+	CNetAddrHashSet() : m_pSlots(0), m_pUsed(0), m_NumSlots(0), m_Size(0) {}
+	~CNetAddrHashSet()
+	{
+		mem_free(m_pSlots);
+		mem_free(m_pUsed);
+	}
+
+	void Clear()
+	{
+		if(m_pUsed)
+			mem_zero(m_pUsed, m_NumSlots);
+		m_Size = 0;
+	}
+
+	// returns false if the address was in the set already
+	bool Insert(const NETADDR *pAddr)
+	{
+		if((m_Size+1)*2 > m_NumSlots)
+			Rehash(m_NumSlots ? m_NumSlots*2 : MIN_SLOTS);
+
+		int Slot = FindSlot(pAddr);
+		if(m_pUsed[Slot])
+			return false;
+		m_pSlots[Slot] = *pAddr;
+		m_pUsed[Slot] = 1;
+		m_Size++;
+		return true;
+	}
+
+	bool Remove(const NETADDR *pAddr)
+	{
+		if(!m_Size)
+			return false;
+		int Slot = FindSlot(pAddr);
+		if(!m_pUsed[Slot])
+			return false;
+
+		// move the following addresses of the run back, so no lookup stops at the gap
+		m_pUsed[Slot] = 0;
+		m_Size--;
+		for(int Next = (Slot+1)&(m_NumSlots-1); m_pUsed[Next]; Next = (Next+1)&(m_NumSlots-1))
+		{
+			int Home = NetAddrHash(&m_pSlots[Next])&(m_NumSlots-1);
+			if(((Next-Home)&(m_NumSlots-1)) >= ((Next-Slot)&(m_NumSlots-1)))
+			{
+				m_pSlots[Slot] = m_pSlots[Next];
+				m_pUsed[Slot] = 1;
+				m_pUsed[Next] = 0;
+				Slot = Next;
+			}
+		}
+		return true;
+	}
+
+	bool Contains(const NETADDR *pAddr) const { return m_Size && m_pUsed[FindSlot(pAddr)]; }
+	int Size() const { return m_Size; }
+
+private:
+	enum
+	{
+		MIN_SLOTS=64,
+	};
+
+	NETADDR *m_pSlots;
+	unsigned char *m_pUsed;
+	int m_NumSlots;
+	int m_Size;
+
+	// the slot holding the address, or the free one it would go to
+	int FindSlot(const NETADDR *pAddr) const
+	{
+		int Slot = NetAddrHash(pAddr)&(m_NumSlots-1);
+		while(m_pUsed[Slot] && net_addr_comp(&m_pSlots[Slot], pAddr) != 0)
+			Slot = (Slot+1)&(m_NumSlots-1);
+		return Slot;
+	}
+
+	void Rehash(int NumSlots)
+	{
+		NETADDR *pOldSlots = m_pSlots;
+		unsigned char *pOldUsed = m_pUsed;
+		int OldNumSlots = m_NumSlots;
+
+		m_pSlots = (NETADDR *)mem_alloc(NumSlots*sizeof(NETADDR), 1);
+		m_pUsed = (unsigned char *)mem_alloc(NumSlots, 1);
+		mem_zero(m_pUsed, NumSlots);
+		m_NumSlots = NumSlots;
+		for(int i = 0; i < OldNumSlots; i++)
+			if(pOldUsed[i])
+			{
+				int Slot = FindSlot(&pOldSlots[i]);
+				m_pSlots[Slot] = pOldSlots[i];
+				m_pUsed[Slot] = 1;
+			}
+
+		mem_free(pOldSlots);
+		mem_free(pOldUsed);
+	}
+};
+
+#endif
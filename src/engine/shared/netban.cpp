@@ -19,105 +19,103 @@ bool CNetBan::StrAllnum(const char *pStr)
 }
 
 
+// fnv-1a, so the hashes of all prefixes of an address come out of one pass
+static unsigned NetHashStart(unsigned Type) { return (2166136261u^Type)*16777619u; }
+static unsigned NetHashStep(unsigned Hash, unsigned char Part) { return (Hash^Part)*16777619u; }
+
 CNetBan::CNetHash::CNetHash(const NETADDR *pAddr)
 {
-	if(pAddr->type==NETTYPE_IPV4)
-		m_Hash = (pAddr->ip[0]+pAddr->ip[1]+pAddr->ip[2]+pAddr->ip[3])&0xFF;
-	else
-		m_Hash = (pAddr->ip[0]+pAddr->ip[1]+pAddr->ip[2]+pAddr->ip[3]+pAddr->ip[4]+pAddr->ip[5]+pAddr->ip[6]+pAddr->ip[7]+
-			pAddr->ip[8]+pAddr->ip[9]+pAddr->ip[10]+pAddr->ip[11]+pAddr->ip[12]+pAddr->ip[13]+pAddr->ip[14]+pAddr->ip[15])&0xFF;
+	int Length = pAddr->type==NETTYPE_IPV4 ? 4 : 16;
+	m_Hash = NetHashStart(pAddr->type);
+	for(int i = 0; i < Length; ++i)
+		m_Hash = NetHashStep(m_Hash, pAddr->ip[i]);
 	m_HashIndex = 0;
 }
 
 CNetBan::CNetHash::CNetHash(const CNetRange *pRange)
 {
-	m_Hash = 0;
+	m_Hash = NetHashStart(pRange->m_LB.type);
 	m_HashIndex = 0;
 	for(int i = 0; pRange->m_LB.ip[i] == pRange->m_UB.ip[i]; ++i)
 	{
-		m_Hash += pRange->m_LB.ip[i];
+		m_Hash = NetHashStep(m_Hash, pRange->m_LB.ip[i]);
 		++m_HashIndex;
 	}
-	m_Hash &= 0xFF;
 }
 
 int CNetBan::CNetHash::MakeHashArray(const NETADDR *pAddr, CNetHash aHash[17])
 {
 	int Length = pAddr->type==NETTYPE_IPV4 ? 4 : 16;
-	aHash[0].m_Hash = 0;
+	aHash[0].m_Hash = NetHashStart(pAddr->type);
 	aHash[0].m_HashIndex = 0;
-	for(int i = 1, Sum = 0; i <= Length; ++i)
+	for(int i = 1; i <= Length; ++i)
 	{
-		Sum += pAddr->ip[i-1];
-		aHash[i].m_Hash = Sum&0xFF;
+		aHash[i].m_Hash = NetHashStep(aHash[i-1].m_Hash, pAddr->ip[i-1]);
 		aHash[i].m_HashIndex = i%Length;
 	}
 	return Length;
 }
 
 
+template<class T, int HashCount>
+void CNetBan::CBanPool<T, HashCount>::Free()
+{
+	for(int i = 0; i < HashCount; ++i)
+		mem_free(m_aHashLists[i].m_papBuckets);
+	mem_zero(m_aHashLists, sizeof(m_aHashLists));
+	mem_free(m_pBloom);
+	m_pBloom = 0;
+	while(m_pFirstChunk)
+	{
+		CChunk *pNext = m_pFirstChunk->m_pNext;
+		mem_free(m_pFirstChunk);
+		m_pFirstChunk = pNext;
+	}
+}
+
 template<class T, int HashCount>
 typename CNetBan::CBan<T> *CNetBan::CBanPool<T, HashCount>::Add(const T *pData, const CBanInfo *pInfo,  const CNetHash *pNetHash)
 {
 	if(!m_pFirstFree)
-		return 0;
+	{
+		// there is no limit on the bans, they are allocated in chunks
+		CChunk *pChunk = (CChunk *)mem_alloc(sizeof(CChunk), 1);
+		if(!pChunk)
+			return 0;
+		mem_zero(pChunk, sizeof(CChunk));
+		pChunk->m_pNext = m_pFirstChunk;
+		m_pFirstChunk = pChunk;
+		for(int i = 0; i < CHUNK_SIZE-1; ++i)
+			pChunk->m_aBans[i].m_pNext = &pChunk->m_aBans[i+1];
+		m_pFirstFree = &pChunk->m_aBans[0];
+	}
 
 	// create new ban
 	CBan<T> *pBan = m_pFirstFree;
+	m_pFirstFree = pBan->m_pNext;
 	pBan->m_Data = *pData;
 	pBan->m_Info = *pInfo;
 	pBan->m_NetHash = *pNetHash;
-	if(pBan->m_pNext)
-		pBan->m_pNext->m_pPrev = pBan->m_pPrev;
-	if(pBan->m_pPrev)
-		pBan->m_pPrev->m_pNext = pBan->m_pNext;
-	else
-		m_pFirstFree = pBan->m_pNext;
 
 	// add it to the hash list
-	if(m_paaHashList[pNetHash->m_HashIndex][pNetHash->m_Hash])
-		m_paaHashList[pNetHash->m_HashIndex][pNetHash->m_Hash]->m_pHashPrev = pBan;
-	pBan->m_pHashPrev = 0;
-	pBan->m_pHashNext = m_paaHashList[pNetHash->m_HashIndex][pNetHash->m_Hash];
-	m_paaHashList[pNetHash->m_HashIndex][pNetHash->m_Hash] = pBan;
+	CHashList *pList = &m_aHashLists[pNetHash->m_HashIndex];
+	if(pList->m_Num >= 1<<(32-pList->m_Shift))
+		GrowHash(pList);
+	LinkHash(pList, pBan);
+	pList->m_Num++;
 
 	// insert it into the used list
-	if(m_pFirstUsed)
-	{
-		for(CBan<T> *p = m_pFirstUsed; ; p = p->m_pNext)
-		{
-			if(p->m_Info.m_Expires == CBanInfo::EXPIRES_NEVER || (pInfo->m_Expires != CBanInfo::EXPIRES_NEVER && pInfo->m_Expires <= p->m_Info.m_Expires))
-			{
-				// insert before
-				pBan->m_pNext = p;
-				pBan->m_pPrev = p->m_pPrev;
-				if(p->m_pPrev)
-					p->m_pPrev->m_pNext = pBan;
-				else
-					m_pFirstUsed = pBan;
-				p->m_pPrev = pBan;
-				break;
-			}
-
-			if(!p->m_pNext)
-			{
-				// last entry
-				p->m_pNext = pBan;
-				pBan->m_pPrev = p;
-				pBan->m_pNext = 0;
-				break;
-			}
-		}
-	}
-	else
-	{
-		m_pFirstUsed = pBan;
-		pBan->m_pNext = pBan->m_pPrev = 0;
-	}
+	LinkUsed(pBan);
 
 	// update ban count
 	++m_CountUsed;
 
+	// and the bloom filter, it's rebuilt larger once it gets too full
+	if(m_CountUsed*BLOOM_BITS_PER_BAN > 1<<(32-m_BloomShift))
+		BuildBloom();
+	else
+		AddToBloom(pNetHash);
+
 	return pBan;
 }
 
@@ -128,25 +126,20 @@ int CNetBan::CBanPool<T, HashCount>::Remove(CBan<T> *pBan)
 		return -1;
 
 	// remove from hash list
+	CHashList *pList = &m_aHashLists[pBan->m_NetHash.m_HashIndex];
 	if(pBan->m_pHashNext)
 		pBan->m_pHashNext->m_pHashPrev = pBan->m_pHashPrev;
 	if(pBan->m_pHashPrev)
 		pBan->m_pHashPrev->m_pHashNext = pBan->m_pHashNext;
 	else
-		m_paaHashList[pBan->m_NetHash.m_HashIndex][pBan->m_NetHash.m_Hash] = pBan->m_pHashNext;
+		pList->m_papBuckets[Bucket(pBan->m_NetHash.m_Hash, pList->m_Shift)] = pBan->m_pHashNext;
 	pBan->m_pHashNext = pBan->m_pHashPrev = 0;
+	pList->m_Num--;
 
 	// remove from used list
-	if(pBan->m_pNext)
-		pBan->m_pNext->m_pPrev = pBan->m_pPrev;
-	if(pBan->m_pPrev)
-		pBan->m_pPrev->m_pNext = pBan->m_pNext;
-	else
-		m_pFirstUsed = pBan->m_pNext;
+	UnlinkUsed(pBan);
 
 	// add to recycle list
-	if(m_pFirstFree)
-		m_pFirstFree->m_pPrev = pBan;
 	pBan->m_pPrev = 0;
 	pBan->m_pNext = m_pFirstFree;
 	m_pFirstFree = pBan;
@@ -154,55 +147,126 @@ int CNetBan::CBanPool<T, HashCount>::Remove(CBan<T> *pBan)
 	// update ban count
 	--m_CountUsed;
 
+	// the bits of removed bans only cost a look into the hash list, the filter is rebuilt once there are many
+	if(++m_NumStale > max(m_CountUsed, 1024))
+		BuildBloom();
+
 	return 0;
 }
 
 template<class T, int HashCount>
 void CNetBan::CBanPool<T, HashCount>::Update(CBan<CDataType> *pBan, const CBanInfo *pInfo)
 {
+	UnlinkUsed(pBan);
 	pBan->m_Info = *pInfo;
+	LinkUsed(pBan);
+}
 
-	// remove from used list
-	if(pBan->m_pNext)
-		pBan->m_pNext->m_pPrev = pBan->m_pPrev;
-	if(pBan->m_pPrev)
-		pBan->m_pPrev->m_pNext = pBan->m_pNext;
-	else
-		m_pFirstUsed = pBan->m_pNext;
+template<class T, int HashCount>
+void CNetBan::CBanPool<T, HashCount>::LinkHash(CHashList *pList, CBan<CDataType> *pBan)
+{
+	CBan<T> **ppBucket = &pList->m_papBuckets[Bucket(pBan->m_NetHash.m_Hash, pList->m_Shift)];
+	if(*ppBucket)
+		(*ppBucket)->m_pHashPrev = pBan;
+	pBan->m_pHashPrev = 0;
+	pBan->m_pHashNext = *ppBucket;
+	*ppBucket = pBan;
+}
 
-	// insert it into the used list
-	if(m_pFirstUsed)
+template<class T, int HashCount>
+void CNetBan::CBanPool<T, HashCount>::GrowHash(CHashList *pList)
+{
+	int OldSize = 1<<(32-pList->m_Shift);
+	CBan<T> **papOld = pList->m_papBuckets;
+	pList->m_papBuckets = (CBan<T> **)mem_alloc(OldSize*2*sizeof(CBan<T> *), 1);
+	mem_zero(pList->m_papBuckets, OldSize*2*sizeof(CBan<T> *));
+	pList->m_Shift--;
+
+	for(int i = 0; i < OldSize; ++i)
 	{
-		for(CBan<T> *p = m_pFirstUsed; ; p = p->m_pNext)
+		while(papOld[i])
 		{
-			if(p->m_Info.m_Expires == CBanInfo::EXPIRES_NEVER || (pInfo->m_Expires != CBanInfo::EXPIRES_NEVER && pInfo->m_Expires <= p->m_Info.m_Expires))
-			{
-				// insert before
-				pBan->m_pNext = p;
-				pBan->m_pPrev = p->m_pPrev;
-				if(p->m_pPrev)
-					p->m_pPrev->m_pNext = pBan;
-				else
-					m_pFirstUsed = pBan;
-				p->m_pPrev = pBan;
-				break;
-			}
-
-			if(!p->m_pNext)
-			{
-				// last entry
-				p->m_pNext = pBan;
-				pBan->m_pPrev = p;
-				pBan->m_pNext = 0;
-				break;
-			}
+			CBan<T> *pBan = papOld[i];
+			papOld[i] = pBan->m_pHashNext;
+			LinkHash(pList, pBan);
 		}
 	}
+	mem_free(papOld);
+}
+
+template<class T, int HashCount>
+void CNetBan::CBanPool<T, HashCount>::BuildBloom()
+{
+	int Bits = MIN_BLOOM_BITS;
+	while(1<<Bits < m_CountUsed*BLOOM_BITS_PER_BAN)
+		++Bits;
+
+	mem_free(m_pBloom);
+	m_pBloom = (unsigned *)mem_alloc((1<<Bits)/8, 1);
+	mem_zero(m_pBloom, (1<<Bits)/8);
+	m_BloomShift = 32-Bits;
+	m_NumStale = 0;
+
+	for(CBan<T> *pBan = m_pFirstUsed; pBan; pBan = pBan->m_pNext)
+		AddToBloom(&pBan->m_NetHash);
+}
+
+// the bans that expire are kept in order of expiry, the ones that don't behind them, each in the order they were added
+template<class T, int HashCount>
+void CNetBan::CBanPool<T, HashCount>::LinkUsed(CBan<CDataType> *pBan)
+{
+	CBan<T> *pPrev;
+	if(pBan->m_Info.m_Expires == CBanInfo::EXPIRES_NEVER)
+	{
+		pPrev = m_pLastUsed;
+		if(!m_pFirstNever)
+			m_pFirstNever = pBan;
+	}
 	else
 	{
+		// behind the last ban that expires at the same time or before
+		typename std::map<int, CBan<T> *>::iterator it = m_LastExpiring.upper_bound(pBan->m_Info.m_Expires);
+		pPrev = it == m_LastExpiring.begin() ? 0 : (--it)->second;
+		m_LastExpiring[pBan->m_Info.m_Expires] = pBan;
+	}
+
+	// insert after pPrev
+	pBan->m_pPrev = pPrev;
+	pBan->m_pNext = pPrev ? pPrev->m_pNext : m_pFirstUsed;
+	if(pBan->m_pNext)
+		pBan->m_pNext->m_pPrev = pBan;
+	else
+		m_pLastUsed = pBan;
+	if(pPrev)
+		pPrev->m_pNext = pBan;
+	else
 		m_pFirstUsed = pBan;
-		pBan->m_pNext = pBan->m_pPrev = 0;
+}
+
+template<class T, int HashCount>
+void CNetBan::CBanPool<T, HashCount>::UnlinkUsed(CBan<CDataType> *pBan)
+{
+	if(pBan == m_pFirstNever)
+		m_pFirstNever = pBan->m_pNext;
+	else if(pBan->m_Info.m_Expires != CBanInfo::EXPIRES_NEVER)
+	{
+		typename std::map<int, CBan<T> *>::iterator it = m_LastExpiring.find(pBan->m_Info.m_Expires);
+		if(it->second == pBan)
+		{
+			if(pBan->m_pPrev && pBan->m_pPrev->m_Info.m_Expires == pBan->m_Info.m_Expires)
+				it->second = pBan->m_pPrev;
+			else
+				m_LastExpiring.erase(it);
+		}
 	}
+	if(pBan->m_pNext)
+		pBan->m_pNext->m_pPrev = pBan->m_pPrev;
+	else
+		m_pLastUsed = pBan->m_pPrev;
+	if(pBan->m_pPrev)
+		pBan->m_pPrev->m_pNext = pBan->m_pNext;
+	else
+		m_pFirstUsed = pBan->m_pNext;
 }
 
 void CNetBan::UnbanAll()
@@ -214,20 +278,22 @@ void CNetBan::UnbanAll()
 template<class T, int HashCount>
 void CNetBan::CBanPool<T, HashCount>::Reset()
 {
-	mem_zero(m_paaHashList, sizeof(m_paaHashList));
-	mem_zero(m_aBans, sizeof(m_aBans));
-	m_pFirstUsed = 0;
-	m_CountUsed = 0;
-
-	for(int i = 1; i < MAX_BANS-1; ++i)
+	Free();
+	for(int i = 0; i < HashCount; ++i)
 	{
-		m_aBans[i].m_pNext = &m_aBans[i+1];
-		m_aBans[i].m_pPrev = &m_aBans[i-1];
+		m_aHashLists[i].m_papBuckets = (CBan<T> **)mem_alloc((1<<MIN_BUCKET_BITS)*sizeof(CBan<T> *), 1);
+		mem_zero(m_aHashLists[i].m_papBuckets, (1<<MIN_BUCKET_BITS)*sizeof(CBan<T> *));
+		m_aHashLists[i].m_Shift = 32-MIN_BUCKET_BITS;
+		m_aHashLists[i].m_Num = 0;
 	}
 
-	m_aBans[0].m_pNext = &m_aBans[1];
-	m_aBans[MAX_BANS-1].m_pPrev = &m_aBans[MAX_BANS-2];
-	m_pFirstFree = &m_aBans[0];
+	m_pFirstFree = 0;
+	m_pFirstUsed = 0;
+	m_pLastUsed = 0;
+	m_pFirstNever = 0;
+	m_LastExpiring.clear();
+	m_CountUsed = 0;
+	BuildBloom();
 }
 
 template<class T, int HashCount>
@@ -571,3 +637,7 @@ void CNetBan::ConBansSave(IConsole::IResult *pResult, void *pUser)
 	str_format(aBuf, sizeof(aBuf), "saved banlist to '%s'", pResult->GetString(0));
 	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", aBuf);
 }
+
+// the pools are used from other files too, by the server ban
+template class CNetBan::CBanPool<NETADDR, 1>;
+template class CNetBan::CBanPool<CNetRange, 16>;
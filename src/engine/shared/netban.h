@@ -1,6 +1,7 @@
 #ifndef ENGINE_SHARED_NETBAN_H
 #define ENGINE_SHARED_NETBAN_H
 
+#include <map>
 #include <base/system.h>
 
 inline int NetComp(const NETADDR *pAddr1, const NETADDR *pAddr2)
@@ -64,7 +65,7 @@ protected:
 	class CNetHash
 	{
 	public:
-		int m_Hash;
+		unsigned m_Hash;	// of the matching parts
 		int m_HashIndex;	// matching parts for ranges, 0 for addr
 
 		CNetHash() {}
@@ -100,24 +101,39 @@ protected:
 		CBan *m_pPrev;
 	};
 
+	// keeps a hash table per number of matching parts, so a lookup only walks the bans that share its prefix with
+	// the address. the tables grow with the bans, and a bloom filter in front of them turns away most addresses
+	// that aren't banned before any table is touched
 	template<class T, int HashCount> class CBanPool
 	{
 	public:
 		typedef T CDataType;
 
+		CBanPool() : m_pBloom(0), m_pFirstChunk(0)
+		{
+			mem_zero(m_aHashLists, sizeof(m_aHashLists));
+			Reset();
+		}
+		~CBanPool() { Free(); }
+
 		CBan<CDataType> *Add(const CDataType *pData, const CBanInfo *pInfo, const CNetHash *pNetHash);
 		int Remove(CBan<CDataType> *pBan);
 		void Update(CBan<CDataType> *pBan, const CBanInfo *pInfo);
 		void Reset();
 
 		int Num() const { return m_CountUsed; }
-		bool IsFull() const { return m_CountUsed == MAX_BANS; }
 
 		CBan<CDataType> *First() const { return m_pFirstUsed; }
-		CBan<CDataType> *First(const CNetHash *pNetHash) const { return m_paaHashList[pNetHash->m_HashIndex][pNetHash->m_Hash]; }
+		CBan<CDataType> *First(const CNetHash *pNetHash) const
+		{
+			const CHashList *pList = &m_aHashLists[pNetHash->m_HashIndex];
+			if(pList->m_Num == 0 || !MayContain(pNetHash))
+				return 0;
+			return pList->m_papBuckets[Bucket(pNetHash->m_Hash, pList->m_Shift)];
+		}
 		CBan<CDataType> *Find(const CDataType *pData, const CNetHash *pNetHash) const
 		{
-			for(CBan<CDataType> *pBan = m_paaHashList[pNetHash->m_HashIndex][pNetHash->m_Hash]; pBan; pBan = pBan->m_pHashNext)
+			for(CBan<CDataType> *pBan = First(pNetHash); pBan; pBan = pBan->m_pHashNext)
 			{
 				if(NetComp(&pBan->m_Data, pData) == 0)
 					return pBan;
@@ -130,14 +146,64 @@ protected:
 	private:
 		enum
 		{
-			MAX_BANS=1024,
+			CHUNK_SIZE=1024,
+			MIN_BUCKET_BITS=8,
+			MIN_BLOOM_BITS=14,
+			BLOOM_BITS_PER_BAN=16,
 		};
 
-		CBan<CDataType> *m_paaHashList[HashCount][256];
-		CBan<CDataType> m_aBans[MAX_BANS];
+		struct CHashList
+		{
+			CBan<CDataType> **m_papBuckets;
+			int m_Shift;	// 32 minus the bits of the bucket count
+			int m_Num;
+		};
+
+		struct CChunk
+		{
+			CChunk *m_pNext;
+			CBan<CDataType> m_aBans[CHUNK_SIZE];
+		};
+
+		CHashList m_aHashLists[HashCount];
+		unsigned *m_pBloom;
+		int m_BloomShift;
+		int m_NumStale;	// bans removed since the bloom filter was built, their bits are still set
+		CChunk *m_pFirstChunk;
 		CBan<CDataType> *m_pFirstFree;
 		CBan<CDataType> *m_pFirstUsed;
+		CBan<CDataType> *m_pLastUsed;
+		CBan<CDataType> *m_pFirstNever;	// the bans that don't expire are at the end of the used list
+		std::map<int, CBan<CDataType> *> m_LastExpiring;	// the last used ban of every expiry time, where a new ban goes
 		int m_CountUsed;
+
+		static unsigned Bucket(unsigned Hash, int Shift) { return (Hash*2654435761u)>>Shift; }
+		void BloomBits(const CNetHash *pNetHash, unsigned *pBit1, unsigned *pBit2) const
+		{
+			unsigned Key = (pNetHash->m_Hash+pNetHash->m_HashIndex*0x9e3779b9u)*0x85ebca6bu;
+			*pBit1 = Key>>m_BloomShift;
+			*pBit2 = ((Key<<16|Key>>16)*0xc2b2ae35u)>>m_BloomShift;
+		}
+		bool MayContain(const CNetHash *pNetHash) const
+		{
+			unsigned Bit1, Bit2;
+			BloomBits(pNetHash, &Bit1, &Bit2);
+			return (m_pBloom[Bit1>>5]&(1u<<(Bit1&31))) && (m_pBloom[Bit2>>5]&(1u<<(Bit2&31)));
+		}
+		void AddToBloom(const CNetHash *pNetHash)
+		{
+			unsigned Bit1, Bit2;
+			BloomBits(pNetHash, &Bit1, &Bit2);
+			m_pBloom[Bit1>>5] |= 1u<<(Bit1&31);
+			m_pBloom[Bit2>>5] |= 1u<<(Bit2&31);
+		}
+
+		void Free();
+		void LinkHash(CHashList *pList, CBan<CDataType> *pBan);
+		void GrowHash(CHashList *pList);
+		void BuildBloom();
+		void LinkUsed(CBan<CDataType> *pBan);
+		void UnlinkUsed(CBan<CDataType> *pBan);
 	};
 
 	typedef CBanPool<NETADDR, 1> CBanAddrPool;
@@ -179,6 +179,8 @@ private:
 	char m_ErrorString[256];
 
 	CNetPacketConstruct m_Construct;
+	unsigned char *m_pPreparedChunk;
+	int m_PreparedFlags;
 
 	NETADDR m_PeerAddr;
 	NETSOCKET m_Socket;
@@ -210,6 +212,9 @@ public:
 
 	int Feed(CNetPacketConstruct *pPacket, NETADDR *pAddr, SECURITY_TOKEN SecurityToken = NET_SECURITY_TOKEN_UNSUPPORTED);
 	int QueueChunk(int Flags, int DataSize, const void *pData);
+	// reserves room for a chunk of up to MaxDataSize bytes in the packet under construction and returns where its
+	// data goes. queueing that pointer next only writes the chunk header instead of copying the data over
+	unsigned char *PrepareChunk(int Flags, int MaxDataSize);
 
 	const char *ErrorString();
 	void SignalResend();
@@ -349,6 +354,8 @@ public:
 	//
 	int Recv(CNetChunk *pChunk);
 	int Send(CNetChunk *pChunk);
+	// buffer to build a message for the client in, hand it to Send() with the same flags right after
+	unsigned char *PrepareSend(int ClientID, int Flags, int MaxSize);
 	int Update();
 
 	//
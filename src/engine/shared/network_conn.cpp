@@ -36,6 +36,7 @@ void CNetConnection::Reset(bool Rejoin)
 	m_LastSendTime = 0;
 	m_LastRecvTime = 0;
 	//m_LastUpdateTime = 0;
+	m_pPreparedChunk = 0;
 
 	//mem_zero(&m_PeerAddr, sizeof(m_PeerAddr));
 	m_UnknownSeq = false;
@@ -100,6 +101,7 @@ int CNetConnection::Flush()
 
 	// clear construct so we can start building a new package
 	mem_zero(&m_Construct, sizeof(m_Construct));
+	m_pPreparedChunk = 0;
 	return NumChunks;
 }
 
@@ -110,8 +112,14 @@ int CNetConnection::QueueChunkEx(int Flags, int DataSize, const void *pData, int
 
 	unsigned char *pChunkData;
 
+	// the data might already sit right behind the header, see PrepareChunk
+	bool InPlace = pData == m_pPreparedChunk;
+	m_pPreparedChunk = 0;
+	if(InPlace)
+		dbg_assert((Flags&NET_CHUNKFLAG_VITAL) == (m_PreparedFlags&NET_CHUNKFLAG_VITAL), "prepared chunk queued with different flags");
+
 	// check if we have space for it, if not, flush the connection
-	if(m_Construct.m_DataSize + DataSize + NET_MAX_CHUNKHEADERSIZE > (int)sizeof(m_Construct.m_aChunkData) - (int)sizeof(SECURITY_TOKEN))
+	if(!InPlace && m_Construct.m_DataSize + DataSize + NET_MAX_CHUNKHEADERSIZE > (int)sizeof(m_Construct.m_aChunkData) - (int)sizeof(SECURITY_TOKEN))
 		Flush();
 
 	// pack all the data
@@ -121,7 +129,8 @@ int CNetConnection::QueueChunkEx(int Flags, int DataSize, const void *pData, int
 	Header.m_Sequence = Sequence;
 	pChunkData = &m_Construct.m_aChunkData[m_Construct.m_DataSize];
 	pChunkData = Header.Pack(pChunkData);
-	mem_copy(pChunkData, pData, DataSize);
+	if(!InPlace)
+		mem_copy(pChunkData, pData, DataSize);
 	pChunkData += DataSize;
 
 	//
@@ -161,6 +170,25 @@ int CNetConnection::QueueChunk(int Flags, int DataSize, const void *pData)
 	return QueueChunkEx(Flags, DataSize, pData, m_Sequence);
 }
 
+unsigned char *CNetConnection::PrepareChunk(int Flags, int MaxDataSize)
+{
+	if (m_State == NET_CONNSTATE_OFFLINE || m_State == NET_CONNSTATE_ERROR)
+		return 0;
+
+	const int MaxSpace = (int)sizeof(m_Construct.m_aChunkData) - (int)sizeof(SECURITY_TOKEN);
+	if(MaxDataSize + NET_MAX_CHUNKHEADERSIZE > MaxSpace)
+		return 0;
+
+	// same check as in QueueChunkEx, so the chunk won't be moved once the data is written
+	if(m_Construct.m_DataSize + MaxDataSize + NET_MAX_CHUNKHEADERSIZE > MaxSpace)
+		Flush();
+
+	// leave room for the header, it is only packed once the size is known
+	m_PreparedFlags = Flags;
+	m_pPreparedChunk = &m_Construct.m_aChunkData[m_Construct.m_DataSize] + ((Flags&NET_CHUNKFLAG_VITAL) ? 3 : 2);
+	return m_pPreparedChunk;
+}
+
 void CNetConnection::SendControl(int ControlMsg, const void *pExtra, int ExtraSize)
 {
 	// send the control message
@@ -700,6 +700,17 @@ int CNetServer::Send(CNetChunk *pChunk)
 	return 0;
 }
 
+unsigned char *CNetServer::PrepareSend(int ClientID, int Flags, int MaxSize)
+{
+	if(Flags&NETSENDFLAG_CONNLESS || MaxSize >= NET_MAX_PAYLOAD)
+		return 0;
+
+	dbg_assert(ClientID >= 0, "errornous client id");
+	dbg_assert(ClientID < MaxClients(), "errornous client id");
+
+	return m_aSlots[ClientID].m_Connection.PrepareChunk((Flags&NETSENDFLAG_VITAL) ? NET_CHUNKFLAG_VITAL : 0, MaxSize);
+}
+
 void CNetServer::SetMaxClientsPerIP(int Max)
 {
 	// clamp
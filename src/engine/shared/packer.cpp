@@ -8,10 +8,16 @@
 #include "config.h"
 
 void CPacker::Reset()
+{
+	Reset(m_aBuffer, PACKER_BUFFER_SIZE);
+}
+
+void CPacker::Reset(unsigned char *pBuffer, int BufferSize)
 {
 	m_Error = 0;
-	m_pCurrent = m_aBuffer;
-	m_pEnd = m_pCurrent + PACKER_BUFFER_SIZE;
+	m_pStart = pBuffer;
+	m_pCurrent = m_pStart;
+	m_pEnd = m_pCurrent + BufferSize;
 }
 
 void CPacker::AddInt(int i)
@@ -77,12 +83,8 @@ void CPacker::AddRaw(const void *pData, int Size)
 		return;
 	}
 
-	const unsigned char *pSrc = (const unsigned char *)pData;
-	while(Size)
-	{
-		*m_pCurrent++ = *pSrc++;
-		Size--;
-	}
+	mem_copy(m_pCurrent, pData, Size);
+	m_pCurrent += Size;
 }
 
 
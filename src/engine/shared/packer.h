@@ -13,17 +13,20 @@ class CPacker
 	};
 
 	unsigned char m_aBuffer[PACKER_BUFFER_SIZE];
+	unsigned char *m_pStart;
 	unsigned char *m_pCurrent;
 	unsigned char *m_pEnd;
 	int m_Error;
 public:
 	void Reset();
+	// pack into pBuffer instead of the internal buffer, e.g. straight into an outgoing network packet
+	void Reset(unsigned char *pBuffer, int BufferSize);
 	void AddInt(int i);
 	void AddString(const char *pStr, int Limit);
 	void AddRaw(const void *pData, int Size);
 
-	int Size() const { return (int)(m_pCurrent-m_aBuffer); }
-	const unsigned char *Data() const { return m_aBuffer; }
+	int Size() const { return (int)(m_pCurrent-m_pStart); }
+	const unsigned char *Data() const { return m_pStart; }
 	bool Error() const { return m_Error; }
 };
 
@@ -406,116 +406,142 @@ int CSnapshotDelta::UnpackDelta(CSnapshot *pFrom, CSnapshot *pTo, void *pSrcData
 
 // CSnapshotStorage
 
+CSnapshotStorage::CSnapshotStorage()
+{
+	m_pFirst = 0;
+	m_pLast = 0;
+	mem_zero(m_aHolders, sizeof(m_aHolders));
+	m_NumOverflow = 0;
+}
+
 CSnapshotStorage::~CSnapshotStorage()
 {
 	PurgeAll();
+	for(int i = 0; i < MAX_SNAPSHOTS; i++)
+		mem_free(m_aHolders[i].m_pData);
 }
 
 void CSnapshotStorage::Init()
 {
-	m_pFirst = 0;
-	m_pLast = 0;
-	m_HeapPool.HintSize(10, 3072);
+	PurgeAll();
 }
 
-void CSnapshotStorage::PurgeAll()
+void CSnapshotStorage::Unlink(CHolder *pHolder)
 {
-	CHolder *pHolder = m_pFirst;
-	CHolder *pNext;
+	if(pHolder->m_pPrev)
+		pHolder->m_pPrev->m_pNext = pHolder->m_pNext;
+	else
+		m_pFirst = pHolder->m_pNext;
 
-	while(pHolder)
+	if(pHolder->m_pNext)
+		pHolder->m_pNext->m_pPrev = pHolder->m_pPrev;
+	else
+		m_pLast = pHolder->m_pPrev;
+
+	pHolder->m_pPrev = 0;
+	pHolder->m_pNext = 0;
+	pHolder->m_Used = false;
+
+	if(pHolder->m_Overflow)
 	{
-		pNext = pHolder->m_pNext;
-		m_HeapPool.Free(pHolder);
-		pHolder = pNext;
+		mem_free(pHolder->m_pData);
+		mem_free(pHolder);
+		m_NumOverflow--;
 	}
+}
 
-	// no more snapshots in storage
-	m_pFirst = 0;
-	m_pLast = 0;
+void CSnapshotStorage::PurgeAll()
+{
+	// no more snapshots in storage, the slot buffers are kept for reuse
+	while(m_pFirst)
+		Unlink(m_pFirst);
 }
 
 void CSnapshotStorage::PurgeUntil(int Tick)
 {
-	CHolder *pHolder = m_pFirst;
-	CHolder *pNext;
-
-	while(pHolder)
-	{
-		pNext = pHolder->m_pNext;
-		if(pHolder->m_Tick >= Tick)
-			return; // no more to remove
-		m_HeapPool.Free(pHolder);
-
-		// did we come to the end of the list?
-		if (!pNext)
-			break;
-
-		m_pFirst = pNext;
-		pNext->m_pPrev = 0x0;
-
-		pHolder = pNext;
-	}
-
-	// no more snapshots in storage
-	m_pFirst = 0;
-	m_pLast = 0;
+	while(m_pFirst && m_pFirst->m_Tick < Tick)
+		Unlink(m_pFirst);
 }
 
 void CSnapshotStorage::Add(int Tick, int64 Tagtime, int DataSize, void *pData, int CreateAlt)
 {
-	// allocate memory for holder + snapshot_data
-	int TotalSize = sizeof(CHolder)+DataSize + CreateAlt*DataSize;
+	CHolder *pHolder = Slot(Tick);
+
+	// the slot is still taken, by the same tick or by one MAX_SNAPSHOTS ticks older that wasn't purged because the
+	// client stalled. its holder may still be in use (as the client's current or previous snapshot), so it isn't
+	// reused and the new snapshot gets a holder of its own
+	if(pHolder->m_Used)
+	{
+		pHolder = (CHolder *)mem_alloc(sizeof(CHolder), 1);
+		mem_zero(pHolder, sizeof(CHolder));
+		pHolder->m_Overflow = true;
+		m_NumOverflow++;
+	}
 
-	CHolder *pHolder = m_HeapPool.Allocate(TotalSize);
+	// only grow the slot buffer, so that we stop allocating once we've seen the biggest snapshots
+	int TotalSize = DataSize + CreateAlt*DataSize;
+	if(TotalSize > pHolder->m_DataCapacity)
+	{
+		mem_free(pHolder->m_pData);
+		pHolder->m_DataCapacity = (TotalSize+1023)&~1023;
+		pHolder->m_pData = (char *)mem_alloc(pHolder->m_DataCapacity, 1);
+	}
 
 	// set data
+	pHolder->m_Used = true;
 	pHolder->m_Tick = Tick;
 	pHolder->m_Tagtime = Tagtime;
 	pHolder->m_SnapSize = DataSize;
-	pHolder->m_pSnap = (CSnapshot*)(pHolder+1);
+	pHolder->m_pSnap = (CSnapshot*)pHolder->m_pData;
 	mem_copy(pHolder->m_pSnap, pData, DataSize);
 
 	if(CreateAlt) // create alternative if wanted
 	{
-		pHolder->m_pAltSnap = (CSnapshot*)(((char *)pHolder->m_pSnap) + DataSize);
+		pHolder->m_pAltSnap = (CSnapshot*)(pHolder->m_pData + DataSize);
 		mem_copy(pHolder->m_pAltSnap, pData, DataSize);
 	}
 	else
 		pHolder->m_pAltSnap = 0;
 
+	// link, keeping the list sorted by tick (snapshots almost always arrive in order)
+	CHolder *pPrev = m_pLast;
+	while(pPrev && pPrev->m_Tick > Tick)
+		pPrev = pPrev->m_pPrev;
 
-	// link
-	pHolder->m_pNext = 0;
-	pHolder->m_pPrev = m_pLast;
-	if(m_pLast)
-		m_pLast->m_pNext = pHolder;
+	pHolder->m_pPrev = pPrev;
+	pHolder->m_pNext = pPrev ? pPrev->m_pNext : m_pFirst;
+	if(pHolder->m_pNext)
+		pHolder->m_pNext->m_pPrev = pHolder;
+	else
+		m_pLast = pHolder;
+	if(pPrev)
+		pPrev->m_pNext = pHolder;
 	else
 		m_pFirst = pHolder;
-	m_pLast = pHolder;
 }
 
 int CSnapshotStorage::Get(int Tick, int64 *pTagtime, CSnapshot **ppData, CSnapshot **ppAltData)
 {
-	CHolder *pHolder = m_pFirst;
-
-	while(pHolder)
+	CHolder *pHolder = Slot(Tick);
+	if(!pHolder->m_Used || pHolder->m_Tick != Tick)
 	{
-		if(pHolder->m_Tick == Tick)
-		{
-			if(pTagtime)
-				*pTagtime = pHolder->m_Tagtime;
-			if(ppData)
-				*ppData = pHolder->m_pSnap;
-			if(ppAltData)
-				*ppAltData = pHolder->m_pAltSnap;
-			return pHolder->m_SnapSize;
-		}
-
-		pHolder = pHolder->m_pNext;
+		// it may have had to go elsewhere
+		pHolder = 0;
+		if(m_NumOverflow)
+			for(CHolder *p = m_pLast; p; p = p->m_pPrev)
+				if(p->m_Tick == Tick)
+					pHolder = p;
+		if(!pHolder)
+			return -1;
 	}
 
-	return -1;
+	if(pTagtime)
+		*pTagtime = pHolder->m_Tagtime;
+	if(ppData)
+		*ppData = pHolder->m_pSnap;
+	if(ppAltData)
+		*ppAltData = pHolder->m_pAltSnap;
+	return pHolder->m_SnapSize;
 }
 
 // CSnapshotBuilder
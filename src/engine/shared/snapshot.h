@@ -4,7 +4,6 @@
 #define ENGINE_SHARED_SNAPSHOT_H
 
 #include <base/system.h>
-#include <base/system++/pool.h>
 
 // CSnapshot
 
@@ -87,6 +86,12 @@ public:
 
 // CSnapshotStorage
 
+/*
+	Fixed ring of snapshot slots, indexed by tick modulo MAX_SNAPSHOTS.
+	The slot buffers are kept around after a purge and only grow, so
+	there is no allocation once the storage has warmed up. The used slots
+	are additionally linked in tick order for the callers that walk them.
+*/
 class CSnapshotStorage
 {
 public:
@@ -102,19 +107,37 @@ public:
 		int m_SnapSize;
 		CSnapshot *m_pSnap;
 		CSnapshot *m_pAltSnap;
+
+		// slot bookkeeping, owned by the storage
+		bool m_Used;
+		bool m_Overflow; // allocated because its slot was taken, freed when it's purged
+		char *m_pData;
+		int m_DataCapacity;
+	};
+
+	enum
+	{
+		MAX_SNAPSHOTS=256, // must be a power of two, covers 5 seconds of ticks
 	};
 
+	CSnapshotStorage();
 	~CSnapshotStorage();
 
 	CHolder *m_pFirst;
 	CHolder *m_pLast;
-	CPool<CHolder> m_HeapPool;
 
 	void Init();
 	void PurgeAll();
 	void PurgeUntil(int Tick);
 	void Add(int Tick, int64 Tagtime, int DataSize, void *pData, int CreateAlt);
 	int Get(int Tick, int64 *Tagtime, CSnapshot **pData, CSnapshot **ppAltData);
+
+private:
+	CHolder m_aHolders[MAX_SNAPSHOTS];
+	int m_NumOverflow;
+
+	CHolder *Slot(int Tick) { return &m_aHolders[Tick&(MAX_SNAPSHOTS-1)]; }
+	void Unlink(CHolder *pHolder);
 };
 
 class CSnapshotBuilder
@@ -78,6 +78,7 @@ public:
 
 				fs_makedir(GetPath(TYPE_SAVE, "tmp", aPath, sizeof(aPath)));
 				fs_makedir(GetPath(TYPE_SAVE, "tmp/cache", aPath, sizeof(aPath)));
+				fs_makedir(GetPath(TYPE_SAVE, "tmp/cache/images", aPath, sizeof(aPath)));
 			}
 			fs_makedir(GetPath(TYPE_SAVE, "dumps", aPath, sizeof(aPath)));
 			fs_makedir(GetPath(TYPE_SAVE, "dumps/console_local", aPath, sizeof(aPath)));
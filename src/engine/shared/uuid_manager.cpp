@@ -1,5 +1,7 @@
 #include "uuid_manager.h"
 
+#include <base/math.h>
+
 #include <engine/external/md5/md5.h>
 #include <engine/shared/packer.h>
 
@@ -64,6 +66,30 @@ static int GetID(int Index)
 	return Index + OFFSET_UUID;
 }
 
+static unsigned HashUuid(const CUuid &Uuid)
+{
+	// the uuids are md5 based, so any four bytes of them are well distributed
+	return Uuid.m_aData[0] | (Uuid.m_aData[1]<<8) | (Uuid.m_aData[2]<<16) | ((unsigned)Uuid.m_aData[3]<<24);
+}
+
+void CUuidManager::AddToIndex(int Index)
+{
+	unsigned Mask = m_aNameIndex.size()-1;
+	unsigned Bucket = HashUuid(m_aNames[Index].m_Uuid)&Mask;
+	while(m_aNameIndex[Bucket] != -1)
+		Bucket = (Bucket+1)&Mask;
+	m_aNameIndex[Bucket] = Index;
+}
+
+void CUuidManager::RebuildIndex(int NumBuckets)
+{
+	m_aNameIndex.set_size(NumBuckets);
+	for(int i = 0; i < NumBuckets; i++)
+		m_aNameIndex[i] = -1;
+	for(int i = 0; i < m_aNames.size(); i++)
+		AddToIndex(i);
+}
+
 void CUuidManager::RegisterName(int ID, const char *pName)
 {
 	int Index = GetIndex(ID);
@@ -74,6 +100,12 @@ void CUuidManager::RegisterName(int ID, const char *pName)
 	dbg_assert(LookupUuid(Name.m_Uuid) == -1, "duplicate uuid");
 
 	m_aNames.add(Name);
+
+	// keep the index at most half full so that the probe sequences stay short
+	if(m_aNames.size()*2 > m_aNameIndex.size())
+		RebuildIndex(max(64, m_aNameIndex.size()*2));
+	else
+		AddToIndex(Index);
 }
 
 CUuid CUuidManager::GetUuid(int ID) const
@@ -88,11 +120,15 @@ const char *CUuidManager::GetName(int ID) const
 
 int CUuidManager::LookupUuid(CUuid Uuid) const
 {
-	for(int i = 0; i < m_aNames.size(); i++)
+	if(m_aNameIndex.size() == 0)
+		return UUID_UNKNOWN;
+
+	unsigned Mask = m_aNameIndex.size()-1;
+	for(unsigned Bucket = HashUuid(Uuid)&Mask; m_aNameIndex[Bucket] != -1; Bucket = (Bucket+1)&Mask)
 	{
-		if(Uuid == m_aNames[i].m_Uuid)
+		if(Uuid == m_aNames[m_aNameIndex[Bucket]].m_Uuid)
 		{
-			return GetID(i);
+			return GetID(m_aNameIndex[Bucket]);
 		}
 	}
 	return UUID_UNKNOWN;
@@ -36,6 +36,12 @@ class CUnpacker;
 class CUuidManager
 {
 	array<CName> m_aNames;
+
+	// open addressing hash index into m_aNames, -1 marks an empty bucket
+	array<int> m_aNameIndex;
+
+	void AddToIndex(int Index);
+	void RebuildIndex(int NumBuckets);
 public:
 	void RegisterName(int ID, const char *pName);
 	CUuid GetUuid(int ID) const;
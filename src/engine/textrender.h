@@ -42,6 +42,17 @@ public:
 	float m_FontSize;
 };
 
+// running totals of the glyph atlas and the layout cache
+class CTextRenderStats
+{
+public:
+	int64 m_NumGlyphHits;
+	int64 m_NumGlyphMisses;
+	int64 m_NumGlyphEvictions;
+	int64 m_NumLayoutHits;
+	int64 m_NumLayoutMisses;
+};
+
 class ITextRender : public IInterface
 {
 	MACRO_INTERFACE("textrender", 0)
@@ -66,6 +77,8 @@ public:
 	virtual float TextWidth(class CFont *pFontSetV, float Size, const char *pText, int Length = -1, float LineWidth = -1) = 0;
 	virtual float TextWidthParse(class CFont *pFontSetV, float Size, const char *pText, float LineWidth = -1, const char *pHighlight = 0) = 0;
 	virtual int TextLineCount(class CFont *pFontSetV, float Size, const char *pText, float LineWidth) = 0;
+
+	virtual void GetStats(CTextRenderStats *pStats) const = 0;
 };
 
 class IEngineTextRender : public ITextRender
@@ -633,16 +633,23 @@ void CChat::OnMessage(int MsgType, void *pRawMsg)
 		// EVENT CALL
 		if(!g_StealthMode && g_Config.m_ClLua)
 		{
-			for(int ijdfg = 0; ijdfg < CLua::Client()->Lua()->GetLuaFiles().size(); ijdfg++)
+			CLua *pLua = CLua::Client()->Lua();
+			if(pLua->EventsDirty())
+				pLua->UpdateEventListeners();
+			const array<CLuaFile*> &apListeners = pLua->GetEventListeners(LUA_EVENT_ON_CHAT);
+			for(int ijdfg = 0; ijdfg < apListeners.size(); ijdfg++)
 			{
-				CLuaFile *pLF = CLua::Client()->Lua()->GetLuaFiles()[ijdfg];
+				CLuaFile *pLF = apListeners[ijdfg];
 				if(pLF->State() != CLuaFile::STATE_LOADED)
 					continue;
-				LuaRef lfunc = pLF->GetFunc("OnChat");
-				if(lfunc) try { HideChat |= lfunc(pMsg->m_ClientID, pMsg->m_Team, std::string(pMsg->m_pMessage)).cast<bool>(); CLua::Client()->LuaCheckDrawingState(pLF->L(), "OnChat"); } catch(std::exception &e) { CLua::Client()->Lua()->HandleException(e, pLF); }
+				const LuaRef &lfunc = pLF->EventHandlers()->Handler(LUA_EVENT_ON_CHAT);
+				try { HideChat |= lfunc(pMsg->m_ClientID, pMsg->m_Team, std::string(pMsg->m_pMessage)).cast<bool>(); CLua::Client()->LuaCheckDrawingState(pLF->L(), "OnChat"); } catch(std::exception &e) { pLua->HandleException(e, pLF); }
+			}
+			if(CGameConsole::m_pStatLuaConsole->m_LuaHandler.m_EventHandlers.Handles(LUA_EVENT_ON_CHAT))
+			{
+				const LuaRef &confunc = CGameConsole::m_pStatLuaConsole->m_LuaHandler.m_EventHandlers.Handler(LUA_EVENT_ON_CHAT);
+				try { HideChat |= confunc(pMsg->m_ClientID, pMsg->m_Team, std::string(pMsg->m_pMessage)).cast<bool>(); } catch(std::exception &e) { printf("LUA EXCEPTION: console: %s\n", e.what()); }
 			}
-			LuaRef confunc = getGlobal(CGameConsole::m_pStatLuaConsole->m_LuaHandler.m_pLuaState, "OnChat");
-			if(confunc) try { HideChat |= confunc(pMsg->m_ClientID, pMsg->m_Team, std::string(pMsg->m_pMessage)).cast<bool>(); } catch(std::exception &e) { printf("LUA EXCEPTION: console: %s\n", e.what()); }
 		}
 
 		// some dennis (you can never have enough)
@@ -1351,18 +1358,25 @@ void CChat::Say(int Team, const char *pLine, bool NoTrans, bool CalledByLua)
 	}
 
 	int DiscardChat = false;
-	//LUA_FIRE_EVENT("OnChatSend", Team, pLine);
+	//LUA_FIRE_EVENT(LUA_EVENT_ON_CHAT_SEND, Team, pLine);
 	if(!g_StealthMode && !CalledByLua)
 	{
-		for(int ijdfg = 0; ijdfg < Client()->Lua()->GetLuaFiles().size(); ijdfg++)
+		CLua *pLua = Client()->Lua();
+		if(pLua->EventsDirty())
+			pLua->UpdateEventListeners();
+		const array<CLuaFile*> &apListeners = pLua->GetEventListeners(LUA_EVENT_ON_CHAT_SEND);
+		for(int ijdfg = 0; ijdfg < apListeners.size(); ijdfg++)
 		{
-			if(Client()->Lua()->GetLuaFiles()[ijdfg]->State() != CLuaFile::STATE_LOADED)
+			if(apListeners[ijdfg]->State() != CLuaFile::STATE_LOADED)
 				continue;
-			LuaRef lfunc = Client()->Lua()->GetLuaFiles()[ijdfg]->GetFunc("OnChatSend");
-			if(lfunc) try { if(lfunc(Team, pLine)) DiscardChat = true; } catch(std::exception &e) { Client()->Lua()->HandleException(e, Client()->Lua()->GetLuaFiles()[ijdfg]); }
+			const LuaRef &lfunc = apListeners[ijdfg]->EventHandlers()->Handler(LUA_EVENT_ON_CHAT_SEND);
+			try { if(lfunc(Team, pLine)) DiscardChat = true; } catch(std::exception &e) { pLua->HandleException(e, apListeners[ijdfg]); }
+		}
+		if(CGameConsole::m_pStatLuaConsole->m_LuaHandler.m_EventHandlers.Handles(LUA_EVENT_ON_CHAT_SEND))
+		{
+			const LuaRef &confunc = CGameConsole::m_pStatLuaConsole->m_LuaHandler.m_EventHandlers.Handler(LUA_EVENT_ON_CHAT_SEND);
+			try { if(confunc(Team, pLine)) DiscardChat = true; } catch(std::exception &e) { printf("LUA EXCEPTION: console: %s\n", e.what()); }
 		}
-		LuaRef confunc = getGlobal(CGameConsole::m_pStatLuaConsole->m_LuaHandler.m_pLuaState, "OnChatSend");
-		if(confunc) try { if(confunc(Team, pLine)) DiscardChat = true; } catch(std::exception &e) { printf("LUA EXCEPTION: console: %s\n", e.what()); }
 	}
 
 	if(!g_Config.m_ClChat || DiscardChat)
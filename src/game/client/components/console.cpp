@@ -133,16 +133,23 @@ void CGameConsole::CInstance::ExecuteLine(const char *pLine)
 			bool DiscardCommand = false;
 			if(g_Config.m_ClLua)
 			{
-				for(int ijdfg = 0; ijdfg < CLua::Client()->Lua()->GetLuaFiles().size(); ijdfg++)
+				CLua *pLua = CLua::Client()->Lua();
+				if(pLua->EventsDirty())
+					pLua->UpdateEventListeners();
+				const array<CLuaFile*> &apListeners = pLua->GetEventListeners(LUA_EVENT_ON_CONSOLE_COMMAND);
+				for(int ijdfg = 0; ijdfg < apListeners.size(); ijdfg++)
 				{
-					CLuaFile *pLF = CLua::Client()->Lua()->GetLuaFiles()[ijdfg];
+					CLuaFile *pLF = apListeners[ijdfg];
 					if(pLF->State() != CLuaFile::STATE_LOADED)
 						continue;
-					LuaRef lfunc = pLF->GetFunc("OnConsoleCommand");
-					if(lfunc) try { if(lfunc(pLine)) DiscardCommand = true; CLua::Client()->LuaCheckDrawingState(pLF->L(), "OnConsoleCommand"); } catch(std::exception &e) { CLua::Client()->Lua()->HandleException(e, pLF); }
+					const LuaRef &lfunc = pLF->EventHandlers()->Handler(LUA_EVENT_ON_CONSOLE_COMMAND);
+					try { if(lfunc(pLine)) DiscardCommand = true; CLua::Client()->LuaCheckDrawingState(pLF->L(), "OnConsoleCommand"); } catch(std::exception &e) { pLua->HandleException(e, pLF); }
+				}
+				if(CGameConsole::m_pStatLuaConsole->m_LuaHandler.m_EventHandlers.Handles(LUA_EVENT_ON_CONSOLE_COMMAND))
+				{
+					const LuaRef &confunc = CGameConsole::m_pStatLuaConsole->m_LuaHandler.m_EventHandlers.Handler(LUA_EVENT_ON_CONSOLE_COMMAND);
+					try { if(confunc(pLine)) DiscardCommand = true; } catch(std::exception &e) { printf("LUA EXCEPTION: console: %s\n", e.what()); }
 				}
-				LuaRef confunc = getGlobal(CGameConsole::m_pStatLuaConsole->m_LuaHandler.m_pLuaState, "OnConsoleCommand");
-				if(confunc) try { if(confunc(pLine)) DiscardCommand = true; } catch(std::exception &e) { printf("LUA EXCEPTION: console: %s\n", e.what()); }
 			}
 			if(DiscardCommand)
 				return;
@@ -199,6 +206,7 @@ void CGameConsole::CInstance::ExecuteLine(const char *pLine)
 			m_LuaHandler.m_FullLine = "";
 			m_LuaHandler.m_Inited = false;
 			m_LuaHandler.m_pDebugChild = 0;
+			m_LuaHandler.m_EventHandlers.Clear();
 			lua_close(m_LuaHandler.m_pLuaState);
 			InitLua();
 			PrintLine("Reload complete");
@@ -352,6 +360,8 @@ void CGameConsole::CInstance::ExecuteLine(const char *pLine)
 			m_LuaHandler.m_FullLine = "";
 			m_LuaHandler.m_ScopeCount = 0;
 
+			// the line might have defined an event function
+			m_pGameConsole->m_pClient->Client()->Lua()->MarkEventsDirty();
 		}
 		else if(m_LuaHandler.m_ScopeCount < 0)
 		{
@@ -792,6 +802,7 @@ bool CGameConsole::CInstance::LoadLuaFile(const char *pFile)  //this function is
 		return false;
 	}
 
+	m_pGameConsole->m_pClient->Client()->Lua()->MarkEventsDirty();
 	return true;
 }
 
@@ -3,6 +3,7 @@
 #ifndef GAME_CLIENT_COMPONENTS_CONSOLE_H
 #define GAME_CLIENT_COMPONENTS_CONSOLE_H
 #include <engine/shared/ringbuffer.h>
+#include <engine/client/luaevents.h>
 #include <game/client/component.h>
 #include <game/client/lineinput.h>
 
@@ -78,6 +79,7 @@ class CGameConsole : public CComponent
 			int m_ScopeCount;
 			std::string m_FullLine;
 
+			CLuaEventHandlers m_EventHandlers;
 		} m_LuaHandler;
 
 		bool LoadLuaFile(const char *pFile);
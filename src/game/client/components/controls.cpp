@@ -358,7 +358,7 @@ int CControls::SnapInput(int *pData)
 		}
 #endif
 
-		LUA_FIRE_EVENT("OnSnapInput");
+		LUA_FIRE_EVENT(LUA_EVENT_ON_SNAP_INPUT);
 
 		// check if we need to send input
 		if(m_InputData[g_Config.m_ClDummy].m_ViewDir != m_LastData[g_Config.m_ClDummy].m_ViewDir) Send = true;
@@ -18,6 +18,12 @@
 #include "debughud.h"
 #include "controls.h"
 
+CDebugHud::CDebugHud()
+{
+	mem_zero(&m_LastStats, sizeof(m_LastStats));
+	mem_zero(&m_LastTextStats, sizeof(m_LastTextStats));
+}
+
 void CDebugHud::RenderNetCorrections()
 {
 	if(!g_Config.m_Debug || g_Config.m_DbgGraphs || !m_pClient->m_Snap.m_pLocalCharacter || !m_pClient->m_Snap.m_pLocalPrevCharacter)
@@ -159,8 +165,64 @@ void CDebugHud::RenderTuning()
 	TextRender()->TextColor(1,1,1,1);
 }
 
+void CDebugHud::RenderGraphicsStats()
+{
+	// the totals keep running while this is off, so the first frame after turning it on shows the difference
+	CGraphicsStats Stats;
+	Graphics()->GetStats(&Stats);
+	CGraphicsStats Last = m_LastStats;
+	m_LastStats = Stats;
+	CTextRenderStats TextStats;
+	TextRender()->GetStats(&TextStats);
+	CTextRenderStats LastText = m_LastTextStats;
+	m_LastTextStats = TextStats;
+	if(!g_Config.m_DbgGfxStats)
+		return;
+
+	Graphics()->MapScreen(0, 0, 300*Graphics()->ScreenAspect(), 300);
+
+	const char *paStrings[] = {
+		"vertices:",
+		"flushes:",
+		"kicks:",
+		"copied bytes:",
+		"commands:",
+		"primitives:",
+		"upload bytes:",
+		"text layouts:",
+		"cached:",
+		"new glyphs:",
+	};
+	const int64 aValues[] = {
+		Stats.m_NumStreamedVertices - Last.m_NumStreamedVertices,
+		Stats.m_NumFlushes - Last.m_NumFlushes,
+		Stats.m_NumKicks - Last.m_NumKicks,
+		Stats.m_BytesCopied - Last.m_BytesCopied,
+		Stats.m_NumCommands - Last.m_NumCommands,
+		Stats.m_NumPrimitives - Last.m_NumPrimitives,
+		Stats.m_TextureUploadBytes - Last.m_TextureUploadBytes,
+		TextStats.m_NumLayoutHits+TextStats.m_NumLayoutMisses - LastText.m_NumLayoutHits-LastText.m_NumLayoutMisses,
+		TextStats.m_NumLayoutHits - LastText.m_NumLayoutHits,
+		TextStats.m_NumGlyphMisses - LastText.m_NumGlyphMisses,
+	};
+	const int Num = sizeof(paStrings)/sizeof(char *);
+	const float LineHeight = 6.0f;
+	const float Fontsize = 5.0f;
+
+	float y = 50.0f;
+	for(int i = 0; i < Num; i++, y += LineHeight)
+	{
+		char aBuf[64];
+		TextRender()->Text(0, 5.0f, y, Fontsize, paStrings[i], -1);
+		str_format(aBuf, sizeof(aBuf), "%lld", aValues[i]);
+		float w = TextRender()->TextWidth(0, Fontsize, aBuf, -1);
+		TextRender()->Text(0, 70.0f-w, y, Fontsize, aBuf, -1);
+	}
+}
+
 void CDebugHud::OnRender()
 {
 	RenderTuning();
 	RenderNetCorrections();
+	RenderGraphicsStats();
 }
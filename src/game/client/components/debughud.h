@@ -2,13 +2,20 @@
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 #ifndef GAME_CLIENT_COMPONENTS_DEBUGHUD_H
 #define GAME_CLIENT_COMPONENTS_DEBUGHUD_H
+#include <engine/graphics.h>
+#include <engine/textrender.h>
 #include <game/client/component.h>
 
 class CDebugHud : public CComponent
 {
+	CGraphicsStats m_LastStats;
+	CTextRenderStats m_LastTextStats;
+
 	void RenderNetCorrections();
 	void RenderTuning();
+	void RenderGraphicsStats();
 public:
+	CDebugHud();
 	virtual void OnRender();
 };
 
@@ -63,7 +63,7 @@ void CIRCBind::OnMessageIRC(const char *pChan, const char *pUser, const char *pT
 	if(g_Config.m_SndIRC)
 		GameClient()->m_pSounds->Play(CSounds::CHN_GUI, SOUND_IRC_MESSAGE, 1.0f);
 
-	LUA_FIRE_EVENT("OnMessageIRC", std::string(pChan), std::string(pUser), std::string(pText));
+	LUA_FIRE_EVENT(LUA_EVENT_ON_MESSAGE_IRC, std::string(pChan), std::string(pUser), std::string(pText));
 
 	// print chat message....
 //	if(g_Config.m_ClIRCPrintChat)
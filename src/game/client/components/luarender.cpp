@@ -4,7 +4,7 @@
 void CLuaComponent::OnRender()
 {
 	// EVENT CALL
-	LUA_FIRE_EVENT("OnRenderLevel", m_Level);
+	LUA_FIRE_EVENT(LUA_EVENT_ON_RENDER_LEVEL, m_Level);
 }
 
 bool CLuaComponent::OnInput(IInput::CEvent Event)
@@ -13,9 +13,13 @@ bool CLuaComponent::OnInput(IInput::CEvent Event)
 		return false;
 
 	bool result = false;
-	for(int ijdfg = 0; ijdfg < CLua::Client()->Lua()->GetLuaFiles().size(); ijdfg++)
+	CLua *pLua = CLua::Client()->Lua();
+	if(pLua->EventsDirty())
+		pLua->UpdateEventListeners();
+	const array<CLuaFile*> &apListeners = pLua->GetEventListeners(LUA_EVENT_ON_INPUT_LEVEL);
+	for(int ijdfg = 0; ijdfg < apListeners.size(); ijdfg++)
 	{
-		CLuaFile *pLF = CLua::Client()->Lua()->GetLuaFiles()[ijdfg];
+		CLuaFile *pLF = apListeners[ijdfg];
 		if(pLF->State() != CLuaFile::STATE_LOADED)
 			continue;
 		luabridge::LuaRef EventTable(pLF->L());
@@ -24,10 +28,10 @@ bool CLuaComponent::OnInput(IInput::CEvent Event)
 		EventTable["Flags"] = Event.m_Flags;
 		EventTable["Text"] = std::string(Event.m_aText);
 		EventTable["InputCount"] = Event.m_InputCount;
-		LuaRef lfunc = pLF->GetFunc("OnInputLevel");
-		if(lfunc) try { result |= lfunc(m_Level, Input()->KeyName(Event.m_Key), EventTable).cast<bool>(); CLua::Client()->LuaCheckDrawingState(pLF->L(), "OnInputLevel"); } catch(std::exception &e) { CLua::Client()->Lua()->HandleException(e, pLF); }
+		const LuaRef &lfunc = pLF->EventHandlers()->Handler(LUA_EVENT_ON_INPUT_LEVEL);
+		try { result |= lfunc(m_Level, Input()->KeyName(Event.m_Key), EventTable).cast<bool>(); CLua::Client()->LuaCheckDrawingState(pLF->L(), "OnInputLevel"); } catch(std::exception &e) { pLua->HandleException(e, pLF); }
 	}
-	if(CGameConsole::m_pStatLuaConsole->m_LuaHandler.m_pDebugChild == NULL)
+	if(CGameConsole::m_pStatLuaConsole->m_LuaHandler.m_pDebugChild == NULL && CGameConsole::m_pStatLuaConsole->m_LuaHandler.m_EventHandlers.Handles(LUA_EVENT_ON_INPUT_LEVEL))
 	{
 		lua_State *L = CGameConsole::m_pStatLuaConsole->m_LuaHandler.m_pLuaState;
 		luabridge::LuaRef EventTable(L);
@@ -36,8 +40,8 @@ bool CLuaComponent::OnInput(IInput::CEvent Event)
 		EventTable["Flags"] = Event.m_Flags;
 		EventTable["Text"] = std::string(Event.m_aText);
 		EventTable["InputCount"] = Event.m_InputCount;
-		LuaRef confunc = getGlobal(L, "OnInputLevel");
-		if(confunc) try { result |= confunc(m_Level, Input()->KeyName(Event.m_Key), EventTable).cast<bool>(); } catch(std::exception &e) { CLua::Client()->Lua()->HandleException(e, L); }
+		const LuaRef &confunc = CGameConsole::m_pStatLuaConsole->m_LuaHandler.m_EventHandlers.Handler(LUA_EVENT_ON_INPUT_LEVEL);
+		try { result |= confunc(m_Level, Input()->KeyName(Event.m_Key), EventTable).cast<bool>(); } catch(std::exception &e) { pLua->HandleException(e, L); }
 	}
 
 	return result;
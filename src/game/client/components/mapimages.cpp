@@ -1,5 +1,6 @@
 /* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <engine/engine.h>
 #include <engine/graphics.h>
 #include <engine/map.h>
 #include <engine/storage.h>
@@ -19,7 +20,23 @@ CMapImages::CMapImages()
 void CMapImages::OnMapLoad()
 {
 	IMap *pMap = Kernel()->RequestInterface<IMap>();
+	LoadImages(pMap);
+}
+
+void CMapImages::LoadBackground(class IMap *pMap)
+{
+	LoadImages(pMap);
+}
 
+int CMapImages::DecodeImageJob(void *pUser)
+{
+	CImageJob *pJob = (CImageJob *)pUser;
+	pJob->m_Loaded = pJob->m_pGraphics->LoadPNG(&pJob->m_Info, pJob->m_aPath, IStorageTW::TYPE_ALL);
+	return 0;
+}
+
+void CMapImages::LoadImages(class IMap *pMap)
+{
 	// unload all textures
 	for(int i = 0; i < m_Count; i++)
 	{
@@ -30,41 +47,22 @@ void CMapImages::OnMapLoad()
 
 	int Start;
 	pMap->GetType(MAPITEMTYPE_IMAGE, &Start, &m_Count);
+	m_Count = min(m_Count, (int)(sizeof(m_aTextures)/sizeof(m_aTextures[0])));
 
-	// load new textures
+	// start decoding the external ones
 	for(int i = 0; i < m_Count; i++)
 	{
-		m_aTextures[i] = 0;
-
 		CMapItemImage *pImg = (CMapItemImage *)pMap->GetItem(Start+i, 0, 0);
 		if(pImg->m_External)
 		{
-			char Buf[256];
+			CImageJob *pJob = &m_aImageJobs[i];
 			char *pName = (char *)pMap->GetData(pImg->m_ImageName);
-			str_format(Buf, sizeof(Buf), "mapres/%s.png", pName);
-			m_aTextures[i] = Graphics()->LoadTexture(Buf, IStorageTW::TYPE_ALL, CImageInfo::FORMAT_AUTO, 0);
-		}
-		else
-		{
-			void *pData = pMap->GetData(pImg->m_ImageData);
-			m_aTextures[i] = Graphics()->LoadTextureRaw(pImg->m_Width, pImg->m_Height, CImageInfo::FORMAT_RGBA, pData, CImageInfo::FORMAT_RGBA, 0);
-			pMap->UnloadData(pImg->m_ImageData);
+			str_format(pJob->m_aPath, sizeof(pJob->m_aPath), "mapres/%s.png", pName);
+			pJob->m_pGraphics = Graphics();
+			pJob->m_Loaded = false;
+			m_pClient->Engine()->AddJob(&pJob->m_Job, DecodeImageJob, pJob);
 		}
 	}
-}
-
-void CMapImages::LoadBackground(class IMap *pMap)
-{
-	// unload all textures
-	for(int i = 0; i < m_Count; i++)
-	{
-		Graphics()->UnloadTexture(m_aTextures[i]);
-		m_aTextures[i] = -1;
-	}
-	m_Count = 0;
-
-	int Start;
-	pMap->GetType(MAPITEMTYPE_IMAGE, &Start, &m_Count);
 
 	// load new textures
 	for(int i = 0; i < m_Count; i++)
@@ -72,20 +70,32 @@ void CMapImages::LoadBackground(class IMap *pMap)
 		m_aTextures[i] = 0;
 
 		CMapItemImage *pImg = (CMapItemImage *)pMap->GetItem(Start+i, 0, 0);
-		if(pImg->m_External)
-		{
-			char Buf[256];
-			char *pName = (char *)pMap->GetData(pImg->m_ImageName);
-			str_format(Buf, sizeof(Buf), "mapres/%s.png", pName);
-			m_aTextures[i] = Graphics()->LoadTexture(Buf, IStorageTW::TYPE_ALL, CImageInfo::FORMAT_AUTO, 0);
-		}
-		else
+		if(!pImg->m_External)
 		{
 			void *pData = pMap->GetData(pImg->m_ImageData);
 			m_aTextures[i] = Graphics()->LoadTextureRaw(pImg->m_Width, pImg->m_Height, CImageInfo::FORMAT_RGBA, pData, CImageInfo::FORMAT_RGBA, 0);
 			pMap->UnloadData(pImg->m_ImageData);
 		}
 	}
+
+	// and upload the external ones once they are done
+	for(int i = 0; i < m_Count; i++)
+	{
+		CMapItemImage *pImg = (CMapItemImage *)pMap->GetItem(Start+i, 0, 0);
+		if(!pImg->m_External)
+			continue;
+
+		CImageJob *pJob = &m_aImageJobs[i];
+		while(pJob->m_Job.Status() != CJob::STATE_DONE)
+			thread_sleep(1);
+		if(pJob->m_Loaded)
+		{
+			m_aTextures[i] = Graphics()->LoadTextureRaw(pJob->m_Info.m_Width, pJob->m_Info.m_Height, pJob->m_Info.m_Format, pJob->m_Info.m_pData, pJob->m_Info.m_Format, 0);
+			mem_free(pJob->m_Info.m_pData);
+		}
+		else // fails again and hands out the invalid texture
+			m_aTextures[i] = Graphics()->LoadTexture(pJob->m_aPath, IStorageTW::TYPE_ALL, CImageInfo::FORMAT_AUTO, 0);
+	}
 }
 
 int CMapImages::GetEntities()
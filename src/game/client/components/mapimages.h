@@ -2,6 +2,8 @@
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 #ifndef GAME_CLIENT_COMPONENTS_MAPIMAGES_H
 #define GAME_CLIENT_COMPONENTS_MAPIMAGES_H
+#include <engine/graphics.h>
+#include <engine/shared/jobs.h>
 #include <game/client/component.h>
 
 class CMapImages : public CComponent
@@ -11,6 +13,20 @@ class CMapImages : public CComponent
 	int m_aTextures[128];
 	int m_Count;
 
+	// external images are decoded on the job threads while the embedded ones are uploaded
+	struct CImageJob
+	{
+		CJob m_Job;
+		IGraphics *m_pGraphics;
+		char m_aPath[256];
+		CImageInfo m_Info;
+		bool m_Loaded;
+	};
+	CImageJob m_aImageJobs[128];
+
+	static int DecodeImageJob(void *pUser);
+	void LoadImages(class IMap *pMap);
+
 public:
 	CMapImages();
 
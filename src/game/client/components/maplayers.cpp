@@ -25,6 +25,8 @@ CMapLayers::CMapLayers(int t)
 	m_CurrentLocalTick = 0;
 	m_LastLocalTick = 0;
 	m_EnvelopeUpdate = false;
+	m_paLayerCaches = 0;
+	m_NumLayerCaches = 0;
 }
 
 void CMapLayers::OnInit()
@@ -32,6 +34,115 @@ void CMapLayers::OnInit()
 	m_pLayers = Layers();
 }
 
+void CMapLayers::ClearLayerCaches()
+{
+	for(int i = 0; i < m_NumLayerCaches; i++)
+	{
+		RenderTools()->DestroyTilemapCache(&m_paLayerCaches[i].m_Tilemap);
+		delete [] m_paLayerCaches[i].m_pConvertedTiles;
+	}
+	delete [] m_paLayerCaches;
+	m_paLayerCaches = 0;
+	m_NumLayerCaches = 0;
+}
+
+CTilemapCache *CMapLayers::LayerCache(int Layer, CMapItemLayerTilemap *pTMap, int Type, const void *pData)
+{
+	if(Layer >= m_NumLayerCaches)
+	{
+		ClearLayerCaches();
+		int Start;
+		m_pLayers->Map()->GetType(MAPITEMTYPE_LAYER, &Start, &m_NumLayerCaches);
+		m_NumLayerCaches = max(m_NumLayerCaches, Layer+1);
+		m_paLayerCaches = new CLayerCache[m_NumLayerCaches];
+		for(int i = 0; i < m_NumLayerCaches; i++)
+		{
+			m_paLayerCaches[i].m_pSource = 0;
+			m_paLayerCaches[i].m_pConvertedTiles = 0;
+		}
+	}
+
+	CLayerCache *pCache = &m_paLayerCaches[Layer];
+	if(pCache->m_pSource == pData)
+		return &pCache->m_Tilemap;
+
+	// the layer changed, build it again
+	delete [] pCache->m_pConvertedTiles;
+	pCache->m_pConvertedTiles = 0;
+	pCache->m_pSource = pData;
+
+	const int Num = pTMap->m_Width*pTMap->m_Height;
+	const CTile *pTiles = (const CTile *)pData;
+	if(Type != CACHE_TILES)
+	{
+		pCache->m_pConvertedTiles = new CTile[Num];
+		mem_zero(pCache->m_pConvertedTiles, sizeof(CTile)*Num);
+		for(int i = 0; i < Num; i++)
+		{
+			CTile *pTile = &pCache->m_pConvertedTiles[i];
+			if(Type == CACHE_TELE)
+				pTile->m_Index = ((const CTeleTile *)pData)[i].m_Type;
+			else if(Type == CACHE_SPEEDUP)
+				pTile->m_Index = ((const CSpeedupTile *)pData)[i].m_Type;
+			else if(Type == CACHE_TUNE)
+				pTile->m_Index = ((const CTuneTile *)pData)[i].m_Type;
+			else if(Type == CACHE_SWITCH)
+			{
+				const CSwitchTile *pSwitch = &((const CSwitchTile *)pData)[i];
+				pTile->m_Index = pSwitch->m_Type == TILE_SWITCHTIMEDOPEN ? 8 : pSwitch->m_Type;
+				pTile->m_Flags = pSwitch->m_Flags;
+			}
+		}
+		pTiles = pCache->m_pConvertedTiles;
+	}
+
+	RenderTools()->CreateTilemapCache(&pCache->m_Tilemap, pTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, Type == CACHE_SWITCH);
+	return &pCache->m_Tilemap;
+}
+
+void CMapLayers::OnMapLoad()
+{
+	ClearLayerCaches();
+
+	// build the layers this component draws now, the entity overlays when they are first shown
+	bool PassedGameLayer = false;
+	for(int g = 0; g < m_pLayers->NumGroups(); g++)
+	{
+		CMapItemGroup *pGroup = m_pLayers->GetGroup(g);
+		if(!pGroup)
+			continue;
+
+		for(int l = 0; l < pGroup->m_NumLayers; l++)
+		{
+			CMapItemLayer *pLayer = m_pLayers->GetLayer(pGroup->m_StartLayer+l);
+			if(!pLayer)
+				continue;
+
+			if(pLayer == (CMapItemLayer*)m_pLayers->GameLayer())
+			{
+				PassedGameLayer = true;
+				continue;
+			}
+
+			if(m_Type == TYPE_BACKGROUND && PassedGameLayer)
+				return;
+			if(m_Type == TYPE_FOREGROUND && !PassedGameLayer)
+				continue;
+
+			if(pLayer->m_Type != LAYERTYPE_TILES || pLayer == (CMapItemLayer*)m_pLayers->FrontLayer() ||
+				pLayer == (CMapItemLayer*)m_pLayers->SwitchLayer() || pLayer == (CMapItemLayer*)m_pLayers->TeleLayer() ||
+				pLayer == (CMapItemLayer*)m_pLayers->SpeedupLayer() || pLayer == (CMapItemLayer*)m_pLayers->TuneLayer())
+				continue;
+
+			CMapItemLayerTilemap *pTMap = (CMapItemLayerTilemap *)pLayer;
+			CTile *pTiles = (CTile *)m_pLayers->Map()->GetData(pTMap->m_Data);
+			unsigned int Size = m_pLayers->Map()->GetDataSize(pTMap->m_Data);
+			if(Size >= pTMap->m_Width*pTMap->m_Height*sizeof(CTile))
+				LayerCache(pGroup->m_StartLayer+l, pTMap, CACHE_TILES, pTiles);
+		}
+	}
+}
+
 void CMapLayers::EnvelopeUpdate()
 {
 	if(Client()->State() == IClient::STATE_DEMOPLAYBACK)
@@ -274,7 +385,8 @@ void CMapLayers::OnRender()
 							Color = vec4(pTMap->m_Color.r/255.0f, pTMap->m_Color.g/255.0f, pTMap->m_Color.b/255.0f, pTMap->m_Color.a/255.0f*g_Config.m_ClOverlayEntities/100.0f);
 						if(!IsGameLayer && g_Config.m_ClOverlayEntities)
 							Color = vec4(pTMap->m_Color.r/255.0f, pTMap->m_Color.g/255.0f, pTMap->m_Color.b/255.0f, pTMap->m_Color.a/255.0f*(100-g_Config.m_ClOverlayEntities)/100.0f);
-						RenderTools()->RenderTilemap(pTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_OPAQUE,
+						CTilemapCache *pCache = LayerCache(pGroup->m_StartLayer+l, pTMap, CACHE_TILES, pTiles);
+						RenderTools()->RenderTilemapCached(pCache, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_OPAQUE,
 														EnvelopeEval, this, pTMap->m_ColorEnv, pTMap->m_ColorEnvOffset);
 						Graphics()->BlendNormal();
 						
@@ -292,7 +404,7 @@ void CMapLayers::OnRender()
 							                                   EnvelopeEval, this, pTMap->m_ColorEnv, pTMap->m_ColorEnvOffset);
 						}
 						
-						RenderTools()->RenderTilemap(pTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_TRANSPARENT,
+						RenderTools()->RenderTilemapCached(pCache, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_TRANSPARENT,
 														EnvelopeEval, this, pTMap->m_ColorEnv, pTMap->m_ColorEnvOffset);
 					}
 				}
@@ -324,10 +436,11 @@ void CMapLayers::OnRender()
 				{
 					Graphics()->BlendNone();
 					vec4 Color = vec4(pTMap->m_Color.r/255.0f, pTMap->m_Color.g/255.0f, pTMap->m_Color.b/255.0f, pTMap->m_Color.a/255.0f*g_Config.m_ClOverlayEntities/100.0f);
-					RenderTools()->RenderTilemap(pFrontTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_OPAQUE,
+					CTilemapCache *pCache = LayerCache(pGroup->m_StartLayer+l, pTMap, CACHE_TILES, pFrontTiles);
+					RenderTools()->RenderTilemapCached(pCache, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_OPAQUE,
 							EnvelopeEval, this, pTMap->m_ColorEnv, pTMap->m_ColorEnvOffset);
 					Graphics()->BlendNormal();
-					RenderTools()->RenderTilemap(pFrontTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_TRANSPARENT,
+					RenderTools()->RenderTilemapCached(pCache, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_TRANSPARENT,
 							EnvelopeEval, this, pTMap->m_ColorEnv, pTMap->m_ColorEnvOffset);
 				}
 			}
@@ -343,9 +456,10 @@ void CMapLayers::OnRender()
 				{
 					Graphics()->BlendNone();
 					vec4 Color = vec4(pTMap->m_Color.r/255.0f, pTMap->m_Color.g/255.0f, pTMap->m_Color.b/255.0f, pTMap->m_Color.a/255.0f*g_Config.m_ClOverlayEntities/100.0f);
-					RenderTools()->RenderSwitchmap(pSwitchTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_OPAQUE);
+					CTilemapCache *pCache = LayerCache(pGroup->m_StartLayer+l, pTMap, CACHE_SWITCH, pSwitchTiles);
+					RenderTools()->RenderTilemapCached(pCache, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_OPAQUE, EnvelopeEval, this, -1, 0);
 					Graphics()->BlendNormal();
-					RenderTools()->RenderSwitchmap(pSwitchTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_TRANSPARENT);
+					RenderTools()->RenderTilemapCached(pCache, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_TRANSPARENT, EnvelopeEval, this, -1, 0);
 					RenderTools()->RenderSwitchOverlay(pSwitchTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, g_Config.m_ClOverlayEntities/100.0f);
 				}
 			}
@@ -361,9 +475,10 @@ void CMapLayers::OnRender()
 				{
 					Graphics()->BlendNone();
 					vec4 Color = vec4(pTMap->m_Color.r/255.0f, pTMap->m_Color.g/255.0f, pTMap->m_Color.b/255.0f, pTMap->m_Color.a/255.0f*g_Config.m_ClOverlayEntities/100.0f);
-					RenderTools()->RenderTelemap(pTeleTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_OPAQUE);
+					CTilemapCache *pCache = LayerCache(pGroup->m_StartLayer+l, pTMap, CACHE_TELE, pTeleTiles);
+					RenderTools()->RenderTilemapCached(pCache, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_OPAQUE, EnvelopeEval, this, -1, 0);
 					Graphics()->BlendNormal();
-					RenderTools()->RenderTelemap(pTeleTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_TRANSPARENT);
+					RenderTools()->RenderTilemapCached(pCache, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_TRANSPARENT, EnvelopeEval, this, -1, 0);
 					RenderTools()->RenderTeleOverlay(pTeleTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, g_Config.m_ClOverlayEntities/100.0f);
 				}
 			}
@@ -379,9 +494,10 @@ void CMapLayers::OnRender()
 				{
 					Graphics()->BlendNone();
 					vec4 Color = vec4(pTMap->m_Color.r/255.0f, pTMap->m_Color.g/255.0f, pTMap->m_Color.b/255.0f, pTMap->m_Color.a/255.0f*g_Config.m_ClOverlayEntities/100.0f);
-					RenderTools()->RenderSpeedupmap(pSpeedupTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_OPAQUE);
+					CTilemapCache *pCache = LayerCache(pGroup->m_StartLayer+l, pTMap, CACHE_SPEEDUP, pSpeedupTiles);
+					RenderTools()->RenderTilemapCached(pCache, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_OPAQUE, EnvelopeEval, this, -1, 0);
 					Graphics()->BlendNormal();
-					RenderTools()->RenderSpeedupmap(pSpeedupTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_TRANSPARENT);
+					RenderTools()->RenderTilemapCached(pCache, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_TRANSPARENT, EnvelopeEval, this, -1, 0);
 					RenderTools()->RenderSpeedupOverlay(pSpeedupTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, g_Config.m_ClOverlayEntities/100.0f);
 				}
 			}
@@ -397,9 +513,10 @@ void CMapLayers::OnRender()
 				{
 					Graphics()->BlendNone();
 					vec4 Color = vec4(pTMap->m_Color.r/255.0f, pTMap->m_Color.g/255.0f, pTMap->m_Color.b/255.0f, pTMap->m_Color.a/255.0f*g_Config.m_ClOverlayEntities/100.0f);
-					RenderTools()->RenderTunemap(pTuneTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_OPAQUE);
+					CTilemapCache *pCache = LayerCache(pGroup->m_StartLayer+l, pTMap, CACHE_TUNE, pTuneTiles);
+					RenderTools()->RenderTilemapCached(pCache, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_OPAQUE, EnvelopeEval, this, -1, 0);
 					Graphics()->BlendNormal();
-					RenderTools()->RenderTunemap(pTuneTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_TRANSPARENT);
+					RenderTools()->RenderTilemapCached(pCache, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_TRANSPARENT, EnvelopeEval, this, -1, 0);
 					//RenderTools()->RenderTuneOverlay(pTuneTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, g_Config.m_ClOverlayEntities/100.0f);
 				}
 			}
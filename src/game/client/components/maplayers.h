@@ -3,6 +3,7 @@
 #ifndef GAME_CLIENT_COMPONENTS_MAPLAYERS_H
 #define GAME_CLIENT_COMPONENTS_MAPLAYERS_H
 #include <game/client/component.h>
+#include <game/client/render.h>
 
 class CMapLayers : public CComponent
 {
@@ -14,6 +15,28 @@ class CMapLayers : public CComponent
 	int m_LastLocalTick;
 	bool m_EnvelopeUpdate;
 
+	enum
+	{
+		CACHE_TILES=0,
+		CACHE_TELE,
+		CACHE_SPEEDUP,
+		CACHE_SWITCH,
+		CACHE_TUNE,
+	};
+
+	// prebuilt geometry for the tile layers, indexed like the map layers
+	struct CLayerCache
+	{
+		const void *m_pSource; // the layer data the cache was built from
+		CTile *m_pConvertedTiles; // the special layers turned into normal tiles
+		CTilemapCache m_Tilemap;
+	};
+	CLayerCache *m_paLayerCaches;
+	int m_NumLayerCaches;
+
+	void ClearLayerCaches();
+	CTilemapCache *LayerCache(int Layer, CMapItemLayerTilemap *pTMap, int Type, const void *pData);
+
 	void MapScreenToGroup(float CenterX, float CenterY, CMapItemGroup *pGroup, float Zoom = 1.0f);
 public:
 	enum
@@ -24,6 +47,7 @@ public:
 
 	CMapLayers(int Type);
 	virtual void OnInit();
+	virtual void OnMapLoad();
 	virtual void OnRender();
 
 	void EnvelopeUpdate();
@@ -2394,7 +2394,7 @@ void CMenus::RenderBackground()
 	Graphics()->QuadsEnd();
 
 	// EVENT CALL
-	LUA_FIRE_EVENT("OnRenderBackground");
+	LUA_FIRE_EVENT(LUA_EVENT_ON_RENDER_BACKGROUND);
 
 	// restore screen
 	{CUIRect Screen = *UI()->Screen();
@@ -250,6 +250,7 @@ void CMenus::RenderServerbrowserServerList(CUIRect View)
 	if(s_WantedScrollValue < 0) s_WantedScrollValue = 0;
 	if(s_WantedScrollValue > 1) s_WantedScrollValue = 1;
 	smooth_set(&s_ScrollValue, s_WantedScrollValue, 27.0f, Client()->RenderFrameTime());
+	ServerBrowser()->SetVisibleRange((int)(s_ScrollValue*ScrollNum), Num);
 
 	// set clipping
 	UI()->ClipEnable(&View);
@@ -21,18 +21,9 @@ CParticles::CParticles()
 void CParticles::OnReset()
 {
 	// reset particles
-	for(int i = 0; i < MAX_PARTICLES; i++)
-	{
-		m_aParticles[i].m_PrevPart = i-1;
-		m_aParticles[i].m_NextPart = i+1;
-	}
-
-	m_aParticles[0].m_PrevPart = 0;
-	m_aParticles[MAX_PARTICLES-1].m_NextPart = -1;
-	m_FirstFree = 0;
-
 	for(int i = 0; i < NUM_GROUPS; i++)
-		m_aFirstPart[i] = -1;
+		m_aGroups[i].m_Num = 0;
+	m_NumParticles = 0;
 }
 
 void CParticles::Add(int Group, CParticle *pPart)
@@ -51,27 +42,12 @@ void CParticles::Add(int Group, CParticle *pPart)
 			return;
 	}
 
-	if (m_FirstFree == -1)
+	// all groups share the same budget
+	if(m_NumParticles >= MAX_PARTICLES)
 		return;
 
-	// remove from the free list
-	int Id = m_FirstFree;
-	m_FirstFree = m_aParticles[Id].m_NextPart;
-	if(m_FirstFree != -1)
-		m_aParticles[m_FirstFree].m_PrevPart = -1;
-
-	// copy data
-	m_aParticles[Id] = *pPart;
-
-	// insert to the group list
-	m_aParticles[Id].m_PrevPart = -1;
-	m_aParticles[Id].m_NextPart = m_aFirstPart[Group];
-	if(m_aFirstPart[Group] != -1)
-		m_aParticles[m_aFirstPart[Group]].m_PrevPart = Id;
-	m_aFirstPart[Group] = Id;
-
-	// set some parameters
-	m_aParticles[Id].m_Life = 0;
+	if(m_aGroups[Group].Add(pPart))
+		m_NumParticles++;
 }
 
 void CParticles::Update(float TimePassed)
@@ -91,48 +67,11 @@ void CParticles::Update(float TimePassed)
 		FrictionFraction -= 0.05f;
 	}
 
+	m_NumParticles = 0;
 	for(int g = 0; g < NUM_GROUPS; g++)
 	{
-		int i = m_aFirstPart[g];
-		while(i != -1)
-		{
-			int Next = m_aParticles[i].m_NextPart;
-			//m_aParticles[i].vel += flow_get(m_aParticles[i].pos)*time_passed * m_aParticles[i].flow_affected;
-			m_aParticles[i].m_Vel.y += m_aParticles[i].m_Gravity*TimePassed;
-
-			for(int f = 0; f < FrictionCount; f++) // apply friction
-				m_aParticles[i].m_Vel *= m_aParticles[i].m_Friction;
-
-			// move the point
-			vec2 Vel = m_aParticles[i].m_Vel*TimePassed;
-			Collision()->MovePoint(&m_aParticles[i].m_Pos, &Vel, 0.1f+0.9f*frandom(), NULL);
-			m_aParticles[i].m_Vel = Vel* (1.0f/TimePassed);
-
-			m_aParticles[i].m_Life += TimePassed;
-			m_aParticles[i].m_Rot += TimePassed * m_aParticles[i].m_Rotspeed;
-
-			// check particle death
-			if(m_aParticles[i].m_Life > m_aParticles[i].m_LifeSpan)
-			{
-				// remove it from the group list
-				if(m_aParticles[i].m_PrevPart != -1)
-					m_aParticles[m_aParticles[i].m_PrevPart].m_NextPart = m_aParticles[i].m_NextPart;
-				else
-					m_aFirstPart[g] = m_aParticles[i].m_NextPart;
-
-				if(m_aParticles[i].m_NextPart != -1)
-					m_aParticles[m_aParticles[i].m_NextPart].m_PrevPart = m_aParticles[i].m_PrevPart;
-
-				// insert to the free list
-				if(m_FirstFree != -1)
-					m_aParticles[m_FirstFree].m_PrevPart = i;
-				m_aParticles[i].m_PrevPart = -1;
-				m_aParticles[i].m_NextPart = m_FirstFree;
-				m_FirstFree = i;
-			}
-
-			i = Next;
-		}
+		m_aGroups[g].Update(TimePassed, FrictionCount, Collision()->SolidMap());
+		m_NumParticles += m_aGroups[g].m_Num;
 	}
 }
 
@@ -166,32 +105,42 @@ void CParticles::RenderGroup(int Group)
 {
 	CALLSTACK_ADD();
 
+	const CParticleGroup *pGroup = &m_aGroups[Group];
+	if(pGroup->m_Num == 0)
+		return;
+
 	Graphics()->BlendNormal();
 	//gfx_blend_additive();
 	Graphics()->TextureSet(g_pData->m_aImages[IMAGE_PARTICLES].m_Id);
 	Graphics()->QuadsBegin();
 
-	int i = m_aFirstPart[Group];
-	while(i != -1)
+	// newest first, the way they were always drawn
+	enum { SPRITE_BATCH=512 };
+	IGraphics::CSpriteItem aSprites[SPRITE_BATCH];
+	int NumSprites = 0;
+	for(int i = pGroup->m_Num-1; i >= 0; i--)
 	{
-		RenderTools()->SelectSprite(m_aParticles[i].m_Spr);
-		float a = m_aParticles[i].m_Life / m_aParticles[i].m_LifeSpan;
-		vec2 p = m_aParticles[i].m_Pos;
-		float Size = mix(m_aParticles[i].m_StartSize, m_aParticles[i].m_EndSize, a);
-
-		Graphics()->QuadsSetRotation(m_aParticles[i].m_Rot);
-
-		Graphics()->SetColor(
-			m_aParticles[i].m_Color.r,
-			m_aParticles[i].m_Color.g,
-			m_aParticles[i].m_Color.b,
-			m_aParticles[i].m_Color.a); // pow(a, 0.75f) *
-
-		IGraphics::CQuadItem QuadItem(p.x, p.y, Size, Size);
-		Graphics()->QuadsDraw(&QuadItem, 1);
-
-		i = m_aParticles[i].m_NextPart;
+		IGraphics::CSpriteItem *pSprite = &aSprites[NumSprites++];
+		float a = pGroup->m_aLife[i] / pGroup->m_aLifeSpan[i];
+		pSprite->m_X = pGroup->m_aPosX[i];
+		pSprite->m_Y = pGroup->m_aPosY[i];
+		pSprite->m_Size = mix(pGroup->m_aStartSize[i], pGroup->m_aEndSize[i], a);
+		pSprite->m_Rotation = pGroup->m_aRot[i];
+		RenderTools()->GetSpriteSubset(pGroup->m_aSpr[i], pSprite->m_aUvs);
+		pSprite->m_R = pGroup->m_aColor[i].r;
+		pSprite->m_G = pGroup->m_aColor[i].g;
+		pSprite->m_B = pGroup->m_aColor[i].b;
+		pSprite->m_A = pGroup->m_aColor[i].a; // pow(a, 0.75f) *
+
+		if(NumSprites == SPRITE_BATCH)
+		{
+			Graphics()->QuadsDrawSprites(aSprites, NumSprites);
+			NumSprites = 0;
+		}
 	}
+	if(NumSprites)
+		Graphics()->QuadsDrawSprites(aSprites, NumSprites);
+
 	Graphics()->QuadsEnd();
 	Graphics()->BlendNormal();
 }
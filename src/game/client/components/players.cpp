@@ -830,9 +830,9 @@ void CPlayers::RenderPlayer(
 		}
 	}
 
-	LUA_FIRE_EVENT("PreRenderPlayer", pInfo.m_ClientID, Position.x, Position.y, Direction.x, Direction.y, OtherTeam);
+	LUA_FIRE_EVENT(LUA_EVENT_PRE_RENDER_PLAYER, pInfo.m_ClientID, Position.x, Position.y, Direction.x, Direction.y, OtherTeam);
 	RenderTools()->RenderTee(&State, &RenderInfo, Player.m_Emote, Direction, Position, OtherTeam);
-	LUA_FIRE_EVENT("PostRenderPlayer", pInfo.m_ClientID, Position.x, Position.y, Direction.x, Direction.y, OtherTeam);
+	LUA_FIRE_EVENT(LUA_EVENT_POST_RENDER_PLAYER, pInfo.m_ClientID, Position.x, Position.y, Direction.x, Direction.y, OtherTeam);
 
 	m_pClient->m_aClients[pInfo.m_ClientID].m_ATH |=
 			   (m_pClient->m_Snap.m_aCharacters[pInfo.m_ClientID].m_Cur.m_PlayerFlags&PLAYERFLAG_ATH1) &&
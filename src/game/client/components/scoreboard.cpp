@@ -676,7 +676,7 @@ void CScoreboard::OnRender()
 	Graphics()->MapScreen(0, 0, Width, Height);
 
 	// EVENT CALL
-	LUA_FIRE_EVENT("OnRenderScoreboard", m_FadeVal);
+	LUA_FIRE_EVENT(LUA_EVENT_ON_RENDER_SCOREBOARD, m_FadeVal);
 
 	float w = 700.0f;
 
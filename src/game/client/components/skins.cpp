@@ -3,6 +3,7 @@
 #include <base/system.h>
 #include <base/math.h>
 
+#include <engine/engine.h>
 #include <engine/graphics.h>
 #include <engine/storage.h>
 #include <engine/shared/config.h>
@@ -47,35 +48,26 @@ int CSkins::CSkin::GetOrgTexture() const
 }
 
 
-void CSkins::LoadTexturesImpl(CSkin *pSkin)
+void CSkins::DecodeSkin(CSkinLoadJob *pJob)
 {
-	if(g_Config.m_Debug)
-		dbg_msg("skins", "loading texture for skin '%s' from '%s'", pSkin->GetName(), pSkin->m_FileInfo.m_aFullPath);
-
-	CImageInfo Info;
-	if(!Graphics()->LoadPNG(&Info, pSkin->m_FileInfo.m_aFullPath, pSkin->m_FileInfo.m_DirType))
-	{
-		// it failed to load, set the textures to default
-		pSkin->m_ColorTexture = m_apSkins[0]->m_ColorTexture;//m_DefaultSkinColorTexture;//CSkin::SKIN_TEXTURE_NOT_FOUND;
-		pSkin->m_OrgTexture = m_apSkins[0]->m_OrgTexture;//m_DefaultSkinOrgTexture;//CSkin::SKIN_TEXTURE_NOT_FOUND;
-		Console()->Printf(IConsole::OUTPUT_LEVEL_ADDINFO, "game", "failed to load skin from %s", pSkin->m_FileInfo.m_aFullPath);
-		// rename invalid downloaded skins so we don't try to load them again
-		if(str_comp_nocase_num(pSkin->m_FileInfo.m_aFullPath, "downloadedskins", 15) == 0)
-		{
-			char aBuf[512];
-			str_formatb(aBuf, "%s.FAIL", pSkin->m_FileInfo.m_aFullPath);
-			Storage()->RenameFile(pSkin->m_FileInfo.m_aFullPath, aBuf, IStorageTW::TYPE_SAVE);
-		}
+	CSkin *pSkin = pJob->m_pSkin;
+	pJob->m_HasColor = false;
+	pJob->m_pColorData = 0;
+	pJob->m_Loaded = Graphics()->LoadPNG(&pJob->m_Info, pSkin->m_FileInfo.m_aFullPath, pSkin->m_FileInfo.m_DirType);
+	if(!pJob->m_Loaded)
 		return;
-	}
-
-	pSkin->m_OrgTexture = Graphics()->LoadTextureRaw(Info.m_Width, Info.m_Height, Info.m_Format, Info.m_pData, Info.m_Format, 0);
 
+	CImageInfo &Info = pJob->m_Info;
 	int BodySize = 96; // body size
 	if (BodySize > Info.m_Height)
 		return;
 
-	unsigned char *d = (unsigned char *)Info.m_pData;
+	// the colorless version is made from a copy, both get uploaded later
+	int Step = Info.m_Format == CImageInfo::FORMAT_RGBA ? 4 : 3;
+	pJob->m_HasColor = true;
+	pJob->m_pColorData = mem_alloc(Info.m_Width*Info.m_Height*Step, 1);
+	mem_copy(pJob->m_pColorData, Info.m_pData, Info.m_Width*Info.m_Height*Step);
+	unsigned char *d = (unsigned char *)pJob->m_pColorData;
 	int Pitch = Info.m_Width*4;
 
 	// dig out blood color
@@ -92,12 +84,9 @@ void CSkins::LoadTexturesImpl(CSkin *pSkin)
 				}
 			}
 
-		pSkin->m_BloodColor = normalize(vec3(aColors[0], aColors[1], aColors[2]));
+		pJob->m_BloodColor = normalize(vec3(aColors[0], aColors[1], aColors[2]));
 	}
 
-	// create colorless version
-	int Step = Info.m_Format == CImageInfo::FORMAT_RGBA ? 4 : 3;
-
 	// make the texture gray scale
 	for(int i = 0; i < Info.m_Width*Info.m_Height; i++)
 	{
@@ -141,14 +130,99 @@ void CSkins::LoadTexturesImpl(CSkin *pSkin)
 			d[y*Pitch+x*4+1] = v;
 			d[y*Pitch+x*4+2] = v;
 		}
+}
 
-	pSkin->m_ColorTexture = Graphics()->LoadTextureRaw(Info.m_Width, Info.m_Height, Info.m_Format, Info.m_pData, Info.m_Format, 0);
+void CSkins::UploadSkin(CSkinLoadJob *pJob)
+{
+	CSkin *pSkin = pJob->m_pSkin;
+	if(!pJob->m_Loaded)
+	{
+		// it failed to load, set the textures to default. the first skin might still be loading itself
+		const CSkin *pDefault = m_pDefaultSkin && m_pDefaultSkin != pSkin ? m_pDefaultSkin : m_apSkins[0];
+		pSkin->m_ColorTexture = pDefault->m_ColorTexture;//m_DefaultSkinColorTexture;//CSkin::SKIN_TEXTURE_NOT_FOUND;
+		pSkin->m_OrgTexture = pDefault->m_OrgTexture;//m_DefaultSkinOrgTexture;//CSkin::SKIN_TEXTURE_NOT_FOUND;
+		Console()->Printf(IConsole::OUTPUT_LEVEL_ADDINFO, "game", "failed to load skin from %s", pSkin->m_FileInfo.m_aFullPath);
+		// rename invalid downloaded skins so we don't try to load them again
+		if(str_comp_nocase_num(pSkin->m_FileInfo.m_aFullPath, "downloadedskins", 15) == 0)
+		{
+			char aBuf[512];
+			str_formatb(aBuf, "%s.FAIL", pSkin->m_FileInfo.m_aFullPath);
+			Storage()->RenameFile(pSkin->m_FileInfo.m_aFullPath, aBuf, IStorageTW::TYPE_SAVE);
+		}
+		return;
+	}
+
+	CImageInfo &Info = pJob->m_Info;
+	pSkin->m_OrgTexture = Graphics()->LoadTextureRaw(Info.m_Width, Info.m_Height, Info.m_Format, Info.m_pData, Info.m_Format, 0);
 	mem_free(Info.m_pData);
+	if(!pJob->m_HasColor)
+		return;
+
+	pSkin->m_BloodColor = pJob->m_BloodColor;
+	pSkin->m_ColorTexture = Graphics()->LoadTextureRaw(Info.m_Width, Info.m_Height, Info.m_Format, pJob->m_pColorData, Info.m_Format, 0);
+	mem_free(pJob->m_pColorData);
 
 	if(g_Config.m_Debug)
 		Console()->Printf(IConsole::OUTPUT_LEVEL_ADDINFO, "game", "loaded skin texture for '%s'", pSkin->m_aName);
 }
 
+int CSkins::DecodeSkinJob(void *pUser)
+{
+	CSkinLoadJob *pJob = (CSkinLoadJob *)pUser;
+	pJob->m_pSkins->DecodeSkin(pJob);
+	return 0;
+}
+
+void CSkins::UpdateLoadJobs(bool Wait)
+{
+	int NumLeft = 0;
+	for(int i = 0; i < m_apLoadJobs.size(); i++)
+	{
+		CSkinLoadJob *pJob = m_apLoadJobs[i];
+		if(Wait)
+		{
+			while(pJob->m_Job.Status() != CJob::STATE_DONE)
+				thread_sleep(1);
+		}
+		else if(pJob->m_Job.Status() != CJob::STATE_DONE)
+		{
+			m_apLoadJobs[NumLeft++] = pJob;
+			continue;
+		}
+
+		UploadSkin(pJob);
+		delete pJob;
+	}
+	m_apLoadJobs.set_size(NumLeft);
+}
+
+void CSkins::QueueLoadJob(CSkin *pSkin)
+{
+	if(g_Config.m_Debug)
+		dbg_msg("skins", "queueing texture for skin '%s' from '%s'", pSkin->GetName(), pSkin->m_FileInfo.m_aFullPath);
+
+	pSkin->m_ColorTexture = CSkin::SKIN_TEXTURE_LOADING;
+	pSkin->m_OrgTexture = CSkin::SKIN_TEXTURE_LOADING;
+
+	CSkinLoadJob *pJob = new CSkinLoadJob;
+	pJob->m_pSkins = this;
+	pJob->m_pSkin = pSkin;
+	m_apLoadJobs.add(pJob);
+	m_pClient->Engine()->AddJob(&pJob->m_Job, DecodeSkinJob, pJob);
+}
+
+void CSkins::LoadTexturesImpl(CSkin *pSkin)
+{
+	if(g_Config.m_Debug)
+		dbg_msg("skins", "loading texture for skin '%s' from '%s'", pSkin->GetName(), pSkin->m_FileInfo.m_aFullPath);
+
+	CSkinLoadJob Job;
+	Job.m_pSkins = this;
+	Job.m_pSkin = pSkin;
+	DecodeSkin(&Job);
+	UploadSkin(&Job);
+}
+
 
 int CSkins::SkinScan(const char *pName, int IsDir, int DirType, void *pUser)
 {
@@ -189,29 +263,28 @@ int CSkins::SkinScan(const char *pName, int IsDir, int DirType, void *pUser)
 	pSkin->m_FileInfo.m_DirType = DirType;
 	str_formatb(pSkin->m_FileInfo.m_aFullPath, "%s/%s", pLoadHelper->pFullDir, pName);
 
-	if(g_Config.m_ClThreadskinloading)
-	{
-		// textures are being loaded on-demand; later when skin is needed
-		pSkin->m_OrgTexture = CSkin::SKIN_TEXTURE_NOT_LOADED;
-		pSkin->m_ColorTexture = CSkin::SKIN_TEXTURE_NOT_LOADED;
-	}
-	else
-	{
-		// textures are loaded right away at client start
-		pSelf->LoadTexturesImpl(pSkin);
-	}
-
 	// set skin data
 	str_copy(pSkin->m_aName, pName, min((int)sizeof(pSkin->m_aName),l-3));
 
-	// always load textures for default skin as replacement for skin textures that are currently being loaded
 	if(str_comp_nocase(pSkin->m_aName, "default") == 0)
 	{
+		// always load textures for default skin as replacement for skin textures that are currently being loaded
 		pSelf->m_pDefaultSkin = pSkin;
 		pSelf->LoadTexturesImpl(pSkin);
 //		pSelf->m_DefaultSkinColorTexture = pSkin->m_ColorTexture;
 //		pSelf->m_DefaultSkinOrgTexture = pSkin->m_OrgTexture;
 	}
+	else if(g_Config.m_ClThreadskinloading)
+	{
+		// textures are being loaded on-demand; later when skin is needed
+		pSkin->m_OrgTexture = CSkin::SKIN_TEXTURE_NOT_LOADED;
+		pSkin->m_ColorTexture = CSkin::SKIN_TEXTURE_NOT_LOADED;
+	}
+	else
+	{
+		// textures are decoded right away on the job threads, RefreshSkinList waits for them
+		pSelf->QueueLoadJob(pSkin);
+	}
 
 	LOCK_SECTION_MUTEX(pSelf->m_SkinsLock);
 	pSelf->m_apSkins.add(pSkin);
@@ -238,6 +311,10 @@ void CSkins::RefreshSkinList(bool clear)
 	if(clear)
 		Clear();
 
+	int64 StartTime = time_get();
+	CGraphicsStats StartStats;
+	Graphics()->GetStats(&StartStats);
+
 	IStorageTW::CLoadHelper<CSkins> *pLoadHelper = new IStorageTW::CLoadHelper<CSkins>;
 	pLoadHelper->pSelf = this;
 
@@ -250,6 +327,15 @@ void CSkins::RefreshSkinList(bool clear)
 		Storage()->ListDirectory(IStorageTW::TYPE_SAVE, "downloadedskins", SkinScan, pLoadHelper);
 	}
 
+	// upload what the job threads decoded in the meantime
+	UpdateLoadJobs(true);
+
+	CGraphicsStats Stats;
+	Graphics()->GetStats(&Stats);
+	dbg_msg("skins", "loaded %d skins in %.2f ms, %d decoded, %d from the image cache", Num(),
+		(time_get()-StartTime)*1000.0f/time_freq(), (int)(Stats.m_NumImagesDecoded-StartStats.m_NumImagesDecoded),
+		(int)(Stats.m_NumImagesFromCache-StartStats.m_NumImagesFromCache));
+
 	LOCK_SECTION_MUTEX(m_SkinsLock);
 	if(m_apSkins.empty())
 	{
@@ -283,12 +369,8 @@ void CSkins::Clear()
 {
 	CALLSTACK_ADD();
 
-	if(m_ThreadRunning)
-	{
-		dbg_msg("skins/debug", "waiting for loader thread to finish before clearing...");
-		thread_wait(m_pThread);
-		m_pThread = NULL;
-	}
+	// the jobs still point at the skins
+	UpdateLoadJobs(true);
 
 	LOCK_SECTION_MUTEX(m_SkinsLock);
 
@@ -317,24 +399,13 @@ vec4 CSkins::GetColorV4(int v)
 	return vec4(r.r, r.g, r.b, 1.0f);
 }
 
-void CSkins::LoadTexturesThreaded(CSkins::CSkin *pSkin)
+void CSkins::OnRender()
 {
-	if(m_ThreadRunning)
-		return;
-
-	LOCK_SECTION_MUTEX(m_SkinsLock);
-
-	pSkin->m_ColorTexture = CSkin::SKIN_TEXTURE_LOADING;
-	pSkin->m_OrgTexture = CSkin::SKIN_TEXTURE_LOADING;
-
-	m_ThreadRunning = true;
-	m_pThread = thread_init_named(CSkins::LoadTexturesThreadProxy, pSkin, "skin_loader");
+	if(m_apLoadJobs.size())
+		UpdateLoadJobs(false);
 }
 
-void CSkins::LoadTexturesThreadProxy(void *pUser)
+void CSkins::LoadTexturesThreaded(CSkins::CSkin *pSkin)
 {
-	CSkin *pSkin = (CSkin*)pUser;
-	CSkins *pSelf = pSkin->m_pSkins;
-	pSelf->LoadTexturesImpl(pSkin);
-	pSelf->m_ThreadRunning = false;
+	QueueLoadJob(pSkin);
 }
@@ -3,9 +3,11 @@
 #ifndef GAME_CLIENT_COMPONENTS_SKINS_H
 #define GAME_CLIENT_COMPONENTS_SKINS_H
 #include <mutex>
-#include <atomic>
 #include <base/vmath.h>
+#include <base/tl/array.h>
 #include <base/tl/sorted_array.h>
+#include <engine/graphics.h>
+#include <engine/shared/jobs.h>
 #include <game/client/component.h>
 
 class CSkins : public CComponent
@@ -54,6 +56,7 @@ public:
 	};
 
 	void OnInit();
+	virtual void OnRender();
 	void RefreshSkinList(bool clear = true);
 
 	vec3 GetColorV3(int v);
@@ -81,11 +84,29 @@ private:
 
 	static int SkinScan(const char *pName, int IsDir, int DirType, void *pUser);
 
-	void *m_pThread;
-	std::atomic<bool> m_ThreadRunning;
+	// the png is decoded and the colorless version is made on the job threads,
+	// only the texture upload is left for the main thread
+	class CSkinLoadJob
+	{
+	public:
+		CJob m_Job;
+		CSkins *m_pSkins;
+		CSkin *m_pSkin;
+		bool m_Loaded;
+		bool m_HasColor;
+		CImageInfo m_Info;
+		void *m_pColorData;
+		vec3 m_BloodColor;
+	};
+	array<CSkinLoadJob *> m_apLoadJobs; // main thread only
+
+	void DecodeSkin(CSkinLoadJob *pJob);
+	void UploadSkin(CSkinLoadJob *pJob);
+	static int DecodeSkinJob(void *pUser);
+	void UpdateLoadJobs(bool Wait);
+	void QueueLoadJob(CSkin *pSkin);
 	void LoadTexturesImpl(CSkin *pSkin);
 	void LoadTexturesThreaded(CSkin *pSkin);
-	static void LoadTexturesThreadProxy(void *pUser);
 };
 
 #endif
@@ -4,6 +4,11 @@
 #include <base/system.h>
 #include <base/tl/sorted_array.h>
 
+#include <typeinfo>
+#if defined(__GNUC__)
+	#include <cxxabi.h>
+#endif
+
 #include <engine/editor.h>
 #include <engine/engine.h>
 #include <engine/friends.h>
@@ -178,6 +183,8 @@ void CGameClient::ResetDummyInput()
 
 void CGameClient::OnConsoleInit()
 {
+	mem_zero(&m_RenderBenchmark, sizeof(m_RenderBenchmark));
+
 	m_pEngine = Kernel()->RequestInterface<IEngine>();
 	m_pClient = Kernel()->RequestInterface<IClient>();
 	m_pTextRender = Kernel()->RequestInterface<ITextRender>();
@@ -353,6 +360,8 @@ void CGameClient::OnConsoleInit()
 	// add the some console commands
 	Console()->Register("team", "i[team-id]", CFGFLAG_CLIENT, ConTeam, this, "Switch team");
 	Console()->Register("kill", "", CFGFLAG_CLIENT, ConKill, this, "Kill yourself");
+	Console()->Register("benchmark_render", "s[demo] ?i[quit]", CFGFLAG_CLIENT, ConBenchmarkRender, this, "Play a demo and report the cpu time spent rendering, best used with gfx_null_backend");
+	Console()->Register("benchmark_text", "?i[frames]", CFGFLAG_CLIENT, ConBenchmarkText, this, "Draw the text of a full scoreboard with and without the text layout cache, best used with gfx_null_backend");
 	if(!g_StealthMode)
 		Console()->Register("luafile", "s[activate|deactivate|toggle] s[filepath]", CFGFLAG_CLIENT, ConLuafile, this, "Toggle Luafiles (use their path)");
 	// register server dummy commands for tab completion
@@ -889,8 +898,13 @@ void CGameClient::OnRender()
 		UpdatePositions();
 
 	// render all systems
-	for(int i = 0; i < m_All.m_Num; i++)
-		m_All.m_paComponents[i]->OnRender();
+	if(m_RenderBenchmark.m_Active)
+		RenderBenchmarked();
+	else
+	{
+		for(int i = 0; i < m_All.m_Num; i++)
+			m_All.m_paComponents[i]->OnRender();
+	}
 
 	// clear all events/input for this frame
 	Input()->Clear();
@@ -944,6 +958,73 @@ void CGameClient::OnRender()
 	}
 }
 
+void CGameClient::RenderBenchmarked()
+{
+	// the demo ended or was paused at its end
+	if(Client()->State() != IClient::STATE_DEMOPLAYBACK || DemoPlayer()->BaseInfo()->m_Paused)
+	{
+		FinishRenderBenchmark();
+		for(int i = 0; i < m_All.m_Num; i++)
+			m_All.m_paComponents[i]->OnRender();
+		return;
+	}
+
+	int64 FrameStart = time_get();
+	for(int i = 0; i < m_All.m_Num; i++)
+	{
+		int64 Start = time_get();
+		m_All.m_paComponents[i]->OnRender();
+		m_RenderBenchmark.m_aComponentTime[i] += time_get()-Start;
+	}
+	int64 FrameTime = time_get()-FrameStart;
+
+	m_RenderBenchmark.m_NumFrames++;
+	m_RenderBenchmark.m_TotalTime += FrameTime;
+	m_RenderBenchmark.m_MaxTime = max(m_RenderBenchmark.m_MaxTime, FrameTime);
+}
+
+void CGameClient::FinishRenderBenchmark()
+{
+	m_RenderBenchmark.m_Active = false;
+	const int Frames = max(m_RenderBenchmark.m_NumFrames, 1);
+	const double Micro = 1000000.0/time_freq();
+	const double Total = max(m_RenderBenchmark.m_TotalTime, (int64)1);
+
+	dbg_msg("benchmark", "%d frames, %.1f us per frame, %.1f us max", m_RenderBenchmark.m_NumFrames,
+		m_RenderBenchmark.m_TotalTime*Micro/Frames, m_RenderBenchmark.m_MaxTime*Micro);
+
+	for(int i = 0; i < m_All.m_Num; i++)
+	{
+		// there are no names for the components, the type is the best there is
+		const char *pName = typeid(*m_All.m_paComponents[i]).name();
+#if defined(__GNUC__)
+		int Status;
+		char *pDemangled = abi::__cxa_demangle(pName, 0, 0, &Status);
+		if(Status == 0)
+			pName = pDemangled;
+#endif
+		dbg_msg("benchmark", "%-20s %8.1f us per frame, %5.1f%%", pName,
+			m_RenderBenchmark.m_aComponentTime[i]*Micro/Frames, m_RenderBenchmark.m_aComponentTime[i]*100.0/Total);
+#if defined(__GNUC__)
+		free(pDemangled);
+#endif
+	}
+
+	CGraphicsStats Stats;
+	Graphics()->GetStats(&Stats);
+	const CGraphicsStats &Start = m_RenderBenchmark.m_StartStats;
+	dbg_msg("benchmark", "per frame: %.1f buffers, %.1f commands, %.1f render commands, %.1f primitives, %.1f vertices",
+		(Stats.m_NumBuffers-Start.m_NumBuffers)/(double)Frames, (Stats.m_NumCommands-Start.m_NumCommands)/(double)Frames,
+		(Stats.m_NumRenderCommands-Start.m_NumRenderCommands)/(double)Frames, (Stats.m_NumPrimitives-Start.m_NumPrimitives)/(double)Frames,
+		(Stats.m_NumVertices-Start.m_NumVertices)/(double)Frames);
+	dbg_msg("benchmark", "texture uploads: %lld (%lld bytes), swaps: %lld",
+		Stats.m_NumTextureUploads-Start.m_NumTextureUploads, Stats.m_TextureUploadBytes-Start.m_TextureUploadBytes,
+		Stats.m_NumSwaps-Start.m_NumSwaps);
+
+	if(m_RenderBenchmark.m_QuitAfter)
+		Client()->Quit();
+}
+
 void CGameClient::OnDummyDisconnect()
 {
 	m_DDRaceMsgSent[1] = false;
@@ -1147,7 +1228,7 @@ void CGameClient::OnStateChange(int NewState, int OldState)
 		m_All.m_paComponents[i]->OnStateChange(NewState, OldState);
 
 	// EVENT CALL
-	LUA_FIRE_EVENT("OnStateChange", NewState, OldState);
+	LUA_FIRE_EVENT(LUA_EVENT_ON_STATE_CHANGE, NewState, OldState);
 }
 
 void CGameClient::OnShutdown()
@@ -1188,7 +1269,7 @@ void CGameClient::OnEnterGame()
 
 void CGameClient::OnGameOver()
 {
-	LUA_FIRE_EVENT("OnGameOver");
+	LUA_FIRE_EVENT(LUA_EVENT_ON_GAME_OVER);
 
 	if(Client()->State() != IClient::STATE_DEMOPLAYBACK && g_Config.m_ClEditor == 0)
 		Client()->AutoScreenshot_Start();
@@ -1196,7 +1277,7 @@ void CGameClient::OnGameOver()
 
 void CGameClient::OnStartGame()
 {
-	LUA_FIRE_EVENT("OnGameStart");
+	LUA_FIRE_EVENT(LUA_EVENT_ON_GAME_START);
 
 	if(Client()->State() != IClient::STATE_DEMOPLAYBACK)
 		Client()->DemoRecorder_HandleAutoStart();
@@ -1207,12 +1288,12 @@ void CGameClient::OnFlagGrab(int TeamID)
 {
 	if(TeamID == TEAM_RED)
 	{
-		LUA_FIRE_EVENT("OnFlagGrab", TeamID, m_Snap.m_pGameDataObj->m_FlagCarrierRed);
+		LUA_FIRE_EVENT(LUA_EVENT_ON_FLAG_GRAB, TeamID, m_Snap.m_pGameDataObj->m_FlagCarrierRed);
 		m_aStats[m_Snap.m_pGameDataObj->m_FlagCarrierRed].m_FlagGrabs++;
 	}
 	else
 	{
-		LUA_FIRE_EVENT("OnFlagGrab", TeamID, m_Snap.m_pGameDataObj->m_FlagCarrierBlue);
+		LUA_FIRE_EVENT(LUA_EVENT_ON_FLAG_GRAB, TeamID, m_Snap.m_pGameDataObj->m_FlagCarrierBlue);
 		m_aStats[m_Snap.m_pGameDataObj->m_FlagCarrierBlue].m_FlagGrabs++;
 	}
 }
@@ -1989,7 +2070,7 @@ void CGameClient::OnPredict()
 							pTarget->ApplyForce((vec2(0.f, -1.0f) + Temp) * Strength);
 							Hits++;
 
-							LUA_FIRE_EVENT("OnPredHammerHit", i);
+							LUA_FIRE_EVENT(LUA_EVENT_ON_PRED_HAMMER_HIT, i);
 						}
 						// if we Hit anything, we have to wait for the reload
 						if(Hits)
@@ -2360,6 +2441,97 @@ void CGameClient::ConKill(IConsole::IResult *pResult, void *pUserData)
 	((CGameClient*)pUserData)->SendKill();
 }
 
+void CGameClient::ConBenchmarkRender(IConsole::IResult *pResult, void *pUserData)
+{
+	CGameClient *pSelf = (CGameClient *)pUserData;
+	const char *pError = pSelf->Client()->DemoPlayer_Play(pResult->GetString(0), IStorageTW::TYPE_ALL);
+	if(pError)
+	{
+		dbg_msg("benchmark", "failed to play demo '%s': %s", pResult->GetString(0), pError);
+		return;
+	}
+
+	mem_zero(&pSelf->m_RenderBenchmark, sizeof(pSelf->m_RenderBenchmark));
+	pSelf->m_RenderBenchmark.m_Active = true;
+	pSelf->m_RenderBenchmark.m_QuitAfter = pResult->NumArguments() > 1 && pResult->GetInteger(1);
+	pSelf->Graphics()->GetStats(&pSelf->m_RenderBenchmark.m_StartStats);
+}
+
+// the text a scoreboard with 64 players draws, scores and pings change every now and then
+static void RenderScoreboardText(ITextRender *pTextRender, IGraphics *pGraphics, int Frame)
+{
+	static const char *s_apClans[] = {"", "clan", "[DDNet]", "Teeworlds", "abc"};
+	const float Height = 400*3.0f;
+	const float Width = Height*pGraphics->ScreenAspect();
+	const float FontSize = 16.0f;
+	pGraphics->MapScreen(0, 0, Width, Height);
+
+	for(int i = 0; i < 64; i++)
+	{
+		char aBuf[64];
+		CTextCursor Cursor;
+		float y = 100.0f + i*FontSize;
+
+		str_format(aBuf, sizeof(aBuf), "%d", (i*7 + Frame/50)%100);
+		float tw = pTextRender->TextWidth(0, FontSize, aBuf, -1);
+		pTextRender->SetCursor(&Cursor, 100.0f-tw, y, FontSize, TEXTFLAG_RENDER);
+		pTextRender->TextEx(&Cursor, aBuf, -1);
+
+		str_format(aBuf, sizeof(aBuf), "player number %d", i);
+		pTextRender->SetCursor(&Cursor, 120.0f, y, FontSize, TEXTFLAG_RENDER|TEXTFLAG_STOP_AT_END);
+		Cursor.m_LineWidth = 300.0f;
+		pTextRender->TextEx(&Cursor, aBuf, -1);
+
+		const char *pClan = s_apClans[i%(sizeof(s_apClans)/sizeof(s_apClans[0]))];
+		tw = pTextRender->TextWidth(0, FontSize, pClan, -1);
+		pTextRender->SetCursor(&Cursor, 500.0f-tw/2, y, FontSize, TEXTFLAG_RENDER|TEXTFLAG_STOP_AT_END);
+		Cursor.m_LineWidth = 200.0f;
+		pTextRender->TextEx(&Cursor, pClan, -1);
+
+		str_format(aBuf, sizeof(aBuf), "%d", 20 + (i*13 + Frame/25)%300);
+		tw = pTextRender->TextWidth(0, FontSize, aBuf, -1);
+		pTextRender->SetCursor(&Cursor, 700.0f-tw, y, FontSize, TEXTFLAG_RENDER|TEXTFLAG_STOP_AT_END);
+		Cursor.m_LineWidth = 65.0f;
+		pTextRender->TextEx(&Cursor, aBuf, -1);
+	}
+}
+
+void CGameClient::ConBenchmarkText(IConsole::IResult *pResult, void *pUserData)
+{
+	CGameClient *pSelf = (CGameClient *)pUserData;
+	const int Frames = pResult->NumArguments() ? max(pResult->GetInteger(0), 1) : 1000;
+	const double Micro = 1000000.0/time_freq();
+	const int OldLayoutCache = g_Config.m_GfxTextLayoutCache;
+
+	for(int Cache = 0; Cache < 2; Cache++)
+	{
+		g_Config.m_GfxTextLayoutCache = Cache;
+		CTextRenderStats Start, End;
+		pSelf->TextRender()->GetStats(&Start);
+
+		// only the text calls are timed, the swap waits for the backend
+		int64 Time = 0;
+		for(int f = 0; f < Frames; f++)
+		{
+			int64 FrameStart = time_get();
+			RenderScoreboardText(pSelf->TextRender(), pSelf->Graphics(), f);
+			Time += time_get()-FrameStart;
+			pSelf->Graphics()->Swap();
+		}
+
+		pSelf->TextRender()->GetStats(&End);
+		int64 LayoutHits = End.m_NumLayoutHits-Start.m_NumLayoutHits;
+		int64 Layouts = LayoutHits + End.m_NumLayoutMisses-Start.m_NumLayoutMisses;
+		int64 GlyphHits = End.m_NumGlyphHits-Start.m_NumGlyphHits;
+		int64 Glyphs = GlyphHits + End.m_NumGlyphMisses-Start.m_NumGlyphMisses;
+		dbg_msg("benchmark", "text layout cache %s: %.1f us per frame, %.1f%% of %lld layouts cached, %.1f%% of %lld glyphs cached, %lld glyphs evicted",
+			Cache ? "on" : "off", Time*Micro/Frames, LayoutHits*100.0/max(Layouts, (int64)1), Layouts,
+			GlyphHits*100.0/max(Glyphs, (int64)1), Glyphs, End.m_NumGlyphEvictions-Start.m_NumGlyphEvictions);
+	}
+
+	g_Config.m_GfxTextLayoutCache = OldLayoutCache;
+}
+
 void CGameClient::ConLuafile(IConsole::IResult *pResult, void *pUserData)
 {
 	if(pResult->NumArguments() < 2)
@@ -2761,3 +2933,21 @@ void CGameClient::FindWeaker(bool IsWeaker[2][MAX_CLIENTS])
 		IsWeaker[g_Config.m_ClDummy][HookedPlayer] = (s_aaDirAccumulated[g_Config.m_ClDummy][HookedPlayer] > 0);
 	}
 }
+
+luabridge::LuaRef CGameClient::LuaSearchServers(const char *pQuery, lua_State *L)
+{
+	// { {Info = <CServerInfo>, Hits = <QUICK_* flags>}, ... }
+	static const CServerInfo *s_apResults[1024];
+	static int s_aHits[1024];
+	int NumResults = CLua::m_pCGameClient->ServerBrowser()->Search(pQuery, s_apResults, s_aHits, 1024);
+
+	luabridge::LuaRef Results = luabridge::newTable(L);
+	for(int i = 0; i < NumResults; i++)
+	{
+		luabridge::LuaRef Result = luabridge::newTable(L);
+		Result["Info"] = s_apResults[i];
+		Result["Hits"] = s_aHits[i];
+		Results[i+1] = Result;
+	}
+	return Results;
+}
@@ -7,6 +7,7 @@
 #include <base/color.h> // this doesn't really belong here; it's for all the components
 #include <engine/client.h>
 #include <engine/console.h>
+#include <engine/graphics.h>
 #include <engine/serverbrowser.h>
 #include <game/layers.h>
 #include <game/gamecore.h>
@@ -133,9 +134,26 @@ protected:
 
 	int m_CheckInfo[2];
 
+	// cpu time spent on rendering while a demo plays, see ConBenchmarkRender
+	struct CRenderBenchmark
+	{
+		bool m_Active;
+		bool m_QuitAfter;
+		int m_NumFrames;
+		int64 m_TotalTime;
+		int64 m_MaxTime;
+		int64 m_aComponentTime[CStack::MAX_COMPONENTS];
+		CGraphicsStats m_StartStats;
+	} m_RenderBenchmark;
+
+	void RenderBenchmarked();
+	void FinishRenderBenchmark();
+
 	static void ConTeam(IConsole::IResult *pResult, void *pUserData);
 	static void ConKill(IConsole::IResult *pResult, void *pUserData);
 	static void ConLuafile(IConsole::IResult *pResult, void *pUserData);
+	static void ConBenchmarkRender(IConsole::IResult *pResult, void *pUserData);
+	static void ConBenchmarkText(IConsole::IResult *pResult, void *pUserData);
 
 	static void ConchainSpecialInfoupdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainSpecialDummyInfoupdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
@@ -441,6 +459,7 @@ public:
 	static CSnapState::CCharacterInfo * LuaGetCharacterInfo(int ID) { return &CLua::m_pCGameClient->m_Snap.m_aCharacters[ID]; }
 	static const CSnapState& LuaGetFullSnap() { return CLua::m_pCGameClient->m_Snap; }
 	static CTuningParams * LuaGetTuning() { return &CLua::m_pCGameClient->m_Tuning[g_Config.m_ClDummy]; }
+	static luabridge::LuaRef LuaSearchServers(const char *pQuery, lua_State *L);
 	
 private:
 	bool m_DDRaceMsgSent[2];
@@ -0,0 +1,202 @@
+#ifndef GAME_CLIENT_PARTICLEGROUP_H
+#define GAME_CLIENT_PARTICLEGROUP_H
+
+#include <base/math.h>
+#include <base/vmath.h>
+#include <game/solidmap.h>
+
+// particles
+struct CParticle
+{
+	void SetDefault()
+	{
+		m_Vel = vec2(0,0);
+		m_LifeSpan = 0;
+		m_StartSize = 32;
+		m_EndSize = 32;
+		m_Rot = 0;
+		m_Rotspeed = 0;
+		m_Gravity = 0;
+		m_Friction = 0;
+		m_FlowAffected = 1.0f;
+		m_Color = vec4(1,1,1,1);
+	}
+
+	vec2 m_Pos;
+	vec2 m_Vel;
+
+	int m_Spr;
+
+	float m_FlowAffected;
+
+	float m_LifeSpan;
+
+	float m_StartSize;
+	float m_EndSize;
+
+	float m_Rot;
+	float m_Rotspeed;
+
+	float m_Gravity;
+	float m_Friction;
+
+	vec4 m_Color;
+};
+
+// the particles of one group as a structure of arrays, in the order they were added
+class CParticleGroup
+{
+public:
+	enum
+	{
+		MAX_PARTICLES=1024*8,
+	};
+
+	int m_Num;
+
+	float m_aPosX[MAX_PARTICLES];
+	float m_aPosY[MAX_PARTICLES];
+	float m_aVelX[MAX_PARTICLES];
+	float m_aVelY[MAX_PARTICLES];
+	float m_aGravity[MAX_PARTICLES];
+	float m_aFriction[MAX_PARTICLES];
+	float m_aLife[MAX_PARTICLES];
+	float m_aLifeSpan[MAX_PARTICLES];
+	float m_aStartSize[MAX_PARTICLES];
+	float m_aEndSize[MAX_PARTICLES];
+	float m_aRot[MAX_PARTICLES];
+	float m_aRotspeed[MAX_PARTICLES];
+	vec4 m_aColor[MAX_PARTICLES];
+	int m_aSpr[MAX_PARTICLES];
+
+	unsigned m_BounceSeed;
+
+	CParticleGroup() : m_Num(0), m_BounceSeed(1) {}
+
+	bool Add(const CParticle *pPart)
+	{
+		if(m_Num == MAX_PARTICLES)
+			return false;
+
+		int i = m_Num++;
+		m_aPosX[i] = pPart->m_Pos.x;
+		m_aPosY[i] = pPart->m_Pos.y;
+		m_aVelX[i] = pPart->m_Vel.x;
+		m_aVelY[i] = pPart->m_Vel.y;
+		m_aGravity[i] = pPart->m_Gravity;
+		m_aFriction[i] = pPart->m_Friction;
+		m_aLife[i] = 0;
+		m_aLifeSpan[i] = pPart->m_LifeSpan;
+		m_aStartSize[i] = pPart->m_StartSize;
+		m_aEndSize[i] = pPart->m_EndSize;
+		m_aRot[i] = pPart->m_Rot;
+		m_aRotspeed[i] = pPart->m_Rotspeed;
+		m_aColor[i] = pPart->m_Color;
+		m_aSpr[i] = pPart->m_Spr;
+		return true;
+	}
+
+	// moves the particles, bounces them off solid tiles and drops the dead ones.
+	// friction is applied FrictionCount times, once for every 50 ms that passed
+	void Update(float TimePassed, int FrictionCount, const CSolidMap *pSolidMap)
+	{
+		const int Num = m_Num;
+
+		// the plain integration has no branches, so these loops vectorize
+		for(int i = 0; i < Num; i++)
+			m_aVelY[i] += m_aGravity[i]*TimePassed;
+
+		for(int f = 0; f < FrictionCount; f++)
+		{
+			for(int i = 0; i < Num; i++)
+			{
+				m_aVelX[i] *= m_aFriction[i];
+				m_aVelY[i] *= m_aFriction[i];
+			}
+		}
+
+		int NumDead = 0;
+		for(int i = 0; i < Num; i++)
+		{
+			m_aLife[i] += TimePassed;
+			m_aRot[i] += TimePassed*m_aRotspeed[i];
+			NumDead += m_aLife[i] > m_aLifeSpan[i];
+		}
+
+		// move the points, bouncing the way CCollision::MovePoint does
+		for(int i = 0; i < Num; i++)
+		{
+			float NewX = m_aPosX[i] + m_aVelX[i]*TimePassed;
+			float NewY = m_aPosY[i] + m_aVelY[i]*TimePassed;
+			if(!pSolidMap->CheckPoint(NewX, NewY))
+			{
+				m_aPosX[i] = NewX;
+				m_aPosY[i] = NewY;
+				continue;
+			}
+
+			// a cheap generator of our own, frandom goes through the locked rand()
+			m_BounceSeed = m_BounceSeed*1103515245+12345;
+			float Elasticity = 0.1f+0.9f*((m_BounceSeed>>8)/(float)(1<<24));
+			int Affected = 0;
+			if(pSolidMap->CheckPoint(NewX, m_aPosY[i]))
+			{
+				m_aVelX[i] *= -Elasticity;
+				Affected++;
+			}
+			if(pSolidMap->CheckPoint(m_aPosX[i], NewY))
+			{
+				m_aVelY[i] *= -Elasticity;
+				Affected++;
+			}
+			if(Affected == 0)
+			{
+				m_aVelX[i] *= -Elasticity;
+				m_aVelY[i] *= -Elasticity;
+			}
+		}
+
+		if(NumDead == 0)
+			return;
+
+		// close the gaps of the dead ones, keeping the order. one array after the other,
+		// they lie a power of two apart and would fight over the same cache sets otherwise
+		int First = 0;
+		while(m_aLife[First] <= m_aLifeSpan[First])
+			First++;
+		int Alive = First;
+		for(int i = First+1; i < Num; i++)
+		{
+			m_aKeep[Alive] = i;
+			Alive += m_aLife[i] <= m_aLifeSpan[i];
+		}
+
+		Compact(m_aPosX, First, Alive);
+		Compact(m_aPosY, First, Alive);
+		Compact(m_aVelX, First, Alive);
+		Compact(m_aVelY, First, Alive);
+		Compact(m_aGravity, First, Alive);
+		Compact(m_aFriction, First, Alive);
+		Compact(m_aLife, First, Alive);
+		Compact(m_aLifeSpan, First, Alive);
+		Compact(m_aStartSize, First, Alive);
+		Compact(m_aEndSize, First, Alive);
+		Compact(m_aRot, First, Alive);
+		Compact(m_aRotspeed, First, Alive);
+		Compact(m_aColor, First, Alive);
+		Compact(m_aSpr, First, Alive);
+		m_Num = Alive;
+	}
+
+private:
+	int m_aKeep[MAX_PARTICLES];
+
+	template<typename T>
+	void Compact(T *pArray, int First, int Num)
+	{
+		for(int i = First; i < Num; i++)
+			pArray[i] = pArray[m_aKeep[i]];
+	}
+};
+
+#endif
@@ -82,6 +82,23 @@ void CRenderTools::SelectSprite(int Id, int Flags, int sx, int sy)
 	SelectSprite(&g_pData->m_aSprites[Id], Flags, sx, sy);
 }
 
+void CRenderTools::GetSpriteSubset(int Id, float *pUvs)
+{
+	if(Id < 0 || Id >= g_pData->m_NumSprites)
+	{
+		pUvs[0] = 0.0f; pUvs[1] = 0.0f; pUvs[2] = 1.0f; pUvs[3] = 1.0f;
+		return;
+	}
+
+	CDataSprite *pSpr = &g_pData->m_aSprites[Id];
+	float cx = (float)pSpr->m_pSet->m_Gridx;
+	float cy = (float)pSpr->m_pSet->m_Gridy;
+	pUvs[0] = pSpr->m_X/cx;
+	pUvs[1] = pSpr->m_Y/cy;
+	pUvs[2] = (pSpr->m_X+pSpr->m_W)/cx;
+	pUvs[3] = (pSpr->m_Y+pSpr->m_H)/cy;
+}
+
 void CRenderTools::DrawSprite(float x, float y, float Size)
 {
 	IGraphics::CQuadItem QuadItem(x, y, Size*gs_SpriteWScale, Size*gs_SpriteHScale);
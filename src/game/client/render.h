@@ -4,6 +4,7 @@
 #define GAME_CLIENT_RENDER_H
 
 #include <base/vmath.h>
+#include <engine/graphics.h>
 #include <game/mapitems.h>
 #include "ui.h"
 
@@ -41,6 +42,37 @@ enum
 
 typedef void (*ENVELOPE_EVAL)(float TimeOffset, int Env, float *pChannels, void *pUser);
 
+// the quads of a tile layer, built once and kept by the graphics backend.
+// they are grouped into chunks of CHUNK_SIZE*CHUNK_SIZE tiles so only the visible part gets drawn
+class CTilemapCache
+{
+public:
+	enum
+	{
+		CHUNK_SIZE=32,
+	};
+
+	struct CChunk
+	{
+		int m_FirstQuad;
+		int m_NumOpaque; // the quads of opaque tiles come first
+		int m_NumQuads;
+		float m_TilesetScale; // the texture coordinates depend on the zoom, rebuilt when it changes
+	};
+
+	const CTile *m_pTiles;
+	int m_Width;
+	int m_Height;
+	float m_Scale;
+	bool m_SeparateOpaque; // opaque tiles are left out of the transparent pass
+	int m_NumChunksX;
+	int m_NumChunksY;
+	CChunk *m_pChunks;
+	int m_QuadBuffer;
+
+	CTilemapCache() : m_pTiles(0), m_pChunks(0), m_QuadBuffer(-1) {}
+};
+
 class CRenderTools
 {
 public:
@@ -55,6 +87,7 @@ public:
 	void SelectSprite(struct CDataSprite *pSprite, int Flags=0, int sx=0, int sy=0);
 	void SelectSprite(int id, int Flags=0, int sx=0, int sy=0);
 	void SelectSpriteLua(int id, int Flags=0, int sx=0, int sy=0) { SelectSprite(id, Flags, sx, sy); }
+	void GetSpriteSubset(int Id, float *pUvs); // u0, v0, u1, v1 without selecting the sprite
 
 	void DrawSprite(float x, float y, float size);
 
@@ -79,6 +112,11 @@ public:
 	void ForceRenderQuads(CQuad *pQuads, int NumQuads, int Flags, ENVELOPE_EVAL pfnEval, void *pUser, float Alpha = 1.0f);
 	void RenderTilemap(const CTile *pTiles, int w, int h, const float Scale, vec4 Color, const int RenderFlags, ENVELOPE_EVAL pfnEval, void *pUser, int ColorEnv, int ColorEnvOffset);
 
+	// same as RenderTilemap, but drawing the visible chunks of the cache instead of building the quads again
+	void CreateTilemapCache(CTilemapCache *pCache, const CTile *pTiles, int w, int h, float Scale, bool SeparateOpaque);
+	void DestroyTilemapCache(CTilemapCache *pCache);
+	void RenderTilemapCached(CTilemapCache *pCache, vec4 Color, int RenderFlags, ENVELOPE_EVAL pfnEval, void *pUser, int ColorEnv, int ColorEnvOffset);
+
 	// render a rectangle made of IndexIn tiles, over a background made of IndexOut tiles
 	// the rectangle include all tiles in [RectX, RectX+RectW-1] x [RectY, RectY+RectH-1]
 	void RenderTileRectangle(int RectX, int RectY, int RectW, int RectH, unsigned char IndexIn, unsigned char IndexOut, float Scale, vec4 Color, int RenderFlags, ENVELOPE_EVAL pfnEval, void *pUser, int ColorEnv, int ColorEnvOffset);
@@ -100,6 +138,7 @@ public:
 
 private:
 	inline void RenderTilemapPutTile(const CTile& Tile, int x, int y, float Scale, float FinalTilesetScale, int Index);
+	int BuildTilemapChunk(const CTilemapCache *pCache, int ChunkX, int ChunkY, float FinalTilesetScale, IGraphics::CQuadVertex *pVertices, int *pNumOpaque);
 };
 
 #endif
@@ -322,15 +322,14 @@ void CRenderTools::RenderTilemap(const CTile *pTiles, int w, int h, const float
 	Graphics()->MapScreen(ScreenX0, ScreenY0, ScreenX1, ScreenY1);
 }
 
-void CRenderTools::RenderTilemapPutTile(const CTile& Tile, int x, int y, float Scale, float FinalTilesetScale, int Index)
+// texture coordinates of the four corners of a tile, in the order QuadsSetSubsetFree takes them
+static void GetTileTexCoords(int Index, int Flags, float FinalTilesetScale, float *pCoords)
 {
 	// adjust the texture shift according to mipmap level
 	const float TexSize = 1024.0f;
 	const float Frac = (1.25f/TexSize) * (1/FinalTilesetScale);
 	const float Nudge = (0.5f/TexSize) * (1/FinalTilesetScale);
 
-	int Flags = Tile.m_Flags;
-
 	int tx = Index%16;
 	int ty = Index/16;
 	float Px0 = tx*(1024/16);
@@ -377,11 +376,243 @@ void CRenderTools::RenderTilemapPutTile(const CTile& Tile, int x, int y, float S
 		y1 = Tmp;
 	}
 
-	Graphics()->QuadsSetSubsetFree(x0, y0, x1, y1, x2, y2, x3, y3);
+	pCoords[0] = x0; pCoords[1] = y0;
+	pCoords[2] = x1; pCoords[3] = y1;
+	pCoords[4] = x2; pCoords[5] = y2;
+	pCoords[6] = x3; pCoords[7] = y3;
+}
+
+void CRenderTools::RenderTilemapPutTile(const CTile& Tile, int x, int y, float Scale, float FinalTilesetScale, int Index)
+{
+	float aCoords[8];
+	GetTileTexCoords(Index, Tile.m_Flags, FinalTilesetScale, aCoords);
+
+	Graphics()->QuadsSetSubsetFree(aCoords[0], aCoords[1], aCoords[2], aCoords[3], aCoords[4], aCoords[5], aCoords[6], aCoords[7]);
 	IGraphics::CQuadItem QuadItem(x*Scale, y*Scale, Scale, Scale);
 	Graphics()->QuadsDrawTL(&QuadItem, 1);
 }
 
+int CRenderTools::BuildTilemapChunk(const CTilemapCache *pCache, int ChunkX, int ChunkY, float FinalTilesetScale, IGraphics::CQuadVertex *pVertices, int *pNumOpaque)
+{
+	const int StartX = ChunkX*CTilemapCache::CHUNK_SIZE;
+	const int StartY = ChunkY*CTilemapCache::CHUNK_SIZE;
+	const int EndX = min(StartX+(int)CTilemapCache::CHUNK_SIZE, pCache->m_Width);
+	const int EndY = min(StartY+(int)CTilemapCache::CHUNK_SIZE, pCache->m_Height);
+	const float Scale = pCache->m_Scale;
+
+	// opaque tiles in the first round, the rest in the second
+	int NumQuads = 0;
+	for(int Round = 0; Round < 2; Round++)
+	{
+		for(int y = StartY; y < EndY; y++)
+			for(int x = StartX; x < EndX; x++)
+			{
+				const CTile &Tile = pCache->m_pTiles[x + y*pCache->m_Width];
+				if(!Tile.m_Index || ((Tile.m_Flags&TILEFLAG_OPAQUE) != 0) != (Round == 0))
+					continue;
+
+				if(pVertices)
+				{
+					float aCoords[8];
+					GetTileTexCoords(Tile.m_Index, Tile.m_Flags, FinalTilesetScale, aCoords);
+
+					IGraphics::CQuadVertex *pQuad = &pVertices[NumQuads*4];
+					pQuad[0].m_X = x*Scale;			pQuad[0].m_Y = y*Scale;
+					pQuad[1].m_X = (x+1)*Scale;		pQuad[1].m_Y = y*Scale;
+					pQuad[2].m_X = (x+1)*Scale;		pQuad[2].m_Y = (y+1)*Scale;
+					pQuad[3].m_X = x*Scale;			pQuad[3].m_Y = (y+1)*Scale;
+					for(int i = 0; i < 4; i++)
+					{
+						pQuad[i].m_U = aCoords[i*2];
+						pQuad[i].m_V = aCoords[i*2+1];
+					}
+				}
+				NumQuads++;
+			}
+
+		if(Round == 0)
+			*pNumOpaque = NumQuads;
+	}
+
+	return NumQuads;
+}
+
+void CRenderTools::CreateTilemapCache(CTilemapCache *pCache, const CTile *pTiles, int w, int h, float Scale, bool SeparateOpaque)
+{
+	DestroyTilemapCache(pCache);
+
+	pCache->m_pTiles = pTiles;
+	pCache->m_Width = w;
+	pCache->m_Height = h;
+	pCache->m_Scale = Scale;
+	pCache->m_SeparateOpaque = SeparateOpaque;
+	pCache->m_NumChunksX = (w+CTilemapCache::CHUNK_SIZE-1)/CTilemapCache::CHUNK_SIZE;
+	pCache->m_NumChunksY = (h+CTilemapCache::CHUNK_SIZE-1)/CTilemapCache::CHUNK_SIZE;
+	pCache->m_pChunks = new CTilemapCache::CChunk[pCache->m_NumChunksX*pCache->m_NumChunksY];
+
+	// the texture coordinates are made for the default zoom, chunks seen with a different one get rebuilt
+	float aPoints[4];
+	MapscreenToWorld(0, 0, 1, 1, 0, 0, Graphics()->ScreenAspect(), 1.0f, aPoints);
+	const float FinalTilesetScale = Scale/(aPoints[2]-aPoints[0]) * Graphics()->ScreenWidth() / (1024/32.0f);
+
+	int NumQuads = 0;
+	for(int i = 0; i < pCache->m_NumChunksX*pCache->m_NumChunksY; i++)
+	{
+		CTilemapCache::CChunk *pChunk = &pCache->m_pChunks[i];
+		pChunk->m_FirstQuad = NumQuads;
+		pChunk->m_NumQuads = BuildTilemapChunk(pCache, i%pCache->m_NumChunksX, i/pCache->m_NumChunksX, FinalTilesetScale, 0, &pChunk->m_NumOpaque);
+		pChunk->m_TilesetScale = FinalTilesetScale;
+		NumQuads += pChunk->m_NumQuads;
+	}
+
+	if(NumQuads == 0)
+		return;
+
+	IGraphics::CQuadVertex *pVertices = new IGraphics::CQuadVertex[NumQuads*4];
+	for(int i = 0; i < pCache->m_NumChunksX*pCache->m_NumChunksY; i++)
+	{
+		int NumOpaque;
+		BuildTilemapChunk(pCache, i%pCache->m_NumChunksX, i/pCache->m_NumChunksX, FinalTilesetScale, &pVertices[pCache->m_pChunks[i].m_FirstQuad*4], &NumOpaque);
+	}
+	pCache->m_QuadBuffer = Graphics()->CreateQuadBuffer(pVertices, NumQuads);
+	delete [] pVertices;
+}
+
+void CRenderTools::DestroyTilemapCache(CTilemapCache *pCache)
+{
+	Graphics()->DeleteQuadBuffer(pCache->m_QuadBuffer);
+	delete [] pCache->m_pChunks;
+	pCache->m_pTiles = 0;
+	pCache->m_pChunks = 0;
+	pCache->m_QuadBuffer = -1;
+}
+
+void CRenderTools::RenderTilemapCached(CTilemapCache *pCache, vec4 Color, int RenderFlags,
+                                       ENVELOPE_EVAL pfnEval, void *pUser, int ColorEnv, int ColorEnvOffset)
+{
+	const int w = pCache->m_Width;
+	const int h = pCache->m_Height;
+	const float Scale = pCache->m_Scale;
+
+	// out of quad buffers, draw it the old way
+	if(pCache->m_QuadBuffer < 0)
+	{
+		if(pCache->m_pTiles)
+			RenderTilemap(pCache->m_pTiles, w, h, Scale, Color, RenderFlags, pfnEval, pUser, ColorEnv, ColorEnvOffset);
+		return;
+	}
+
+	float ScreenX0, ScreenY0, ScreenX1, ScreenY1;
+	Graphics()->GetScreen(&ScreenX0, &ScreenY0, &ScreenX1, &ScreenY1);
+
+	// calculate the final pixelsize for the tiles
+	const float TilePixelSize = 1024/32.0f;
+	const float FinalTileSize = Scale/(ScreenX1-ScreenX0) * Graphics()->ScreenWidth();
+	const float FinalTilesetScale = FinalTileSize/TilePixelSize;
+
+	float r=1, g=1, b=1, a=1;
+	if(ColorEnv >= 0)
+	{
+		float aChannels[4];
+		pfnEval(ColorEnvOffset/1000.0f, ColorEnv, aChannels, pUser);
+		r = aChannels[0];
+		g = aChannels[1];
+		b = aChannels[2];
+		a = aChannels[3];
+	}
+	const vec4 FinalColor = vec4(Color.r*r, Color.g*g, Color.b*b, Color.a*a);
+
+	// which part of the chunks this pass draws
+	const bool ColorOpaque = FinalColor.a > 254.0f/255.0f;
+	const bool Transparent = (RenderFlags&LAYERRENDERFLAG_TRANSPARENT) != 0;
+	const bool DrawOpaque = (Transparent && !pCache->m_SeparateOpaque) ||
+		((RenderFlags&LAYERRENDERFLAG_OPAQUE) && (pCache->m_SeparateOpaque || ColorOpaque));
+	if(!DrawOpaque && !Transparent)
+		return;
+
+	int StartY = (int)(ScreenY0/Scale)-1;
+	int StartX = (int)(ScreenX0/Scale)-1;
+	int EndY = (int)(ScreenY1/Scale)+1;
+	int EndX = (int)(ScreenX1/Scale)+1;
+
+	if(max(StartX, 0) < min(EndX, w) && max(StartY, 0) < min(EndY, h))
+	{
+		static IGraphics::CQuadVertex s_aChunkVertices[CTilemapCache::CHUNK_SIZE*CTilemapCache::CHUNK_SIZE*4];
+
+		const int StartChunkX = max(StartX, 0)/CTilemapCache::CHUNK_SIZE;
+		const int StartChunkY = max(StartY, 0)/CTilemapCache::CHUNK_SIZE;
+		const int EndChunkX = (min(EndX, w)-1)/CTilemapCache::CHUNK_SIZE;
+		const int EndChunkY = (min(EndY, h)-1)/CTilemapCache::CHUNK_SIZE;
+
+		for(int cy = StartChunkY; cy <= EndChunkY; cy++)
+		{
+			// neighbouring chunks follow each other in the buffer, draw them in one go where possible
+			int First = 0;
+			int Num = 0;
+			for(int cx = StartChunkX; cx <= EndChunkX; cx++)
+			{
+				CTilemapCache::CChunk *pChunk = &pCache->m_pChunks[cx + cy*pCache->m_NumChunksX];
+				if(pChunk->m_NumQuads == 0)
+					continue;
+
+				if(pChunk->m_TilesetScale != FinalTilesetScale)
+				{
+					int NumOpaque;
+					BuildTilemapChunk(pCache, cx, cy, FinalTilesetScale, s_aChunkVertices, &NumOpaque);
+					Graphics()->UpdateQuadBuffer(pCache->m_QuadBuffer, pChunk->m_FirstQuad, s_aChunkVertices, pChunk->m_NumQuads);
+					pChunk->m_TilesetScale = FinalTilesetScale;
+				}
+
+				int ChunkFirst = pChunk->m_FirstQuad + (DrawOpaque ? 0 : pChunk->m_NumOpaque);
+				int ChunkNum = (Transparent ? pChunk->m_NumQuads : pChunk->m_NumOpaque) - (DrawOpaque ? 0 : pChunk->m_NumOpaque);
+				if(ChunkNum == 0)
+					continue;
+
+				if(Num && First+Num == ChunkFirst)
+					Num += ChunkNum;
+				else
+				{
+					Graphics()->RenderQuadBuffer(pCache->m_QuadBuffer, First, Num, FinalColor.r, FinalColor.g, FinalColor.b, FinalColor.a);
+					First = ChunkFirst;
+					Num = ChunkNum;
+				}
+			}
+			Graphics()->RenderQuadBuffer(pCache->m_QuadBuffer, First, Num, FinalColor.r, FinalColor.g, FinalColor.b, FinalColor.a);
+		}
+	}
+
+	// the border tiles repeated outside of the layer are few, those are still built every frame
+	if((RenderFlags&TILERENDERFLAG_EXTEND) && (StartX < 0 || StartY < 0 || EndX > w || EndY > h))
+	{
+		Graphics()->QuadsBegin();
+		Graphics()->SetColor(FinalColor.r, FinalColor.g, FinalColor.b, FinalColor.a);
+
+		for(int y = StartY; y < EndY; y++)
+		{
+			for(int x = StartX; x < EndX; x++)
+			{
+				// skip over the part the chunks cover
+				if(x >= 0 && x < w && y >= 0 && y < h)
+				{
+					x = w-1;
+					continue;
+				}
+
+				const CTile &Tile = pCache->m_pTiles[clamp(x, 0, w-1) + clamp(y, 0, h-1)*w];
+				if(!Tile.m_Index)
+					continue;
+
+				if(Tile.m_Flags&TILEFLAG_OPAQUE ? DrawOpaque : Transparent)
+					RenderTilemapPutTile(Tile, x, y, Scale, FinalTilesetScale, Tile.m_Index);
+			}
+		}
+
+		Graphics()->QuadsEnd();
+	}
+
+	Graphics()->MapScreen(ScreenX0, ScreenY0, ScreenX1, ScreenY1);
+}
+
 void CRenderTools::RenderTeleOverlay(CTeleTile *pTele, int w, int h, float Scale, float Alpha)
 {
 	if(!g_Config.m_ClTextEntities)
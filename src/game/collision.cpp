@@ -92,8 +92,11 @@ void CCollision::Init(class CLayers *pLayers)
 			m_pFront = static_cast<CTile *>(m_pLayers->Map()->GetData(m_pLayers->FrontLayer()->m_Front));
 	}
 
+	m_SolidMap.Init(m_Width, m_Height);
 	for(int i = 0; i < m_Width*m_Height; i++)
 	{
+		m_SolidMap.Set(i%m_Width, i/m_Width, m_pTiles[i].m_Index == TILE_SOLID || m_pTiles[i].m_Index == TILE_NOHOOK);
+
 		int Index;
 		if(m_pSwitch)
 		{
@@ -431,6 +434,7 @@ void CCollision::Dest()
 	m_Width = 0;
 	m_Height = 0;
 	m_pLayers = 0;
+	m_SolidMap.Clear();
 	m_pTele = 0;
 	m_pSpeedup = 0;
 	m_pFront = 0;
@@ -1133,6 +1137,7 @@ void CCollision::SetCollisionAt(float x, float y, int id)
 	int Ny = clamp(round_to_int(y)/32, 0, m_Height-1);
 
 	m_pTiles[Ny * m_Width + Nx].m_Index = id;
+	m_SolidMap.Set(Nx, Ny, id == TILE_SOLID || id == TILE_NOHOOK);
 }
 
 void CCollision::SetDCollisionAt(float x, float y, int Type, int Flags, int Number)
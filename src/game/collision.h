@@ -5,6 +5,7 @@
 
 #include <base/vmath.h>
 #include <engine/shared/protocol.h>
+#include <game/solidmap.h>
 
 #include <list>
 
@@ -14,15 +15,17 @@ class CCollision
 	int m_Width;
 	int m_Height;
 	class CLayers *m_pLayers;
+	CSolidMap m_SolidMap;
 
 public:
 	CCollision();
 	~CCollision();
 	void Init(class CLayers *pLayers);
-	bool CheckPoint(float x, float y) { return IsSolid(round_to_int(x), round_to_int(y)); }
+	bool CheckPoint(float x, float y) { return m_SolidMap.CheckPoint(x, y); }
 	bool CheckPoint(vec2 Pos) { return CheckPoint(Pos.x, Pos.y); }
 	bool CheckPointLua(vec2 Pos) { return CheckPoint(Pos.x, Pos.y); }
 	int GetCollisionAt(float x, float y) { return GetTile(round_to_int(x), round_to_int(y)); }
+	const CSolidMap *SolidMap() const { return &m_SolidMap; }
 	int GetWidth() const { return m_Width; };
 	int GetHeight() const { return m_Height; };
 	int IntersectLine(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision);
@@ -12,6 +12,7 @@
 #include <engine/shared/config.h>
 #include <engine/client.h>
 #include <engine/console.h>
+#include <engine/engine.h>
 #include <engine/graphics.h>
 #include <engine/input.h>
 #include <engine/keys.h>
@@ -173,7 +174,7 @@ void CLayerGroup::DeleteLayer(int Index)
 	delete m_lLayers[Index];
 	m_lLayers.remove_index(Index);
 	m_pMap->m_Modified = true;
-	m_pMap->m_UndoModified++;
+	m_pMap->m_UndoUntracked = true;
 }
 
 void CLayerGroup::GetSize(float *w, float *h)
@@ -194,7 +195,7 @@ int CLayerGroup::SwapLayers(int Index0, int Index1)
 	if(Index1 < 0 || Index1 >= m_lLayers.size()) return Index0;
 	if(Index0 == Index1) return Index0;
 	m_pMap->m_Modified = true;
-	m_pMap->m_UndoModified++;
+	m_pMap->m_UndoUntracked = true;
 	swap(m_lLayers[Index0], m_lLayers[Index1]);
 	return Index1;
 }
@@ -895,8 +896,6 @@ void CEditor::CallbackSaveMap(const char *pFileName, int StorageType, void *pUse
 		str_copy(pEditor->m_aFileName, pFileName, sizeof(pEditor->m_aFileName));
 		pEditor->m_ValidSaveFilename = StorageType == IStorageTW::TYPE_SAVE && pEditor->m_pFileDialogPath == pEditor->m_aFileDialogCurrentFolder;
 		pEditor->m_Map.m_Modified = false;
-		pEditor->m_Map.m_UndoModified = 0;
-		pEditor->m_LastUndoUpdateTime = time_get();
 	}
 
 	pEditor->m_Dialog = DIALOG_NONE;
@@ -917,8 +916,6 @@ void CEditor::CallbackSaveCopyMap(const char *pFileName, int StorageType, void *
 	if(pEditor->Save(pFileName))
 	{
 		pEditor->m_Map.m_Modified = false;
-		pEditor->m_Map.m_UndoModified = 0;
-		pEditor->m_LastUndoUpdateTime = time_get();
 	}
 
 	pEditor->m_Dialog = DIALOG_NONE;
@@ -978,6 +975,15 @@ void CEditor::DoToolbar(CUIRect ToolBar)
 		InvokeFileDialog(IStorageTW::TYPE_ALL, FILETYPE_MAP, "Load map", "Load", "maps", "", CallbackOpenMap, this);
 	}
 
+	// ctrl+z to undo, ctrl+y or ctrl+shift+z to redo
+	if(g_Config.m_ClEditorUndo && (Input()->KeyIsPressed(KEY_LCTRL) || Input()->KeyIsPressed(KEY_RCTRL)) && m_Dialog == DIALOG_NONE && !UI()->ActiveItem())
+	{
+		if(Input()->KeyPress(KEY_Y) || (Input()->KeyPress(KEY_Z) && (Input()->KeyIsPressed(KEY_LSHIFT) || Input()->KeyIsPressed(KEY_RSHIFT))))
+			Redo();
+		else if(Input()->KeyPress(KEY_Z))
+			Undo();
+	}
+
 	// detail button
 	TB_Top.VSplitLeft(40.0f, &Button, &TB_Top);
 	static int s_HqButton = 0;
@@ -1383,8 +1389,6 @@ void CEditor::DoSoundSource(CSoundSource *pSource, int Index)
 		{
 			if(!UI()->MouseButton(1))
 			{
-				m_Map.m_UndoModified++;
-
 				static int s_SourcePopupID = 0;
 				UiInvokePopupMenu(&s_SourcePopupID, 0, UI()->MouseX(), UI()->MouseY(), 120, 200, PopupSource);
 				m_LockMouse = false;
@@ -1396,11 +1400,6 @@ void CEditor::DoSoundSource(CSoundSource *pSource, int Index)
 		{
 			if(!UI()->MouseButton(0))
 			{
-				if(s_Operation == OP_MOVE)
-				{
-					m_Map.m_UndoModified++;
-				}
-
 				m_LockMouse = false;
 				s_Operation = OP_NONE;
 				UI()->SetActiveItem(0);
@@ -1576,8 +1575,6 @@ void CEditor::DoQuad(CQuad *q, int Index)
 		{
 			if(!UI()->MouseButton(1))
 			{
-				m_Map.m_UndoModified++;
-
 				static int s_QuadPopupID = 0;
 				UiInvokePopupMenu(&s_QuadPopupID, 0, UI()->MouseX(), UI()->MouseY(), 120, 180, PopupQuad);
 				m_LockMouse = false;
@@ -1589,7 +1586,6 @@ void CEditor::DoQuad(CQuad *q, int Index)
 		{
 			if(!UI()->MouseButton(1))
 			{
-				m_Map.m_UndoModified++;
 				m_LockMouse = false;
 				m_Map.m_Modified = true;
 				CLayerQuads *pLayer = (CLayerQuads *)GetSelectedLayerType(0, LAYERTYPE_QUADS);
@@ -1603,11 +1599,6 @@ void CEditor::DoQuad(CQuad *q, int Index)
 		{
 			if(!UI()->MouseButton(0))
 			{
-				if(s_Operation == OP_ROTATE || s_Operation == OP_MOVE_ALL || s_Operation == OP_MOVE_PIVOT)
-				{
-					m_Map.m_UndoModified++;
-				}
-
 				m_LockMouse = false;
 				s_Operation = OP_NONE;
 				UI()->SetActiveItem(0);
@@ -1782,8 +1773,6 @@ void CEditor::DoQuadPoint(CQuad *pQuad, int QuadIndex, int V)
 		{
 			if(!UI()->MouseButton(1))
 			{
-				m_Map.m_UndoModified++;
-
 				static int s_PointPopupID = 0;
 				UiInvokePopupMenu(&s_PointPopupID, 0, UI()->MouseX(), UI()->MouseY(), 120, 150, PopupPoint);
 				UI()->SetActiveItem(0);
@@ -1801,9 +1790,6 @@ void CEditor::DoQuadPoint(CQuad *pQuad, int QuadIndex, int V)
 						m_SelectedPoints = 1<<V;
 				}
 
-				if(s_Operation == OP_MOVEPOINT || s_Operation == OP_MOVEUV)
-					m_Map.m_UndoModified++;
-
 				m_LockMouse = false;
 				UI()->SetActiveItem(0);
 			}
@@ -2505,9 +2491,6 @@ void CEditor::DoMapEditor(CUIRect View, CUIRect ToolBar)
 			// release mouse
 			if(!UI()->MouseButton(0))
 			{
-				if(s_Operation == OP_BRUSH_DRAW || s_Operation == OP_BRUSH_PAINT)
-					m_Map.m_UndoModified++;
-
 				s_Operation = OP_NONE;
 				UI()->SetActiveItem(0);
 			}
@@ -4214,10 +4197,9 @@ void CEditor::RenderStatusbar(CUIRect View)
 
 void CEditor::RenderUndoList(CUIRect View)
 {
-	CUIRect List, Preview, Scroll, Button;
-	View.VSplitMid(&List, &Preview);
+	CUIRect List, Info, Scroll, Button;
+	View.VSplitMid(&List, &Info);
 	List.VSplitRight(15.0f, &List, &Scroll);
-	//int Num = (int)(List.h/17.0f)+1;
 	static int ScrollBar = 0;
 	Scroll.HMargin(5.0f, &Scroll);
 	m_UndoScrollValue = UiDoScrollbarV(&ScrollBar, &Scroll, m_UndoScrollValue);
@@ -4226,50 +4208,40 @@ void CEditor::RenderUndoList(CUIRect View)
 	float Height = List.h;
 	UI()->ClipEnable(&List);
 	int ClickedIndex = -1;
-	int HoveredIndex = -1;
-	int ScrollNum = m_lUndoSteps.size() - List.h / 17.0f;
+	int ScrollNum = m_UndoHistory.NumSteps() - List.h / 17.0f;
 	if (ScrollNum < 0)
 		ScrollNum = 0;
 	List.y -= m_UndoScrollValue*ScrollNum*17.0f;
-	for (int i = 0; i < m_lUndoSteps.size(); i++)
+	for (int i = 0; i < m_UndoHistory.NumSteps(); i++)
 	{
 		List.HSplitTop(17.0f, &Button, &List);
 		if (List.y < TopY)
 			continue;
 		if (List.y - 17.0f > TopY + Height)
 			break;
-		if(DoButton_Editor(&m_lUndoSteps[i].m_ButtonId, m_lUndoSteps[i].m_aName, 0, &Button, 0, "Undo to this step"))
+		// the steps that were undone are shown unchecked
+		if(DoButton_Editor(m_UndoHistory.Step(i), m_UndoHistory.Step(i)->m_aName, i < m_UndoHistory.Current(), &Button, 0, "Undo or redo to this step"))
 			ClickedIndex = i;
-		if (UI()->HotItem() == &m_lUndoSteps[i].m_ButtonId)
-			HoveredIndex = i;
 	}
 	UI()->ClipDisable();
 	if (ClickedIndex != -1)
 	{
-		char aBuffer[1024];
-		str_format(aBuffer, sizeof(aBuffer), "editor/undo_%i", m_lUndoSteps[HoveredIndex].m_FileNum);
-		m_Map.Load(m_pStorage, aBuffer, IStorageTW::TYPE_SAVE);
-		m_Map.m_UndoModified = 0;
-		m_LastUndoUpdateTime = time_get();
-	}
-	if (HoveredIndex != -1)
-	{
-		if (m_lUndoSteps[HoveredIndex].m_PreviewImage == 0)
-		{
-			char aBuffer[1024];
-			str_format(aBuffer, sizeof(aBuffer), "editor/undo_%i.png", m_lUndoSteps[HoveredIndex].m_FileNum);
-			m_lUndoSteps[HoveredIndex].m_PreviewImage = Graphics()->LoadTexture(aBuffer, IStorageTW::TYPE_SAVE, CImageInfo::FORMAT_RGB, IGraphics::TEXLOAD_NORESAMPLE);
-		}
-		if (m_lUndoSteps[HoveredIndex].m_PreviewImage)
-		{
-			Graphics()->TextureSet(m_lUndoSteps[HoveredIndex].m_PreviewImage);
-			Graphics()->BlendNormal();
-			Graphics()->QuadsBegin();
-			IGraphics::CQuadItem QuadItem(Preview.x, Preview.y, Preview.w, Preview.h);
-			Graphics()->QuadsDrawTL(&QuadItem, 1);
-			Graphics()->QuadsEnd();
-		}
+		while(m_UndoHistory.Current() > ClickedIndex+1)
+			Undo();
+		while(m_UndoHistory.Current() < ClickedIndex+1)
+			Redo();
 	}
+
+	char aBuf[128];
+	Info.VMargin(10.0f, &Info);
+	Info.HSplitTop(17.0f, &Button, &Info);
+	str_format(aBuf, sizeof(aBuf), "%d of %d steps", m_UndoHistory.Current(), m_UndoHistory.NumSteps());
+	UI()->DoLabel(&Button, aBuf, 10.0f, -1, -1);
+	Info.HSplitTop(17.0f, &Button, &Info);
+	str_format(aBuf, sizeof(aBuf), "%d of %d KiB used", m_UndoHistory.MemoryUsage()/1024, g_Config.m_ClEditorUndoMemory*1024);
+	UI()->DoLabel(&Button, aBuf, 10.0f, -1, -1);
+	Info.HSplitTop(17.0f, &Button, &Info);
+	UI()->DoLabel(&Button, "[ctrl+z] Undo, [ctrl+y] Redo", 10.0f, -1, -1);
 }
 
 void CEditor::RenderEnvelopeEditor(CUIRect View)
@@ -4300,7 +4272,6 @@ void CEditor::RenderEnvelopeEditor(CUIRect View)
 		if(DoButton_Editor(&s_NewSoundButton, "Sound+", 0, &Button, 0, "Creates a new sound envelope"))
 		{
 			m_Map.m_Modified = true;
-			m_Map.m_UndoModified++;
 			pNewEnv = m_Map.NewEnvelope(1);
 		}
 
@@ -4310,7 +4281,6 @@ void CEditor::RenderEnvelopeEditor(CUIRect View)
 		if(DoButton_Editor(&s_New4dButton, "Color+", 0, &Button, 0, "Creates a new color envelope"))
 		{
 			m_Map.m_Modified = true;
-			m_Map.m_UndoModified++;
 			pNewEnv = m_Map.NewEnvelope(4);
 		}
 
@@ -4320,7 +4290,6 @@ void CEditor::RenderEnvelopeEditor(CUIRect View)
 		if(DoButton_Editor(&s_New2dButton, "Pos.+", 0, &Button, 0, "Creates a new position envelope"))
 		{
 			m_Map.m_Modified = true;
-			m_Map.m_UndoModified++;
 			pNewEnv = m_Map.NewEnvelope(3);
 		}
 
@@ -4333,7 +4302,6 @@ void CEditor::RenderEnvelopeEditor(CUIRect View)
 			if(DoButton_Editor(&s_DelButton, "Delete", 0, &Button, 0, "Delete this envelope"))
 			{
 				m_Map.m_Modified = true;
-				m_Map.m_UndoModified++;
 				m_Map.DeleteEnvelope(m_SelectedEnvelope);
 				if(m_SelectedEnvelope >= m_Map.m_lEnvelopes.size())
 					m_SelectedEnvelope = m_Map.m_lEnvelopes.size()-1;
@@ -4394,7 +4362,6 @@ void CEditor::RenderEnvelopeEditor(CUIRect View)
 			if(DoEditBox(&s_NameBox, &Button, pEnvelope->m_aName, sizeof(pEnvelope->m_aName), 10.0f, &s_NameBox))
 			{
 				m_Map.m_Modified = true;
-				m_Map.m_UndoModified++;
 			}
 		}
 	}
@@ -4500,7 +4467,6 @@ void CEditor::RenderEnvelopeEditor(CUIRect View)
 										f2fx(aChannels[0]), f2fx(aChannels[1]),
 										f2fx(aChannels[2]), f2fx(aChannels[3]));
 					m_Map.m_Modified = true;
-					m_Map.m_UndoModified++;
 				}
 
 				m_ShowEnvelopePreview = 1;
@@ -4686,9 +4652,6 @@ void CEditor::RenderEnvelopeEditor(CUIRect View)
 									pEnvelope->m_lPoints[i].m_aValues[c] -= f2fx(m_MouseDeltaY*ValueScale);
 							}
 
-							if (m_SelectedEnvelopePoint != i)
-								m_Map.m_UndoModified++;
-
 							m_SelectedQuadEnvelope = m_SelectedEnvelope;
 							m_ShowEnvelopePreview = 1;
 							m_SelectedEnvelopePoint = i;
@@ -4723,7 +4686,6 @@ void CEditor::RenderEnvelopeEditor(CUIRect View)
 
 							pEnvelope->m_lPoints.remove_index(i);
 							m_Map.m_Modified = true;
-							m_Map.m_UndoModified++;
 						}
 
 						m_ShowEnvelopePreview = 1;
@@ -5287,29 +5249,10 @@ void CEditor::Render()
 	}
 }
 
-static int UndoStepsListdirCallback(const char *pName, int IsDir, int StorageType, void *pUser)
-{
-	IStorageTW *pStorage = (IStorageTW *)pUser;
-	if (str_comp_nocase_num(pName, "undo_", 5) == 0)
-	{
-		char aBuffer[1024];
-		pStorage->GetCompletePath(IStorageTW::TYPE_SAVE, "editor/", aBuffer, sizeof(aBuffer));
-		str_append(aBuffer, pName, sizeof(aBuffer));
-		fs_remove(aBuffer);
-	}
-	return 0;
-}
-
 void CEditor::Reset(bool CreateDefault)
 {
 	m_Map.Clean();
 
-	//delete undo file
-	char aBuffer[1024];
-	m_pStorage->GetCompletePath(IStorageTW::TYPE_SAVE, "editor/", aBuffer, sizeof(aBuffer));
-	fs_listdir(aBuffer, UndoStepsListdirCallback, 0, m_pStorage);
-	m_lUndoSteps.clear();
-
 	// create default layers
 	if(CreateDefault)
 		m_Map.CreateDefault(ms_EntitiesTexture);
@@ -5337,16 +5280,12 @@ void CEditor::Reset(bool CreateDefault)
 	m_MouseDeltaWy = 0;
 
 	m_Map.m_Modified = false;
-	m_Map.m_UndoModified = 0;
-	m_LastUndoUpdateTime = time_get();
-	m_UndoRunning = false;
+	m_Map.m_UndoUntracked = false;
 
 	m_ShowEnvelopePreview = 0;
 	m_ShiftBy = 1;
 
-	m_Map.m_Modified = false;
-	m_Map.m_UndoModified = 0;
-	m_LastUndoUpdateTime = time_get();
+	ResetUndo();
 }
 
 int CEditor::GetLineDistance()
@@ -5393,7 +5332,7 @@ void CEditorMap::DeleteEnvelope(int Index)
 		return;
 
 	m_Modified = true;
-	m_UndoModified++;
+	m_UndoUntracked = true;
 
 	// fix links between envelopes and quads
 	for(int i = 0; i < m_lGroups.size(); ++i)
@@ -5456,6 +5395,7 @@ void CEditorMap::Clean()
 	m_pGameGroup = 0x0;
 
 	m_Modified = false;
+	m_UndoUntracked = false;
 
 	m_pTeleLayer = 0x0;
 	m_pSpeedupLayer = 0x0;
@@ -5507,6 +5447,7 @@ void CEditor::Init()
 	m_pGraphics = Kernel()->RequestInterface<IGraphics>();
 	m_pTextRender = Kernel()->RequestInterface<ITextRender>();
 	m_pStorage = Kernel()->RequestInterface<IStorageTW>();
+	m_pEngine = Kernel()->RequestInterface<IEngine>();
 	m_pSound = Kernel()->RequestInterface<ISound>();
 	m_RenderTools.m_pGraphics = m_pGraphics;
 	m_RenderTools.m_pUI = &m_UI;
@@ -5536,8 +5477,7 @@ void CEditor::Init()
 
 	Reset();
 	m_Map.m_Modified = false;
-	m_Map.m_UndoModified = 0;
-	m_LastUndoUpdateTime = time_get();
+	m_Map.m_UndoUntracked = false;
 
 	ms_PickerColor = vec3(1.0f, 0.0f, 0.0f);
 }
@@ -5557,35 +5497,199 @@ void CEditor::DoMapBorder()
 
 	for(int i = (pT->m_Width*(pT->m_Height-2)); i < pT->m_Width*pT->m_Height; ++i)
 		pT->m_pTiles[i].m_Index = 1;
+
+	pT->MarkUndo(0, 0, pT->m_Width, pT->m_Height);
 }
 
-void CEditor::CreateUndoStep()
+bool CEditor::UndoStructureChanged()
 {
-	void *CreateThread = thread_init(CreateUndoStepThread, this);
-	thread_detach(CreateThread);
+	int Num = 0;
+	for(int g = 0; g < m_Map.m_lGroups.size(); g++)
+		for(int l = 0; l < m_Map.m_lGroups[g]->m_lLayers.size(); l++)
+		{
+			CLayer *pLayer = m_Map.m_lGroups[g]->m_lLayers[l];
+			if(Num >= m_lUndoLayers.size() || m_lUndoLayers[Num].m_pLayer != pLayer)
+				return true;
+			if(pLayer->m_Type == LAYERTYPE_TILES)
+			{
+				CLayerTiles *pTiles = static_cast<CLayerTiles *>(pLayer);
+				if(m_lUndoLayers[Num].m_pData != pTiles->m_pTiles || m_lUndoLayers[Num].m_Width != pTiles->m_Width || m_lUndoLayers[Num].m_Height != pTiles->m_Height)
+					return true;
+			}
+			Num++;
+		}
+	return Num != m_lUndoLayers.size() || m_lUndoEnvelopes.size() != m_Map.m_lEnvelopes.size();
 }
 
-void CEditor::CreateUndoStepThread(void *pUser)
+void CEditor::ResetUndo()
 {
-	CEditor *pEditor = (CEditor *)pUser;
+	m_UndoHistory.Clear();
+	for(int i = 0; i < m_lUndoLayers.size(); i++)
+		delete m_lUndoLayers[i].m_pBlob;
+	m_lUndoLayers.clear();
+	m_lUndoEnvelopes.delete_all();
 
-	CUndo NewStep;
-	str_timestamp(NewStep.m_aName, sizeof(NewStep.m_aName));
-	if (pEditor->m_lUndoSteps.size())
-		NewStep.m_FileNum = pEditor->m_lUndoSteps[pEditor->m_lUndoSteps.size() - 1].m_FileNum + 1;
-	else
-		NewStep.m_FileNum = 0;
-	NewStep.m_PreviewImage = 0;
+	// take the current map as the committed state
+	for(int g = 0; g < m_Map.m_lGroups.size(); g++)
+		for(int l = 0; l < m_Map.m_lGroups[g]->m_lLayers.size(); l++)
+		{
+			CLayer *pLayer = m_Map.m_lGroups[g]->m_lLayers[l];
+			if(!g_Config.m_ClEditorUndo)
+			{
+				if(pLayer->m_Type == LAYERTYPE_TILES)
+					for(int p = 0; p < CLayerTiles::NUM_UNDO_PLANES; p++)
+						static_cast<CLayerTiles *>(pLayer)->m_aUndoPlanes[p].Reset();
+				continue;
+			}
 
-	char aBuffer[1024];
-	str_format(aBuffer, sizeof(aBuffer), "editor/undo_%i.png", NewStep.m_FileNum);
-	pEditor->Graphics()->TakeCustomScreenshot(aBuffer);
+			CUndoLayer Entry;
+			Entry.m_pLayer = pLayer;
+			Entry.m_pData = 0;
+			Entry.m_Width = Entry.m_Height = 0;
+			Entry.m_pBlob = 0;
+			if(pLayer->m_Type == LAYERTYPE_TILES)
+			{
+				CLayerTiles *pTiles = static_cast<CLayerTiles *>(pLayer);
+				pTiles->InitUndo();
+				Entry.m_pData = pTiles->m_pTiles;
+				Entry.m_Width = pTiles->m_Width;
+				Entry.m_Height = pTiles->m_Height;
+			}
+			else if(pLayer->m_Type == LAYERTYPE_QUADS)
+			{
+				CLayerQuads *pQuads = static_cast<CLayerQuads *>(pLayer);
+				Entry.m_pBlob = new CBlobUndoTracker;
+				Entry.m_pBlob->Init(pQuads->m_lQuads.base_ptr(), pQuads->m_lQuads.size()*sizeof(CQuad));
+			}
+			else if(pLayer->m_Type == LAYERTYPE_SOUNDS)
+			{
+				CLayerSounds *pSounds = static_cast<CLayerSounds *>(pLayer);
+				Entry.m_pBlob = new CBlobUndoTracker;
+				Entry.m_pBlob->Init(pSounds->m_lSources.base_ptr(), pSounds->m_lSources.size()*sizeof(CSoundSource));
+			}
+			m_lUndoLayers.add(Entry);
+		}
+
+	for(int e = 0; g_Config.m_ClEditorUndo && e < m_Map.m_lEnvelopes.size(); e++)
+	{
+		CBlobUndoTracker *pBlob = new CBlobUndoTracker;
+		pBlob->Init(m_Map.m_lEnvelopes[e]->m_lPoints.base_ptr(), m_Map.m_lEnvelopes[e]->m_lPoints.size()*sizeof(CEnvPoint));
+		m_lUndoEnvelopes.add(pBlob);
+	}
+
+	m_Map.m_UndoUntracked = false;
+}
+
+void CEditor::CommitUndoStep()
+{
+	// adding, removing or resizing layers starts over, the steps only hold the content of the layers
+	if(UndoStructureChanged())
+	{
+		ResetUndo();
+		return;
+	}
+
+	// tile writes mark what they change, only the structure changes make every tile layer be compared
+	bool CompareAll = m_Map.m_UndoUntracked;
+	m_Map.m_UndoUntracked = false;
+
+	CUndoStep *pStep = new CUndoStep;
+	for(int i = 0; i < m_lUndoLayers.size(); i++)
+	{
+		CLayer *pLayer = m_lUndoLayers[i].m_pLayer;
+		if(pLayer->m_Type == LAYERTYPE_TILES)
+		{
+			CLayerTiles *pTiles = static_cast<CLayerTiles *>(pLayer);
+			for(int p = 0; p < CLayerTiles::NUM_UNDO_PLANES; p++)
+			{
+				if(CompareAll)
+					pTiles->m_aUndoPlanes[p].MarkAllDirty();
+				pTiles->m_aUndoPlanes[p].Commit(i*CLayerTiles::NUM_UNDO_PLANES+p, pStep);
+			}
+		}
+		else if(pLayer->m_Type == LAYERTYPE_QUADS)
+		{
+			CLayerQuads *pQuads = static_cast<CLayerQuads *>(pLayer);
+			m_lUndoLayers[i].m_pBlob->Commit(CUndoStep::ITEM_QUADS, i, pQuads->m_lQuads.base_ptr(), pQuads->m_lQuads.size()*sizeof(CQuad), pStep);
+		}
+		else if(pLayer->m_Type == LAYERTYPE_SOUNDS)
+		{
+			CLayerSounds *pSounds = static_cast<CLayerSounds *>(pLayer);
+			m_lUndoLayers[i].m_pBlob->Commit(CUndoStep::ITEM_SOUNDSOURCES, i, pSounds->m_lSources.base_ptr(), pSounds->m_lSources.size()*sizeof(CSoundSource), pStep);
+		}
+	}
+	for(int e = 0; e < m_lUndoEnvelopes.size(); e++)
+		m_lUndoEnvelopes[e]->Commit(CUndoStep::ITEM_ENVPOINTS, e, m_Map.m_lEnvelopes[e]->m_lPoints.base_ptr(), m_Map.m_lEnvelopes[e]->m_lPoints.size()*sizeof(CEnvPoint), pStep);
+
+	if(pStep->m_lItems.size() == 0)
+	{
+		delete pStep;
+		return;
+	}
+
+	char aTimestamp[32];
+	str_timestamp_format(aTimestamp, sizeof(aTimestamp), "%H:%M:%S");
+	str_format(pStep->m_aName, sizeof(pStep->m_aName), "%s, %d changes", aTimestamp, pStep->m_lItems.size());
+	m_UndoHistory.Push(pStep, g_Config.m_ClEditorUndoMemory*1024*1024);
+}
+
+void CEditor::ApplyUndoStep(const CUndoStep *pStep, bool Before)
+{
+	for(int i = 0; i < pStep->m_lItems.size(); i++)
+	{
+		const CUndoStep::CItem *pItem = &pStep->m_lItems[i];
+		if(pItem->m_Type == CUndoStep::ITEM_TILES)
+		{
+			CLayerTiles *pTiles = static_cast<CLayerTiles *>(m_lUndoLayers[pItem->m_Index/CLayerTiles::NUM_UNDO_PLANES].m_pLayer);
+			pTiles->m_aUndoPlanes[pItem->m_Index%CLayerTiles::NUM_UNDO_PLANES].Apply(pItem, Before);
+		}
+		else if(pItem->m_Type == CUndoStep::ITEM_QUADS)
+		{
+			CLayerQuads *pQuads = static_cast<CLayerQuads *>(m_lUndoLayers[pItem->m_Index].m_pLayer);
+			CBlobUndoTracker *pBlob = m_lUndoLayers[pItem->m_Index].m_pBlob;
+			pBlob->Apply(pItem, Before);
+			pQuads->m_lQuads.set_size(pBlob->Size()/sizeof(CQuad));
+			mem_copy(pQuads->m_lQuads.base_ptr(), pBlob->Data(), pBlob->Size());
+			m_SelectedQuad = -1;
+			m_SelectedPoints = 0;
+		}
+		else if(pItem->m_Type == CUndoStep::ITEM_SOUNDSOURCES)
+		{
+			CLayerSounds *pSounds = static_cast<CLayerSounds *>(m_lUndoLayers[pItem->m_Index].m_pLayer);
+			CBlobUndoTracker *pBlob = m_lUndoLayers[pItem->m_Index].m_pBlob;
+			pBlob->Apply(pItem, Before);
+			pSounds->m_lSources.set_size(pBlob->Size()/sizeof(CSoundSource));
+			mem_copy(pSounds->m_lSources.base_ptr(), pBlob->Data(), pBlob->Size());
+			m_SelectedSource = -1;
+		}
+		else if(pItem->m_Type == CUndoStep::ITEM_ENVPOINTS)
+		{
+			CEnvelope *pEnvelope = m_Map.m_lEnvelopes[pItem->m_Index];
+			CBlobUndoTracker *pBlob = m_lUndoEnvelopes[pItem->m_Index];
+			pBlob->Apply(pItem, Before);
+			pEnvelope->m_lPoints.set_size(pBlob->Size()/sizeof(CEnvPoint));
+			mem_copy(pEnvelope->m_lPoints.base_ptr(), pBlob->Data(), pBlob->Size());
+			pEnvelope->FindTopBottom(0xf);
+		}
+	}
+	m_Map.m_Modified = true;
+}
 
-	str_format(aBuffer, sizeof(aBuffer), "editor/undo_%i", NewStep.m_FileNum);
-	pEditor->Save(aBuffer);
+void CEditor::Undo()
+{
+	// what changed since the last step becomes a step of its own first
+	CommitUndoStep();
+	CUndoStep *pStep = m_UndoHistory.Undo();
+	if(pStep)
+		ApplyUndoStep(pStep, true);
+}
 
-	pEditor->m_lUndoSteps.add(NewStep);
-	pEditor->m_UndoRunning = false;
+void CEditor::Redo()
+{
+	CommitUndoStep();
+	CUndoStep *pStep = m_UndoHistory.Redo();
+	if(pStep)
+		ApplyUndoStep(pStep, false);
 }
 
 void CEditor::UpdateAndRender()
@@ -5678,22 +5782,14 @@ void CEditor::UpdateAndRender()
 	if(Input()->KeyPress(KEY_F10))
 		m_ShowMousePointer = false;
 
-	if (g_Config.m_ClEditorUndo)
+	// an edit is one step, taken once the mouse lets go of it
+	if(g_Config.m_ClEditorUndo)
 	{
-		// Screenshot at most every 5 seconds, at least every 60
-		if ((m_LastUndoUpdateTime + time_freq() * 60 < time_get() && m_Map.m_UndoModified)
-			||  (m_LastUndoUpdateTime + time_freq() *  5 < time_get() && m_Map.m_UndoModified >= 10))
-		{
-			m_Map.m_UndoModified = 0;
-			m_LastUndoUpdateTime = time_get();
-
-			if (!m_UndoRunning)
-			{
-				m_UndoRunning = true;
-				CreateUndoStep();
-			}
-		}
+		if(!UI()->ActiveItem() && m_Dialog == DIALOG_NONE)
+			CommitUndoStep();
 	}
+	else if(m_lUndoLayers.size())
+		ResetUndo();
 	Render();
 
 	if(Input()->KeyPress(KEY_F10))
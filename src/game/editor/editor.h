@@ -24,6 +24,7 @@
 #include <engine/sound.h>
 
 #include "auto_map.h"
+#include "undo.h"
 
 typedef void (*INDEX_MODIFY_FUNC)(int *pIndex);
 
@@ -336,7 +337,11 @@ class CEditorMap
 public:
 	CEditor *m_pEditor;
 	bool m_Modified;
-	int m_UndoModified;
+	// set by the structure changes that no tile write marks, the next undo step then compares all tile layers
+	bool m_UndoUntracked;
+
+	// the compressed data of the last save, what didn't change since isn't compressed again
+	CDataFileCache m_SaveCache;
 
 	CEditorMap()
 	{
@@ -393,7 +398,7 @@ public:
 	CEnvelope *NewEnvelope(int Channels)
 	{
 		m_Modified = true;
-		m_UndoModified++;
+		m_UndoUntracked = true;
 		CEnvelope *e = new CEnvelope(Channels);
 		m_lEnvelopes.add(e);
 		return e;
@@ -404,7 +409,7 @@ public:
 	CLayerGroup *NewGroup()
 	{
 		m_Modified = true;
-		m_UndoModified++;
+		m_UndoUntracked = true;
 		CLayerGroup *g = new CLayerGroup;
 		g->m_pMap = this;
 		m_lGroups.add(g);
@@ -417,7 +422,6 @@ public:
 		if(Index1 < 0 || Index1 >= m_lGroups.size()) return Index0;
 		if(Index0 == Index1) return Index0;
 		m_Modified = true;
-		m_UndoModified++;
 		swap(m_lGroups[Index0], m_lGroups[Index1]);
 		return Index1;
 	}
@@ -426,7 +430,6 @@ public:
 	{
 		if(Index < 0 || Index >= m_lGroups.size()) return;
 		m_Modified = true;
-		m_UndoModified++;
 		delete m_lGroups[Index];
 		m_lGroups.remove_index(Index);
 	}
@@ -434,7 +437,6 @@ public:
 	void ModifyImageIndex(INDEX_MODIFY_FUNC pfnFunc)
 	{
 		m_Modified = true;
-		m_UndoModified++;
 		for(int i = 0; i < m_lGroups.size(); i++)
 			m_lGroups[i]->ModifyImageIndex(pfnFunc);
 	}
@@ -442,7 +444,6 @@ public:
 	void ModifyEnvelopeIndex(INDEX_MODIFY_FUNC pfnFunc)
 	{
 		m_Modified = true;
-		m_UndoModified++;
 		for(int i = 0; i < m_lGroups.size(); i++)
 			m_lGroups[i]->ModifyEnvelopeIndex(pfnFunc);
 	}
@@ -450,7 +451,6 @@ public:
 	void ModifySoundIndex(INDEX_MODIFY_FUNC pfnFunc)
 	{
 		m_Modified = true;
-		m_UndoModified++;
 		for(int i = 0; i < m_lGroups.size(); i++)
 			m_lGroups[i]->ModifySoundIndex(pfnFunc);
 	}
@@ -545,6 +545,15 @@ public:
 
 	void GetSize(float *w, float *h) { *w = m_Width*32.0f; *h = m_Height*32.0f; }
 
+	// undo, the tiles and the extra tiles of the ddrace layers
+	enum
+	{
+		NUM_UNDO_PLANES=2,
+	};
+	CTileUndoTracker m_aUndoPlanes[NUM_UNDO_PLANES];
+	virtual void InitUndo();
+	void MarkUndo(int x, int y, int w, int h);
+
 	int m_TexID;
 	int m_Game;
 	int m_Image;
@@ -613,6 +622,7 @@ class CEditor : public IEditor
 	class ITextRender *m_pTextRender;
 	class ISound *m_pSound;
 	class IStorageTW *m_pStorage;
+	class IEngine *m_pEngine;
 	CRenderTools m_RenderTools;
 	CUI m_UI;
 public:
@@ -623,6 +633,7 @@ public:
 	class ISound *Sound() { return m_pSound; }
 	class ITextRender *TextRender() { return m_pTextRender; };
 	class IStorageTW *Storage() { return m_pStorage; };
+	class IEngine *Engine() { return m_pEngine; }
 	CUI *UI() { return &m_UI; }
 	CRenderTools *RenderTools() { return &m_RenderTools; }
 
@@ -734,20 +745,24 @@ public:
 	virtual void UpdateAndRender();
 	virtual bool HasUnsavedData() { return m_Map.m_Modified; }
 
-	int64 m_LastUndoUpdateTime;
-	bool m_UndoRunning;
-	void CreateUndoStep();
-	static void CreateUndoStepThread(void *pUser);
-	int UndoStep();
-	struct CUndo
+	// the layers the undo history was built for, in map order. a change to them starts a new history
+	struct CUndoLayer
 	{
-		int m_FileNum;
-		int m_ButtonId;
-		char m_aName[128];
-		int m_PreviewImage;
+		CLayer *m_pLayer;
+		void *m_pData;
+		int m_Width;
+		int m_Height;
+		CBlobUndoTracker *m_pBlob;
 	};
-	array<CUndo> m_lUndoSteps;
-	bool m_Undo;
+	array<CUndoLayer> m_lUndoLayers;
+	array<CBlobUndoTracker *> m_lUndoEnvelopes;
+	CUndoHistory m_UndoHistory;
+	bool UndoStructureChanged();
+	void ResetUndo();
+	void CommitUndoStep();
+	void ApplyUndoStep(const CUndoStep *pStep, bool Before);
+	void Undo();
+	void Redo();
 	int m_ShowUndo;
 	float m_UndoScrollValue;
 	void FilelistPopulate(int StorageType);
@@ -1063,6 +1078,7 @@ public:
 	CTeleTile *m_pTeleTile;
 	unsigned char m_TeleNum;
 
+	virtual void InitUndo();
 	virtual void Resize(int NewW, int NewH);
 	virtual void Shift(int Direction);
 	virtual void BrushDraw(CLayer *pBrush, float wx, float wy);
@@ -1083,6 +1099,7 @@ public:
 	unsigned char m_SpeedupMaxSpeed;
 	unsigned char m_SpeedupAngle;
 
+	virtual void InitUndo();
 	virtual void Resize(int NewW, int NewH);
 	virtual void Shift(int Direction);
 	virtual void BrushDraw(CLayer *pBrush, float wx, float wy);
@@ -1113,6 +1130,7 @@ public:
 	unsigned char m_SwitchNumber;
 	unsigned char m_SwitchDelay;
 
+	virtual void InitUndo();
 	virtual void Resize(int NewW, int NewH);
 	virtual void Shift(int Direction);
 	virtual void BrushDraw(CLayer *pBrush, float wx, float wy);
@@ -1128,6 +1146,7 @@ public:
 	CTuneTile *m_pTuneTile;
 	unsigned char m_TuningNumber;
 
+	virtual void InitUndo();
 	virtual void Resize(int NewW, int NewH);
 	virtual void Shift(int Direction);
 	virtual void BrushDraw(CLayer *pBrush, float wx, float wy);
@@ -228,6 +228,8 @@ int CEditorMap::Save(class IStorageTW *pStorage, const char *pFileName)
 		m_pEditor->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "editor", aBuf);
 		return 0;
 	}
+	df.SetEngine(m_pEditor->Engine());
+	df.SetCache(&m_SaveCache);
 
 	// save version
 	{
@@ -54,6 +54,18 @@ CTile CLayerTiles::GetTile(int x, int y)
 void CLayerTiles::SetTile(int x, int y, CTile tile)
 {
 	m_pTiles[y*m_Width+x] = tile;
+	m_aUndoPlanes[0].MarkDirty(x, y, 1, 1);
+}
+
+void CLayerTiles::InitUndo()
+{
+	m_aUndoPlanes[0].Init(m_pTiles, m_Width, m_Height, sizeof(CTile));
+}
+
+void CLayerTiles::MarkUndo(int x, int y, int w, int h)
+{
+	for(int i = 0; i < NUM_UNDO_PLANES; i++)
+		m_aUndoPlanes[i].MarkDirty(x, y, w, h);
 }
 
 void CLayerTiles::PrepareForSave()
@@ -357,6 +369,7 @@ void CLayerTiles::FillSelection(bool Empty, CLayer *pBrush, CUIRect Rect)
 		}
 	}
 	m_pEditor->m_Map.m_Modified = true;
+	MarkUndo(sx, sy, w, h);
 }
 
 void CLayerTiles::BrushDraw(CLayer *pBrush, float wx, float wy)
@@ -528,6 +541,9 @@ void CLayerTiles::Shift(int Direction)
 			}
 		}
 	}
+
+	// the derived layers shift their own tiles after this, the mark covers them too
+	MarkUndo(0, 0, m_Width, m_Height);
 }
 
 void CLayerTiles::ShowInfo()
@@ -583,6 +599,7 @@ int CLayerTiles::RenderProperties(CUIRect *pToolBox)
 			if(Result > -1)
 			{
 				m_pEditor->m_Map.m_lImages[m_Image]->m_AutoMapper.Proceed(this, Result);
+				MarkUndo(0, 0, m_Width, m_Height);
 				return 1;
 			}
 		}
@@ -653,6 +670,7 @@ int CLayerTiles::RenderProperties(CUIRect *pToolBox)
 							gl->m_pTeleTile[y*gl->m_Width+x].m_Number = 1;
 							gl->m_pTeleTile[y*gl->m_Width+x].m_Type = TILE_AIR+Result;
 						}
+				gl->MarkUndo(0, 0, w, h);
 			}
 
 			return 1;
@@ -700,7 +718,10 @@ int CLayerTiles::RenderProperties(CUIRect *pToolBox)
 	int NewVal = 0;
 	int Prop = m_pEditor->DoProperties(pToolBox, aProps, s_aIds, &NewVal);
 	if(Prop != -1)
+	{
 		m_pEditor->m_Map.m_Modified = true;
+		MarkUndo(0, 0, m_Width, m_Height);
+	}
 
 	if(Prop == PROP_WIDTH && NewVal > 1)
 	{
@@ -789,6 +810,12 @@ CLayerTele::~CLayerTele()
 	delete[] m_pTeleTile;
 }
 
+void CLayerTele::InitUndo()
+{
+	CLayerTiles::InitUndo();
+	m_aUndoPlanes[1].Init(m_pTeleTile, m_Width, m_Height, sizeof(CTeleTile));
+}
+
 void CLayerTele::Resize(int NewW, int NewH)
 {
 	// resize tele data
@@ -911,6 +938,7 @@ void CLayerTele::BrushDraw(CLayer *pBrush, float wx, float wy)
 			}
 		}
 	m_pEditor->m_Map.m_Modified = true;
+	MarkUndo(sx, sy, l->m_Width, l->m_Height);
 }
 
 void CLayerTele::BrushFlipX()
@@ -1021,6 +1049,7 @@ void CLayerTele::FillSelection(bool Empty, CLayer *pBrush, CUIRect Rect)
 			}
 		}
 	}
+	MarkUndo(sx, sy, w, h);
 }
 
 CLayerSpeedup::CLayerSpeedup(int w, int h)
@@ -1039,6 +1068,12 @@ CLayerSpeedup::~CLayerSpeedup()
 	delete[] m_pSpeedupTile;
 }
 
+void CLayerSpeedup::InitUndo()
+{
+	CLayerTiles::InitUndo();
+	m_aUndoPlanes[1].Init(m_pSpeedupTile, m_Width, m_Height, sizeof(CSpeedupTile));
+}
+
 void CLayerSpeedup::Resize(int NewW, int NewH)
 {
 	// resize speedup data
@@ -1176,6 +1211,7 @@ void CLayerSpeedup::BrushDraw(CLayer *pBrush, float wx, float wy)
 			}
 		}
 	m_pEditor->m_Map.m_Modified = true;
+	MarkUndo(sx, sy, l->m_Width, l->m_Height);
 }
 
 void CLayerSpeedup::BrushFlipX()
@@ -1294,6 +1330,7 @@ void CLayerSpeedup::FillSelection(bool Empty, CLayer *pBrush, CUIRect Rect)
 			}
 		}
 	}
+	MarkUndo(sx, sy, w, h);
 }
 
 CLayerFront::CLayerFront(int w, int h)
@@ -1380,6 +1417,12 @@ CLayerSwitch::~CLayerSwitch()
 	delete[] m_pSwitchTile;
 }
 
+void CLayerSwitch::InitUndo()
+{
+	CLayerTiles::InitUndo();
+	m_aUndoPlanes[1].Init(m_pSwitchTile, m_Width, m_Height, sizeof(CSwitchTile));
+}
+
 void CLayerSwitch::Resize(int NewW, int NewH)
 {
 	// resize switch data
@@ -1515,6 +1558,7 @@ void CLayerSwitch::BrushDraw(CLayer *pBrush, float wx, float wy)
 			}
 		}
 	m_pEditor->m_Map.m_Modified = true;
+	MarkUndo(sx, sy, l->m_Width, l->m_Height);
 }
 
 void CLayerSwitch::FillSelection(bool Empty, CLayer *pBrush, CUIRect Rect)
@@ -1569,6 +1613,7 @@ void CLayerSwitch::FillSelection(bool Empty, CLayer *pBrush, CUIRect Rect)
 			}
 		}
 	}
+	MarkUndo(sx, sy, w, h);
 }
 
 //------------------------------------------------------
@@ -1589,6 +1634,12 @@ CLayerTune::~CLayerTune()
 	delete[] m_pTuneTile;
 }
 
+void CLayerTune::InitUndo()
+{
+	CLayerTiles::InitUndo();
+	m_aUndoPlanes[1].Init(m_pTuneTile, m_Width, m_Height, sizeof(CTuneTile));
+}
+
 void CLayerTune::Resize(int NewW, int NewH)
 {
 	// resize Tune data
@@ -1713,6 +1764,7 @@ void CLayerTune::BrushDraw(CLayer *pBrush, float wx, float wy)
 				}
 			}
 		m_pEditor->m_Map.m_Modified = true;
+		MarkUndo(sx, sy, l->m_Width, l->m_Height);
 }
 
 
@@ -1823,4 +1875,5 @@ void CLayerTune::FillSelection(bool Empty, CLayer *pBrush, CUIRect Rect)
 				}
 			}
 		}
+		MarkUndo(sx, sy, w, h);
 }
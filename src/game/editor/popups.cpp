@@ -152,6 +152,7 @@ int CEditor::PopupGroup(CEditor *pEditor, CUIRect View)
 						pEditor->m_Map.m_Modified = true;
 					}
 				}
+			gl->MarkUndo(0, 0, gl->m_Width, gl->m_Height);
 
 			return 1;
 		}
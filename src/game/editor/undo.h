@@ -0,0 +1,296 @@
+#ifndef GAME_EDITOR_UNDO_H
+#define GAME_EDITOR_UNDO_H
+
+#include <base/math.h>
+#include <base/system.h>
+#include <base/tl/array.h>
+
+// one undo step: the parts of the map that changed, with their content before and after
+class CUndoStep
+{
+public:
+	enum
+	{
+		ITEM_TILES=0,
+		ITEM_QUADS,
+		ITEM_SOUNDSOURCES,
+		ITEM_ENVPOINTS,
+	};
+
+	struct CItem
+	{
+		int m_Type;
+		int m_Index;
+		// the rows of a tile chunk, in tiles
+		int m_X, m_Y, m_W, m_H;
+		unsigned char *m_pBefore;
+		int m_BeforeSize;
+		unsigned char *m_pAfter;
+		int m_AfterSize;
+	};
+
+	array<CItem> m_lItems;
+	char m_aName[64];
+	int m_MemoryUsage;
+
+	CUndoStep() : m_MemoryUsage(sizeof(CUndoStep)) { m_aName[0] = 0; }
+
+	~CUndoStep()
+	{
+		// before and after share one allocation
+		for(int i = 0; i < m_lItems.size(); i++)
+			mem_free(m_lItems[i].m_pBefore);
+	}
+
+	CItem *AddItem(int Type, int Index, int BeforeSize, int AfterSize)
+	{
+		CItem Item;
+		Item.m_Type = Type;
+		Item.m_Index = Index;
+		Item.m_X = Item.m_Y = Item.m_W = Item.m_H = 0;
+		Item.m_pBefore = (unsigned char *)mem_alloc(BeforeSize+AfterSize+1, 1);
+		Item.m_BeforeSize = BeforeSize;
+		Item.m_pAfter = Item.m_pBefore+BeforeSize;
+		Item.m_AfterSize = AfterSize;
+		m_MemoryUsage += BeforeSize+AfterSize+sizeof(CItem);
+		return &m_lItems[m_lItems.add(Item)];
+	}
+};
+
+// the committed state of one tile array and the chunks that were written since the last commit.
+// only the dirty chunks are compared on commit, so a step costs as much as was changed
+class CTileUndoTracker
+{
+public:
+	enum
+	{
+		CHUNK_SIZE=32,
+	};
+
+	CTileUndoTracker() : m_pData(0), m_pCommitted(0), m_pDirty(0), m_pDirtyList(0), m_NumDirty(0), m_NumCompared(0) {}
+	~CTileUndoTracker() { Reset(); }
+
+	void Init(void *pData, int Width, int Height, int ElemSize)
+	{
+		Reset();
+		m_pData = (unsigned char *)pData;
+		m_Width = Width;
+		m_Height = Height;
+		m_ElemSize = ElemSize;
+		m_ChunksX = (Width+CHUNK_SIZE-1)/CHUNK_SIZE;
+		int NumChunks = m_ChunksX*((Height+CHUNK_SIZE-1)/CHUNK_SIZE);
+
+		m_pCommitted = (unsigned char *)mem_alloc(Width*Height*ElemSize, 1);
+		mem_copy(m_pCommitted, m_pData, Width*Height*ElemSize);
+		m_pDirty = (unsigned char *)mem_alloc(NumChunks, 1);
+		mem_zero(m_pDirty, NumChunks);
+		m_pDirtyList = (int *)mem_alloc(NumChunks*sizeof(int), 1);
+	}
+
+	void Reset()
+	{
+		mem_free(m_pCommitted);
+		mem_free(m_pDirty);
+		mem_free(m_pDirtyList);
+		m_pData = 0;
+		m_pCommitted = 0;
+		m_pDirty = 0;
+		m_pDirtyList = 0;
+		m_NumDirty = 0;
+		m_NumCompared = 0;
+	}
+
+	bool IsActive() const { return m_pData != 0; }
+	bool IsDirty() const { return m_NumDirty != 0; }
+	int NumCompared() const { return m_NumCompared; } // chunks the last commit compared
+	int MemoryUsage() const { return m_pData ? m_Width*m_Height*m_ElemSize : 0; }
+
+	void MarkDirty(int x, int y, int w, int h)
+	{
+		if(!m_pData)
+			return;
+
+		int x1 = min(x+w, m_Width), y1 = min(y+h, m_Height);
+		x = max(x, 0);
+		y = max(y, 0);
+		if(x >= x1 || y >= y1)
+			return;
+
+		for(int cy = y/CHUNK_SIZE; cy <= (y1-1)/CHUNK_SIZE; cy++)
+			for(int cx = x/CHUNK_SIZE; cx <= (x1-1)/CHUNK_SIZE; cx++)
+			{
+				int Chunk = cy*m_ChunksX+cx;
+				if(!m_pDirty[Chunk])
+				{
+					m_pDirty[Chunk] = 1;
+					m_pDirtyList[m_NumDirty++] = Chunk;
+				}
+			}
+	}
+
+	void MarkAllDirty() { MarkDirty(0, 0, m_Width, m_Height); }
+
+	// compares the dirty chunks with the committed state and adds the rows that changed to the step
+	void Commit(int Index, CUndoStep *pStep)
+	{
+		m_NumCompared = m_NumDirty;
+		for(int d = 0; d < m_NumDirty; d++)
+		{
+			int Chunk = m_pDirtyList[d];
+			m_pDirty[Chunk] = 0;
+
+			int x = (Chunk%m_ChunksX)*CHUNK_SIZE;
+			int y = (Chunk/m_ChunksX)*CHUNK_SIZE;
+			int h = min((int)CHUNK_SIZE, m_Height-y);
+			int RowSize = min((int)CHUNK_SIZE, m_Width-x)*m_ElemSize;
+
+			int First = -1, Last = -1;
+			for(int r = 0; r < h; r++)
+				if(mem_comp(Row(m_pData, x, y+r), Row(m_pCommitted, x, y+r), RowSize) != 0)
+				{
+					if(First < 0)
+						First = r;
+					Last = r;
+				}
+			if(First < 0)
+				continue;
+
+			int NumRows = Last-First+1;
+			CUndoStep::CItem *pItem = pStep->AddItem(CUndoStep::ITEM_TILES, Index, NumRows*RowSize, NumRows*RowSize);
+			pItem->m_X = x;
+			pItem->m_Y = y+First;
+			pItem->m_W = RowSize/m_ElemSize;
+			pItem->m_H = NumRows;
+			for(int r = 0; r < NumRows; r++)
+			{
+				mem_copy(pItem->m_pBefore+r*RowSize, Row(m_pCommitted, x, pItem->m_Y+r), RowSize);
+				mem_copy(pItem->m_pAfter+r*RowSize, Row(m_pData, x, pItem->m_Y+r), RowSize);
+				mem_copy(Row(m_pCommitted, x, pItem->m_Y+r), Row(m_pData, x, pItem->m_Y+r), RowSize);
+			}
+		}
+		m_NumDirty = 0;
+	}
+
+	// writes one side of a recorded item back into the array and the committed state
+	void Apply(const CUndoStep::CItem *pItem, bool Before)
+	{
+		const unsigned char *pSrc = Before ? pItem->m_pBefore : pItem->m_pAfter;
+		int RowSize = pItem->m_W*m_ElemSize;
+		for(int r = 0; r < pItem->m_H; r++)
+		{
+			mem_copy(Row(m_pData, pItem->m_X, pItem->m_Y+r), pSrc+r*RowSize, RowSize);
+			mem_copy(Row(m_pCommitted, pItem->m_X, pItem->m_Y+r), pSrc+r*RowSize, RowSize);
+		}
+	}
+
+private:
+	unsigned char *m_pData;
+	unsigned char *m_pCommitted;
+	unsigned char *m_pDirty;
+	int *m_pDirtyList;
+	int m_NumDirty;
+	int m_NumCompared;
+	int m_Width;
+	int m_Height;
+	int m_ElemSize;
+	int m_ChunksX;
+
+	unsigned char *Row(unsigned char *pBase, int x, int y) const { return pBase+(y*m_Width+x)*m_ElemSize; }
+};
+
+// the committed state of a small array that is compared as a whole: quads, sound sources, envelope points
+class CBlobUndoTracker
+{
+public:
+	CBlobUndoTracker() : m_pCommitted(0), m_Size(0) {}
+	~CBlobUndoTracker() { mem_free(m_pCommitted); }
+
+	void Init(const void *pData, int Size)
+	{
+		mem_free(m_pCommitted);
+		m_pCommitted = (unsigned char *)mem_alloc(Size+1, 1);
+		mem_copy(m_pCommitted, pData, Size);
+		m_Size = Size;
+	}
+
+	bool Commit(int Type, int Index, const void *pData, int Size, CUndoStep *pStep)
+	{
+		if(Size == m_Size && mem_comp(pData, m_pCommitted, Size) == 0)
+			return false;
+
+		CUndoStep::CItem *pItem = pStep->AddItem(Type, Index, m_Size, Size);
+		mem_copy(pItem->m_pBefore, m_pCommitted, m_Size);
+		mem_copy(pItem->m_pAfter, pData, Size);
+		Init(pData, Size);
+		return true;
+	}
+
+	// takes one side of a recorded item as the committed state, the caller copies it into the map
+	void Apply(const CUndoStep::CItem *pItem, bool Before)
+	{
+		if(Before)
+			Init(pItem->m_pBefore, pItem->m_BeforeSize);
+		else
+			Init(pItem->m_pAfter, pItem->m_AfterSize);
+	}
+
+	const void *Data() const { return m_pCommitted; }
+	int Size() const { return m_Size; }
+
+private:
+	unsigned char *m_pCommitted;
+	int m_Size;
+};
+
+// the steps in order, the ones from m_Current on were undone and can be redone
+class CUndoHistory
+{
+public:
+	CUndoHistory() : m_Current(0), m_MemoryUsage(0) {}
+	~CUndoHistory() { Clear(); }
+
+	void Clear()
+	{
+		m_lSteps.delete_all();
+		m_Current = 0;
+		m_MemoryUsage = 0;
+	}
+
+	// takes the step over. drops the undone steps, and the oldest ones while the history is over the limit
+	void Push(CUndoStep *pStep, int MemoryLimit)
+	{
+		while(m_lSteps.size() > m_Current)
+		{
+			m_MemoryUsage -= m_lSteps[m_lSteps.size()-1]->m_MemoryUsage;
+			delete m_lSteps[m_lSteps.size()-1];
+			m_lSteps.remove_index(m_lSteps.size()-1);
+		}
+
+		m_lSteps.add(pStep);
+		m_Current++;
+		m_MemoryUsage += pStep->m_MemoryUsage;
+
+		while(m_MemoryUsage > MemoryLimit && m_lSteps.size() > 1)
+		{
+			m_MemoryUsage -= m_lSteps[0]->m_MemoryUsage;
+			delete m_lSteps[0];
+			m_lSteps.remove_index(0);
+			m_Current--;
+		}
+	}
+
+	CUndoStep *Undo() { return m_Current > 0 ? m_lSteps[--m_Current] : 0; }
+	CUndoStep *Redo() { return m_Current < m_lSteps.size() ? m_lSteps[m_Current++] : 0; }
+
+	int NumSteps() const { return m_lSteps.size(); }
+	int Current() const { return m_Current; }
+	const CUndoStep *Step(int Index) const { return m_lSteps[Index]; }
+	int MemoryUsage() const { return m_MemoryUsage; }
+
+private:
+	array<CUndoStep *> m_lSteps;
+	int m_Current;
+	int m_MemoryUsage;
+};
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef GAME_SOLIDMAP_H
+#define GAME_SOLIDMAP_H
+
+#include <base/math.h>
+#include <base/system.h>
+
+// a bit per game tile that stops points, the same tiles CCollision::IsSolid reports
+class CSolidMap
+{
+	unsigned *m_pBits;
+	int m_Width;
+	int m_Height;
+	int m_Pitch; // words per row
+
+public:
+	CSolidMap() : m_pBits(0), m_Width(0), m_Height(0), m_Pitch(0) {}
+	~CSolidMap() { Clear(); }
+
+	void Init(int Width, int Height)
+	{
+		Clear();
+		m_Width = Width;
+		m_Height = Height;
+		m_Pitch = (Width+31)/32;
+		m_pBits = (unsigned *)mem_alloc(m_Pitch*Height*sizeof(unsigned), sizeof(unsigned));
+		mem_zero(m_pBits, m_Pitch*Height*sizeof(unsigned));
+	}
+
+	void Clear()
+	{
+		if(m_pBits)
+			mem_free(m_pBits);
+		m_pBits = 0;
+		m_Width = 0;
+		m_Height = 0;
+		m_Pitch = 0;
+	}
+
+	void Set(int TileX, int TileY, bool Solid)
+	{
+		unsigned *pWord = &m_pBits[TileY*m_Pitch + (TileX>>5)];
+		if(Solid)
+			*pWord |= 1u<<(TileX&31);
+		else
+			*pWord &= ~(1u<<(TileX&31));
+	}
+
+	// clamps like CCollision::GetTile, points outside of the map hit the border tiles
+	bool CheckPoint(float x, float y) const
+	{
+		if(!m_pBits)
+			return false;
+		int TileX = clamp(round_to_int(x)/32, 0, m_Width-1);
+		int TileY = clamp(round_to_int(y)/32, 0, m_Height-1);
+		return (m_pBits[TileY*m_Pitch + (TileX>>5)]>>(TileX&31))&1;
+	}
+};
+
+#endif
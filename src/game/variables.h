@@ -63,7 +63,7 @@ MACRO_CONFIG_INT(ClEyeDuration, cl_eye_duration, 999999, 1, 999999, CFGFLAG_CLIE
 
 MACRO_CONFIG_INT(ClAirjumpindicator, cl_airjumpindicator, 1, 0, 1, CFGFLAG_CLIENT|CFGFLAG_SAVE, "")
 MACRO_CONFIG_INT(ClThreadsoundloading, cl_threaded_soundloading, 1, 0, 1, CFGFLAG_CLIENT|CFGFLAG_SAVE, "Load sound files threaded to speed up client start")
-MACRO_CONFIG_INT(ClThreadskinloading, cl_threaded_skinloading, 0, 0, 1, CFGFLAG_CLIENT|CFGFLAG_SAVE, "[BROKEN] Load skin textures threaded and on demand to speed up client start")
+MACRO_CONFIG_INT(ClThreadskinloading, cl_threaded_skinloading, 0, 0, 1, CFGFLAG_CLIENT|CFGFLAG_SAVE, "Load skin textures on demand instead of all of them at client start")
 
 MACRO_CONFIG_INT(ClWarningTeambalance, cl_warning_teambalance, 1, 0, 1, CFGFLAG_CLIENT|CFGFLAG_SAVE, "Warn about team balance")
 
@@ -1,5 +1,8 @@
 /* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <unordered_map>
+#include <vector>
+
 #include <base/system.h>
 
 #include <engine/config.h>
@@ -8,6 +11,7 @@
 #include <engine/storage.h>
 
 #include <engine/shared/config.h>
+#include <engine/shared/netaddr_hash.h>
 #include <engine/shared/netban.h>
 #include <engine/shared/network.h>
 
@@ -16,8 +20,6 @@
 enum {
 	MTU = 1400,
 	MAX_SERVERS_PER_PACKET=75,
-	MAX_PACKETS=16,
-	MAX_SERVERS=MAX_SERVERS_PER_PACKET*MAX_PACKETS,
 	EXPIRE_TIME = 90
 };
 
@@ -28,45 +30,181 @@ struct CCheckServer
 	NETADDR m_AltAddress;
 	int m_TryCount;
 	int64 m_TryTime;
+	int m_Index; // in m_apCheckServers
 };
 
-static CCheckServer m_aCheckServers[MAX_SERVERS];
-static int m_NumCheckServers = 0;
+// the answer to a check comes from either address
+typedef std::unordered_multimap<NETADDR, CCheckServer *, CNetAddrHasher, CNetAddrEqual> CCheckServerMap;
+
+static std::vector<CCheckServer *> m_apCheckServers;
+static CCheckServerMap m_CheckServerMap;
 
 struct CServerEntry
 {
 	enum ServerType m_Type;
-	NETADDR m_Address;
+	NETADDR m_Addr;
 	int64 m_Expire;
+	int m_Page;
+	int m_Slot;
+	CServerEntry *m_pNextIp;
 };
 
-static CServerEntry m_aServers[MAX_SERVERS];
-static int m_NumServers = 0;
-
-struct CPacketData
+// the servers of one type, grouped by the list packet that carries them. a server that comes or goes
+// only dirties its own packet, the others are sent as they were serialized
+class CServerPages
 {
-	int m_Size;
-	struct {
-		unsigned char m_aHeader[sizeof(SERVERBROWSE_LIST)];
-		CMastersrvAddr m_aServers[MAX_SERVERS_PER_PACKET];
-	} m_Data;
-};
+public:
+	CServerPages() : m_Type(SERVERTYPE_INVALID) {}
+	~CServerPages()
+	{
+		for(unsigned i = 0; i < m_apPages.size(); i++)
+			delete m_apPages[i];
+	}
 
-CPacketData m_aPackets[MAX_PACKETS];
-static int m_NumPackets = 0;
+	void Init(ServerType Type) { m_Type = Type; }
 
-// legacy code
-struct CPacketDataLegacy
-{
-	int m_Size;
-	struct {
-		unsigned char m_aHeader[sizeof(SERVERBROWSE_LIST_LEGACY)];
-		CMastersrvAddrLegacy m_aServers[MAX_SERVERS_PER_PACKET];
-	} m_Data;
+	CServerEntry *Add(const NETADDR *pAddr)
+	{
+		// fill the gaps first, so the packets stay full
+		int Page = 0;
+		while(Page < (int)m_apPages.size() && m_apPages[Page]->m_NumUsed == MAX_SERVERS_PER_PACKET)
+			Page++;
+		if(Page == (int)m_apPages.size())
+		{
+			CPage *pPage = new CPage;
+			mem_zero(pPage, sizeof(CPage));
+			m_apPages.push_back(pPage);
+		}
+
+		CPage *pPage = m_apPages[Page];
+		int Slot = 0;
+		while(pPage->m_aUsed[Slot])
+			Slot++;
+		pPage->m_aUsed[Slot] = true;
+		pPage->m_NumUsed++;
+		pPage->m_Dirty = true;
+
+		CServerEntry *pEntry = &pPage->m_aEntries[Slot];
+		pEntry->m_Type = m_Type;
+		pEntry->m_Addr = *pAddr;
+		pEntry->m_Page = Page;
+		pEntry->m_Slot = Slot;
+		pEntry->m_pNextIp = 0;
+		return pEntry;
+	}
+
+	void Remove(CServerEntry *pEntry)
+	{
+		CPage *pPage = m_apPages[pEntry->m_Page];
+		pPage->m_aUsed[pEntry->m_Slot] = false;
+		pPage->m_NumUsed--;
+		pPage->m_Dirty = true;
+	}
+
+	int NumPages() const { return (int)m_apPages.size(); }
+	int NumUsed(int Page) const { return m_apPages[Page]->m_NumUsed; }
+	bool Used(int Page, int Slot) const { return m_apPages[Page]->m_aUsed[Slot]; }
+	CServerEntry *Entry(int Page, int Slot) { return &m_apPages[Page]->m_aEntries[Slot]; }
+
+	// serializes the packets that changed, returns how many
+	int Build()
+	{
+		int NumBuilt = 0;
+		for(unsigned i = 0; i < m_apPages.size(); i++)
+		{
+			if(!m_apPages[i]->m_Dirty)
+				continue;
+			if(m_Type == SERVERTYPE_LEGACY)
+				BuildLegacy(m_apPages[i]);
+			else
+				BuildNormal(m_apPages[i]);
+			m_apPages[i]->m_Dirty = false;
+			NumBuilt++;
+		}
+		return NumBuilt;
+	}
+
+	// as of the last build
+	void Send(CNetClient *pNet, const NETADDR *pAddr) const
+	{
+		CNetChunk p;
+		p.m_ClientID = -1;
+		p.m_Address = *pAddr;
+		p.m_Flags = NETSENDFLAG_CONNLESS;
+
+		for(unsigned i = 0; i < m_apPages.size(); i++)
+		{
+			if(m_apPages[i]->m_Size <= (int)sizeof(SERVERBROWSE_LIST))
+				continue;
+			p.m_DataSize = m_apPages[i]->m_Size;
+			p.m_pData = m_apPages[i]->m_aData;
+			pNet->Send(&p);
+		}
+	}
+
+private:
+	struct CPage
+	{
+		CServerEntry m_aEntries[MAX_SERVERS_PER_PACKET];
+		bool m_aUsed[MAX_SERVERS_PER_PACKET];
+		int m_NumUsed;
+		bool m_Dirty;
+
+		// the list packet, the legacy one is smaller
+		int m_Size;
+		unsigned char m_aData[sizeof(SERVERBROWSE_LIST)+MAX_SERVERS_PER_PACKET*sizeof(CMastersrvAddr)];
+	};
+
+	ServerType m_Type;
+	std::vector<CPage *> m_apPages;
+
+	static void BuildNormal(CPage *pPage)
+	{
+		static const unsigned char s_aIPV4Mapping[] = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF };
+
+		mem_copy(pPage->m_aData, SERVERBROWSE_LIST, sizeof(SERVERBROWSE_LIST));
+		CMastersrvAddr *pAddr = (CMastersrvAddr *)(pPage->m_aData+sizeof(SERVERBROWSE_LIST));
+		for(int i = 0; i < MAX_SERVERS_PER_PACKET; i++)
+		{
+			if(!pPage->m_aUsed[i])
+				continue;
+			const NETADDR *pServerAddr = &pPage->m_aEntries[i].m_Addr;
+			if(pServerAddr->type == NETTYPE_IPV6)
+				mem_copy(pAddr->m_aIp, pServerAddr->ip, sizeof(pAddr->m_aIp));
+			else
+			{
+				mem_copy(pAddr->m_aIp, s_aIPV4Mapping, sizeof(s_aIPV4Mapping));
+				mem_copy(&pAddr->m_aIp[12], pServerAddr->ip, 4);
+			}
+			pAddr->m_aPort[0] = (pServerAddr->port>>8)&0xff;
+			pAddr->m_aPort[1] = pServerAddr->port&0xff;
+			pAddr++;
+		}
+		pPage->m_Size = (unsigned char *)pAddr - pPage->m_aData;
+	}
+
+	static void BuildLegacy(CPage *pPage)
+	{
+		mem_copy(pPage->m_aData, SERVERBROWSE_LIST_LEGACY, sizeof(SERVERBROWSE_LIST_LEGACY));
+		CMastersrvAddrLegacy *pAddr = (CMastersrvAddrLegacy *)(pPage->m_aData+sizeof(SERVERBROWSE_LIST_LEGACY));
+		for(int i = 0; i < MAX_SERVERS_PER_PACKET; i++)
+		{
+			if(!pPage->m_aUsed[i])
+				continue;
+			const NETADDR *pServerAddr = &pPage->m_aEntries[i].m_Addr;
+			mem_copy(pAddr->m_aIp, pServerAddr->ip, sizeof(pAddr->m_aIp));
+			// 0.5 has the port in little endian on the network
+			pAddr->m_aPort[0] = pServerAddr->port&0xff;
+			pAddr->m_aPort[1] = (pServerAddr->port>>8)&0xff;
+			pAddr++;
+		}
+		pPage->m_Size = (unsigned char *)pAddr - pPage->m_aData;
+	}
 };
 
-CPacketDataLegacy m_aPacketsLegacy[MAX_PACKETS];
-static int m_NumPacketsLegacy = 0;
+static CServerPages m_aServerPages[2]; // by ServerType
+static CNetAddrHashTable<CServerEntry> m_ServerTable;
+static int m_NumServers = 0;
 
 
 struct CCountPacketData
@@ -89,82 +227,8 @@ IConsole *m_pConsole;
 
 void BuildPackets()
 {
-	CServerEntry *pCurrent = &m_aServers[0];
-	int ServersLeft = m_NumServers;
-	m_NumPackets = 0;
-	m_NumPacketsLegacy = 0;
-	int PacketIndex = 0;
-	int PacketIndexLegacy = 0;
-	while(ServersLeft-- && (m_NumPackets + m_NumPacketsLegacy) < MAX_PACKETS)
-	{
-		if(pCurrent->m_Type == SERVERTYPE_NORMAL)
-		{
-			if(PacketIndex % MAX_SERVERS_PER_PACKET == 0)
-			{
-				PacketIndex = 0;
-				m_NumPackets++;
-			}
-
-			// copy header
-			mem_copy(m_aPackets[m_NumPackets-1].m_Data.m_aHeader, SERVERBROWSE_LIST, sizeof(SERVERBROWSE_LIST));
-
-			// copy server addresses
-			if(pCurrent->m_Address.type == NETTYPE_IPV6)
-			{
-				mem_copy(m_aPackets[m_NumPackets-1].m_Data.m_aServers[PacketIndex].m_aIp, pCurrent->m_Address.ip,
-					sizeof(m_aPackets[m_NumPackets-1].m_Data.m_aServers[PacketIndex].m_aIp));
-			}
-			else
-			{
-				static char IPV4Mapping[] = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, (char)0xFF, (char)0xFF };
-
-				mem_copy(m_aPackets[m_NumPackets-1].m_Data.m_aServers[PacketIndex].m_aIp, IPV4Mapping, sizeof(IPV4Mapping));
-				m_aPackets[m_NumPackets-1].m_Data.m_aServers[PacketIndex].m_aIp[12] = pCurrent->m_Address.ip[0];
-				m_aPackets[m_NumPackets-1].m_Data.m_aServers[PacketIndex].m_aIp[13] = pCurrent->m_Address.ip[1];
-				m_aPackets[m_NumPackets-1].m_Data.m_aServers[PacketIndex].m_aIp[14] = pCurrent->m_Address.ip[2];
-				m_aPackets[m_NumPackets-1].m_Data.m_aServers[PacketIndex].m_aIp[15] = pCurrent->m_Address.ip[3];
-			}
-
-			m_aPackets[m_NumPackets-1].m_Data.m_aServers[PacketIndex].m_aPort[0] = (pCurrent->m_Address.port>>8)&0xff;
-			m_aPackets[m_NumPackets-1].m_Data.m_aServers[PacketIndex].m_aPort[1] = pCurrent->m_Address.port&0xff;
-
-			PacketIndex++;
-
-			m_aPackets[m_NumPackets-1].m_Size = sizeof(SERVERBROWSE_LIST) + sizeof(CMastersrvAddr)*PacketIndex;
-
-			pCurrent++;
-		}
-		else if(pCurrent->m_Type == SERVERTYPE_LEGACY)
-		{
-			if(PacketIndexLegacy % MAX_SERVERS_PER_PACKET == 0)
-			{
-				PacketIndexLegacy = 0;
-				m_NumPacketsLegacy++;
-			}
-
-			// copy header
-			mem_copy(m_aPacketsLegacy[m_NumPacketsLegacy-1].m_Data.m_aHeader, SERVERBROWSE_LIST_LEGACY, sizeof(SERVERBROWSE_LIST_LEGACY));
-
-			// copy server addresses
-			mem_copy(m_aPacketsLegacy[m_NumPacketsLegacy-1].m_Data.m_aServers[PacketIndexLegacy].m_aIp, pCurrent->m_Address.ip,
-				sizeof(m_aPacketsLegacy[m_NumPacketsLegacy-1].m_Data.m_aServers[PacketIndexLegacy].m_aIp));
-			// 0.5 has the port in little endian on the network
-			m_aPacketsLegacy[m_NumPacketsLegacy-1].m_Data.m_aServers[PacketIndexLegacy].m_aPort[0] = pCurrent->m_Address.port&0xff;
-			m_aPacketsLegacy[m_NumPacketsLegacy-1].m_Data.m_aServers[PacketIndexLegacy].m_aPort[1] = (pCurrent->m_Address.port>>8)&0xff;
-
-			PacketIndexLegacy++;
-
-			m_aPacketsLegacy[m_NumPacketsLegacy-1].m_Size = sizeof(SERVERBROWSE_LIST_LEGACY) + sizeof(CMastersrvAddrLegacy)*PacketIndexLegacy;
-
-			pCurrent++;
-		}
-		else
-		{
-			*pCurrent = m_aServers[m_NumServers-1];
-			m_NumServers--;
-			dbg_msg("mastersrv", "ERROR: server of invalid type, dropping it");
-		}
-	}
+	m_aServerPages[SERVERTYPE_NORMAL].Build();
+	m_aServerPages[SERVERTYPE_LEGACY].Build();
 }
 
 void SendOk(NETADDR *pAddr)
@@ -203,56 +267,83 @@ void SendCheck(NETADDR *pAddr)
 	m_NetChecker.Send(&p);
 }
 
-void AddCheckserver(NETADDR *pInfo, NETADDR *pAlt, ServerType Type)
+CCheckServer *FindCheckserver(const NETADDR *pAddr)
 {
-	// add server
-	if(m_NumCheckServers == MAX_SERVERS)
+	CCheckServerMap::iterator it = m_CheckServerMap.find(*pAddr);
+	return it != m_CheckServerMap.end() ? it->second : 0;
+}
+
+void RemoveCheckserver(CCheckServer *pCheck)
+{
+	const NETADDR *apAddrs[] = {&pCheck->m_Address, &pCheck->m_AltAddress};
+	for(int a = 0; a < 2; a++)
 	{
-		dbg_msg("mastersrv", "ERROR: mastersrv is full");
-		return;
+		std::pair<CCheckServerMap::iterator, CCheckServerMap::iterator> Range = m_CheckServerMap.equal_range(*apAddrs[a]);
+		for(CCheckServerMap::iterator it = Range.first; it != Range.second; ++it)
+			if(it->second == pCheck)
+			{
+				m_CheckServerMap.erase(it);
+				break;
+			}
 	}
 
+	m_apCheckServers[pCheck->m_Index] = m_apCheckServers.back();
+	m_apCheckServers[pCheck->m_Index]->m_Index = pCheck->m_Index;
+	m_apCheckServers.pop_back();
+	delete pCheck;
+}
+
+void AddCheckserver(NETADDR *pInfo, NETADDR *pAlt, ServerType Type)
+{
+	// a heartbeat while the last one is still checked
+	if(FindCheckserver(pInfo))
+		return;
+
 	char aAddrStr[NETADDR_MAXSTRSIZE];
 	net_addr_str(pInfo, aAddrStr, sizeof(aAddrStr), true);
 	char aAltAddrStr[NETADDR_MAXSTRSIZE];
 	net_addr_str(pAlt, aAltAddrStr, sizeof(aAltAddrStr), true);
 	dbg_msg("mastersrv", "checking: %s (%s)", aAddrStr, aAltAddrStr);
-	m_aCheckServers[m_NumCheckServers].m_Address = *pInfo;
-	m_aCheckServers[m_NumCheckServers].m_AltAddress = *pAlt;
-	m_aCheckServers[m_NumCheckServers].m_TryCount = 0;
-	m_aCheckServers[m_NumCheckServers].m_TryTime = 0;
-	m_aCheckServers[m_NumCheckServers].m_Type = Type;
-	m_NumCheckServers++;
+
+	// add server
+	CCheckServer *pCheck = new CCheckServer;
+	pCheck->m_Address = *pInfo;
+	pCheck->m_AltAddress = *pAlt;
+	pCheck->m_TryCount = 0;
+	pCheck->m_TryTime = 0;
+	pCheck->m_Type = Type;
+	pCheck->m_Index = (int)m_apCheckServers.size();
+	m_apCheckServers.push_back(pCheck);
+	m_CheckServerMap.insert(std::make_pair(pCheck->m_Address, pCheck));
+	if(net_addr_comp(&pCheck->m_Address, &pCheck->m_AltAddress) != 0)
+		m_CheckServerMap.insert(std::make_pair(pCheck->m_AltAddress, pCheck));
 }
 
 void AddServer(NETADDR *pInfo, ServerType Type)
 {
 	// see if server already exists in list
-	for(int i = 0; i < m_NumServers; i++)
+	CServerEntry *pEntry = m_ServerTable.Find(pInfo);
+	if(pEntry)
 	{
-		if(net_addr_comp(&m_aServers[i].m_Address, pInfo) == 0)
-		{
-			char aAddrStr[NETADDR_MAXSTRSIZE];
-			net_addr_str(pInfo, aAddrStr, sizeof(aAddrStr), true);
-			dbg_msg("mastersrv", "updated: %s", aAddrStr);
-			m_aServers[i].m_Expire = time_get()+time_freq()*EXPIRE_TIME;
-			return;
-		}
+		char aAddrStr[NETADDR_MAXSTRSIZE];
+		net_addr_str(pInfo, aAddrStr, sizeof(aAddrStr), true);
+		dbg_msg("mastersrv", "updated: %s", aAddrStr);
+		pEntry->m_Expire = time_get()+time_freq()*EXPIRE_TIME;
+		return;
 	}
 
-	// add server
-	if(m_NumServers == MAX_SERVERS)
+	if(Type != SERVERTYPE_NORMAL && Type != SERVERTYPE_LEGACY)
 	{
-		dbg_msg("mastersrv", "ERROR: mastersrv is full");
+		dbg_msg("mastersrv", "ERROR: server of invalid type, dropping it");
 		return;
 	}
 
 	char aAddrStr[NETADDR_MAXSTRSIZE];
 	net_addr_str(pInfo, aAddrStr, sizeof(aAddrStr), true);
 	dbg_msg("mastersrv", "added: %s", aAddrStr);
-	m_aServers[m_NumServers].m_Address = *pInfo;
-	m_aServers[m_NumServers].m_Expire = time_get()+time_freq()*EXPIRE_TIME;
-	m_aServers[m_NumServers].m_Type = Type;
+	pEntry = m_aServerPages[Type].Add(pInfo);
+	pEntry->m_Expire = time_get()+time_freq()*EXPIRE_TIME;
+	m_ServerTable.Insert(pEntry);
 	m_NumServers++;
 }
 
@@ -260,32 +351,32 @@ void UpdateServers()
 {
 	int64 Now = time_get();
 	int64 Freq = time_freq();
-	for(int i = 0; i < m_NumCheckServers; i++)
+	for(int i = 0; i < (int)m_apCheckServers.size(); i++)
 	{
-		if(Now > m_aCheckServers[i].m_TryTime+Freq)
+		CCheckServer *pCheck = m_apCheckServers[i];
+		if(Now > pCheck->m_TryTime+Freq)
 		{
-			if(m_aCheckServers[i].m_TryCount == 10)
+			if(pCheck->m_TryCount == 10)
 			{
 				char aAddrStr[NETADDR_MAXSTRSIZE];
-				net_addr_str(&m_aCheckServers[i].m_Address, aAddrStr, sizeof(aAddrStr), true);
+				net_addr_str(&pCheck->m_Address, aAddrStr, sizeof(aAddrStr), true);
 				char aAltAddrStr[NETADDR_MAXSTRSIZE];
-				net_addr_str(&m_aCheckServers[i].m_AltAddress, aAltAddrStr, sizeof(aAltAddrStr), true);
+				net_addr_str(&pCheck->m_AltAddress, aAltAddrStr, sizeof(aAltAddrStr), true);
 				dbg_msg("mastersrv", "check failed: %s (%s)", aAddrStr, aAltAddrStr);
 
 				// FAIL!!
-				SendError(&m_aCheckServers[i].m_Address);
-				m_aCheckServers[i] = m_aCheckServers[m_NumCheckServers-1];
-				m_NumCheckServers--;
+				SendError(&pCheck->m_Address);
+				RemoveCheckserver(pCheck);
 				i--;
 			}
 			else
 			{
-				m_aCheckServers[i].m_TryCount++;
-				m_aCheckServers[i].m_TryTime = Now;
-				if(m_aCheckServers[i].m_TryCount&1)
-					SendCheck(&m_aCheckServers[i].m_Address);
+				pCheck->m_TryCount++;
+				pCheck->m_TryTime = Now;
+				if(pCheck->m_TryCount&1)
+					SendCheck(&pCheck->m_Address);
 				else
-					SendCheck(&m_aCheckServers[i].m_AltAddress);
+					SendCheck(&pCheck->m_AltAddress);
 			}
 		}
 	}
@@ -294,20 +385,26 @@ void UpdateServers()
 void PurgeServers()
 {
 	int64 Now = time_get();
-	int i = 0;
-	while(i < m_NumServers)
+	for(int t = SERVERTYPE_NORMAL; t <= SERVERTYPE_LEGACY; t++)
 	{
-		if(m_aServers[i].m_Expire < Now)
+		CServerPages *pPages = &m_aServerPages[t];
+		for(int p = 0; p < pPages->NumPages(); p++)
 		{
-			// remove server
-			char aAddrStr[NETADDR_MAXSTRSIZE];
-			net_addr_str(&m_aServers[i].m_Address, aAddrStr, sizeof(aAddrStr), true);
-			dbg_msg("mastersrv", "expired: %s", aAddrStr);
-			m_aServers[i] = m_aServers[m_NumServers-1];
-			m_NumServers--;
+			for(int i = 0; i < MAX_SERVERS_PER_PACKET && pPages->NumUsed(p); i++)
+			{
+				CServerEntry *pEntry = pPages->Entry(p, i);
+				if(!pPages->Used(p, i) || pEntry->m_Expire >= Now)
+					continue;
+
+				// remove server
+				char aAddrStr[NETADDR_MAXSTRSIZE];
+				net_addr_str(&pEntry->m_Addr, aAddrStr, sizeof(aAddrStr), true);
+				dbg_msg("mastersrv", "expired: %s", aAddrStr);
+				m_ServerTable.Remove(pEntry);
+				pPages->Remove(pEntry);
+				m_NumServers--;
+			}
 		}
-		else
-			i++;
 	}
 }
 
@@ -319,7 +416,7 @@ void ReloadBans()
 
 int main(int argc, const char **argv) // ignore_convention
 {
-	int64 LastBuild = 0, LastBanReload = 0;
+	int64 LastBuild = 0, LastPurge = 0, LastBanReload = 0;
 	ServerType Type = SERVERTYPE_INVALID;
 	NETADDR BindAddr;
 
@@ -327,6 +424,8 @@ int main(int argc, const char **argv) // ignore_convention
 	net_init();
 
 	mem_copy(m_CountData.m_Header, SERVERBROWSE_COUNT, sizeof(SERVERBROWSE_COUNT));
+	m_aServerPages[SERVERTYPE_NORMAL].Init(SERVERTYPE_NORMAL);
+	m_aServerPages[SERVERTYPE_LEGACY].Init(SERVERTYPE_LEGACY);
 	mem_copy(m_CountDataLegacy.m_Header, SERVERBROWSE_COUNT_LEGACY, sizeof(SERVERBROWSE_COUNT_LEGACY));
 
 	IKernel *pKernel = IKernel::Create();
@@ -427,8 +526,9 @@ int main(int argc, const char **argv) // ignore_convention
 				p.m_Flags = NETSENDFLAG_CONNLESS;
 				p.m_DataSize = sizeof(m_CountData);
 				p.m_pData = &m_CountData;
-				m_CountData.m_High = (m_NumServers>>8)&0xff;
-				m_CountData.m_Low = m_NumServers&0xff;
+				int Count = min(m_NumServers, 0xffff);
+				m_CountData.m_High = (Count>>8)&0xff;
+				m_CountData.m_Low = Count&0xff;
 				m_NetOp.Send(&p);
 			}
 			else if(Packet.m_DataSize == sizeof(SERVERBROWSE_GETCOUNT_LEGACY) &&
@@ -442,8 +542,9 @@ int main(int argc, const char **argv) // ignore_convention
 				p.m_Flags = NETSENDFLAG_CONNLESS;
 				p.m_DataSize = sizeof(m_CountData);
 				p.m_pData = &m_CountDataLegacy;
-				m_CountDataLegacy.m_High = (m_NumServers>>8)&0xff;
-				m_CountDataLegacy.m_Low = m_NumServers&0xff;
+				int Count = min(m_NumServers, 0xffff);
+				m_CountDataLegacy.m_High = (Count>>8)&0xff;
+				m_CountDataLegacy.m_Low = Count&0xff;
 				m_NetOp.Send(&p);
 			}
 			else if(Packet.m_DataSize == sizeof(SERVERBROWSE_GETLIST) &&
@@ -452,17 +553,7 @@ int main(int argc, const char **argv) // ignore_convention
 				// someone requested the list
 				dbg_msg("mastersrv", "requested, responding with %d m_aServers", m_NumServers);
 
-				CNetChunk p;
-				p.m_ClientID = -1;
-				p.m_Address = Packet.m_Address;
-				p.m_Flags = NETSENDFLAG_CONNLESS;
-
-				for(int i = 0; i < m_NumPackets; i++)
-				{
-					p.m_DataSize = m_aPackets[i].m_Size;
-					p.m_pData = &m_aPackets[i].m_Data;
-					m_NetOp.Send(&p);
-				}
+				m_aServerPages[SERVERTYPE_NORMAL].Send(&m_NetOp, &Packet.m_Address);
 			}
 			else if(Packet.m_DataSize == sizeof(SERVERBROWSE_GETLIST_LEGACY) &&
 				mem_comp(Packet.m_pData, SERVERBROWSE_GETLIST_LEGACY, sizeof(SERVERBROWSE_GETLIST_LEGACY)) == 0)
@@ -470,17 +561,7 @@ int main(int argc, const char **argv) // ignore_convention
 				// someone requested the list
 				dbg_msg("mastersrv", "requested, responding with %d m_aServers", m_NumServers);
 
-				CNetChunk p;
-				p.m_ClientID = -1;
-				p.m_Address = Packet.m_Address;
-				p.m_Flags = NETSENDFLAG_CONNLESS;
-
-				for(int i = 0; i < m_NumPacketsLegacy; i++)
-				{
-					p.m_DataSize = m_aPacketsLegacy[i].m_Size;
-					p.m_pData = &m_aPacketsLegacy[i].m_Data;
-					m_NetOp.Send(&p);
-				}
+				m_aServerPages[SERVERTYPE_LEGACY].Send(&m_NetOp, &Packet.m_Address);
 			}
 		}
 
@@ -496,16 +577,11 @@ int main(int argc, const char **argv) // ignore_convention
 			{
 				Type = SERVERTYPE_INVALID;
 				// remove it from checking
-				for(int i = 0; i < m_NumCheckServers; i++)
+				CCheckServer *pCheck = FindCheckserver(&Packet.m_Address);
+				if(pCheck)
 				{
-					if(net_addr_comp(&m_aCheckServers[i].m_Address, &Packet.m_Address) == 0 ||
-						net_addr_comp(&m_aCheckServers[i].m_AltAddress, &Packet.m_Address) == 0)
-					{
-						Type = m_aCheckServers[i].m_Type;
-						m_NumCheckServers--;
-						m_aCheckServers[i] = m_aCheckServers[m_NumCheckServers];
-						break;
-					}
+					Type = pCheck->m_Type;
+					RemoveCheckserver(pCheck);
 				}
 
 				// drops servers that were not in the CheckServers list
@@ -524,11 +600,18 @@ int main(int argc, const char **argv) // ignore_convention
 			ReloadBans();
 		}
 
-		if(time_get()-LastBuild > time_freq()*5)
+		if(time_get()-LastPurge > time_freq()*5)
 		{
-			LastBuild = time_get();
+			LastPurge = time_get();
 
 			PurgeServers();
+		}
+
+		// the checks are retried every second, only the packets that changed are rebuilt
+		if(time_get()-LastBuild > time_freq())
+		{
+			LastBuild = time_get();
+
 			UpdateServers();
 			BuildPackets();
 		}
@@ -0,0 +1,55 @@
+#ifndef TESTING_TEST_H
+#define TESTING_TEST_H
+
+#include <stdlib.h>
+#include <base/system.h>
+
+// what the tests of the program found to differ from their reference. every test is a program of its own
+int g_NumMismatches = 0;
+
+// after the test ran: the numbers it adds to its line, and where it can check its results
+void test_result(const char *pWhat, int Num, double Us, char *pResult, int ResultSize);
+
+inline void test_init()
+{
+	dbg_logger_stdout();
+	time_get_raw();
+}
+
+// files the tests write go to the temp directory, the ones of the user stay untouched
+inline void test_temp_path(const char *pFilename, char *pPath, int Size)
+{
+#if defined(CONF_FAMILY_WINDOWS)
+	const char *pTemp = getenv("TEMP");
+#else
+	const char *pTemp = getenv("TMPDIR");
+#endif
+	str_format(pPath, Size, "%s/%s", pTemp ? pTemp : "/tmp", pFilename);
+}
+
+inline void test_finish(const char *pWhat, int Num, int64 Start, int64 End)
+{
+	int64 Dauer = End-Start;
+	double Us = (double)Dauer / (((double)time_freq())/1000000.0);
+	char aResult[512];
+	aResult[0] = 0;
+	test_result(pWhat, Num, Us, aResult, sizeof(aResult));
+	dbg_msg("main", "%s test %i took %lli time units (%f µs = %f ms), %s, %i mismatches", pWhat, Num, Dauer, Us, Us/1000.0, aResult, g_NumMismatches);
+}
+
+// a test with mismatches fails
+inline int test_exit()
+{
+	return g_NumMismatches ? 1 : 0;
+}
+
+#define CONDUCT_TEST(WHAT, NUM) \
+	{\
+		int64 start, end;\
+\
+		test_##WHAT(&start, NUM);\
+		end = time_get_raw();\
+		test_finish(#WHAT, NUM, start, end);\
+	}
+
+#endif
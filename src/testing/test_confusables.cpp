@@ -0,0 +1,106 @@
+#include <base/system.h>
+#include <engine/shared/protocol.h>
+#include "test.h"
+
+
+const int NUM_TEST_NAMES = MAX_CLIENTS;
+const int MAX_SKELETON_LENGTH = MAX_NAME_LENGTH*16;
+
+
+/* names made of code points from the end of the confusables table and of
+   ones with long decompositions, the worst case for the skeleton lookup */
+static const int s_aAdversarialChars[] = {
+	0x2a600, 0x2a392, 0x2a291, 0x2a20e, 0x29b30, 0x295b6,
+	0xfdfa, 0xfdfb, 0x3316, 0x33af, 0x1d400, 0x1d7ff,
+};
+
+char g_aaNames[NUM_TEST_NAMES][MAX_NAME_LENGTH];
+int g_aaSkeletons[NUM_TEST_NAMES][MAX_SKELETON_LENGTH];
+int g_aSkeletonLengths[NUM_TEST_NAMES];
+int g_NumConfusable;
+
+
+void generate_names()
+{
+	const int NumChars = sizeof(s_aAdversarialChars)/sizeof(s_aAdversarialChars[0]);
+	for(int i = 0; i < NUM_TEST_NAMES; i++)
+	{
+		char *pName = g_aaNames[i];
+		int Used = 0;
+		for(int c = 0; ; c++)
+		{
+			char aChar[4];
+			int Size = str_utf8_encode(aChar, s_aAdversarialChars[(i*7+c*3)%NumChars]);
+			if(Used + Size >= MAX_NAME_LENGTH)
+				break;
+			mem_copy(pName+Used, aChar, Size);
+			Used += Size;
+		}
+		pName[Used] = 0;
+	}
+}
+
+void test_compare(int64 *pTimeStart, int num)
+{
+	g_NumConfusable = 0;
+	*pTimeStart = time_get_raw();
+	for(int n = 0; n < num; n++)
+	{
+		// one name change checked against every other client
+		const char *pNewName = g_aaNames[n%NUM_TEST_NAMES];
+		for(int i = 0; i < NUM_TEST_NAMES; i++)
+			if(str_utf8_comp_confusable(pNewName, g_aaNames[i]) == 0)
+				g_NumConfusable++;
+	}
+}
+
+void test_skeleton(int64 *pTimeStart, int num)
+{
+	for(int i = 0; i < NUM_TEST_NAMES; i++)
+		g_aSkeletonLengths[i] = str_utf8_to_skeleton(g_aaNames[i], g_aaSkeletons[i], MAX_SKELETON_LENGTH);
+
+	g_NumConfusable = 0;
+	*pTimeStart = time_get_raw();
+	for(int n = 0; n < num; n++)
+	{
+		// one skeleton computation, then compare against the cached ones
+		int aSkeleton[MAX_SKELETON_LENGTH];
+		int Length = str_utf8_to_skeleton(g_aaNames[n%NUM_TEST_NAMES], aSkeleton, MAX_SKELETON_LENGTH);
+		for(int i = 0; i < NUM_TEST_NAMES; i++)
+			if(g_aSkeletonLengths[i] == Length && mem_comp(g_aaSkeletons[i], aSkeleton, Length*sizeof(int)) == 0)
+				g_NumConfusable++;
+	}
+}
+
+
+// both ways have to find the same names
+void test_result(const char *pWhat, int Num, double Us, char *pResult, int ResultSize)
+{
+	static int s_NumCompared = 0;
+	if(str_comp(pWhat, "compare") == 0)
+		s_NumCompared = g_NumConfusable;
+	else
+		g_NumMismatches += g_NumConfusable != s_NumCompared;
+	str_format(pResult, ResultSize, "%i confusable", g_NumConfusable);
+}
+
+
+int main()
+{
+	test_init();
+
+	generate_names();
+
+	CONDUCT_TEST(compare, 100);
+	CONDUCT_TEST(skeleton, 100);
+	dbg_msg("main", "------------------------");
+
+	CONDUCT_TEST(compare, 1000);
+	CONDUCT_TEST(skeleton, 1000);
+	dbg_msg("main", "------------------------");
+
+	CONDUCT_TEST(compare, 10000);
+	CONDUCT_TEST(skeleton, 10000);
+
+	return test_exit();
+}
@@ -0,0 +1,229 @@
+#include <base/system.h>
+#include <engine/shared/config.h>
+#include <game/editor/editor.h>
+#include <game/editor/undo.h>
+#include "test.h"
+
+// the editor names keys, the table comes with the input otherwise
+#include <engine/input.h>
+#define KEYS_INCLUDE
+#include <engine/client/keynames.h>
+#undef KEYS_INCLUDE
+
+
+const int LAYER_WIDTH = 1000;
+const int LAYER_HEIGHT = 1000;
+const int NUM_STROKES = 1000;
+const int STAMPS_PER_STROKE = 24;
+const int MEMORY_LIMIT = 256*1024*1024;
+
+
+// same layout as CTile
+struct CTestTile
+{
+	unsigned char m_Index;
+	unsigned char m_Flags;
+	unsigned char m_Skip;
+	unsigned char m_Reserved;
+};
+
+CTestTile *g_pTiles;
+CTestTile *g_pOriginal;
+CTestTile *g_pFinal;
+CTestTile *g_pSnapshot;
+CTileUndoTracker g_Tracker;
+CUndoHistory g_History;
+CUndoHistory *g_pHistory = &g_History;
+CEditor *g_pEditor;
+
+
+void setup()
+{
+	int Size = LAYER_WIDTH*LAYER_HEIGHT*sizeof(CTestTile);
+	g_pTiles = (CTestTile *)mem_alloc(Size, 1);
+	g_pOriginal = (CTestTile *)mem_alloc(Size, 1);
+	g_pFinal = (CTestTile *)mem_alloc(Size, 1);
+	g_pSnapshot = (CTestTile *)mem_alloc(Size, 1);
+
+	// some ground to paint over
+	unsigned Seed = 1;
+	for(int i = 0; i < LAYER_WIDTH*LAYER_HEIGHT; i++)
+	{
+		Seed = Seed*1103515245+12345;
+		mem_zero(&g_pTiles[i], sizeof(CTestTile));
+		g_pTiles[i].m_Index = (Seed>>16)%4 == 0 ? (Seed>>20)%256 : 0;
+	}
+	mem_copy(g_pOriginal, g_pTiles, Size);
+}
+
+// where the stamps of a stroke go
+void stroke_start(int n, unsigned *pSeed, int *pX, int *pY)
+{
+	*pSeed = n*2654435761u+1;
+	*pSeed = *pSeed*1103515245+12345;
+	*pX = (*pSeed>>8)%LAYER_WIDTH;
+	*pSeed = *pSeed*1103515245+12345;
+	*pY = (*pSeed>>8)%LAYER_HEIGHT;
+}
+
+void stroke_next(unsigned *pSeed, int *pX, int *pY)
+{
+	*pSeed = *pSeed*1103515245+12345;
+	*pX += (int)((*pSeed>>16)%5)-2;
+	*pSeed = *pSeed*1103515245+12345;
+	*pY += (int)((*pSeed>>16)%5)-2;
+}
+
+// one stroke of a 4x4 brush dragged across the layer, the way CLayerTiles::BrushDraw stamps it
+void stroke(int n, bool Track)
+{
+	unsigned Seed;
+	int x, y;
+	stroke_start(n, &Seed, &x, &y);
+	for(int s = 0; s < STAMPS_PER_STROKE; s++)
+	{
+		for(int by = 0; by < 4; by++)
+			for(int bx = 0; bx < 4; bx++)
+			{
+				int fx = x+bx, fy = y+by;
+				if(fx < 0 || fx >= LAYER_WIDTH || fy < 0 || fy >= LAYER_HEIGHT)
+					continue;
+				g_pTiles[fy*LAYER_WIDTH+fx].m_Index = 1+(n+bx+by)%255;
+				g_pTiles[fy*LAYER_WIDTH+fx].m_Flags = n%4;
+			}
+		if(Track)
+			g_Tracker.MarkDirty(x, y, 4, 4);
+		stroke_next(&Seed, &x, &y);
+	}
+}
+
+void test_snapshot(int64 *pTimeStart, int num)
+{
+	// what the old undo did for every step short of the disk: take the whole layer
+	mem_copy(g_pTiles, g_pOriginal, LAYER_WIDTH*LAYER_HEIGHT*sizeof(CTestTile));
+	*pTimeStart = time_get_raw();
+	for(int n = 0; n < num; n++)
+	{
+		stroke(n, false);
+		mem_copy(g_pSnapshot, g_pTiles, LAYER_WIDTH*LAYER_HEIGHT*sizeof(CTestTile));
+	}
+}
+
+void test_commit(int64 *pTimeStart, int num)
+{
+	mem_copy(g_pTiles, g_pOriginal, LAYER_WIDTH*LAYER_HEIGHT*sizeof(CTestTile));
+	g_History.Clear();
+	g_Tracker.Init(g_pTiles, LAYER_WIDTH, LAYER_HEIGHT, sizeof(CTestTile));
+	*pTimeStart = time_get_raw();
+	for(int n = 0; n < num; n++)
+	{
+		stroke(n, true);
+		CUndoStep *pStep = new CUndoStep;
+		g_Tracker.Commit(0, pStep);
+		g_History.Push(pStep, MEMORY_LIMIT);
+	}
+}
+
+void test_undo(int64 *pTimeStart, int num)
+{
+	mem_copy(g_pFinal, g_pTiles, LAYER_WIDTH*LAYER_HEIGHT*sizeof(CTestTile));
+	*pTimeStart = time_get_raw();
+	for(int n = 0; n < num; n++)
+	{
+		const CUndoStep *pStep = g_History.Undo();
+		if(!pStep)
+			break;
+		for(int i = 0; i < pStep->m_lItems.size(); i++)
+			g_Tracker.Apply(&pStep->m_lItems[i], true);
+	}
+	g_NumMismatches += mem_comp(g_pTiles, g_pOriginal, LAYER_WIDTH*LAYER_HEIGHT*sizeof(CTestTile)) != 0;
+}
+
+void test_redo(int64 *pTimeStart, int num)
+{
+	*pTimeStart = time_get_raw();
+	for(int n = 0; n < num; n++)
+	{
+		const CUndoStep *pStep = g_History.Redo();
+		if(!pStep)
+			break;
+		for(int i = 0; i < pStep->m_lItems.size(); i++)
+			g_Tracker.Apply(&pStep->m_lItems[i], false);
+	}
+	g_NumMismatches += mem_comp(g_pTiles, g_pFinal, LAYER_WIDTH*LAYER_HEIGHT*sizeof(CTestTile)) != 0;
+}
+
+// the strokes drawn by the editor's brush and committed the way the editor does once the mouse lets go.
+// only the chunks under a stroke may be compared, not the whole layer
+void test_editor(int64 *pTimeStart, int num)
+{
+	g_Config.m_ClEditorUndo = 1;
+	g_Config.m_ClEditorUndoMemory = MEMORY_LIMIT/(1024*1024);
+	g_pEditor = new CEditor;
+	g_pEditor->m_Map.m_pEditor = g_pEditor;
+	CLayerTiles *pLayer = new CLayerTiles(LAYER_WIDTH, LAYER_HEIGHT);
+	pLayer->m_pEditor = g_pEditor;
+	mem_copy(pLayer->m_pTiles, g_pOriginal, LAYER_WIDTH*LAYER_HEIGHT*sizeof(CTile));
+	g_pEditor->m_Map.NewGroup()->AddLayer(pLayer);
+	g_pEditor->ResetUndo();
+	g_pHistory = &g_pEditor->m_UndoHistory;
+
+	CLayerTiles Brush(4, 4);
+	Brush.m_pEditor = g_pEditor;
+	for(int i = 0; i < 4*4; i++)
+		Brush.m_pTiles[i].m_Index = 1+i;
+
+	const int ChunksX = (LAYER_WIDTH+CTileUndoTracker::CHUNK_SIZE-1)/CTileUndoTracker::CHUNK_SIZE;
+	const int ChunksY = (LAYER_HEIGHT+CTileUndoTracker::CHUNK_SIZE-1)/CTileUndoTracker::CHUNK_SIZE;
+	bool *pStroked = (bool *)mem_alloc(ChunksX*ChunksY, 1);
+
+	*pTimeStart = time_get_raw();
+	for(int n = 0; n < num; n++)
+	{
+		mem_zero(pStroked, ChunksX*ChunksY);
+		int NumStroked = 0;
+		unsigned Seed;
+		int x, y;
+		stroke_start(n, &Seed, &x, &y);
+		for(int s = 0; s < STAMPS_PER_STROKE; s++)
+		{
+			pLayer->BrushDraw(&Brush, x*32.0f, y*32.0f);
+			for(int by = max(y, 0); by < min(y+4, LAYER_HEIGHT); by++)
+				for(int bx = max(x, 0); bx < min(x+4, LAYER_WIDTH); bx++)
+				{
+					int Chunk = (by/CTileUndoTracker::CHUNK_SIZE)*ChunksX+bx/CTileUndoTracker::CHUNK_SIZE;
+					NumStroked += !pStroked[Chunk];
+					pStroked[Chunk] = true;
+				}
+			stroke_next(&Seed, &x, &y);
+		}
+
+		g_pEditor->CommitUndoStep();
+		g_NumMismatches += pLayer->m_aUndoPlanes[0].NumCompared() != NumStroked;
+	}
+
+	mem_free(pStroked);
+}
+
+
+void test_result(const char *pWhat, int Num, double Us, char *pResult, int ResultSize)
+{
+	str_format(pResult, ResultSize, "%ix%i layer, %.2f µs per step, %i steps with %i KiB", LAYER_WIDTH, LAYER_HEIGHT, Us/Num, g_pHistory->NumSteps(), g_pHistory->MemoryUsage()/1024);
+}
+
+
+int main()
+{
+	test_init();
+
+	setup();
+
+	CONDUCT_TEST(snapshot, NUM_STROKES);
+	CONDUCT_TEST(commit, NUM_STROKES);
+	CONDUCT_TEST(undo, NUM_STROKES);
+	CONDUCT_TEST(redo, NUM_STROKES);
+	CONDUCT_TEST(editor, NUM_STROKES);
+
+	delete g_pEditor;
+	return test_exit();
+}
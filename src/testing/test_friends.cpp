@@ -0,0 +1,163 @@
+#include <base/system.h>
+#include <engine/client/friends_lookup.h>
+#include "test.h"
+
+
+const int NUM_FRIENDS = 500;
+const int NUM_SERVERS = 2000;
+const int NUM_CLIENTS = 32;
+
+
+struct CTestClient
+{
+	char m_aName[MAX_NAME_LENGTH];
+	char m_aClan[MAX_CLAN_LENGTH];
+};
+
+CFriendInfo g_aFriends[NUM_FRIENDS];
+CTestClient *g_pClients;
+int *g_pStates;
+int *g_pReferenceStates;
+CFriendsLookup g_Lookup;
+int g_NumMarked;
+
+
+const char *const g_apWords[] = {"DDNet", "Vanilla", "Pro", "Block", "Race", "Fun", "CTF", "Teeworlds", "Zomb", "Insta", "GER", "USA", "RUS", "Novice", "Solo"};
+
+unsigned next_rand(unsigned *pSeed)
+{
+	*pSeed = *pSeed*1103515245+12345;
+	return *pSeed>>8;
+}
+
+void make_client(char *pName, int NameSize, char *pClan, int ClanSize, unsigned *pSeed)
+{
+	str_format(pName, NameSize, "%s%d", g_apWords[next_rand(pSeed)%15], next_rand(pSeed)%300);
+	if(next_rand(pSeed)%4 == 0)
+		pClan[0] = 0;
+	else
+		str_copy(pClan, g_apWords[next_rand(pSeed)%15], ClanSize);
+}
+
+void setup()
+{
+	g_pClients = (CTestClient *)mem_alloc(NUM_SERVERS*NUM_CLIENTS*sizeof(CTestClient), 1);
+	g_pStates = (int *)mem_alloc(NUM_SERVERS*NUM_CLIENTS*sizeof(int), 1);
+	g_pReferenceStates = (int *)mem_alloc(NUM_SERVERS*NUM_CLIENTS*sizeof(int), 1);
+
+	// mostly players, a few whole clans
+	unsigned Seed = 1;
+	for(int i = 0; i < NUM_FRIENDS; i++)
+	{
+		CFriendInfo *pFriend = &g_aFriends[i];
+		make_client(pFriend->m_aName, sizeof(pFriend->m_aName), pFriend->m_aClan, sizeof(pFriend->m_aClan), &Seed);
+		if(i%50 == 0)
+		{
+			pFriend->m_aName[0] = 0;
+			str_copy(pFriend->m_aClan, g_apWords[next_rand(&Seed)%15], sizeof(pFriend->m_aClan));
+		}
+		pFriend->m_NameHash = str_quickhash(pFriend->m_aName);
+		pFriend->m_ClanHash = str_quickhash(pFriend->m_aClan);
+	}
+
+	for(int i = 0; i < NUM_SERVERS*NUM_CLIENTS; i++)
+		make_client(g_pClients[i].m_aName, sizeof(g_pClients[i].m_aName), g_pClients[i].m_aClan, sizeof(g_pClients[i].m_aClan), &Seed);
+
+	g_Lookup.Build(g_aFriends, NUM_FRIENDS);
+}
+
+// what CFriends::GetFriendState did for every player of every server
+int reference_state(const char *pName, const char *pClan, bool IgnoreClan)
+{
+	int Result = IFriends::FRIEND_NO;
+	unsigned NameHash = str_quickhash(pName);
+	unsigned ClanHash = str_quickhash(pClan);
+	for(int i = 0; i < NUM_FRIENDS; ++i)
+	{
+		if((IgnoreClan && g_aFriends[i].m_aName[0]) || (g_aFriends[i].m_ClanHash == ClanHash && !str_comp(g_aFriends[i].m_aClan, pClan)))
+		{
+			if(g_aFriends[i].m_aName[0] == 0)
+				Result = IFriends::FRIEND_CLAN;
+			else if(g_aFriends[i].m_NameHash == NameHash && !str_comp(g_aFriends[i].m_aName, pName))
+			{
+				Result = IFriends::FRIEND_PLAYER;
+				break;
+			}
+		}
+	}
+	return Result;
+}
+
+void test_linear(int64 *pTimeStart, int num)
+{
+	*pTimeStart = time_get_raw();
+	g_NumMarked = 0;
+	for(int n = 0; n < num; n++)
+		for(int i = 0; i < NUM_SERVERS*NUM_CLIENTS; i++)
+		{
+			g_pReferenceStates[i] = reference_state(g_pClients[i].m_aName, g_pClients[i].m_aClan, false);
+			g_NumMarked += g_pReferenceStates[i] != IFriends::FRIEND_NO;
+		}
+}
+
+void test_lookup(int64 *pTimeStart, int num)
+{
+	*pTimeStart = time_get_raw();
+	g_NumMarked = 0;
+	for(int n = 0; n < num; n++)
+		for(int i = 0; i < NUM_SERVERS*NUM_CLIENTS; i++)
+		{
+			g_pStates[i] = g_Lookup.GetFriendState(g_pClients[i].m_aName, g_pClients[i].m_aClan, false);
+			g_NumMarked += g_pStates[i] != IFriends::FRIEND_NO;
+		}
+}
+
+void test_build(int64 *pTimeStart, int num)
+{
+	*pTimeStart = time_get_raw();
+	for(int n = 0; n < num; n++)
+		g_Lookup.Build(g_aFriends, NUM_FRIENDS);
+}
+
+void test_compare(int64 *pTimeStart, int num)
+{
+	*pTimeStart = time_get_raw();
+	g_NumMarked = 0;
+	for(int n = 0; n < num; n++)
+	{
+		// with and without cl_friends_ignore_clan, the players only check of the scoreboard too
+		bool IgnoreClan = n%2 == 1;
+		for(int i = 0; i < NUM_SERVERS*NUM_CLIENTS; i++)
+		{
+			const char *pName = g_pClients[i].m_aName;
+			const char *pClan = g_pClients[i].m_aClan;
+			int State = g_Lookup.GetFriendState(pName, pClan, IgnoreClan);
+			int ReferenceState = reference_state(pName, pClan, IgnoreClan);
+			g_NumMarked += State != IFriends::FRIEND_NO;
+			if(State != ReferenceState || g_Lookup.IsFriend(pName, pClan, false, IgnoreClan) != (ReferenceState != IFriends::FRIEND_NO) ||
+				g_Lookup.IsFriend(pName, pClan, true, IgnoreClan) != (ReferenceState == IFriends::FRIEND_PLAYER))
+				g_NumMismatches++;
+		}
+	}
+}
+
+
+void test_result(const char *pWhat, int Num, double Us, char *pResult, int ResultSize)
+{
+	str_format(pResult, ResultSize, "%i friends and %i servers, %.2f µs per round, %i marked", NUM_FRIENDS, NUM_SERVERS, Us/Num, g_NumMarked);
+}
+
+
+int main()
+{
+	test_init();
+
+	setup();
+
+	CONDUCT_TEST(linear, 1);
+	CONDUCT_TEST(lookup, 10);
+	CONDUCT_TEST(build, 100);
+	CONDUCT_TEST(compare, 2);
+
+	return test_exit();
+}
@@ -0,0 +1,212 @@
+#include <base/math.h>
+#include <base/system.h>
+#include <engine/external/pnglite/pnglite.h>
+#include <engine/client/image_cache.h>
+#include "test.h"
+
+
+const int MAX_IMAGES = 256;
+
+
+struct CPng
+{
+	char m_aName[128];
+	unsigned char *m_pData;
+	unsigned m_Size;
+};
+
+CPng g_aPngs[MAX_IMAGES];
+int g_NumPngs;
+char g_aCacheDir[1024];
+int g_NumLoaded;
+int64 g_CacheSize;
+
+
+int png_callback(const char *pName, int IsDir, int DirType, void *pUser)
+{
+	int Length = str_length(pName);
+	if(IsDir || Length < 4 || str_comp(pName+Length-4, ".png") != 0 || g_NumPngs == MAX_IMAGES)
+		return 0;
+
+	char aPath[256];
+	str_format(aPath, sizeof(aPath), "%s/%s", (const char *)pUser, pName);
+	IOHANDLE File = io_open(aPath, IOFLAG_READ);
+	if(!File)
+		return 0;
+	CPng *pPng = &g_aPngs[g_NumPngs++];
+	str_copy(pPng->m_aName, pName, sizeof(pPng->m_aName));
+	pPng->m_Size = (unsigned)io_length(File);
+	pPng->m_pData = (unsigned char *)mem_alloc(pPng->m_Size, 1);
+	io_read(File, pPng->m_pData, pPng->m_Size);
+	io_close(File);
+	return 0;
+}
+
+// the skins that come with the client, the pngs are read once so only the decoding and the cache get measured
+void setup()
+{
+	fs_listdir("data/skins", png_callback, 0, (void *)"data/skins");
+
+	test_temp_path("test_image_cache", g_aCacheDir, sizeof(g_aCacheDir));
+	fs_makedir(g_aCacheDir);
+}
+
+struct CReadBuffer
+{
+	const unsigned char *m_pData;
+	unsigned m_Size;
+	unsigned m_Pos;
+};
+
+// what CGraphics_Threaded::DecodePNG reads from
+unsigned read_callback(void *pOutput, unsigned long Size, unsigned long Numel, void *pUser)
+{
+	CReadBuffer *pBuffer = (CReadBuffer *)pUser;
+	unsigned Bytes = min((unsigned)(Size*Numel), pBuffer->m_Size - pBuffer->m_Pos);
+	if(pOutput)
+		mem_copy(pOutput, pBuffer->m_pData + pBuffer->m_Pos, Bytes);
+	pBuffer->m_Pos += Bytes;
+	return Size ? Bytes/Size : 0;
+}
+
+bool decode(const CPng *pPng, CImageInfo *pImg)
+{
+	png_t Png; // ignore_convention
+	CReadBuffer Buffer = {pPng->m_pData, pPng->m_Size, 0};
+	if(png_open(&Png, read_callback, &Buffer) != PNG_NO_ERROR) // ignore_convention
+		return false;
+	if(Png.depth != 8 || (Png.color_type != PNG_TRUECOLOR && Png.color_type != PNG_TRUECOLOR_ALPHA)) // ignore_convention
+		return false;
+	unsigned char *pBuffer = (unsigned char *)mem_alloc(Png.width * Png.height * Png.bpp, 1); // ignore_convention
+	if(png_get_data(&Png, pBuffer) != PNG_NO_ERROR) // ignore_convention
+	{
+		mem_free(pBuffer);
+		return false;
+	}
+	pImg->m_Width = Png.width; // ignore_convention
+	pImg->m_Height = Png.height; // ignore_convention
+	pImg->m_Format = Png.color_type == PNG_TRUECOLOR ? CImageInfo::FORMAT_RGB : CImageInfo::FORMAT_RGBA; // ignore_convention
+	pImg->m_pData = pBuffer;
+	return true;
+}
+
+void cache_file(const CPng *pPng, char *pPath, int Size)
+{
+	MD5_HASH Hash = md5_simple(pPng->m_pData, pPng->m_Size);
+	char aHash[33];
+	str_hex_simple(aHash, sizeof(aHash), Hash.digest, sizeof(Hash.digest));
+	str_format(pPath, Size, "%s/%s.img", g_aCacheDir, aHash);
+}
+
+// the first start: hash, miss, decode and write the decoded image
+void test_cold(int64 *pTimeStart, int num)
+{
+	png_init(0, 0); // ignore_convention
+	*pTimeStart = time_get_raw();
+	g_NumLoaded = 0;
+	g_CacheSize = 0;
+	for(int i = 0; i < num; i++)
+	{
+		char aPath[1200];
+		cache_file(&g_aPngs[i], aPath, sizeof(aPath));
+		IOHANDLE File = io_open(aPath, IOFLAG_READ);
+		CImageInfo Img;
+		if(File && CImageCache::Load(File, &Img))
+			g_NumMismatches++;
+		if(File)
+			io_close(File);
+
+		if(!decode(&g_aPngs[i], &Img))
+			continue;
+		File = io_open(aPath, IOFLAG_WRITE);
+		if(File)
+		{
+			CImageCache::Save(File, &Img);
+			g_CacheSize += io_length(File);
+			io_close(File);
+			g_NumLoaded++;
+		}
+		else
+			g_NumMismatches++;
+		mem_free(Img.m_pData);
+	}
+}
+
+// every start after: hash and read the decoded image
+void test_warm(int64 *pTimeStart, int num)
+{
+	*pTimeStart = time_get_raw();
+	g_NumLoaded = 0;
+	for(int i = 0; i < num; i++)
+	{
+		char aPath[1200];
+		cache_file(&g_aPngs[i], aPath, sizeof(aPath));
+		IOHANDLE File = io_open(aPath, IOFLAG_READ);
+		if(!File)
+			continue;
+		CImageInfo Img;
+		if(CImageCache::Load(File, &Img))
+		{
+			g_NumLoaded++;
+			mem_free(Img.m_pData);
+		}
+		io_close(File);
+	}
+}
+
+// down to half the size, what is left has to fit
+void test_prune(int64 *pTimeStart, int num)
+{
+	*pTimeStart = time_get_raw();
+	g_NumLoaded = CImageCache::Prune(g_aCacheDir, g_CacheSize/2);
+
+	int NumLeft = 0;
+	int64 SizeLeft = 0;
+	for(int i = 0; i < num; i++)
+	{
+		char aPath[1200];
+		cache_file(&g_aPngs[i], aPath, sizeof(aPath));
+		IOHANDLE File = io_open(aPath, IOFLAG_READ);
+		if(!File)
+			continue;
+		NumLeft++;
+		SizeLeft += io_length(File);
+		io_close(File);
+	}
+	g_NumMismatches += SizeLeft > g_CacheSize/2 || NumLeft+g_NumLoaded != num;
+
+	// nothing stays behind
+	CImageCache::Prune(g_aCacheDir, 0);
+	fs_remove(g_aCacheDir);
+}
+
+
+// whatever the cold start wrote has to be read back
+void test_result(const char *pWhat, int Num, double Us, char *pResult, int ResultSize)
+{
+	static int s_NumWritten = 0;
+	if(str_comp(pWhat, "cold") == 0)
+		s_NumWritten = g_NumLoaded;
+	else if(str_comp(pWhat, "warm") == 0)
+		g_NumMismatches += g_NumLoaded != s_NumWritten;
+	str_format(pResult, ResultSize, "%.2f µs per image, %i images, %lli KiB in the cache", Us/Num, g_NumLoaded, g_CacheSize/1024);
+}
+
+
+int main()
+{
+	test_init();
+
+	setup();
+	if(!g_NumPngs)
+	{
+		dbg_msg("main", "no images in data/skins, run from the directory the client runs from");
+		return 1;
+	}
+
+	CONDUCT_TEST(cold, g_NumPngs);
+	CONDUCT_TEST(warm, g_NumPngs);
+	CONDUCT_TEST(prune, g_NumPngs);
+
+	return test_exit();
+}
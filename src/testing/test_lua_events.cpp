@@ -0,0 +1,210 @@
+#include <base/system.h>
+#include <engine/client/luaevents.h>
+#include "test.h"
+
+
+const int NUM_SCRIPTS = 20;
+const int NUM_LEVELS = 6;
+const int NUM_PLAYERS = 16;
+
+
+// what the scripts do: a few draw something, the rest hook events that are not about rendering
+const char *const g_apScripts[] = {
+	"RegisterEvent('OnRenderLevel', function(Level) g_Calls = g_Calls + 1 end)",
+	"function PreRenderPlayer(ID, PosX, PosY, DirX, DirY, OtherTeam) g_Calls = g_Calls + 1 end",
+	"RegisterEvent('OnRenderBackground', function() g_Calls = g_Calls + 1 end)",
+	"RegisterEvent('OnTick', function() g_Calls = g_Calls + 1 end)",
+	"RegisterEvent('OnChat', function(ID, Team, Msg) return false end)",
+	"function Helper(a, b) return a + b end",
+};
+
+struct CTestScript
+{
+	lua_State *m_pLuaState;
+	CLuaEventHandlers m_EventHandlers;
+};
+
+CTestScript g_aScripts[NUM_SCRIPTS];
+CLuaEventRegistry<CTestScript> g_Registry;
+int g_NumChanges;
+
+
+int events_changed(lua_State *L)
+{
+	g_NumChanges++;
+	return 0;
+}
+
+bool setup()
+{
+	for(int i = 0; i < NUM_SCRIPTS; i++)
+	{
+		lua_State *L = luaL_newstate();
+		luaL_openlibs(L);
+		lua_register(L, "_EventsChanged", events_changed);
+		if(luaL_dofile(L, "data/luabase/events.lua") != 0)
+		{
+			dbg_msg("main", "failed to load events.lua: %s", lua_tostring(L, -1));
+			return false;
+		}
+		const char *pScript = g_apScripts[i%(sizeof(g_apScripts)/sizeof(g_apScripts[0]))];
+		if(luaL_dostring(L, "g_Calls = 0") != 0 || luaL_dostring(L, pScript) != 0)
+		{
+			dbg_msg("main", "failed to load script %i: %s", i, lua_tostring(L, -1));
+			return false;
+		}
+		g_aScripts[i].m_pLuaState = L;
+	}
+	return true;
+}
+
+int count_calls()
+{
+	int Calls = 0;
+	for(int i = 0; i < NUM_SCRIPTS; i++)
+		Calls += luabridge::getGlobal(g_aScripts[i].m_pLuaState, "g_Calls").cast<int>();
+	return Calls;
+}
+
+// the events of one rendered frame, the way the old LUA_FIRE_EVENT did them: a lookup by name in every script
+void frame_lookup()
+{
+	for(int i = 0; i < NUM_SCRIPTS; i++)
+	{
+		lua_State *L = g_aScripts[i].m_pLuaState;
+		luabridge::LuaRef Background = luabridge::getGlobal(L, "OnRenderBackground");
+		if(Background)
+			Background();
+	}
+	for(int Level = 0; Level < NUM_LEVELS; Level++)
+		for(int i = 0; i < NUM_SCRIPTS; i++)
+		{
+			luabridge::LuaRef Func = luabridge::getGlobal(g_aScripts[i].m_pLuaState, "OnRenderLevel");
+			if(Func)
+				Func(Level);
+		}
+	for(int p = 0; p < NUM_PLAYERS; p++)
+	{
+		for(int i = 0; i < NUM_SCRIPTS; i++)
+		{
+			luabridge::LuaRef Func = luabridge::getGlobal(g_aScripts[i].m_pLuaState, "PreRenderPlayer");
+			if(Func)
+				Func(p, 100.0f*p, 200.0f, 1.0f, 0.0f, false);
+		}
+		for(int i = 0; i < NUM_SCRIPTS; i++)
+		{
+			luabridge::LuaRef Func = luabridge::getGlobal(g_aScripts[i].m_pLuaState, "PostRenderPlayer");
+			if(Func)
+				Func(p, 100.0f*p, 200.0f, 1.0f, 0.0f, false);
+		}
+	}
+}
+
+// the same frame through the registry
+void frame_registry()
+{
+	const array<CTestScript *> &apBackground = g_Registry.Listeners(LUA_EVENT_ON_RENDER_BACKGROUND);
+	for(int i = 0; i < apBackground.size(); i++)
+		apBackground[i]->m_EventHandlers.Handler(LUA_EVENT_ON_RENDER_BACKGROUND)();
+	const array<CTestScript *> &apLevel = g_Registry.Listeners(LUA_EVENT_ON_RENDER_LEVEL);
+	for(int Level = 0; Level < NUM_LEVELS; Level++)
+		for(int i = 0; i < apLevel.size(); i++)
+			apLevel[i]->m_EventHandlers.Handler(LUA_EVENT_ON_RENDER_LEVEL)(Level);
+	const array<CTestScript *> &apPre = g_Registry.Listeners(LUA_EVENT_PRE_RENDER_PLAYER);
+	const array<CTestScript *> &apPost = g_Registry.Listeners(LUA_EVENT_POST_RENDER_PLAYER);
+	for(int p = 0; p < NUM_PLAYERS; p++)
+	{
+		for(int i = 0; i < apPre.size(); i++)
+			apPre[i]->m_EventHandlers.Handler(LUA_EVENT_PRE_RENDER_PLAYER)(p, 100.0f*p, 200.0f, 1.0f, 0.0f, false);
+		for(int i = 0; i < apPost.size(); i++)
+			apPost[i]->m_EventHandlers.Handler(LUA_EVENT_POST_RENDER_PLAYER)(p, 100.0f*p, 200.0f, 1.0f, 0.0f, false);
+	}
+}
+
+void test_resolve(int64 *pTimeStart, int num)
+{
+	*pTimeStart = time_get_raw();
+	for(int n = 0; n < num; n++)
+	{
+		g_Registry.Clear();
+		for(int i = 0; i < NUM_SCRIPTS; i++)
+		{
+			g_aScripts[i].m_EventHandlers.Resolve(g_aScripts[i].m_pLuaState);
+			g_Registry.Add(&g_aScripts[i], &g_aScripts[i].m_EventHandlers);
+		}
+	}
+}
+
+void test_lookup(int64 *pTimeStart, int num)
+{
+	*pTimeStart = time_get_raw();
+	for(int n = 0; n < num; n++)
+		frame_lookup();
+}
+
+void test_registry(int64 *pTimeStart, int num)
+{
+	*pTimeStart = time_get_raw();
+	for(int n = 0; n < num; n++)
+		frame_registry();
+}
+
+void test_compare(int64 *pTimeStart, int num)
+{
+	// both have to reach the same handlers
+	*pTimeStart = time_get_raw();
+	for(int n = 0; n < num; n++)
+	{
+		int Before = count_calls();
+		frame_lookup();
+		int Lookup = count_calls()-Before;
+		frame_registry();
+		int Registry = count_calls()-Before-Lookup;
+		if(Lookup != Registry || Lookup == 0)
+			g_NumMismatches++;
+	}
+}
+
+
+void test_result(const char *pWhat, int Num, double Us, char *pResult, int ResultSize)
+{
+	str_format(pResult, ResultSize, "%i scripts, %.2f µs per round", NUM_SCRIPTS, Us/Num);
+}
+
+
+int main()
+{
+	test_init();
+
+	if(!setup())
+		return 1;
+
+	CONDUCT_TEST(resolve, 100);
+	CONDUCT_TEST(compare, 10);
+	CONDUCT_TEST(lookup, 1000);
+	CONDUCT_TEST(registry, 1000);
+
+	// a script registering another handler while running
+	luaL_dostring(g_aScripts[NUM_SCRIPTS-1].m_pLuaState, "RegisterEvent('OnRenderLevel', function(Level) g_Calls = g_Calls + 1 end)");
+	dbg_msg("main", "%i changes reported by events.lua", g_NumChanges);
+	CONDUCT_TEST(resolve, 1);
+	CONDUCT_TEST(compare, 10);
+
+	// scripts assigning the event globals themselves: a handler defined inside a callback, and one taken away
+	int NumChanges = g_NumChanges;
+	luaL_dostring(g_aScripts[5].m_pLuaState, "function Helper(a, b) function PostRenderPlayer(ID) g_Calls = g_Calls + 1 end return a + b end Helper(1, 2)");
+	luaL_dostring(g_aScripts[1].m_pLuaState, "PreRenderPlayer = nil");
+	if(g_NumChanges != NumChanges+2)
+		g_NumMismatches++;
+	dbg_msg("main", "%i changes reported by events.lua", g_NumChanges);
+	CONDUCT_TEST(resolve, 1);
+	CONDUCT_TEST(compare, 10);
+
+	for(int i = 0; i < NUM_SCRIPTS; i++)
+	{
+		g_aScripts[i].m_EventHandlers.Clear();
+		lua_close(g_aScripts[i].m_pLuaState);
+	}
+
+	return test_exit();
+}
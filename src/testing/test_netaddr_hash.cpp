@@ -0,0 +1,228 @@
+#include <base/system.h>
+#include <engine/shared/netaddr_hash.h>
+#include "test.h"
+
+
+const int NUM_SERVERS = 8000;
+const int NUM_FAVORITES = 2048;
+
+
+// the parts of CServerBrowser::CServerEntry the lookups touch
+struct CTestEntry
+{
+	NETADDR m_Addr;
+	int m_Favorite;
+	int m_GotInfo;
+	CTestEntry *m_pNextIp;
+};
+
+NETADDR *g_pAddresses;
+NETADDR *g_pResponses;
+NETADDR g_aFavorites[NUM_FAVORITES];
+CTestEntry *g_pEntries;
+
+// the old layout: one chain per first byte of the address, the list grown by 100
+CTestEntry *g_apOldHash[256];
+CTestEntry **g_ppOldList;
+int g_OldNum;
+int g_OldCapacity;
+
+CNetAddrHashTable<CTestEntry> g_Table;
+CNetAddrHashSet g_FavoriteSet;
+CTestEntry **g_ppList;
+int g_Num;
+int g_Capacity;
+
+
+unsigned next_rand(unsigned *pSeed)
+{
+	*pSeed = *pSeed*1103515245+12345;
+	return *pSeed>>8;
+}
+
+void setup()
+{
+	g_pAddresses = (NETADDR *)mem_alloc(NUM_SERVERS*sizeof(NETADDR), 1);
+	g_pResponses = (NETADDR *)mem_alloc(NUM_SERVERS*sizeof(NETADDR), 1);
+	g_pEntries = (CTestEntry *)mem_alloc(NUM_SERVERS*sizeof(CTestEntry), 1);
+
+	// a master list the way it looks: a few hosters with many servers, often several ports per host, some ipv6
+	unsigned Seed = 1;
+	for(int i = 0; i < NUM_SERVERS; i++)
+	{
+		NETADDR *pAddr = &g_pAddresses[i];
+		mem_zero(pAddr, sizeof(NETADDR));
+		if(i%10 == 9)
+		{
+			pAddr->type = NETTYPE_IPV6;
+			pAddr->ip[0] = 0x2a;
+			pAddr->ip[1] = 0x01;
+			for(int b = 2; b < 16; b++)
+				pAddr->ip[b] = next_rand(&Seed);
+		}
+		else
+		{
+			static const unsigned char s_aHosters[] = {5, 37, 51, 78, 85, 88, 91, 144, 176, 185, 188, 195};
+			pAddr->type = NETTYPE_IPV4;
+			pAddr->ip[0] = s_aHosters[next_rand(&Seed)%sizeof(s_aHosters)];
+			pAddr->ip[1] = next_rand(&Seed)%4;
+			pAddr->ip[2] = next_rand(&Seed);
+			pAddr->ip[3] = next_rand(&Seed);
+		}
+		pAddr->port = 8303+next_rand(&Seed)%16;
+	}
+
+	// the info responses come back in a different order
+	for(int i = 0; i < NUM_SERVERS; i++)
+		g_pResponses[i] = g_pAddresses[(i*7919)%NUM_SERVERS];
+	for(int i = 0; i < NUM_FAVORITES; i++)
+		g_aFavorites[i] = g_pAddresses[(i*131)%NUM_SERVERS];
+}
+
+CTestEntry *old_find(const NETADDR *pAddr)
+{
+	for(CTestEntry *pEntry = g_apOldHash[pAddr->ip[0]]; pEntry; pEntry = pEntry->m_pNextIp)
+		if(net_addr_comp(&pEntry->m_Addr, pAddr) == 0)
+			return pEntry;
+	return 0;
+}
+
+void old_add(const NETADDR *pAddr, CTestEntry *pEntry)
+{
+	pEntry->m_Addr = *pAddr;
+	pEntry->m_GotInfo = 0;
+	pEntry->m_Favorite = 0;
+	for(int i = 0; i < NUM_FAVORITES; i++)
+		if(net_addr_comp(pAddr, &g_aFavorites[i]) == 0)
+			pEntry->m_Favorite = 1;
+	pEntry->m_pNextIp = g_apOldHash[pAddr->ip[0]];
+	g_apOldHash[pAddr->ip[0]] = pEntry;
+
+	if(g_OldNum == g_OldCapacity)
+	{
+		g_OldCapacity += 100;
+		CTestEntry **ppNewList = (CTestEntry **)mem_alloc(g_OldCapacity*sizeof(CTestEntry *), 1);
+		mem_copy(ppNewList, g_ppOldList, g_OldNum*sizeof(CTestEntry *));
+		mem_free(g_ppOldList);
+		g_ppOldList = ppNewList;
+	}
+	g_ppOldList[g_OldNum++] = pEntry;
+}
+
+void add(const NETADDR *pAddr, CTestEntry *pEntry)
+{
+	pEntry->m_Addr = *pAddr;
+	pEntry->m_GotInfo = 0;
+	pEntry->m_Favorite = g_FavoriteSet.Contains(pAddr);
+	g_Table.Insert(pEntry);
+
+	if(g_Num == g_Capacity)
+	{
+		g_Capacity = g_Capacity ? g_Capacity*2 : 256;
+		CTestEntry **ppNewList = (CTestEntry **)mem_alloc(g_Capacity*sizeof(CTestEntry *), 1);
+		mem_copy(ppNewList, g_ppList, g_Num*sizeof(CTestEntry *));
+		mem_free(g_ppList);
+		g_ppList = ppNewList;
+	}
+	g_ppList[g_Num++] = pEntry;
+}
+
+void test_old(int64 *pTimeStart, int num)
+{
+	*pTimeStart = time_get_raw();
+	for(int n = 0; n < num; n++)
+	{
+		// the master list, then the infos
+		mem_zero(g_apOldHash, sizeof(g_apOldHash));
+		g_OldNum = 0;
+		for(int i = 0; i < NUM_SERVERS; i++)
+			if(!old_find(&g_pAddresses[i]))
+				old_add(&g_pAddresses[i], &g_pEntries[i]);
+		for(int i = 0; i < NUM_SERVERS; i++)
+		{
+			CTestEntry *pEntry = old_find(&g_pResponses[i]);
+			if(pEntry)
+				pEntry->m_GotInfo = 1;
+		}
+	}
+}
+
+void test_new(int64 *pTimeStart, int num)
+{
+	g_FavoriteSet.Clear();
+	for(int i = 0; i < NUM_FAVORITES; i++)
+		g_FavoriteSet.Insert(&g_aFavorites[i]);
+
+	*pTimeStart = time_get_raw();
+	for(int n = 0; n < num; n++)
+	{
+		g_Table.Clear();
+		g_Num = 0;
+		for(int i = 0; i < NUM_SERVERS; i++)
+			if(!g_Table.Find(&g_pAddresses[i]))
+				add(&g_pAddresses[i], &g_pEntries[i]);
+		for(int i = 0; i < NUM_SERVERS; i++)
+		{
+			CTestEntry *pEntry = g_Table.Find(&g_pResponses[i]);
+			if(pEntry)
+				pEntry->m_GotInfo = 1;
+		}
+	}
+}
+
+void test_compare(int64 *pTimeStart, int num)
+{
+	*pTimeStart = time_get_raw();
+	int64 Dummy;
+
+	// the same servers have to be found and marked as favorites
+	test_old(&Dummy, 1);
+	int OldNum = g_OldNum, NumFavorites = 0;
+	int *pFavorite = (int *)mem_alloc(NUM_SERVERS*sizeof(int), 1);
+	for(int i = 0; i < NUM_SERVERS; i++)
+		pFavorite[i] = old_find(&g_pAddresses[i]) ? old_find(&g_pAddresses[i])->m_Favorite : -1;
+	test_new(&Dummy, 1);
+	if(OldNum != g_Num || g_Table.Size() != g_Num)
+		g_NumMismatches++;
+	for(int i = 0; i < NUM_SERVERS; i++)
+	{
+		CTestEntry *pEntry = g_Table.Find(&g_pAddresses[i]);
+		if(!pEntry || pEntry->m_Favorite != pFavorite[i])
+			g_NumMismatches++;
+		NumFavorites += pEntry && pEntry->m_Favorite;
+	}
+	mem_free(pFavorite);
+
+	// removing favorites has to keep the rest findable
+	for(int i = 0; i < NUM_FAVORITES; i += 2)
+		g_FavoriteSet.Remove(&g_aFavorites[i]);
+	for(int i = 0; i < NUM_FAVORITES; i++)
+	{
+		bool Duplicate = false;
+		for(int j = 0; j < i && !Duplicate; j++)
+			Duplicate = net_addr_comp(&g_aFavorites[i], &g_aFavorites[j]) == 0;
+		if(!Duplicate && g_FavoriteSet.Contains(&g_aFavorites[i]) != (i%2 == 1))
+			g_NumMismatches++;
+	}
+	dbg_msg("main", "%i servers, %i of them favorites", g_Num, NumFavorites);
+}
+
+
+void test_result(const char *pWhat, int Num, double Us, char *pResult, int ResultSize)
+{
+	str_format(pResult, ResultSize, "%i servers, %.2f µs per list", NUM_SERVERS, Us/Num);
+}
+
+
+int main()
+{
+	test_init();
+
+	setup();
+
+	CONDUCT_TEST(old, 10);
+	CONDUCT_TEST(new, 10);
+	CONDUCT_TEST(compare, 1);
+
+	return test_exit();
+}
@@ -0,0 +1,239 @@
+#include <base/system.h>
+#include <engine/console.h>
+#include <engine/shared/netban.h>
+#include "test.h"
+
+
+const int NUM_CHECKS = 1000000;
+const int MAX_BANS = 100000;
+
+
+// fills the pools directly, the console is only needed for the messages
+class CTestBan : public CNetBan
+{
+public:
+	void Reset()
+	{
+		m_BanAddrPool.Reset();
+		m_BanRangePool.Reset();
+	}
+
+	void AddAddr(const NETADDR *pAddr, int Expires)
+	{
+		CBanInfo Info = {0};
+		Info.m_Expires = Expires;
+		str_copy(Info.m_aReason, "Stressing network", sizeof(Info.m_aReason));
+		CNetHash NetHash(pAddr);
+		m_BanAddrPool.Add(pAddr, &Info, &NetHash);
+	}
+
+	void AddRange(const CNetRange *pRange, int Expires)
+	{
+		CBanInfo Info = {0};
+		Info.m_Expires = Expires;
+		str_copy(Info.m_aReason, "Stressing network", sizeof(Info.m_aReason));
+		CNetHash NetHash(pRange);
+		m_BanRangePool.Add(pRange, &Info, &NetHash);
+	}
+
+	void RemoveAddr(const NETADDR *pAddr)
+	{
+		CNetHash NetHash(pAddr);
+		m_BanAddrPool.Remove(m_BanAddrPool.Find(pAddr, &NetHash));
+	}
+
+	void RemoveRange(const CNetRange *pRange)
+	{
+		CNetHash NetHash(pRange);
+		m_BanRangePool.Remove(m_BanRangePool.Find(pRange, &NetHash));
+	}
+
+	int Num() const { return m_BanAddrPool.Num()+m_BanRangePool.Num(); }
+	static int Never() { return CBanInfo::EXPIRES_NEVER; }
+};
+
+CTestBan g_Ban;
+
+NETADDR *g_pAddrBans;
+CNetRange *g_pRangeBans;
+bool *g_pRemoved;
+NETADDR *g_pPackets;
+int g_NumAddrBans;
+int g_NumRangeBans;
+int g_NumBanned;
+
+
+unsigned next_rand(unsigned *pSeed)
+{
+	*pSeed = *pSeed*1103515245+12345;
+	return *pSeed>>8;
+}
+
+void random_addr(NETADDR *pAddr, unsigned *pSeed)
+{
+	mem_zero(pAddr, sizeof(NETADDR));
+	if(next_rand(pSeed)%10 == 0)
+	{
+		pAddr->type = NETTYPE_IPV6;
+		pAddr->ip[0] = 0x2a;
+		for(int i = 1; i < 16; i++)
+			pAddr->ip[i] = next_rand(pSeed)>>16;
+	}
+	else
+	{
+		pAddr->type = NETTYPE_IPV4;
+		for(int i = 0; i < 4; i++)
+			pAddr->ip[i] = next_rand(pSeed)>>16;
+	}
+}
+
+// a flood from all over: mostly single addresses, every tenth ban a range. most ranges are whole /24 blocks,
+// a few /16 and some cut where the attacker's addresses happened to end
+void random_range(CNetRange *pRange, unsigned *pSeed)
+{
+	random_addr(&pRange->m_LB, pSeed);
+	pRange->m_UB = pRange->m_LB;
+	int Length = pRange->m_LB.type == NETTYPE_IPV4 ? 4 : 16;
+	int Kind = next_rand(pSeed)%8;
+	if(Kind < 2)
+	{
+		pRange->m_LB.ip[Length-1] = next_rand(pSeed)%128;
+		pRange->m_UB.ip[Length-1] = pRange->m_LB.ip[Length-1]+1+next_rand(pSeed)%127;
+	}
+	else
+	{
+		for(int i = Kind == 2 ? Length-2 : Length-1; i < Length; i++)
+		{
+			pRange->m_LB.ip[i] = 0;
+			pRange->m_UB.ip[i] = 255;
+		}
+	}
+}
+
+bool brute_banned(const NETADDR *pAddr)
+{
+	int Length = pAddr->type == NETTYPE_IPV4 ? 4 : 16;
+	for(int i = 0; i < g_NumAddrBans; i++)
+		if(!g_pRemoved[i] && NetComp(&g_pAddrBans[i], pAddr) == 0)
+			return true;
+	for(int i = 0; i < g_NumRangeBans; i++)
+	{
+		const CNetRange *pRange = &g_pRangeBans[i];
+		if(!g_pRemoved[g_NumAddrBans+i] && pRange->m_LB.type == pAddr->type &&
+			mem_comp(pRange->m_LB.ip, pAddr->ip, Length) <= 0 && mem_comp(pRange->m_UB.ip, pAddr->ip, Length) >= 0)
+			return true;
+	}
+	return false;
+}
+
+void setup()
+{
+	g_pAddrBans = (NETADDR *)mem_alloc(MAX_BANS*sizeof(NETADDR), 1);
+	g_pRangeBans = (CNetRange *)mem_alloc(MAX_BANS*sizeof(CNetRange), 1);
+	g_pRemoved = (bool *)mem_alloc(MAX_BANS*sizeof(bool), 1);
+	g_pPackets = (NETADDR *)mem_alloc(NUM_CHECKS*sizeof(NETADDR), 1);
+}
+
+void make_bans(int NumBans)
+{
+	unsigned Seed = 1;
+	g_NumRangeBans = NumBans/10;
+	g_NumAddrBans = NumBans-g_NumRangeBans;
+	for(int i = 0; i < g_NumAddrBans; i++)
+		random_addr(&g_pAddrBans[i], &Seed);
+	for(int i = 0; i < g_NumRangeBans; i++)
+		random_range(&g_pRangeBans[i], &Seed);
+	mem_zero(g_pRemoved, NumBans*sizeof(bool));
+
+	// a tenth of the packets comes from banned addresses, the rest from everywhere
+	for(int i = 0; i < NUM_CHECKS; i++)
+	{
+		int Kind = next_rand(&Seed)%20;
+		if(Kind == 0)
+			g_pPackets[i] = g_pAddrBans[next_rand(&Seed)%g_NumAddrBans];
+		else if(Kind == 1 && g_NumRangeBans)
+		{
+			const CNetRange *pRange = &g_pRangeBans[next_rand(&Seed)%g_NumRangeBans];
+			g_pPackets[i] = pRange->m_LB;
+			int Length = pRange->m_LB.type == NETTYPE_IPV4 ? 4 : 16;
+			g_pPackets[i].ip[Length-1] = pRange->m_LB.ip[Length-1]+next_rand(&Seed)%(pRange->m_UB.ip[Length-1]-pRange->m_LB.ip[Length-1]+1);
+		}
+		else
+			random_addr(&g_pPackets[i], &Seed);
+		g_pPackets[i].port = 8303;
+	}
+}
+
+// some bans expire, most of them at different times
+void test_ban(int64 *pTimeStart, int num)
+{
+	make_bans(num);
+	g_Ban.Reset();
+
+	unsigned Seed = 2;
+	int Now = time_timestamp();
+	*pTimeStart = time_get_raw();
+	for(int i = 0; i < g_NumAddrBans; i++)
+		g_Ban.AddAddr(&g_pAddrBans[i], i%4 ? Now+600+next_rand(&Seed)%600 : CTestBan::Never());
+	for(int i = 0; i < g_NumRangeBans; i++)
+		g_Ban.AddRange(&g_pRangeBans[i], i%4 ? Now+600+next_rand(&Seed)%600 : CTestBan::Never());
+}
+
+void test_check(int64 *pTimeStart, int num)
+{
+	char aBuf[256];
+	g_NumBanned = 0;
+	*pTimeStart = time_get_raw();
+	for(int i = 0; i < num; i++)
+		g_NumBanned += g_Ban.IsBanned(&g_pPackets[i%NUM_CHECKS], aBuf, sizeof(aBuf));
+}
+
+void test_unban(int64 *pTimeStart, int num)
+{
+	*pTimeStart = time_get_raw();
+	for(int i = 0; i < g_NumAddrBans; i += 2)
+	{
+		g_Ban.RemoveAddr(&g_pAddrBans[i]);
+		g_pRemoved[i] = true;
+	}
+	for(int i = 0; i < g_NumRangeBans; i += 2)
+	{
+		g_Ban.RemoveRange(&g_pRangeBans[i]);
+		g_pRemoved[g_NumAddrBans+i] = true;
+	}
+}
+
+// against a plain walk over all bans, on a sample of the packets
+void verify()
+{
+	char aBuf[256];
+	for(int i = 0; i < NUM_CHECKS; i += NUM_CHECKS/2000)
+		g_NumMismatches += g_Ban.IsBanned(&g_pPackets[i], aBuf, sizeof(aBuf)) != brute_banned(&g_pPackets[i]);
+}
+
+
+void test_result(const char *pWhat, int Num, double Us, char *pResult, int ResultSize)
+{
+	verify();
+	str_format(pResult, ResultSize, "%i bans, %i banned", g_Ban.Num(), g_NumBanned);
+}
+
+
+int main()
+{
+	test_init();
+
+	setup();
+
+	CONDUCT_TEST(ban, 1024);
+	CONDUCT_TEST(check, NUM_CHECKS);
+	CONDUCT_TEST(unban, 1024);
+	CONDUCT_TEST(check, NUM_CHECKS);
+
+	CONDUCT_TEST(ban, MAX_BANS);
+	CONDUCT_TEST(check, NUM_CHECKS);
+	CONDUCT_TEST(unban, MAX_BANS);
+	CONDUCT_TEST(check, NUM_CHECKS);
+
+	return test_exit();
+}
@@ -0,0 +1,221 @@
+#include <base/system.h>
+#include <engine/message.h>
+#include <engine/shared/network.h>
+#include <engine/shared/packer.h>
+#include <engine/shared/protocol.h>
+#include "test.h"
+
+
+const int NUM_PAYLOADS = 64;
+
+
+CNetConnection g_Connection;
+NETSOCKET g_Sink;
+unsigned char g_aaPayloads[NUM_PAYLOADS][MAX_SNAPSHOT_PACKSIZE];
+int64 g_NumBytes;
+
+
+bool setup()
+{
+	CNetBase::Init();
+
+	// the packets go to a socket nobody reads from, the kernel just drops them
+	NETADDR BindAddr;
+	mem_zero(&BindAddr, sizeof(BindAddr));
+	BindAddr.type = NETTYPE_IPV4;
+	net_addr_from_str(&BindAddr, "127.0.0.1");
+	NETSOCKET Socket = net_udp_create(BindAddr);
+	if(!Socket.type)
+		return false;
+
+	NETADDR PeerAddr = BindAddr;
+	for(PeerAddr.port = 42000; PeerAddr.port < 42100; PeerAddr.port++)
+	{
+		g_Sink = net_udp_create(PeerAddr);
+		if(g_Sink.type)
+			break;
+	}
+	if(!g_Sink.type)
+		return false;
+
+	g_Connection.Init(Socket, false);
+	g_Connection.DirectInit(PeerAddr, NET_SECURITY_TOKEN_UNSUPPORTED);
+
+	// compressed snapshot data doesn't compress any further
+	unsigned Seed = 1;
+	for(int i = 0; i < NUM_PAYLOADS; i++)
+		for(int j = 0; j < MAX_SNAPSHOT_PACKSIZE; j++)
+		{
+			Seed = Seed*1103515245+12345;
+			g_aaPayloads[i][j] = Seed>>24;
+		}
+	return true;
+}
+
+// what CServer::SendMsgEx does with a message before it hits the network
+void send_msg(CMsgPacker *pMsg, bool Flush)
+{
+	unsigned char *pData = (unsigned char *)pMsg->Data();
+	*pData <<= 1;
+	*pData |= 1;
+	if(g_Connection.QueueChunk(0, pMsg->Size(), pData) == 0)
+		g_NumBytes += pMsg->Size();
+	if(Flush)
+		g_Connection.Flush();
+}
+
+void pack_snap(CMsgPacker *pMsg, int n, int Size)
+{
+	pMsg->AddInt(n);
+	pMsg->AddInt(1);
+	pMsg->AddInt(0x12345678);
+	pMsg->AddInt(Size);
+	pMsg->AddRaw(g_aaPayloads[n%NUM_PAYLOADS], Size);
+}
+
+void test_snap_copy(int64 *pTimeStart, int num)
+{
+	g_NumBytes = 0;
+	*pTimeStart = time_get_raw();
+	for(int n = 0; n < num; n++)
+	{
+		CMsgPacker Msg(NETMSG_SNAPSINGLE);
+		pack_snap(&Msg, n, MAX_SNAPSHOT_PACKSIZE);
+		send_msg(&Msg, true);
+	}
+}
+
+void test_snap_inplace(int64 *pTimeStart, int num)
+{
+	g_NumBytes = 0;
+	*pTimeStart = time_get_raw();
+	for(int n = 0; n < num; n++)
+	{
+		const int MaxMsgSize = MAX_SNAPSHOT_PACKSIZE+32;
+		CMsgPacker Msg(NETMSG_SNAPSINGLE, g_Connection.PrepareChunk(0, MaxMsgSize), MaxMsgSize);
+		pack_snap(&Msg, n, MAX_SNAPSHOT_PACKSIZE);
+		send_msg(&Msg, true);
+	}
+}
+
+// small messages that are batched into full packets
+void test_small_copy(int64 *pTimeStart, int num)
+{
+	g_NumBytes = 0;
+	*pTimeStart = time_get_raw();
+	for(int n = 0; n < num; n++)
+	{
+		CMsgPacker Msg(NETMSG_SNAPSINGLE);
+		pack_snap(&Msg, n, 64);
+		send_msg(&Msg, false);
+	}
+	g_Connection.Flush();
+}
+
+void test_small_inplace(int64 *pTimeStart, int num)
+{
+	g_NumBytes = 0;
+	*pTimeStart = time_get_raw();
+	for(int n = 0; n < num; n++)
+	{
+		CMsgPacker Msg(NETMSG_SNAPSINGLE, g_Connection.PrepareChunk(0, 64+32), 64+32);
+		pack_snap(&Msg, n, 64);
+		send_msg(&Msg, false);
+	}
+	g_Connection.Flush();
+}
+
+// one packet of snapshot parts or of small messages, built in a buffer of its own or in the packet
+void send_packet(int n, bool InPlace)
+{
+	int NumMsgs = n%2 ? 1+n%8 : 1;
+	int Size = n%2 ? 64 : MAX_SNAPSHOT_PACKSIZE;
+	for(int i = 0; i < NumMsgs; i++)
+	{
+		if(InPlace)
+		{
+			CMsgPacker Msg(NETMSG_SNAPSINGLE, g_Connection.PrepareChunk(0, Size+32), Size+32);
+			pack_snap(&Msg, n+i, Size);
+			send_msg(&Msg, false);
+		}
+		else
+		{
+			CMsgPacker Msg(NETMSG_SNAPSINGLE);
+			pack_snap(&Msg, n+i, Size);
+			send_msg(&Msg, false);
+		}
+	}
+	g_Connection.Flush();
+}
+
+// the next packet that arrived at the sink
+int receive_packet(unsigned char *pData)
+{
+	NETADDR Addr;
+	for(int i = 0; i < 100; i++)
+	{
+		int Size = net_udp_recv(g_Sink, &Addr, pData, NET_MAX_PACKETSIZE);
+		if(Size > 0)
+			return Size;
+		net_socket_read_wait(g_Sink, 1000);
+	}
+	return 0;
+}
+
+// both ways have to put the same bytes on the wire
+void test_compare(int64 *pTimeStart, int num)
+{
+	unsigned char aCopy[NET_MAX_PACKETSIZE], aInPlace[NET_MAX_PACKETSIZE];
+	NETADDR Addr;
+	while(net_udp_recv(g_Sink, &Addr, aCopy, sizeof(aCopy)) > 0);
+
+	g_NumBytes = 0;
+	*pTimeStart = time_get_raw();
+	for(int n = 0; n < num; n++)
+	{
+		send_packet(n, false);
+		int CopySize = receive_packet(aCopy);
+		send_packet(n, true);
+		int InPlaceSize = receive_packet(aInPlace);
+		if(CopySize == 0 || CopySize != InPlaceSize || mem_comp(aCopy, aInPlace, CopySize) != 0)
+			g_NumMismatches++;
+	}
+}
+
+
+void test_result(const char *pWhat, int Num, double Us, char *pResult, int ResultSize)
+{
+	str_format(pResult, ResultSize, "%.2f MB/s", g_NumBytes/(Us/1000000.0)/(1024*1024));
+}
+
+
+int main()
+{
+	test_init();
+
+	if(!setup())
+	{
+		dbg_msg("main", "failed to create sockets");
+		return -1;
+	}
+
+	CONDUCT_TEST(compare, 1000);
+	dbg_msg("main", "------------------------");
+
+	CONDUCT_TEST(snap_copy, 10000);
+	CONDUCT_TEST(snap_inplace, 10000);
+	dbg_msg("main", "------------------------");
+
+	CONDUCT_TEST(snap_copy, 100000);
+	CONDUCT_TEST(snap_inplace, 100000);
+	dbg_msg("main", "------------------------");
+
+	CONDUCT_TEST(small_copy, 100000);
+	CONDUCT_TEST(small_inplace, 100000);
+	dbg_msg("main", "------------------------");
+
+	CONDUCT_TEST(small_copy, 1000000);
+	CONDUCT_TEST(small_inplace, 1000000);
+
+	return test_exit();
+}
@@ -0,0 +1,247 @@
+#include <base/system.h>
+#include <base/math.h>
+#include <game/client/particlegroup.h>
+#include "test.h"
+
+
+const int MAP_WIDTH = 256;
+const int MAP_HEIGHT = 256;
+const int NUM_PARTICLES = CParticleGroup::MAX_PARTICLES;
+const float FRAME_TIME = 1.0f/120.0f;
+
+
+// the old particle storage, one struct per particle linked into its group
+struct CRefParticle
+{
+	vec2 m_Pos;
+	vec2 m_Vel;
+	float m_Gravity;
+	float m_Friction;
+	float m_Life;
+	float m_LifeSpan;
+	float m_Rot;
+	float m_Rotspeed;
+	int m_PrevPart;
+	int m_NextPart;
+};
+
+// same layout as CTile
+struct CRefTile
+{
+	unsigned char m_Index;
+	unsigned char m_Flags;
+	unsigned char m_Skip;
+	unsigned char m_Reserved;
+};
+
+CRefTile g_aTiles[MAP_WIDTH*MAP_HEIGHT];
+CSolidMap g_SolidMap;
+CParticle g_aSpawn[NUM_PARTICLES];
+CRefParticle g_aReference[NUM_PARTICLES];
+int g_FirstReference;
+int g_NumReference;
+CParticleGroup g_Group;
+
+
+void setup()
+{
+	// a closed box with scattered solid tiles, about as dense as a game map
+	g_SolidMap.Init(MAP_WIDTH, MAP_HEIGHT);
+	unsigned Seed = 1;
+	for(int y = 0; y < MAP_HEIGHT; y++)
+		for(int x = 0; x < MAP_WIDTH; x++)
+		{
+			Seed = Seed*1103515245+12345;
+			bool Solid = x == 0 || y == 0 || x == MAP_WIDTH-1 || y == MAP_HEIGHT-1 || (Seed>>16)%8 == 0;
+			mem_zero(&g_aTiles[y*MAP_WIDTH+x], sizeof(CRefTile));
+			g_aTiles[y*MAP_WIDTH+x].m_Index = Solid ? 1 : 0;
+			g_SolidMap.Set(x, y, Solid);
+		}
+
+	// the kind of particles the effects spawn: smoke, sparks and debris
+	for(int i = 0; i < NUM_PARTICLES; i++)
+	{
+		CParticle *p = &g_aSpawn[i];
+		p->SetDefault();
+		do
+			p->m_Pos = vec2(32.0f + frandom()*(MAP_WIDTH-2)*32.0f, 32.0f + frandom()*(MAP_HEIGHT-2)*32.0f);
+		while(g_SolidMap.CheckPoint(p->m_Pos.x, p->m_Pos.y));
+		p->m_Vel = vec2(frandom()-0.5f, frandom()-0.5f)*1500.0f;
+		p->m_LifeSpan = 0.5f + frandom()*1.5f;
+		p->m_Gravity = i%3 == 0 ? 0.0f : 800.0f + frandom()*1000.0f;
+		p->m_Friction = 0.7f + frandom()*0.2f;
+		p->m_Rotspeed = frandom()*10.0f;
+	}
+}
+
+void spawn()
+{
+	// the particles are scattered over the old array the way the free list hands them out after a while
+	g_Group.m_Num = 0;
+	g_FirstReference = -1;
+	for(int i = 0; i < NUM_PARTICLES; i++)
+	{
+		const CParticle *p = &g_aSpawn[i];
+		g_Group.Add(p);
+
+		int Id = (i*7919)%NUM_PARTICLES;
+		CRefParticle *r = &g_aReference[Id];
+		r->m_Pos = p->m_Pos;
+		r->m_Vel = p->m_Vel;
+		r->m_Gravity = p->m_Gravity;
+		r->m_Friction = p->m_Friction;
+		r->m_Life = 0;
+		r->m_LifeSpan = p->m_LifeSpan;
+		r->m_Rot = p->m_Rot;
+		r->m_Rotspeed = p->m_Rotspeed;
+
+		// new ones go to the front
+		r->m_PrevPart = -1;
+		r->m_NextPart = g_FirstReference;
+		if(g_FirstReference != -1)
+			g_aReference[g_FirstReference].m_PrevPart = Id;
+		g_FirstReference = Id;
+	}
+	g_NumReference = NUM_PARTICLES;
+}
+
+// what CCollision::CheckPoint did on the tile array
+bool ref_check_point(float x, float y)
+{
+	int Nx = clamp(round_to_int(x)/32, 0, MAP_WIDTH-1);
+	int Ny = clamp(round_to_int(y)/32, 0, MAP_HEIGHT-1);
+	int Index = g_aTiles[Ny*MAP_WIDTH+Nx].m_Index;
+	if(Index < 1 || Index > 4)
+		Index = 0;
+	return Index == 1 || Index == 3;
+}
+
+// the old update loop, with CCollision::MovePoint inlined
+void ref_update(float TimePassed, int FrictionCount)
+{
+	int i = g_FirstReference;
+	while(i != -1)
+	{
+		CRefParticle *p = &g_aReference[i];
+		int Next = p->m_NextPart;
+		p->m_Vel.y += p->m_Gravity*TimePassed;
+		for(int f = 0; f < FrictionCount; f++)
+			p->m_Vel *= p->m_Friction;
+
+		vec2 Vel = p->m_Vel*TimePassed;
+		float Elasticity = 0.1f+0.9f*frandom();
+		if(ref_check_point(p->m_Pos.x+Vel.x, p->m_Pos.y+Vel.y))
+		{
+			int Affected = 0;
+			if(ref_check_point(p->m_Pos.x+Vel.x, p->m_Pos.y))
+			{
+				Vel.x *= -Elasticity;
+				Affected++;
+			}
+			if(ref_check_point(p->m_Pos.x, p->m_Pos.y+Vel.y))
+			{
+				Vel.y *= -Elasticity;
+				Affected++;
+			}
+			if(Affected == 0)
+				Vel *= -Elasticity;
+		}
+		else
+			p->m_Pos += Vel;
+		p->m_Vel = Vel*(1.0f/TimePassed);
+
+		p->m_Life += TimePassed;
+		p->m_Rot += TimePassed*p->m_Rotspeed;
+
+		if(p->m_Life > p->m_LifeSpan)
+		{
+			// unlink it, the free list is left out
+			if(p->m_PrevPart != -1)
+				g_aReference[p->m_PrevPart].m_NextPart = p->m_NextPart;
+			else
+				g_FirstReference = p->m_NextPart;
+			if(p->m_NextPart != -1)
+				g_aReference[p->m_NextPart].m_PrevPart = p->m_PrevPart;
+			g_NumReference--;
+		}
+
+		i = Next;
+	}
+}
+
+void test_reference(int64 *pTimeStart, int num)
+{
+	spawn();
+	*pTimeStart = time_get_raw();
+	for(int n = 0; n < num; n++)
+	{
+		if(g_NumReference == 0)
+			spawn();
+		ref_update(FRAME_TIME, n%6 == 0);
+	}
+}
+
+void test_group(int64 *pTimeStart, int num)
+{
+	spawn();
+	*pTimeStart = time_get_raw();
+	for(int n = 0; n < num; n++)
+	{
+		if(g_Group.m_Num == 0)
+			spawn();
+		g_Group.Update(FRAME_TIME, n%6 == 0, &g_SolidMap);
+	}
+}
+
+void test_compare(int64 *pTimeStart, int num)
+{
+	// the bounce elasticity is random, so compare one step from a fresh spawn: positions, lifetimes
+	// and the direction of the velocities have to agree
+	*pTimeStart = time_get_raw();
+	for(int n = 0; n < num; n++)
+	{
+		spawn();
+		float TimePassed = FRAME_TIME*(1+n%8);
+		ref_update(TimePassed, n%2);
+		g_Group.Update(TimePassed, n%2, &g_SolidMap);
+		if(g_NumReference != g_Group.m_Num)
+		{
+			g_NumMismatches++;
+			continue;
+		}
+		// the list runs newest first
+		int i = g_Group.m_Num;
+		for(int Id = g_FirstReference; Id != -1; Id = g_aReference[Id].m_NextPart)
+		{
+			const CRefParticle *r = &g_aReference[Id];
+			i--;
+			if(r->m_Pos.x != g_Group.m_aPosX[i] || r->m_Pos.y != g_Group.m_aPosY[i] ||
+				r->m_Life != g_Group.m_aLife[i] || r->m_Rot != g_Group.m_aRot[i] ||
+				(r->m_Vel.x < 0) != (g_Group.m_aVelX[i] < 0) || (r->m_Vel.y < 0) != (g_Group.m_aVelY[i] < 0))
+			{
+				g_NumMismatches++;
+				break;
+			}
+		}
+	}
+}
+
+
+void test_result(const char *pWhat, int Num, double Us, char *pResult, int ResultSize)
+{
+	str_format(pResult, ResultSize, "%i particles, %.2f µs per update", NUM_PARTICLES, Us/Num);
+}
+
+
+int main()
+{
+	test_init();
+
+	setup();
+
+	CONDUCT_TEST(compare, 16);
+	CONDUCT_TEST(reference, 1000);
+	CONDUCT_TEST(group, 1000);
+
+	return test_exit();
+}
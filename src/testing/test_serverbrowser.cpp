@@ -0,0 +1,246 @@
+#include <algorithm>
+#include <base/system.h>
+#include <engine/client/serverbrowser_filter.h>
+#include "test.h"
+
+
+const int NUM_SERVERS = 2000;
+
+
+struct CTestServer
+{
+	CServerInfo m_Info;
+	CServerFilterKeys m_FilterKeys;
+	int m_GotInfo;
+};
+
+CTestServer *g_pServers;
+CServerInfo *g_pArrivals;
+int *g_pOrder;
+int g_NumSorted;
+int *g_pReferenceOrder;
+int g_NumReferenceSorted;
+CServerFilter g_Filter;
+CServerSortOrder g_SortOrder;
+int g_Sort;
+int g_SortOrderReverse;
+
+
+const char *const g_apWords[] = {"DDNet", "Vanilla", "Pro", "Block", "Race", "Fun", "CTF", "Teeworlds", "Zomb", "Insta", "GER", "USA", "RUS", "Novice", "Solo"};
+const char *const g_apMaps[] = {"dm1", "ctf5", "Kobra 4", "Tutorial", "Sunny Side Up", "Multeasymap", "Grandma", "Baby Aim"};
+const char *const g_apGameTypes[] = {"DM", "TDM", "CTF", "DDraceNetwork", "iCTF", "zCatch", "Block"};
+
+unsigned next_rand(unsigned *pSeed)
+{
+	*pSeed = *pSeed*1103515245+12345;
+	return *pSeed>>8;
+}
+
+void setup()
+{
+	g_pServers = (CTestServer *)mem_alloc(NUM_SERVERS*sizeof(CTestServer), 1);
+	g_pArrivals = (CServerInfo *)mem_alloc(NUM_SERVERS*sizeof(CServerInfo), 1);
+	g_pOrder = (int *)mem_alloc(NUM_SERVERS*sizeof(int), 1);
+	g_pReferenceOrder = (int *)mem_alloc(NUM_SERVERS*sizeof(int), 1);
+
+	// the infos the servers will answer with, in the order they arrive
+	unsigned Seed = 1;
+	for(int i = 0; i < NUM_SERVERS; i++)
+	{
+		CServerInfo *pInfo = &g_pArrivals[i];
+		mem_zero(pInfo, sizeof(CServerInfo));
+		pInfo->m_ServerIndex = next_rand(&Seed)%NUM_SERVERS;
+		str_format(pInfo->m_aName, sizeof(pInfo->m_aName), "%s %s #%d", g_apWords[next_rand(&Seed)%15], g_apWords[next_rand(&Seed)%15], next_rand(&Seed)%100);
+		str_copy(pInfo->m_aMap, g_apMaps[next_rand(&Seed)%8], sizeof(pInfo->m_aMap));
+		str_copy(pInfo->m_aGameType, g_apGameTypes[next_rand(&Seed)%7], sizeof(pInfo->m_aGameType));
+		str_copy(pInfo->m_aVersion, "0.6.4", sizeof(pInfo->m_aVersion));
+		str_format(pInfo->m_aAddress, sizeof(pInfo->m_aAddress), "10.0.%d.%d:8303", i/256, i%256);
+		pInfo->m_Latency = 20+next_rand(&Seed)%300;
+		pInfo->m_MaxClients = pInfo->m_MaxPlayers = next_rand(&Seed)%2 ? 16 : 64;
+		pInfo->m_NumClients = next_rand(&Seed)%(pInfo->m_MaxClients/2+1);
+		pInfo->m_NumPlayers = pInfo->m_NumClients;
+		for(int c = 0; c < pInfo->m_NumClients; c++)
+		{
+			str_format(pInfo->m_aClients[c].m_aName, sizeof(pInfo->m_aClients[c].m_aName), "%s%d", g_apWords[next_rand(&Seed)%15], next_rand(&Seed)%1000);
+			str_copy(pInfo->m_aClients[c].m_aClan, g_apWords[next_rand(&Seed)%15], sizeof(pInfo->m_aClients[c].m_aClan));
+			pInfo->m_aClients[c].m_Country = next_rand(&Seed)%300;
+		}
+	}
+
+	// what the browser filters with
+	CServerFilter::CSettings Settings;
+	mem_zero(&Settings, sizeof(Settings));
+	Settings.m_FilterPing = 999;
+	Settings.m_FilterEmpty = 1;
+	ServerFilterLowercase(Settings.m_aFilterString, "PRO", sizeof(Settings.m_aFilterString));
+	ServerFilterLowercase(Settings.m_aExcludeString, "Zomb", sizeof(Settings.m_aExcludeString));
+	str_copy(Settings.m_aNetVersion, "0.6 626fce9a778df4d4", sizeof(Settings.m_aNetVersion));
+	g_Filter.SetSettings(Settings);
+}
+
+// the servers the master sent, without infos yet
+void reset()
+{
+	for(int i = 0; i < NUM_SERVERS; i++)
+	{
+		CServerInfo *pInfo = &g_pServers[i].m_Info;
+		mem_zero(pInfo, sizeof(CServerInfo));
+		str_format(pInfo->m_aAddress, sizeof(pInfo->m_aAddress), "10.0.%d.%d:8303", i/256, i%256);
+		str_copy(pInfo->m_aName, pInfo->m_aAddress, sizeof(pInfo->m_aName));
+		pInfo->m_Latency = 999;
+		pInfo->m_ServerIndex = i;
+		g_pServers[i].m_GotInfo = 0;
+		g_pServers[i].m_FilterKeys.Set(pInfo);
+	}
+}
+
+void arrive(int n)
+{
+	CTestServer *pServer = &g_pServers[g_pArrivals[n].m_ServerIndex];
+	pServer->m_Info = g_pArrivals[n];
+	pServer->m_GotInfo = 1;
+}
+
+// what CServerBrowser::Filter did for every server on every packet
+bool reference_filtered(CServerInfo *pInfo)
+{
+	const CServerFilter::CSettings &s = g_Filter.Settings();
+	if(s.m_FilterEmpty && pInfo->m_NumClients == 0)
+		return true;
+	if(s.m_FilterPing < pInfo->m_Latency)
+		return true;
+
+	pInfo->m_QuickSearchHit = 0;
+	if(str_find_nocase(pInfo->m_aName, s.m_aFilterString))
+		pInfo->m_QuickSearchHit |= IServerBrowser::QUICK_SERVERNAME;
+	for(int p = 0; p < pInfo->m_NumClients; p++)
+	{
+		if(str_find_nocase(pInfo->m_aClients[p].m_aName, s.m_aFilterString) || str_find_nocase(pInfo->m_aClients[p].m_aClan, s.m_aFilterString))
+		{
+			pInfo->m_QuickSearchHit |= IServerBrowser::QUICK_PLAYER;
+			break;
+		}
+	}
+	if(str_find_nocase(pInfo->m_aMap, s.m_aFilterString))
+		pInfo->m_QuickSearchHit |= IServerBrowser::QUICK_MAPNAME;
+	if(!pInfo->m_QuickSearchHit)
+		return true;
+
+	return str_find_nocase(pInfo->m_aName, s.m_aExcludeString) || str_find_nocase(pInfo->m_aMap, s.m_aExcludeString);
+}
+
+bool reference_less(int Index1, int Index2)
+{
+	const CTestServer *a = &g_pServers[Index1];
+	const CTestServer *b = &g_pServers[Index2];
+	if(g_Sort == IServerBrowser::SORT_NAME)
+		return (a->m_GotInfo && b->m_GotInfo) || (!a->m_GotInfo && !b->m_GotInfo) ? str_comp(a->m_Info.m_aName, b->m_Info.m_aName) < 0 : a->m_GotInfo != 0;
+	return a->m_Info.m_NumPlayers < b->m_Info.m_NumPlayers;
+}
+
+bool reference_compare(int a, int b)
+{
+	return g_SortOrderReverse ? reference_less(b, a) : reference_less(a, b);
+}
+
+void reference_sort()
+{
+	g_NumReferenceSorted = 0;
+	for(int i = 0; i < NUM_SERVERS; i++)
+		if(!reference_filtered(&g_pServers[i].m_Info))
+			g_pReferenceOrder[g_NumReferenceSorted++] = i;
+	std::stable_sort(g_pReferenceOrder, g_pReferenceOrder+g_NumReferenceSorted, reference_compare);
+}
+
+void update(int Index)
+{
+	CTestServer *pServer = &g_pServers[Index];
+	pServer->m_FilterKeys.Set(&pServer->m_Info);
+	if(g_Filter.Filtered(&pServer->m_Info, &pServer->m_FilterKeys, &pServer->m_Info.m_QuickSearchHit))
+		g_SortOrder.Remove(Index);
+	else if(g_Sort == IServerBrowser::SORT_NAME)
+		g_SortOrder.Insert(Index, pServer->m_GotInfo ? 0 : 1, 0, pServer->m_Info.m_aName);
+	else
+		g_SortOrder.Insert(Index, 0, pServer->m_Info.m_NumPlayers, 0);
+}
+
+void init_order()
+{
+	g_SortOrder.Init(g_Sort == IServerBrowser::SORT_NAME, g_SortOrderReverse != 0);
+	for(int i = 0; i < NUM_SERVERS; i++)
+		update(i);
+	g_NumSorted = g_SortOrder.Flatten(g_pOrder);
+}
+
+void test_full(int64 *pTimeStart, int num)
+{
+	// every packet filters and sorts the whole list
+	reset();
+	*pTimeStart = time_get_raw();
+	for(int n = 0; n < num; n++)
+	{
+		arrive(n);
+		reference_sort();
+	}
+}
+
+void test_incremental(int64 *pTimeStart, int num)
+{
+	// every packet filters and places the one server
+	reset();
+	init_order();
+	*pTimeStart = time_get_raw();
+	for(int n = 0; n < num; n++)
+	{
+		arrive(n);
+		update(g_pArrivals[n].m_ServerIndex);
+		g_NumSorted = g_SortOrder.Flatten(g_pOrder);
+	}
+}
+
+void test_compare(int64 *pTimeStart, int num)
+{
+	reset();
+	init_order();
+	*pTimeStart = time_get_raw();
+	for(int n = 0; n < num; n++)
+	{
+		arrive(n);
+		update(g_pArrivals[n].m_ServerIndex);
+		if(n%(num/20) != 0 && n != num-1)
+			continue;
+
+		g_NumSorted = g_SortOrder.Flatten(g_pOrder);
+		reference_sort();
+		if(g_NumSorted != g_NumReferenceSorted || mem_comp(g_pOrder, g_pReferenceOrder, g_NumSorted*sizeof(int)) != 0)
+			g_NumMismatches++;
+	}
+}
+
+
+void test_result(const char *pWhat, int Num, double Us, char *pResult, int ResultSize)
+{
+	str_format(pResult, ResultSize, "%i servers, %.2f µs per packet, %i listed", NUM_SERVERS, Us/Num, g_NumSorted > g_NumReferenceSorted ? g_NumSorted : g_NumReferenceSorted);
+}
+
+
+int main()
+{
+	test_init();
+
+	setup();
+
+	g_Sort = IServerBrowser::SORT_NAME;
+	g_SortOrderReverse = 0;
+	CONDUCT_TEST(full, NUM_SERVERS);
+	CONDUCT_TEST(incremental, NUM_SERVERS);
+	CONDUCT_TEST(compare, NUM_SERVERS);
+
+	g_Sort = IServerBrowser::SORT_NUMPLAYERS;
+	g_SortOrderReverse = 1;
+	CONDUCT_TEST(full, NUM_SERVERS);
+	CONDUCT_TEST(incremental, NUM_SERVERS);
+	CONDUCT_TEST(compare, NUM_SERVERS);
+
+	return test_exit();
+}
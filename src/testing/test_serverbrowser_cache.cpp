@@ -0,0 +1,226 @@
+#include <base/system.h>
+#include <engine/shared/network.h>
+#include <engine/client/serverbrowser_cache.h>
+#include "test.h"
+
+
+const int NUM_SERVERS = 5000;
+
+
+CServerInfo *g_pInfos;
+CServerInfo *g_pLoaded;
+int g_NumLoaded;
+int g_FileSize;
+
+
+const char *const g_apWords[] = {"DDNet", "Vanilla", "Pro", "Block", "Race", "Fun", "CTF", "Teeworlds", "Zomb", "Insta", "GER", "USA", "RUS", "Novice", "Solo"};
+const char *const g_apMaps[] = {"dm1", "ctf5", "Kobra 4", "Tutorial", "Sunny Side Up", "Multeasymap", "Grandma", "Baby Aim"};
+const char *const g_apGameTypes[] = {"DM", "CTF", "DDraceNetwork", "Gores", "iDM"};
+
+unsigned next_rand(unsigned *pSeed)
+{
+	*pSeed = *pSeed*1103515245+12345;
+	return *pSeed>>8;
+}
+
+// most servers are empty or nearly so, a few are full
+void make_info(CServerInfo *pInfo, int Index, unsigned *pSeed)
+{
+	mem_zero(pInfo, sizeof(CServerInfo));
+	pInfo->m_NetAddr.type = NETTYPE_IPV4;
+	pInfo->m_NetAddr.ip[0] = 10;
+	pInfo->m_NetAddr.ip[1] = Index>>8;
+	pInfo->m_NetAddr.ip[2] = Index&0xff;
+	pInfo->m_NetAddr.ip[3] = 1;
+	pInfo->m_NetAddr.port = 8303;
+	net_addr_str(&pInfo->m_NetAddr, pInfo->m_aAddress, sizeof(pInfo->m_aAddress), true);
+	str_format(pInfo->m_aName, sizeof(pInfo->m_aName), "%s %s #%d", g_apWords[next_rand(pSeed)%15], g_apWords[next_rand(pSeed)%15], next_rand(pSeed)%100);
+	str_copy(pInfo->m_aMap, g_apMaps[next_rand(pSeed)%8], sizeof(pInfo->m_aMap));
+	str_copy(pInfo->m_aGameType, g_apGameTypes[next_rand(pSeed)%5], sizeof(pInfo->m_aGameType));
+	str_copy(pInfo->m_aVersion, "0.6.4, 11.2.1", sizeof(pInfo->m_aVersion));
+	pInfo->m_MaxClients = next_rand(pSeed)%2 ? 64 : 16;
+	pInfo->m_MaxPlayers = pInfo->m_MaxClients;
+	pInfo->m_NumClients = next_rand(pSeed)%3 ? next_rand(pSeed)%4 : next_rand(pSeed)%(pInfo->m_MaxClients+1);
+	pInfo->m_NumPlayers = pInfo->m_NumClients;
+	pInfo->m_NumReceivedClients = pInfo->m_NumClients;
+	pInfo->m_Latency = next_rand(pSeed)%300;
+	pInfo->m_MapCrc = next_rand(pSeed);
+	pInfo->m_MapSize = next_rand(pSeed)%100000;
+	for(int c = 0; c < pInfo->m_NumClients; c++)
+	{
+		str_format(pInfo->m_aClients[c].m_aName, sizeof(pInfo->m_aClients[c].m_aName), "%s%d", g_apWords[next_rand(pSeed)%15], next_rand(pSeed)%1000);
+		str_copy(pInfo->m_aClients[c].m_aClan, g_apWords[next_rand(pSeed)%15], sizeof(pInfo->m_aClients[c].m_aClan));
+		pInfo->m_aClients[c].m_Country = next_rand(pSeed)%1000;
+		pInfo->m_aClients[c].m_Score = next_rand(pSeed)%500;
+		pInfo->m_aClients[c].m_Player = true;
+	}
+}
+
+void setup()
+{
+	g_pInfos = (CServerInfo *)mem_alloc(NUM_SERVERS*sizeof(CServerInfo), 1);
+	g_pLoaded = (CServerInfo *)mem_alloc(NUM_SERVERS*sizeof(CServerInfo), 1);
+	unsigned Seed = 1;
+	for(int i = 0; i < NUM_SERVERS; i++)
+		make_info(&g_pInfos[i], i, &Seed);
+}
+
+bool same_info(const CServerInfo *pA, const CServerInfo *pB)
+{
+	if(net_addr_comp(&pA->m_NetAddr, &pB->m_NetAddr) != 0 || str_comp(pA->m_aName, pB->m_aName) != 0 || str_comp(pA->m_aMap, pB->m_aMap) != 0 ||
+		str_comp(pA->m_aGameType, pB->m_aGameType) != 0 || str_comp(pA->m_aVersion, pB->m_aVersion) != 0 || str_comp(pA->m_aAddress, pB->m_aAddress) != 0 ||
+		pA->m_NumClients != pB->m_NumClients || pA->m_MaxClients != pB->m_MaxClients || pA->m_Latency != pB->m_Latency || pA->m_MapCrc != pB->m_MapCrc ||
+		pA->m_NumReceivedClients != pB->m_NumReceivedClients)
+		return false;
+	for(int c = 0; c < pA->m_NumReceivedClients; c++)
+		if(str_comp(pA->m_aClients[c].m_aName, pB->m_aClients[c].m_aName) != 0 || str_comp(pA->m_aClients[c].m_aClan, pB->m_aClients[c].m_aClan) != 0 ||
+			pA->m_aClients[c].m_Country != pB->m_aClients[c].m_Country || pA->m_aClients[c].m_Score != pB->m_aClients[c].m_Score)
+			return false;
+	return true;
+}
+
+// what CServerBrowser::SaveCache and LoadCacheThread did: every CServerInfo as it is, huffman compressed
+void save_raw(const char *pPath)
+{
+	IOHANDLE File = io_open(pPath, IOFLAG_WRITE);
+	char Version = 3;
+	io_write(File, &Version, 1);
+	int NumServers = NUM_SERVERS;
+	io_write(File, &NumServers, sizeof(NumServers));
+	io_write(File, &NumServers, sizeof(NumServers));
+
+	const unsigned int SIZE = sizeof(CServerInfo)*NUM_SERVERS;
+	unsigned char *pCompressed = (unsigned char *)mem_alloc(SIZE, 0);
+	int CompressedSize = CNetBase::Compress(g_pInfos, SIZE, pCompressed, SIZE);
+	io_write(File, &CompressedSize, sizeof(CompressedSize));
+	if(CompressedSize == -1)
+		io_write(File, g_pInfos, SIZE);
+	else
+		io_write(File, pCompressed, (unsigned int)CompressedSize);
+	io_close(File);
+	mem_free(pCompressed);
+}
+
+void test_raw(int64 *pTimeStart, int num)
+{
+	char aPath[1024];
+	test_temp_path("test_serverlist_raw", aPath, sizeof(aPath));
+	save_raw(aPath);
+
+	*pTimeStart = time_get_raw();
+	for(int n = 0; n < num; n++)
+	{
+		IOHANDLE File = io_open(aPath, IOFLAG_READ);
+		g_FileSize = (int)io_length(File);
+		char Version;
+		int NumServers, Capacity, CompressedSize;
+		io_read(File, &Version, 1);
+		io_read(File, &NumServers, sizeof(NumServers));
+		io_read(File, &Capacity, sizeof(Capacity));
+		io_read(File, &CompressedSize, sizeof(CompressedSize));
+
+		const unsigned int SIZE = sizeof(CServerInfo)*NumServers;
+		CServerInfo *aAllInfos = mem_allocb(CServerInfo, NumServers);
+		unsigned char *pCompressed = (unsigned char *)mem_alloc((unsigned int)CompressedSize, 0);
+		io_read(File, pCompressed, (unsigned int)CompressedSize);
+		io_close(File);
+		CNetBase::Decompress(pCompressed, CompressedSize, aAllInfos, SIZE);
+		mem_free(pCompressed);
+
+		for(int i = 0; i < NumServers; i++)
+			mem_copy(&g_pLoaded[i], &aAllInfos[i], sizeof(CServerInfo));
+		g_NumLoaded = NumServers;
+		mem_free(aAllInfos);
+	}
+	fs_remove(aPath);
+}
+
+void save_mapped(const char *pPath)
+{
+	CServerListCache::CWriter Writer;
+	for(int i = 0; i < NUM_SERVERS; i++)
+		Writer.Add(&g_pInfos[i]);
+	std::vector<char> aData;
+	Writer.Finish(&aData);
+	IOHANDLE File = io_open(pPath, IOFLAG_WRITE);
+	io_write(File, &aData[0], (unsigned)aData.size());
+	io_close(File);
+}
+
+void test_mapped(int64 *pTimeStart, int num)
+{
+	char aPath[1024];
+	test_temp_path("test_serverlist_mapped", aPath, sizeof(aPath));
+	save_mapped(aPath);
+
+	*pTimeStart = time_get_raw();
+	for(int n = 0; n < num; n++)
+	{
+		unsigned Size;
+		const void *pData = fs_map_file(aPath, &Size);
+		g_FileSize = (int)Size;
+		CServerListCache Cache;
+		g_NumLoaded = 0;
+		if(Cache.Open(pData, Size))
+			for(int i = 0; i < Cache.NumServers(); i++)
+				g_NumLoaded += Cache.Get(i, &g_pLoaded[i]);
+		fs_unmap_file(pData, Size);
+	}
+	fs_remove(aPath);
+}
+
+// only up to the first server on screen
+void test_open(int64 *pTimeStart, int num)
+{
+	char aPath[1024];
+	test_temp_path("test_serverlist_mapped", aPath, sizeof(aPath));
+	save_mapped(aPath);
+
+	*pTimeStart = time_get_raw();
+	for(int n = 0; n < num; n++)
+	{
+		unsigned Size;
+		const void *pData = fs_map_file(aPath, &Size);
+		g_FileSize = (int)Size;
+		CServerListCache Cache;
+		g_NumLoaded = Cache.Open(pData, Size) && Cache.Get(0, &g_pLoaded[0]);
+		fs_unmap_file(pData, Size);
+	}
+	fs_remove(aPath);
+}
+
+void test_save(int64 *pTimeStart, int num)
+{
+	char aPath[1024];
+	test_temp_path("test_serverlist_mapped", aPath, sizeof(aPath));
+
+	*pTimeStart = time_get_raw();
+	for(int n = 0; n < num; n++)
+		save_mapped(aPath);
+	fs_remove(aPath);
+}
+
+
+// whatever was loaded has to be what was saved
+void test_result(const char *pWhat, int Num, double Us, char *pResult, int ResultSize)
+{
+	for(int i = 0; i < g_NumLoaded; i++)
+		g_NumMismatches += !same_info(&g_pInfos[i], &g_pLoaded[i]);
+	str_format(pResult, ResultSize, "%i servers, %.2f ms per load, %i bytes, %i loaded", NUM_SERVERS, Us/1000.0/Num, g_FileSize, g_NumLoaded);
+}
+
+
+int main()
+{
+	test_init();
+	CNetBase::Init();
+
+	setup();
+
+	CONDUCT_TEST(raw, 5);
+	CONDUCT_TEST(mapped, 5);
+	CONDUCT_TEST(open, 100);
+	CONDUCT_TEST(save, 5);
+
+	return test_exit();
+}
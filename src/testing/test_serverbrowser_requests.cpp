@@ -0,0 +1,266 @@
+#include <queue>
+#include <vector>
+#include <base/system.h>
+#include <engine/client/serverbrowser_requests.h>
+#include "test.h"
+
+
+// a refresh against a simulated farm of servers behind the downlink of the client: the answers queue up
+// in front of the link and are dropped when its buffer is full. in virtual time, so loopback can't hide the losses
+const int NUM_SERVERS = 5000;
+const int NUM_FAVORITES = 20;
+const int DEAD_PERCENT = 5;
+const int LOSS_PERMILLE = 5;
+const int FRAME_MS = 8;
+const int MAX_SIM_MS = 120000;
+
+struct CLink
+{
+	const char *m_pName;
+	int m_Capacity; // answers per second
+	int m_Buffer; // answers that fit in the queue in front of it
+};
+
+const CLink g_aLinks[] = {
+	{"fast", 5000, 256},
+	{"slow", 300, 64},
+};
+
+struct CTestServer
+{
+	bool m_Dead;
+	bool m_Favorite;
+	int m_Rtt; // ms
+};
+
+struct CResult
+{
+	int m_DoneMs;
+	int m_FavoritesMs;
+	int m_NumAnswered;
+	int m_NumSent;
+	int m_NumDropped;
+};
+
+CTestServer g_aServers[NUM_SERVERS];
+int g_NumAlive;
+CResult g_Result;
+
+
+unsigned next_rand(unsigned *pSeed)
+{
+	*pSeed = *pSeed*1103515245+12345;
+	return *pSeed>>8;
+}
+
+void setup()
+{
+	unsigned Seed = 1;
+	g_NumAlive = 0;
+	for(int i = 0; i < NUM_SERVERS; i++)
+	{
+		g_aServers[i].m_Dead = next_rand(&Seed)%100 < (unsigned)DEAD_PERCENT;
+		g_aServers[i].m_Favorite = false;
+		g_aServers[i].m_Rtt = 20+next_rand(&Seed)%280;
+		g_NumAlive += !g_aServers[i].m_Dead;
+	}
+	for(int i = 0; i < NUM_FAVORITES; )
+	{
+		CTestServer *pServer = &g_aServers[next_rand(&Seed)%NUM_SERVERS];
+		if(!pServer->m_Dead && !pServer->m_Favorite)
+		{
+			pServer->m_Favorite = true;
+			i++;
+		}
+	}
+}
+
+struct CEvent
+{
+	int m_Time; // ms
+	int m_Index;
+	bool operator<(const CEvent &Other) const { return m_Time > Other.m_Time; }
+};
+
+// the answers on their way: first to the link, then through it
+class CFarm
+{
+public:
+	CFarm(const CLink *pLink) : m_pLink(pLink), m_LinkFree(0.0), m_Seed(7) {}
+
+	void Send(int Index, int Now)
+	{
+		g_Result.m_NumSent++;
+		if(g_aServers[Index].m_Dead || (int)(next_rand(&m_Seed)%1000) < LOSS_PERMILLE)
+			return;
+		CEvent Event = {Now+g_aServers[Index].m_Rtt, Index};
+		m_Arriving.push(Event);
+	}
+
+	// returns the next answer that got through until Now, -1 if there is none
+	int Receive(int Now)
+	{
+		while(!m_Arriving.empty() && m_Arriving.top().m_Time <= Now)
+		{
+			CEvent Event = m_Arriving.top();
+			m_Arriving.pop();
+			double Start = max(m_LinkFree, (double)Event.m_Time);
+			if((Start-Event.m_Time)*m_pLink->m_Capacity/1000.0 >= m_pLink->m_Buffer)
+			{
+				g_Result.m_NumDropped++;
+				continue;
+			}
+			m_LinkFree = Start+1000.0/m_pLink->m_Capacity;
+			Event.m_Time = (int)m_LinkFree+1;
+			m_Delivered.push(Event);
+		}
+		if(!m_Delivered.empty() && m_Delivered.top().m_Time <= Now)
+		{
+			int Index = m_Delivered.top().m_Index;
+			m_Delivered.pop();
+			return Index;
+		}
+		return -1;
+	}
+
+private:
+	const CLink *m_pLink;
+	std::priority_queue<CEvent> m_Arriving;
+	std::priority_queue<CEvent> m_Delivered;
+	double m_LinkFree;
+	unsigned m_Seed;
+};
+
+struct CProgress
+{
+	bool m_aAnswered[NUM_SERVERS];
+	int m_NumFavorites;
+
+	CProgress() : m_NumFavorites(0) { mem_zero(m_aAnswered, sizeof(m_aAnswered)); }
+
+	void Answer(int Index, int Now)
+	{
+		if(m_aAnswered[Index])
+			return;
+		m_aAnswered[Index] = true;
+		g_Result.m_NumAnswered++;
+		if(g_aServers[Index].m_Favorite && ++m_NumFavorites == NUM_FAVORITES)
+			g_Result.m_FavoritesMs = Now;
+	}
+};
+
+int64 ticks(int Ms)
+{
+	return 1+Ms*time_freq()/1000;
+}
+
+// what CServerBrowser::ProcessServerList did: up to br_max_requests in flight, a second until a request times out,
+// every timed out request again with half as many in flight once all of them timed out
+void test_window(int64 *pTimeStart, int num)
+{
+	*pTimeStart = time_get_raw();
+	mem_zero(&g_Result, sizeof(g_Result));
+	CFarm Farm(&g_aLinks[num]);
+	CProgress *pProgress = new CProgress();
+
+	const int MaxRequests = 50;
+	const int AbortLimit = 10;
+	std::vector<int> aList; // request list, in master order
+	std::vector<int> aRequestTime(NUM_SERVERS, 0); // 0 = not asked yet, ms+1 otherwise
+	for(int i = 0; i < NUM_SERVERS; i++)
+		aList.push_back(i);
+	int CurrentMaxRequests = MaxRequests;
+
+	int Now = 0;
+	for(; Now < MAX_SIM_MS && !aList.empty(); Now += FRAME_MS)
+	{
+		int Index;
+		while((Index = Farm.Receive(Now)) >= 0)
+			pProgress->Answer(Index, Now);
+		unsigned Num = 0;
+		for(unsigned i = 0; i < aList.size(); i++)
+			if(!pProgress->m_aAnswered[aList[i]])
+				aList[Num++] = aList[i];
+		aList.resize(Num);
+
+		int Count = 0;
+		for(unsigned i = 0; i < aList.size(); i++)
+		{
+			int Server = aList[i];
+			if(aRequestTime[Server] && aRequestTime[Server]-1+1000 < Now)
+				continue;
+			if(Count >= CurrentMaxRequests)
+				break;
+			if(aRequestTime[Server] == 0)
+			{
+				Farm.Send(Server, Now);
+				aRequestTime[Server] = Now+1;
+			}
+			Count++;
+		}
+
+		if(Count == 0 && !aList.empty() && CurrentMaxRequests > AbortLimit)
+		{
+			for(unsigned i = 0; i < aList.size(); i++)
+				aRequestTime[aList[i]] = 0;
+			CurrentMaxRequests /= 2;
+			if(CurrentMaxRequests <= AbortLimit)
+				aList.clear();
+		}
+	}
+	g_Result.m_DoneMs = Now;
+	delete pProgress;
+}
+
+void test_bucket(int64 *pTimeStart, int num)
+{
+	*pTimeStart = time_get_raw();
+	mem_zero(&g_Result, sizeof(g_Result));
+	CFarm Farm(&g_aLinks[num]);
+	CProgress *pProgress = new CProgress();
+
+	CRequestScheduler Scheduler;
+	Scheduler.Reset(500, 50, 10);
+	for(int i = 0; i < NUM_SERVERS; i++)
+		Scheduler.Queue(i, g_aServers[i].m_Favorite ? CRequestScheduler::PRIO_FAVORITE : CRequestScheduler::PRIO_NORMAL);
+
+	int Now = 0;
+	for(; Now < MAX_SIM_MS && Scheduler.Pending() && !Scheduler.Stalled(); Now += FRAME_MS)
+	{
+		int Index;
+		while((Index = Farm.Receive(Now)) >= 0)
+		{
+			pProgress->Answer(Index, Now);
+			Scheduler.Answered(Index, ticks(Now));
+		}
+		Scheduler.Expire(ticks(Now));
+		while((Index = Scheduler.Next(ticks(Now))) >= 0)
+			Farm.Send(Index, Now);
+	}
+	g_Result.m_DoneMs = Now;
+	delete pProgress;
+}
+
+
+// every server that is alive has to be heard of, however the requests are paced
+void test_result(const char *pWhat, int Num, double Us, char *pResult, int ResultSize)
+{
+	g_NumMismatches += g_Result.m_NumAnswered != g_NumAlive;
+	str_format(pResult, ResultSize, "%s link, %i servers, refresh done after %.2f s, favorites after %.2f s, %i of %i answered, %i sent, %i dropped", g_aLinks[Num].m_pName, NUM_SERVERS,
+		g_Result.m_DoneMs/1000.0f, g_Result.m_FavoritesMs/1000.0f, g_Result.m_NumAnswered, g_NumAlive, g_Result.m_NumSent, g_Result.m_NumDropped);
+}
+
+
+int main()
+{
+	test_init();
+
+	setup();
+
+	CONDUCT_TEST(window, 0);
+	CONDUCT_TEST(bucket, 0);
+	CONDUCT_TEST(window, 1);
+	CONDUCT_TEST(bucket, 1);
+
+	return test_exit();
+}
@@ -0,0 +1,165 @@
+#include <base/system.h>
+#include <engine/client/serverbrowser_search.h>
+#include "test.h"
+
+
+const int NUM_SERVERS = 2000;
+const int NUM_QUERIES = 64;
+
+
+CServerInfo *g_pInfos;
+CServerFilterKeys *g_pKeys;
+CServerSearchIndex g_Index;
+int *g_paHits;
+int *g_paReferenceHits;
+char g_aaQueries[NUM_QUERIES][32];
+int g_NumFound;
+
+
+const char *const g_apWords[] = {"DDNet", "Vanilla", "Pro", "Block", "Race", "Fun", "CTF", "Teeworlds", "Zomb", "Insta", "GER", "USA", "RUS", "Novice", "Solo"};
+const char *const g_apMaps[] = {"dm1", "ctf5", "Kobra 4", "Tutorial", "Sunny Side Up", "Multeasymap", "Grandma", "Baby Aim"};
+
+unsigned next_rand(unsigned *pSeed)
+{
+	*pSeed = *pSeed*1103515245+12345;
+	return *pSeed>>8;
+}
+
+void make_info(CServerInfo *pInfo, unsigned *pSeed)
+{
+	mem_zero(pInfo, sizeof(CServerInfo));
+	str_format(pInfo->m_aName, sizeof(pInfo->m_aName), "%s %s #%d", g_apWords[next_rand(pSeed)%15], g_apWords[next_rand(pSeed)%15], next_rand(pSeed)%100);
+	str_copy(pInfo->m_aMap, g_apMaps[next_rand(pSeed)%8], sizeof(pInfo->m_aMap));
+	pInfo->m_NumClients = next_rand(pSeed)%33;
+	for(int c = 0; c < pInfo->m_NumClients; c++)
+	{
+		str_format(pInfo->m_aClients[c].m_aName, sizeof(pInfo->m_aClients[c].m_aName), "%s%d", g_apWords[next_rand(pSeed)%15], next_rand(pSeed)%1000);
+		str_copy(pInfo->m_aClients[c].m_aClan, g_apWords[next_rand(pSeed)%15], sizeof(pInfo->m_aClients[c].m_aClan));
+	}
+}
+
+void setup()
+{
+	g_pInfos = (CServerInfo *)mem_alloc(NUM_SERVERS*sizeof(CServerInfo), 1);
+	g_pKeys = (CServerFilterKeys *)mem_alloc(NUM_SERVERS*sizeof(CServerFilterKeys), 1);
+	g_paHits = (int *)mem_alloc(NUM_SERVERS*sizeof(int), 1);
+	g_paReferenceHits = (int *)mem_alloc(NUM_SERVERS*sizeof(int), 1);
+
+	unsigned Seed = 1;
+	for(int i = 0; i < NUM_SERVERS; i++)
+		make_info(&g_pInfos[i], &Seed);
+
+	// what people look for: a friend, a clan, a map, part of a server name
+	for(int q = 0; q < NUM_QUERIES; q++)
+	{
+		if(q%4 == 0)
+			str_format(g_aaQueries[q], sizeof(g_aaQueries[q]), "%s%d", g_apWords[next_rand(&Seed)%15], next_rand(&Seed)%1000);
+		else if(q%4 == 1)
+			str_copy(g_aaQueries[q], g_apWords[next_rand(&Seed)%15], sizeof(g_aaQueries[q]));
+		else if(q%4 == 2)
+			str_copy(g_aaQueries[q], g_apMaps[next_rand(&Seed)%8], sizeof(g_aaQueries[q]));
+		else
+			str_format(g_aaQueries[q], sizeof(g_aaQueries[q]), "%s #%d", g_apWords[next_rand(&Seed)%15], next_rand(&Seed)%100);
+	}
+}
+
+// what the browser did for every server on every filter pass
+int reference_search(const char *pQuery, int *paHits)
+{
+	int NumFound = 0;
+	for(int i = 0; i < NUM_SERVERS; i++)
+	{
+		const CServerInfo *pInfo = &g_pInfos[i];
+		int Hit = 0;
+		if(str_find_nocase(pInfo->m_aName, pQuery))
+			Hit |= IServerBrowser::QUICK_SERVERNAME;
+		for(int p = 0; p < pInfo->m_NumClients; p++)
+			if(str_find_nocase(pInfo->m_aClients[p].m_aName, pQuery) || str_find_nocase(pInfo->m_aClients[p].m_aClan, pQuery))
+			{
+				Hit |= IServerBrowser::QUICK_PLAYER;
+				break;
+			}
+		if(str_find_nocase(pInfo->m_aMap, pQuery))
+			Hit |= IServerBrowser::QUICK_MAPNAME;
+		paHits[i] = Hit;
+		NumFound += Hit != 0;
+	}
+	return NumFound;
+}
+
+void test_index(int64 *pTimeStart, int num)
+{
+	// the infos arriving, each one indexed
+	*pTimeStart = time_get_raw();
+	for(int n = 0; n < num; n++)
+	{
+		g_Index.Clear();
+		for(int i = 0; i < NUM_SERVERS; i++)
+		{
+			g_pKeys[i].Set(&g_pInfos[i]);
+			g_Index.Update(i, &g_pKeys[i], g_pInfos[i].m_NumClients);
+		}
+	}
+}
+
+void test_scan(int64 *pTimeStart, int num)
+{
+	*pTimeStart = time_get_raw();
+	g_NumFound = 0;
+	for(int n = 0; n < num; n++)
+		g_NumFound += reference_search(g_aaQueries[n%NUM_QUERIES], g_paReferenceHits);
+}
+
+void test_search(int64 *pTimeStart, int num)
+{
+	*pTimeStart = time_get_raw();
+	g_NumFound = 0;
+	for(int n = 0; n < num; n++)
+		g_NumFound += g_Index.Search(g_aaQueries[n%NUM_QUERIES], g_paHits);
+}
+
+void test_compare(int64 *pTimeStart, int num)
+{
+	*pTimeStart = time_get_raw();
+	g_NumFound = 0;
+	for(int n = 0; n < num; n++)
+	{
+		// some servers answer again with other players, the index has to follow
+		unsigned Seed = n+1;
+		for(int k = 0; k < 50; k++)
+		{
+			int i = next_rand(&Seed)%NUM_SERVERS;
+			make_info(&g_pInfos[i], &Seed);
+			g_pKeys[i].Set(&g_pInfos[i]);
+			g_Index.Update(i, &g_pKeys[i], g_pInfos[i].m_NumClients);
+		}
+
+		const char *pQuery = g_aaQueries[n%NUM_QUERIES];
+		int NumFound = g_Index.Search(pQuery, g_paHits);
+		g_NumFound += NumFound;
+		if(NumFound != reference_search(pQuery, g_paReferenceHits) || mem_comp(g_paHits, g_paReferenceHits, NUM_SERVERS*sizeof(int)) != 0)
+			g_NumMismatches++;
+	}
+}
+
+
+void test_result(const char *pWhat, int Num, double Us, char *pResult, int ResultSize)
+{
+	str_format(pResult, ResultSize, "%i servers, %.2f µs per round, %i found", NUM_SERVERS, Us/Num, g_NumFound);
+}
+
+
+int main()
+{
+	test_init();
+
+	setup();
+
+	CONDUCT_TEST(index, 10);
+	dbg_msg("main", "%i runs indexed", g_Index.NumRuns());
+	CONDUCT_TEST(scan, NUM_QUERIES);
+	CONDUCT_TEST(search, NUM_QUERIES*10);
+	CONDUCT_TEST(compare, 200);
+
+	return test_exit();
+}
@@ -0,0 +1,118 @@
+#include <base/system.h>
+#include <engine/client/soundmix.h>
+#include "test.h"
+
+
+const int NUM_TEST_SAMPLES = 16;
+const int SAMPLE_FRAMES = 48000;
+const int MIX_FRAMES = 1024;
+
+
+short *g_apSamples[NUM_TEST_SAMPLES];
+int g_aSampleChannels[NUM_TEST_SAMPLES];
+int g_aMixBuffer[MIX_FRAMES*2];
+int g_aReferenceBuffer[MIX_FRAMES*2];
+short g_aFinalOut[MIX_FRAMES*2];
+int g_NumVoices;
+
+
+void setup()
+{
+	// half mono, half stereo, as the game sounds are
+	unsigned Seed = 1;
+	for(int i = 0; i < NUM_TEST_SAMPLES; i++)
+	{
+		g_aSampleChannels[i] = 1 + i%2;
+		g_apSamples[i] = (short *)mem_alloc(SAMPLE_FRAMES*g_aSampleChannels[i]*sizeof(short), 16);
+		for(int j = 0; j < SAMPLE_FRAMES*g_aSampleChannels[i]; j++)
+		{
+			Seed = Seed*1103515245+12345;
+			g_apSamples[i][j] = (short)(Seed>>16);
+		}
+	}
+}
+
+// one callback worth of mixing with g_NumVoices voices, the way the mixer does it
+void mix(bool Simd, int n)
+{
+	mem_zero(g_aMixBuffer, sizeof(g_aMixBuffer));
+	for(int v = 0; v < g_NumVoices; v++)
+	{
+		int Sample = v%NUM_TEST_SAMPLES;
+		int Channels = g_aSampleChannels[Sample];
+		int Tick = ((v*997+n*MIX_FRAMES)%(SAMPLE_FRAMES-MIX_FRAMES));
+		int LVol = 64 + v%192, RVol = 255 - v%128;
+		if(Simd)
+			SoundMix(g_aMixBuffer, &g_apSamples[Sample][Tick*Channels], Channels, MIX_FRAMES, LVol, RVol);
+		else
+			SoundMixScalar(g_aMixBuffer, &g_apSamples[Sample][Tick*Channels], Channels, MIX_FRAMES, LVol, RVol);
+	}
+	if(Simd)
+		SoundClamp(g_aFinalOut, g_aMixBuffer, MIX_FRAMES, 100);
+	else
+		SoundClampScalar(g_aFinalOut, g_aMixBuffer, MIX_FRAMES, 100);
+}
+
+void test_mix_scalar(int64 *pTimeStart, int num)
+{
+	*pTimeStart = time_get_raw();
+	for(int n = 0; n < num; n++)
+		mix(false, n);
+}
+
+void test_mix_simd(int64 *pTimeStart, int num)
+{
+	*pTimeStart = time_get_raw();
+	for(int n = 0; n < num; n++)
+		mix(true, n);
+}
+
+void test_compare(int64 *pTimeStart, int num)
+{
+	// the accumulation has to be exact, the float clamp may be one off. very loud mixes overflow in the
+	// integer clamp and wrap around to the opposite sign, those are left out
+	*pTimeStart = time_get_raw();
+	for(int n = 0; n < num; n++)
+	{
+		short aReferenceOut[MIX_FRAMES*2];
+		mix(false, n);
+		mem_copy(g_aReferenceBuffer, g_aMixBuffer, sizeof(g_aMixBuffer));
+		mem_copy(aReferenceOut, g_aFinalOut, sizeof(g_aFinalOut));
+		mix(true, n);
+		if(mem_comp(g_aReferenceBuffer, g_aMixBuffer, sizeof(g_aMixBuffer)) != 0)
+			g_NumMismatches++;
+		for(int i = 0; i < MIX_FRAMES*2; i++)
+			if(g_aMixBuffer[i] < 0x7fffffff/100 && g_aMixBuffer[i] > -0x7fffffff/100 &&
+				(aReferenceOut[i]-g_aFinalOut[i] > 1 || g_aFinalOut[i]-aReferenceOut[i] > 1))
+			{
+				g_NumMismatches++;
+				break;
+			}
+	}
+}
+
+
+void test_result(const char *pWhat, int Num, double Us, char *pResult, int ResultSize)
+{
+	str_format(pResult, ResultSize, "%i voices, %.2f µs per callback", g_NumVoices, Us/Num);
+}
+
+
+int main()
+{
+	test_init();
+
+	setup();
+
+	const int aNumVoices[] = {8, 64, 256};
+	for(unsigned i = 0; i < sizeof(aNumVoices)/sizeof(aNumVoices[0]); i++)
+	{
+		g_NumVoices = aNumVoices[i];
+		CONDUCT_TEST(compare, 10);
+		CONDUCT_TEST(mix_scalar, 1000);
+		CONDUCT_TEST(mix_simd, 1000);
+		dbg_msg("main", "------------------------");
+	}
+
+	return test_exit();
+}
@@ -0,0 +1,223 @@
+#include <base/system.h>
+#include <engine/client/db_sqlite3.h>
+#include "test.h"
+
+
+const int NUM_SERVERS = 500;
+const int NUM_CLIENTS = 16;
+const int NUM_ROWS = NUM_SERVERS*NUM_CLIENTS;
+
+
+struct CTestRow
+{
+	char m_aName[16];
+	char m_aClan[12];
+	char m_aServer[24];
+	int m_NumClients;
+	int m_Score;
+};
+
+CTestRow *g_pRows;
+int g_NumStored;
+int g_NumExpected;
+
+
+const char *const g_apWords[] = {"DDNet", "Vanilla", "Pro", "Block", "Race", "Fun", "CTF", "Teeworlds", "Zomb", "Insta", "GER", "USA", "RUS", "Novice", "Solo"};
+const char g_aCreateTable[] = "CREATE TABLE IF NOT EXISTS names_v2 (" \
+	"id INTEGER PRIMARY KEY AUTOINCREMENT, " \
+	"name TEXT NOT NULL UNIQUE, " \
+	"clan TEXT NOT NULL, " \
+	"server TEXT NOT NULL, " \
+	"gametype TEXT NOT NULL, " \
+	"num_clients TEXT NOT NULL, " \
+	"state TEXT NOT NULL, " \
+	"score INTEGER, " \
+	"last_seen TIMESTAMP DEFAULT CURRENT_TIMESTAMP);";
+
+unsigned next_rand(unsigned *pSeed)
+{
+	*pSeed = *pSeed*1103515245+12345;
+	return *pSeed>>8;
+}
+
+void setup()
+{
+	g_pRows = (CTestRow *)mem_alloc(NUM_ROWS*sizeof(CTestRow), 1);
+
+	// the players of the info packets, many of them seen again on other servers
+	unsigned Seed = 1;
+	for(int i = 0; i < NUM_ROWS; i++)
+	{
+		CTestRow *pRow = &g_pRows[i];
+		str_format(pRow->m_aName, sizeof(pRow->m_aName), "%s%d", g_apWords[next_rand(&Seed)%15], next_rand(&Seed)%3000);
+		str_copy(pRow->m_aClan, g_apWords[next_rand(&Seed)%15], sizeof(pRow->m_aClan));
+		str_format(pRow->m_aServer, sizeof(pRow->m_aServer), "%d.%d.%d.%d:8303", i/NUM_CLIENTS%256, 1, 2, 3);
+		pRow->m_NumClients = NUM_CLIENTS;
+		pRow->m_Score = next_rand(&Seed)%100;
+	}
+}
+
+int count_rows(sqlite3 *pDB)
+{
+	sqlite3_stmt *pStatement;
+	int Num = -1;
+	if(sqlite3_prepare_v2(pDB, "SELECT COUNT(*) FROM names_v2;", -1, &pStatement, 0) == SQLITE_OK)
+	{
+		if(sqlite3_step(pStatement) == SQLITE_ROW)
+			Num = sqlite3_column_int(pStatement, 0);
+		sqlite3_finalize(pStatement);
+	}
+	return Num;
+}
+
+// what CSql did for the queries of ProcessServerInfo: a formatted string prepared for every row, 250 rows per transaction.
+// with Wal the database is opened like CSql opens it now, so the statement cache and the journal mode can be told apart
+void run_formatted(int64 *pTimeStart, int num, bool Wal)
+{
+	char aPath[1024];
+	test_temp_path("test_sql_formatted.db", aPath, sizeof(aPath));
+	fs_remove(aPath);
+	sqlite3 *pDB;
+	sqlite3_open(aPath, &pDB);
+	if(Wal)
+	{
+		sqlite3_exec(pDB, "PRAGMA journal_mode=WAL;", 0, 0, 0);
+		sqlite3_exec(pDB, "PRAGMA synchronous=NORMAL;", 0, 0, 0);
+	}
+	sqlite3_exec(pDB, g_aCreateTable, 0, 0, 0);
+
+	*pTimeStart = time_get_raw();
+	for(int n = 0; n < num; n++)
+		for(int i = 0; i < NUM_ROWS; i++)
+		{
+			if(i%250 == 0)
+				sqlite3_exec(pDB, "BEGIN;", 0, 0, 0);
+
+			const CTestRow *pRow = &g_pRows[i];
+			char *pQueryStr = sqlite3_mprintf("INSERT OR REPLACE INTO names_v2 (name, clan, server, gametype, num_clients, state, score) VALUES ('%q', '%q', '%q', '%q', '%d', '%q', '%d');",
+				pRow->m_aName, pRow->m_aClan, pRow->m_aServer, "DDraceNetwork", pRow->m_NumClients, "player", pRow->m_Score);
+			sqlite3_stmt *pStatement;
+			if(sqlite3_prepare_v2(pDB, pQueryStr, -1, &pStatement, 0) == SQLITE_OK)
+			{
+				sqlite3_step(pStatement);
+				sqlite3_finalize(pStatement);
+			}
+			sqlite3_free(pQueryStr);
+
+			if(i%250 == 249 || i == NUM_ROWS-1)
+				sqlite3_exec(pDB, "END;", 0, 0, 0);
+		}
+
+	g_NumStored = count_rows(pDB);
+	sqlite3_close(pDB);
+	fs_remove(aPath);
+}
+
+void test_formatted(int64 *pTimeStart, int num)
+{
+	run_formatted(pTimeStart, num, false);
+}
+
+void test_formatted_wal(int64 *pTimeStart, int num)
+{
+	run_formatted(pTimeStart, num, true);
+}
+
+CQuery *make_query(const CTestRow *pRow, bool Keyed)
+{
+	CQuery *pQuery = new CQuery();
+	pQuery->SetTemplate("INSERT OR REPLACE INTO names_v2 (name, clan, server, gametype, num_clients, state, score) VALUES (?, ?, ?, ?, ?, ?, ?);");
+	pQuery->BindText(pRow->m_aName);
+	pQuery->BindText(pRow->m_aClan);
+	pQuery->BindText(pRow->m_aServer);
+	pQuery->BindText("DDraceNetwork");
+	pQuery->BindInt(pRow->m_NumClients);
+	pQuery->BindText("player");
+	pQuery->BindInt(pRow->m_Score);
+	if(Keyed)
+		pQuery->SetKey(pRow->m_aName);
+	return pQuery;
+}
+
+void test_prepared(int64 *pTimeStart, int num)
+{
+	char aPath[1024];
+	test_temp_path("test_sql_prepared.db", aPath, sizeof(aPath));
+	fs_remove(aPath);
+	CSql *pSql = new CSql(aPath, false);
+	pSql->InsertQuerySync(new CQuery(sqlite3_mprintf("%s", g_aCreateTable)));
+
+	*pTimeStart = time_get_raw();
+	for(int n = 0; n < num; n++)
+	{
+		for(int i = 0; i < NUM_ROWS; i++)
+			pSql->InsertQuery(make_query(&g_pRows[i], false));
+		pSql->Flush();
+	}
+	delete pSql;
+
+	// the rows have to be there after the database was closed
+	sqlite3 *pDB;
+	sqlite3_open(aPath, &pDB);
+	g_NumStored = count_rows(pDB);
+	sqlite3_close(pDB);
+	fs_remove(aPath);
+}
+
+// a browser refresh: the infos arrive in a burst and the worker thread writes them while the client goes on.
+// a full queue holds the burst back, every row has to arrive like in the synchronous runs
+void test_threaded(int64 *pTimeStart, int num)
+{
+	char aPath[1024];
+	test_temp_path("test_sql_threaded.db", aPath, sizeof(aPath));
+	fs_remove(aPath);
+	CSql *pSql = new CSql(aPath, true);
+	pSql->InsertQuery(new CQuery(sqlite3_mprintf("%s", g_aCreateTable)));
+
+	*pTimeStart = time_get_raw();
+	int64 InsertTime = 0;
+	for(int n = 0; n < num; n++)
+	{
+		int64 Start = time_get_raw();
+		for(int i = 0; i < NUM_ROWS; i++)
+			pSql->InsertQuery(make_query(&g_pRows[i], true));
+		InsertTime += time_get_raw()-Start;
+	}
+	CSql::CStats Stats = pSql->GetStats();
+	delete pSql;
+
+	dbg_msg("main", "threaded: %.2f ms spent queueing, peak %d queued, %d coalesced, %d stalls, %.1f ms max latency",
+		InsertTime*1000.0f/(float)time_freq(), Stats.m_PeakQueued, Stats.m_NumCoalesced, Stats.m_NumStalls, Stats.m_MaxLatency);
+
+	sqlite3 *pDB;
+	sqlite3_open(aPath, &pDB);
+	g_NumStored = count_rows(pDB);
+	sqlite3_close(pDB);
+	fs_remove(aPath);
+}
+
+
+// every way has to store the rows the first one stored
+void test_result(const char *pWhat, int Num, double Us, char *pResult, int ResultSize)
+{
+	if(str_comp(pWhat, "formatted") == 0)
+		g_NumExpected = g_NumStored;
+	else
+		g_NumMismatches += g_NumStored != g_NumExpected;
+	str_format(pResult, ResultSize, "%i rows, %.2f rows per ms, %i stored", NUM_ROWS, NUM_ROWS*Num/(Us/1000.0), g_NumStored);
+}
+
+
+int main()
+{
+	test_init();
+
+	setup();
+
+	CONDUCT_TEST(formatted, 5);
+	CONDUCT_TEST(formatted_wal, 5);
+	CONDUCT_TEST(prepared, 5);
+	CONDUCT_TEST(threaded, 5);
+
+	return test_exit();
+}
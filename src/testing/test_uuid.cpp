@@ -0,0 +1,127 @@
+#include <base/system.h>
+#include <engine/message.h>
+#include <engine/shared/packer.h>
+#include <engine/shared/protocol.h>
+#include <engine/shared/protocol_ex.h>
+#include "test.h"
+#include <engine/shared/uuid_manager.h>
+
+
+const int NUM_TEST_NAMES = 256;
+const int NUM_TEST_MESSAGES = 1024;
+
+
+char g_aaNames[NUM_TEST_NAMES][32];
+CUuidManager g_Manager;
+unsigned char g_aaMessageData[NUM_TEST_MESSAGES][64];
+int g_aMessageSizes[NUM_TEST_MESSAGES];
+int g_NumFound;
+
+
+void setup()
+{
+	// a manager with many more extended messages than we have today
+	for(int i = 0; i < NUM_TEST_NAMES; i++)
+	{
+		str_format(g_aaNames[i], sizeof(g_aaNames[i]), "test-message-%d@allthehaxx", i);
+		g_Manager.RegisterName(OFFSET_UUID+i, g_aaNames[i]);
+	}
+
+	// extended messages the way they come in over the network
+	for(int i = 0; i < NUM_TEST_MESSAGES; i++)
+	{
+		int Type = NETMSG_WHATIS + i%(OFFSET_GAME_UUID-OFFSET_NETMSG_UUID);
+		CMsgPacker Msg(Type);
+		mem_copy(g_aaMessageData[i], Msg.Data(), Msg.Size());
+		g_aMessageSizes[i] = Msg.Size();
+	}
+}
+
+void test_lookup(int64 *pTimeStart, int num)
+{
+	g_NumFound = 0;
+	*pTimeStart = time_get_raw();
+	for(int n = 0; n < num; n++)
+	{
+		for(int i = 0; i < NUM_TEST_NAMES; i++)
+			if(g_Manager.LookupUuid(g_Manager.GetUuid(OFFSET_UUID+i)) == OFFSET_UUID+i)
+				g_NumFound++;
+	}
+}
+
+void test_lookup_linear(int64 *pTimeStart, int num)
+{
+	// reference: what LookupUuid used to do
+	g_NumFound = 0;
+	*pTimeStart = time_get_raw();
+	for(int n = 0; n < num; n++)
+	{
+		for(int i = 0; i < NUM_TEST_NAMES; i++)
+		{
+			CUuid Uuid = g_Manager.GetUuid(OFFSET_UUID+i);
+			for(int j = 0; j < NUM_TEST_NAMES; j++)
+			{
+				if(Uuid == g_Manager.GetUuid(OFFSET_UUID+j))
+				{
+					g_NumFound++;
+					break;
+				}
+			}
+		}
+	}
+}
+
+void test_unpack(int64 *pTimeStart, int num)
+{
+	g_NumFound = 0;
+	*pTimeStart = time_get_raw();
+	for(int n = 0; n < num; n++)
+	{
+		for(int i = 0; i < NUM_TEST_MESSAGES; i++)
+		{
+			CUnpacker Unpacker;
+			Unpacker.Reset(g_aaMessageData[i], g_aMessageSizes[i]);
+			CMsgPacker Answer(NETMSG_EX);
+			int ID;
+			bool Sys;
+			CUuid Uuid;
+			if(UnpackMessageID(&ID, &Sys, &Uuid, &Unpacker, &Answer) == UNPACKMESSAGE_OK)
+				g_NumFound++;
+		}
+	}
+}
+
+
+// the hashed lookup has to find what the linear one finds, every message has to unpack
+void test_result(const char *pWhat, int Num, double Us, char *pResult, int ResultSize)
+{
+	static int s_NumLookedUp = 0;
+	if(str_comp(pWhat, "lookup") == 0)
+		s_NumLookedUp = g_NumFound;
+	else if(str_comp(pWhat, "lookup_linear") == 0)
+		g_NumMismatches += g_NumFound != s_NumLookedUp;
+	else
+		g_NumMismatches += g_NumFound != Num*NUM_TEST_MESSAGES;
+	str_format(pResult, ResultSize, "%i found", g_NumFound);
+}
+
+
+int main()
+{
+	test_init();
+
+	setup();
+
+	CONDUCT_TEST(lookup, 100);
+	CONDUCT_TEST(lookup_linear, 100);
+	dbg_msg("main", "------------------------");
+
+	CONDUCT_TEST(lookup, 1000);
+	CONDUCT_TEST(lookup_linear, 1000);
+	dbg_msg("main", "------------------------");
+
+	CONDUCT_TEST(unpack, 1000);
+	CONDUCT_TEST(unpack, 10000);
+
+	return test_exit();
+}
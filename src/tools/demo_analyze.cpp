@@ -0,0 +1,314 @@
+/*
+	demo_analyze - headless batch demo decoder
+
+	Plays back demos without any real-time pacing, decodes every snapshot
+	into its netobjects and writes them to a columnar file next to the demo
+	(<demo>.twcol). Demos are distributed over a job pool so that a whole
+	corpus is processed on all cores.
+
+	Usage: demo_analyze [-j threads] <demo> [<demo> ...]
+
+	Columnar file layout (all integers are 32 bit little endian):
+		char[8]   "TWCOLMN\0"
+		int       version
+		int       number of tables
+		per table:
+			int       netobj type (>= OFFSET_UUID for extended types)
+			char[64]  netobj name
+			int       number of fields (excluding tick and id)
+			int       number of rows
+			int[rows] tick column
+			int[rows] id column
+			int[rows] one column per field
+*/
+#include <map>
+#include <vector>
+
+#include <base/math.h>
+#include <base/system.h>
+
+#include <engine/console.h>
+#include <engine/storage.h>
+#include <engine/shared/config.h>
+#include <engine/shared/demo.h>
+#include <engine/shared/jobs.h>
+#include <engine/shared/network.h>
+#include <engine/shared/snapshot.h>
+#include <engine/shared/uuid_manager.h>
+
+#include <game/generated/protocol.h>
+
+static const char gs_aColumnMarker[8] = {'T', 'W', 'C', 'O', 'L', 'M', 'N', 0};
+static const int gs_ColumnVersion = 1;
+
+static IStorageTW *s_pStorage = 0;
+
+class CColumnTable
+{
+public:
+	int m_Type;
+	int m_NumFields;
+	std::vector<int> m_aTick;
+	std::vector<int> m_aID;
+	std::vector< std::vector<int> > m_aaFields;
+
+	void AddRow(int Tick, int ID, const int *pData)
+	{
+		m_aTick.push_back(Tick);
+		m_aID.push_back(ID);
+		for(int i = 0; i < m_NumFields; i++)
+			m_aaFields[i].push_back(pData[i]);
+	}
+};
+
+class CDemoAnalyzer : public CDemoPlayer::IListener
+{
+	CSnapshotDelta m_SnapshotDelta;
+	CDemoPlayer m_DemoPlayer;
+	CNetObjHandler m_NetObjHandler;
+
+	std::map<int, CColumnTable> m_Tables;
+
+public:
+	int m_NumSnapshots;
+	int m_NumMessages;
+	int m_NumItems;
+	int m_NumMismatchedItems;
+
+	CDemoAnalyzer() : m_DemoPlayer(&m_SnapshotDelta, true)
+	{
+		m_NumSnapshots = 0;
+		m_NumMessages = 0;
+		m_NumItems = 0;
+		m_NumMismatchedItems = 0;
+
+		for(int i = 0; i < NUM_NETOBJTYPES; i++)
+			m_SnapshotDelta.SetStaticsize(i, m_NetObjHandler.GetObjSize(i));
+		m_DemoPlayer.SetListener(this);
+	}
+
+	const char *ItemName(int Type)
+	{
+		if(Type >= OFFSET_UUID)
+			return g_UuidManager.GetName(Type);
+		return m_NetObjHandler.GetObjName(Type);
+	}
+
+	virtual void OnDemoPlayerSnapshot(void *pData, int Size)
+	{
+		CSnapshot *pSnap = (CSnapshot *)pData;
+		const int Tick = m_DemoPlayer.Info()->m_Info.m_CurrentTick;
+		m_NumSnapshots++;
+
+		for(int i = 0; i < pSnap->NumItems(); i++)
+		{
+			CSnapshotItem *pItem = pSnap->GetItem(i);
+			int Type = pSnap->GetItemType(i);
+			int NumFields = pSnap->GetItemSize(i)/4;
+			if(Type <= NETOBJTYPE_EX || Type == UUID_UNKNOWN || Type == UUID_INVALID)
+				continue;
+
+			std::map<int, CColumnTable>::iterator it = m_Tables.find(Type);
+			if(it == m_Tables.end())
+			{
+				CColumnTable &Table = m_Tables[Type];
+				Table.m_Type = Type;
+				Table.m_NumFields = NumFields;
+				Table.m_aaFields.resize(NumFields);
+				it = m_Tables.find(Type);
+			}
+
+			// items of the same type have to agree in size, otherwise they can't share the columns
+			if(it->second.m_NumFields != NumFields)
+			{
+				m_NumMismatchedItems++;
+				continue;
+			}
+
+			it->second.AddRow(Tick, pItem->ID(), pItem->Data());
+			m_NumItems++;
+		}
+	}
+
+	virtual void OnDemoPlayerMessage(void *pData, int Size)
+	{
+		m_NumMessages++;
+	}
+
+	bool Run(const char *pDemo, IConsole *pConsole)
+	{
+		if(m_DemoPlayer.Load(s_pStorage, pConsole, pDemo, IStorageTW::TYPE_ABSOLUTE) == -1)
+			return false;
+
+		m_DemoPlayer.Play();
+		while(m_DemoPlayer.IsPlaying())
+		{
+			m_DemoPlayer.Update(false);
+			if(m_DemoPlayer.Info()->m_Info.m_Paused)
+				break;
+		}
+		m_DemoPlayer.Stop();
+		return true;
+	}
+
+	bool Write(const char *pFilename)
+	{
+		IOHANDLE File = io_open(pFilename, IOFLAG_WRITE);
+		if(!File)
+			return false;
+
+		io_write(File, gs_aColumnMarker, sizeof(gs_aColumnMarker));
+		WriteInt(File, gs_ColumnVersion);
+		WriteInt(File, (int)m_Tables.size());
+		for(std::map<int, CColumnTable>::const_iterator it = m_Tables.begin(); it != m_Tables.end(); ++it)
+		{
+			const CColumnTable &Table = it->second;
+			char aName[64] = {0};
+			str_copy(aName, ItemName(Table.m_Type), sizeof(aName));
+
+			WriteInt(File, Table.m_Type);
+			io_write(File, aName, sizeof(aName));
+			WriteInt(File, Table.m_NumFields);
+			WriteInt(File, (int)Table.m_aTick.size());
+			WriteColumn(File, Table.m_aTick);
+			WriteColumn(File, Table.m_aID);
+			for(int i = 0; i < Table.m_NumFields; i++)
+				WriteColumn(File, Table.m_aaFields[i]);
+		}
+
+		io_close(File);
+		return true;
+	}
+
+private:
+	static void WriteInt(IOHANDLE File, int Value)
+	{
+		unsigned char aBuf[4];
+		aBuf[0] = Value&0xff;
+		aBuf[1] = (Value>>8)&0xff;
+		aBuf[2] = (Value>>16)&0xff;
+		aBuf[3] = (Value>>24)&0xff;
+		io_write(File, aBuf, sizeof(aBuf));
+	}
+
+	static void WriteColumn(IOHANDLE File, const std::vector<int> &aColumn)
+	{
+		// convert in blocks, writing the values one by one is way too slow for big demos
+		unsigned char aBuf[4*1024];
+		unsigned Used = 0;
+		for(unsigned i = 0; i < aColumn.size(); i++)
+		{
+			int Value = aColumn[i];
+			aBuf[Used++] = Value&0xff;
+			aBuf[Used++] = (Value>>8)&0xff;
+			aBuf[Used++] = (Value>>16)&0xff;
+			aBuf[Used++] = (Value>>24)&0xff;
+			if(Used == sizeof(aBuf))
+			{
+				io_write(File, aBuf, Used);
+				Used = 0;
+			}
+		}
+		if(Used)
+			io_write(File, aBuf, Used);
+	}
+};
+
+struct CDemoJob
+{
+	const char *m_pDemo;
+	IConsole *m_pConsole; // one per job, the console isn't meant to be shared between threads
+	CJob m_Job;
+	bool m_Success;
+	int m_NumSnapshots;
+	int m_NumItems;
+};
+
+static int AnalyzeDemoJob(void *pUser)
+{
+	CDemoJob *pDemoJob = (CDemoJob *)pUser;
+
+	// the analyzer carries a couple of snapshot sized buffers, keep it off the stack
+	CDemoAnalyzer *pAnalyzer = new CDemoAnalyzer();
+	pDemoJob->m_Success = pAnalyzer->Run(pDemoJob->m_pDemo, pDemoJob->m_pConsole);
+	if(pDemoJob->m_Success)
+	{
+		char aOutput[1024];
+		str_format(aOutput, sizeof(aOutput), "%s.twcol", pDemoJob->m_pDemo);
+		pDemoJob->m_Success = pAnalyzer->Write(aOutput);
+		if(pAnalyzer->m_NumMismatchedItems)
+			dbg_msg("demo_analyze", "%s: skipped %d items with unexpected size", pDemoJob->m_pDemo, pAnalyzer->m_NumMismatchedItems);
+	}
+	pDemoJob->m_NumSnapshots = pAnalyzer->m_NumSnapshots;
+	pDemoJob->m_NumItems = pAnalyzer->m_NumItems;
+	delete pAnalyzer;
+	return pDemoJob->m_Success ? 0 : -1;
+}
+
+int main(int argc, const char **argv) // ignore_convention
+{
+	dbg_logger_stdout();
+
+	int NumThreads = 4;
+	int FirstDemo = 1;
+	if(argc > 2 && str_comp(argv[1], "-j") == 0) // ignore_convention
+	{
+		NumThreads = max(1, str_toint(argv[2])); // ignore_convention
+		FirstDemo = 3;
+	}
+
+	if(argc <= FirstDemo)
+	{
+		dbg_msg("usage", "%s [-j threads] <demo> [<demo> ...]", argv[0]); // ignore_convention
+		return -1;
+	}
+
+	CNetBase::Init();
+	s_pStorage = CreateStorage("Teeworlds", IStorageTW::STORAGETYPE_BASIC, argc, argv); // ignore_convention
+	if(!s_pStorage)
+		return -1;
+
+	const int NumDemos = argc - FirstDemo;
+	CDemoJob *pJobs = new CDemoJob[NumDemos];
+
+	int64 StartTime = time_get();
+	{
+		CJobPool JobPool;
+		JobPool.Init(NumThreads);
+		for(int i = 0; i < NumDemos; i++)
+		{
+			pJobs[i].m_pDemo = argv[FirstDemo+i]; // ignore_convention
+			pJobs[i].m_pConsole = CreateConsole(CFGFLAG_CLIENT);
+			pJobs[i].m_Success = false;
+			pJobs[i].m_NumSnapshots = 0;
+			pJobs[i].m_NumItems = 0;
+			JobPool.Add(&pJobs[i].m_Job, AnalyzeDemoJob, &pJobs[i]);
+		}
+
+		for(int i = 0; i < NumDemos; i++)
+			while(pJobs[i].m_Job.Status() != CJob::STATE_DONE)
+				thread_sleep(1);
+	}
+	float Seconds = (time_get() - StartTime) / (float)time_freq();
+
+	int NumFailed = 0;
+	int64 TotalSnapshots = 0;
+	int64 TotalItems = 0;
+	for(int i = 0; i < NumDemos; i++)
+	{
+		if(!pJobs[i].m_Success)
+		{
+			dbg_msg("demo_analyze", "failed to analyze '%s'", pJobs[i].m_pDemo);
+			NumFailed++;
+		}
+		TotalSnapshots += pJobs[i].m_NumSnapshots;
+		TotalItems += pJobs[i].m_NumItems;
+		delete pJobs[i].m_pConsole;
+	}
+	delete[] pJobs;
+
+	dbg_msg("demo_analyze", "%d demos (%d failed) on %d threads in %.3fs: %.2f demos/s, %.0f snapshots/s, %.0f items/s",
+		NumDemos, NumFailed, NumThreads, Seconds, NumDemos/Seconds, TotalSnapshots/Seconds, TotalItems/Seconds);
+
+	return NumFailed ? -1 : 0;
+}
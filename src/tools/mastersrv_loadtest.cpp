@@ -0,0 +1,199 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/system.h>
+#include <engine/shared/network.h>
+#include <mastersrv/mastersrv.h>
+
+// registers lots of fake servers at a master and floods it with list requests, all on loopback.
+// usage: mastersrv_loadtest [servers] [requests] [master host]
+
+enum
+{
+	FIRST_SERVER_PORT=20000,
+	NUM_REQUESTERS=16,
+	REQUESTS_PER_WAVE=16,
+	HEARTBEATS_PER_MS=32,
+	REGISTER_TIMEOUT=60,
+};
+
+struct CFakeServer
+{
+	NETSOCKET m_Socket;
+	NETADDR m_Addr;
+	bool m_Checked;
+	bool m_Registered;
+};
+
+static CNetPacketConstruct s_Packet;
+
+static void SendConnless(NETSOCKET Socket, NETADDR *pAddr, const void *pData, int Size)
+{
+	CNetBase::SendPacketConnless(Socket, pAddr, pData, Size, false, 0);
+}
+
+// returns the payload of the next connless packet, 0 if there is none
+static const unsigned char *RecvConnless(NETSOCKET Socket, NETADDR *pAddr, int *pSize)
+{
+	static unsigned char s_aBuffer[NET_MAX_PACKETSIZE];
+	while(1)
+	{
+		int Bytes = net_udp_recv(Socket, pAddr, s_aBuffer, sizeof(s_aBuffer));
+		if(Bytes <= 0)
+			return 0;
+		if(CNetBase::UnpackPacket(s_aBuffer, Bytes, &s_Packet) == 0 && (s_Packet.m_Flags&NET_PACKETFLAG_CONNLESS))
+		{
+			*pSize = s_Packet.m_DataSize;
+			return s_Packet.m_aChunkData;
+		}
+	}
+}
+
+static void SendHeartbeat(CFakeServer *pServer, NETADDR *pMaster)
+{
+	unsigned char aData[sizeof(SERVERBROWSE_HEARTBEAT)+2];
+	mem_copy(aData, SERVERBROWSE_HEARTBEAT, sizeof(SERVERBROWSE_HEARTBEAT));
+	aData[sizeof(SERVERBROWSE_HEARTBEAT)] = (pServer->m_Addr.port>>8)&0xff;
+	aData[sizeof(SERVERBROWSE_HEARTBEAT)+1] = pServer->m_Addr.port&0xff;
+	SendConnless(pServer->m_Socket, pMaster, aData, sizeof(aData));
+}
+
+// answers the checks of the master, returns how many servers are registered
+static int PumpServers(CFakeServer *pServers, int NumServers)
+{
+	int NumRegistered = 0;
+	for(int i = 0; i < NumServers; i++)
+	{
+		NETADDR From;
+		int Size;
+		const unsigned char *pData;
+		while((pData = RecvConnless(pServers[i].m_Socket, &From, &Size)))
+		{
+			if(Size == sizeof(SERVERBROWSE_FWCHECK) && mem_comp(pData, SERVERBROWSE_FWCHECK, sizeof(SERVERBROWSE_FWCHECK)) == 0)
+			{
+				SendConnless(pServers[i].m_Socket, &From, SERVERBROWSE_FWRESPONSE, sizeof(SERVERBROWSE_FWRESPONSE));
+				pServers[i].m_Checked = true;
+			}
+			else if(Size == sizeof(SERVERBROWSE_FWOK) && mem_comp(pData, SERVERBROWSE_FWOK, sizeof(SERVERBROWSE_FWOK)) == 0)
+				pServers[i].m_Registered = true;
+		}
+		NumRegistered += pServers[i].m_Registered;
+	}
+	return NumRegistered;
+}
+
+int main(int argc, const char **argv) // ignore_convention
+{
+	dbg_logger_stdout();
+	net_init();
+
+	int NumServers = argc > 1 ? str_toint(argv[1]) : 2000; // ignore_convention
+	int NumRequests = argc > 2 ? str_toint(argv[2]) : 5000; // ignore_convention
+	const char *pMasterHost = argc > 3 ? argv[3] : "127.0.0.1"; // ignore_convention
+
+	NETADDR Master;
+	if(net_host_lookup(pMasterHost, &Master, NETTYPE_IPV4) != 0)
+	{
+		dbg_msg("loadtest", "couldn't resolve '%s'", pMasterHost);
+		return -1;
+	}
+	Master.port = MASTERSERVER_PORT;
+
+	// one socket per server, the master tells them apart by address
+	CFakeServer *pServers = (CFakeServer *)mem_alloc(NumServers*sizeof(CFakeServer), 1);
+	for(int i = 0; i < NumServers; i++)
+	{
+		mem_zero(&pServers[i], sizeof(CFakeServer));
+		net_addr_from_str(&pServers[i].m_Addr, "127.0.0.1");
+		pServers[i].m_Addr.port = FIRST_SERVER_PORT+i;
+		pServers[i].m_Socket = net_udp_create(pServers[i].m_Addr);
+		if(!pServers[i].m_Socket.type)
+		{
+			dbg_msg("loadtest", "couldn't open socket %d, raise the open file limit", i);
+			return -1;
+		}
+	}
+
+	// the master checks new servers every second. the heartbeats are spread out, a burst overflows its socket
+	dbg_msg("loadtest", "registering %d servers at %s", NumServers, pMasterHost);
+	int64 Start = time_get();
+	int64 LastHeartbeats = 0;
+	int NextHeartbeat = NumServers;
+	int NumRegistered = 0;
+	while(NumRegistered < NumServers && time_get() < Start+time_freq()*REGISTER_TIMEOUT)
+	{
+		if(NextHeartbeat == NumServers && time_get() > LastHeartbeats+time_freq()*10)
+		{
+			LastHeartbeats = time_get();
+			NextHeartbeat = 0;
+		}
+		for(int n = 0; n < HEARTBEATS_PER_MS && NextHeartbeat < NumServers; NextHeartbeat++)
+			if(!pServers[NextHeartbeat].m_Checked)
+			{
+				SendHeartbeat(&pServers[NextHeartbeat], &Master);
+				n++;
+			}
+		NumRegistered = PumpServers(pServers, NumServers);
+		thread_sleep(1);
+	}
+	dbg_msg("loadtest", "%d of %d servers registered after %.1f s", NumRegistered, NumServers, (time_get()-Start)/(float)time_freq());
+
+	// the list requests, in waves so the socket buffers don't overflow
+	NETSOCKET aRequesters[NUM_REQUESTERS];
+	for(int i = 0; i < NUM_REQUESTERS; i++)
+	{
+		NETADDR Bind;
+		net_addr_from_str(&Bind, "127.0.0.1");
+		Bind.port = FIRST_SERVER_PORT+NumServers+i;
+		aRequesters[i] = net_udp_create(Bind);
+	}
+
+	int NumSent = 0;
+	int64 NumAddresses = 0;
+	int NumPackets = 0;
+	int64 BusyTime = 0;
+	while(NumSent < NumRequests)
+	{
+		int64 WaveStart = time_get();
+		for(int i = 0; i < REQUESTS_PER_WAVE && NumSent < NumRequests; i++, NumSent++)
+			SendConnless(aRequesters[NumSent%NUM_REQUESTERS], &Master, SERVERBROWSE_GETLIST, sizeof(SERVERBROWSE_GETLIST));
+
+		// until the master went quiet, only the time until its last answer counts
+		int64 LastRecv = time_get();
+		while(time_get() < LastRecv+time_freq()/20)
+		{
+			bool Got = false;
+			for(int r = 0; r < NUM_REQUESTERS; r++)
+			{
+				NETADDR From;
+				int Size;
+				const unsigned char *pData;
+				while((pData = RecvConnless(aRequesters[r], &From, &Size)))
+				{
+					if(Size >= (int)sizeof(SERVERBROWSE_LIST) && mem_comp(pData, SERVERBROWSE_LIST, sizeof(SERVERBROWSE_LIST)) == 0)
+					{
+						NumAddresses += (Size-sizeof(SERVERBROWSE_LIST))/sizeof(CMastersrvAddr);
+						NumPackets++;
+					}
+					Got = true;
+				}
+			}
+			if(Got)
+				LastRecv = time_get();
+			else
+				thread_sleep(1);
+		}
+		BusyTime += LastRecv-WaveStart;
+		PumpServers(pServers, NumServers);
+	}
+	float Seconds = BusyTime/(float)time_freq();
+
+	dbg_msg("loadtest", "%d list requests answered in %.2f s (%.0f per s), %d packets, %.1f of %d servers per request",
+		NumRequests, Seconds, NumRequests/Seconds, NumPackets, NumRequests ? NumAddresses/(float)NumRequests : 0.0f, NumRegistered);
+
+	for(int i = 0; i < NUM_REQUESTERS; i++)
+		net_udp_close(aRequesters[i]);
+	for(int i = 0; i < NumServers; i++)
+		net_udp_close(pServers[i].m_Socket);
+	mem_free(pServers);
+	return 0;
+}
@@ -4,6 +4,7 @@
 #include <engine/storage.h>
 #include <engine/serverbrowser.h>
 #include <engine/client/serverbrowser.h>
+#include <engine/client/serverbrowser_cache.h>
 #include <engine/shared/network.h>
 
 
@@ -149,85 +150,27 @@ int main(int argc, const char **argv)
 		return 1;// false;
 	}
 
-	// get version
-	{
-		char v; io_read(File, &v, 1);
-		if(v != IServerBrowser::CACHE_VERSION)
-		{
-			dbg_msg("browser", "couldn't load cache: file version doesn't match! (%i != %i)", v, IServerBrowser::CACHE_VERSION);
-			return 1;
-		}
-	}
-
-	// get number of servers
-	int NumServers;
-	io_read(File, &NumServers, sizeof(NumServers));
-	//dbg_msg("browser", "serverlist cache entries: %i", NumServers);
-
-	CServerInfo *pServerInfos = mem_allocb(CServerInfo, NumServers);
-	int CurrentIndex = 0;
-
-	// get length of array
-	int NumServerCapacity;
-	io_read(File, &NumServerCapacity, sizeof(NumServerCapacity));
-
-	// read the compressed size data
-	int CompressedSize;
-	io_read(File, &CompressedSize, sizeof(CompressedSize));
-
-	// read the data from the file into the serverlist
-	if(CompressedSize == -1)
-	{
-		// if the data is not compressed, read the entries as they are
-		for(int i = 0; i < NumServers; i++)
-		{
-			CServerInfo Info;
-			io_read(File, &Info, sizeof(CServerInfo));
+	// the cache is read in place by the client, here it's simply read into memory
+	unsigned FileSize = (unsigned)io_length(File);
+	char *pData = (char *)mem_alloc(max(FileSize, 1u), 1);
+	FileSize = io_read(File, pData, FileSize);
 
-			NETADDR Addr;
-			net_addr_from_str(&Addr, Info.m_aAddress);
-			//dbg_msg("browser", "loading %i %s %s", i, Info.m_aAddress, Info.m_aName);
-			pServerInfos[CurrentIndex++] = Info;
-		}
-	}
-	else
+	CServerListCache Cache;
+	if(!Cache.Open(pData, FileSize))
 	{
-		// allocate some memory
-		const unsigned int SIZE = sizeof(CServerInfo)*NumServers;
-		CServerInfo *aAllInfos = mem_allocb(CServerInfo, NumServers);
-		unsigned char *pCompressed = (unsigned char *)mem_alloc((unsigned int)CompressedSize, 0);
-
-		// read the data from the file and try to decompress it
-		io_read(File, pCompressed, (unsigned int)CompressedSize);
-		int DecompressedSize = CNetBase::Decompress(pCompressed, CompressedSize, aAllInfos, SIZE);
-		mem_free(pCompressed);
-
-		// process the data
-		if(DecompressedSize == -1)
-		{
-			// if decompression failed, return with no serverlist
-			dbg_msg("browser", "failed to decompress the serverlist cache");
-			io_close(File);
-			mem_free(aAllInfos);
-			return 2;
-		}
-		else
-		{
-			// process all the entries
-			dbg_msg("browser", "decompressed serverlist cache %i -> %i", CompressedSize, DecompressedSize);
-			for(int i = 0; i < NumServers; i++)
-			{
-				CServerInfo Info;
-				mem_copy(&Info, &aAllInfos[i], sizeof(CServerInfo));
-				NETADDR Addr;
-				net_addr_from_str(&Addr, Info.m_aAddress);
-				//dbg_msg("browser", "loading %i %s %s", i, Info.m_aAddress, Info.m_aName);
-				pServerInfos[CurrentIndex++] = Info;
-			}
-		}
-		mem_free(aAllInfos);
+		dbg_msg("browser", "couldn't load cache: not a serverlist cache or the version doesn't match (expected %i)", IServerBrowser::CACHE_VERSION);
+		io_close(File);
+		mem_free(pData);
+		return 1;
 	}
 
+	int NumServers = 0;
+	CServerInfo *pServerInfos = mem_allocb(CServerInfo, max(Cache.NumServers(), 1));
+	for(int i = 0; i < Cache.NumServers(); i++)
+		if(Cache.Get(i, &pServerInfos[NumServers]))
+			NumServers++;
+	mem_free(pData);
+
 	io_close(File);
 
 	if(as_pOut)